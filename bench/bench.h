@@ -0,0 +1,72 @@
+/**
+  rbn - Robkoo's Benchmarks
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "core/errorHandler.h"
+
+#include <stddef.h>
+
+// version of the JSON report, bumped when its layout changes
+#define RBN_JSON_VERSION 1
+
+/**
+  @brief Gets the current time in nanoseconds
+*/
+double rbn_NowNs(void);
+
+/**
+  @brief Prints a single benchmark result line and keeps it for the JSON report and the baseline comparison
+*/
+void rbn_Report(const char *group, const char *name, double nsPerOp, size_t iterations);
+
+/**
+  @brief Prints a check a benchmark failed (a result outside of its documented bound) and counts it
+  @note The bench exits with 1 once any check failed
+*/
+void rbn_ReportFailure(const char *group, const char *name, const char *reason);
+
+/**
+  @brief Gets the number of checks failed so far
+*/
+int rbn_FailureCount(void);
+
+/**
+  @brief Frees the results kept by rbn_Report
+*/
+void rbn_ReleaseResults(void);
+
+/**
+  @brief Writes every result reported so far as JSON, along with the batch kernels, the JIT support and the hardware thread count
+*/
+enum reh_error_code_e rbn_WriteJson(const char *path);
+
+/**
+  @brief Compares the results reported so far against a JSON report written by rbn_WriteJson, matching them by group and name
+  @note A result slower than its baseline by more than threshold (0.1 is 10%) counts as a regression
+*/
+enum reh_error_code_e rbn_CompareBaseline(const char *path, double threshold, int *regressions);
+
+/**
+  @brief Benchmarks the RPN evaluator against the bytecode interpreter, the domain failure modes, the precision tiers, the JIT, interval culling, dual-number derivatives, the math kernel modes, inlined function composition and parameter sweeps
+*/
+void rbn_EvaluatorBench(void);
+
+/**
+  @brief Benchmarks adding, looking up and removing functions of a manager holding ten thousand of them, and definitions hitting or missing the parse cache
+*/
+void rbn_ManagerBench(void);
+
+/**
+  @brief Benchmarks sampling a dozen functions per frame, and one function cut into chunks, on the calling thread against spreading them over a thread pool
+*/
+void rbn_SamplingBench(void);
+
+/**
+  @brief Benchmarks lexing, parsing, evaluating and sampling a fixed corpus (polynomials, nested trig, piecewise, long generated expressions) per viewport width, and sampling all of it for a frame
+*/
+void rbn_PipelineBench(void);
+
+#endif // BENCH_H
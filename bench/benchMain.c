@@ -0,0 +1,123 @@
+#include "bench.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// a regression is a result this much slower than its baseline unless --threshold says otherwise
+#define RBN_DEFAULT_THRESHOLD_PCT 10.0
+
+struct rbn_suite_t {
+  const char *name;
+  void (*run)(void);
+};
+
+static const struct rbn_suite_t suites[] = {
+  {"evaluator", rbn_EvaluatorBench},
+  {"manager", rbn_ManagerBench},
+  {"sampling", rbn_SamplingBench},
+  {"pipeline", rbn_PipelineBench},
+};
+#define SUITE_COUNT (sizeof(suites) / sizeof(suites[0]))
+
+double rbn_NowNs(void){
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void rbn_PrintUsage(const char *program){
+  printf("usage: %s [options]\n", program);
+  printf("  --suite NAME       run only this suite (evaluator, manager, sampling, pipeline), repeatable, all by default\n");
+  printf("  --json FILE        write the results as JSON to FILE\n");
+  printf("  --compare FILE     compare the results against a JSON report saved earlier, exits with 1 on regressions\n");
+  printf("  --threshold PCT    slowdown counted as a regression by --compare (default %.0f)\n", RBN_DEFAULT_THRESHOLD_PCT);
+  printf("  -h, --help         show this help\n");
+}
+
+int main(int argc, char **argv){
+  // the results go to stdout, debug lines from the code under test would land in the timed loops
+  rl_SetLogOutput(stderr, RL_WARNING);
+
+  const char *jsonPath = nullptr;
+  const char *baselinePath = nullptr;
+  double threshold = RBN_DEFAULT_THRESHOLD_PCT;
+  bool selected[SUITE_COUNT] = {0};
+  bool anySelected = false;
+
+  for (int i = 1; i < argc; ++i){
+    const char *option = argv[i];
+    if (strcmp(option, "-h") == 0 || strcmp(option, "--help") == 0){
+      rbn_PrintUsage(argv[0]);
+      return 0;
+    }
+    else if (i + 1 >= argc || strncmp(option, "--", 2) != 0){
+      fprintf(stderr, "Unknown option or missing value: %s\n", option);
+      rbn_PrintUsage(argv[0]);
+      return 2;
+    }
+
+    const char *value = argv[++i];
+    if (strcmp(option, "--json") == 0){
+      jsonPath = value;
+    }
+    else if (strcmp(option, "--compare") == 0){
+      baselinePath = value;
+    }
+    else if (strcmp(option, "--threshold") == 0){
+      char *end;
+      threshold = strtod(value, &end);
+      if (end == value || *end != '\0' || threshold < 0.0){
+        fprintf(stderr, "Invalid threshold: %s\n", value);
+        return 2;
+      }
+    }
+    else if (strcmp(option, "--suite") == 0){
+      size_t s = 0;
+      while (s < SUITE_COUNT && strcmp(suites[s].name, value) != 0) s++;
+      if (s == SUITE_COUNT){
+        fprintf(stderr, "Unknown suite: %s\n", value);
+        return 2;
+      }
+      selected[s] = true;
+      anySelected = true;
+    }
+    else {
+      fprintf(stderr, "Unknown option: %s\n", option);
+      rbn_PrintUsage(argv[0]);
+      return 2;
+    }
+  }
+
+  for (size_t s = 0; s < SUITE_COUNT; ++s){
+    if (anySelected == false || selected[s] == true) suites[s].run();
+  }
+
+  int status = 0;
+  if (rbn_FailureCount() > 0){
+    fprintf(stderr, "%d checks failed.\n", rbn_FailureCount());
+    status = 1;
+  }
+
+  if (jsonPath != nullptr && rbn_WriteJson(jsonPath) != ERR_SUCCESS){
+    rl_LogLastError(RL_ERROR);
+    status = 1;
+  }
+
+  if (baselinePath != nullptr){
+    int regressions = 0;
+    if (rbn_CompareBaseline(baselinePath, threshold / 100.0, &regressions) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      status = 1;
+    }
+    else if (regressions > 0){
+      status = 1;
+    }
+  }
+
+  rbn_ReleaseResults();
+  return status;
+}
@@ -0,0 +1,292 @@
+#include "bench.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+#include "core/threadPool.h"
+#include "expressionEngine/batchKernels.h"
+#include "expressionEngine/jit.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RBN_GROUP_LEN 24
+#define RBN_NAME_LEN  128
+
+struct rbn_result_t {
+  char group[RBN_GROUP_LEN];    /**< Benchmark group (evaluator, lexer, sampler, ...) */
+  char name[RBN_NAME_LEN];      /**< What was measured, unique within its group */
+  double nsPerOp;               /**< Nanoseconds per operation */
+  size_t iterations;            /**< Operations the time was averaged over */
+};
+
+// every result reported so far, in order
+static struct rbn_result_t *results = nullptr;
+static size_t resultCount = 0;
+static size_t resultCapacity = 0;
+
+// checks failed so far, any of them fails the whole run
+static int failureCount = 0;
+
+void rbn_Report(const char *group, const char *name, double nsPerOp, size_t iterations){
+  printf("%-12s %-64s %10.2f ns/op  (%zu iterations)\n", group, name, nsPerOp, iterations);
+
+  if (resultCount == resultCapacity){
+    const size_t capacity = (resultCapacity > 0) ? resultCapacity * 2 : 256;
+    struct rbn_result_t *grown = realloc(results, capacity * sizeof *grown);
+    if (grown == nullptr){
+      rl_LogMsg(RL_WARNING, "Failed to keep the result of %s %s for the report.", group, name);
+      return;
+    }
+    results = grown;
+    resultCapacity = capacity;
+  }
+
+  struct rbn_result_t *result = &results[resultCount++];
+  snprintf(result->group, sizeof(result->group), "%s", group);
+  snprintf(result->name, sizeof(result->name), "%s", name);
+  result->nsPerOp = nsPerOp;
+  result->iterations = iterations;
+}
+
+void rbn_ReportFailure(const char *group, const char *name, const char *reason){
+  printf("%-12s %-64s FAILED: %s\n", group, name, reason);
+  failureCount++;
+}
+
+int rbn_FailureCount(void){
+  return failureCount;
+}
+
+void rbn_ReleaseResults(void){
+  free(results);
+  results = nullptr;
+  resultCount = 0;
+  resultCapacity = 0;
+}
+
+static void rbn_WriteJsonString(FILE *file, const char *text){
+  fputc('"', file);
+  for (const unsigned char *c = (const unsigned char*)text; *c != '\0'; ++c){
+    if (*c == '"' || *c == '\\') fprintf(file, "\\%c", *c);
+    else if (*c < 0x20) fprintf(file, "\\u%04x", *c);
+    else fputc(*c, file);
+  }
+  fputc('"', file);
+}
+
+enum reh_error_code_e rbn_WriteJson(const char *path){
+  if (path == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Path passed to rbn_WriteJson is NULL.");
+  }
+
+  FILE *file = fopen(path, "w");
+  if (file == nullptr){
+    SET_ERROR_RETURN(ERR_FILE_WRITE_FAILED, "Failed to open %s for writing: %s", path, strerror(errno));
+  }
+
+  // the machine description tells whether two reports can be compared at all
+  fprintf(file, "{\n  \"format\": \"equafun-bench\",\n  \"version\": %d,\n", RBN_JSON_VERSION);
+  fprintf(file, "  \"batch_kernels\": \"%s\",\n", ree_KernelIsaToStr(ree_GetBatchKernels()->isa));
+  fprintf(file, "  \"jit\": %s,\n", ree_JitIsSupported() ? "true" : "false");
+  fprintf(file, "  \"hardware_threads\": %d,\n", rtp_HardwareThreadCount());
+  fprintf(file, "  \"results\": [\n");
+  for (size_t i = 0; i < resultCount; ++i){
+    fprintf(file, "    {\"group\": ");
+    rbn_WriteJsonString(file, results[i].group);
+    fprintf(file, ", \"name\": ");
+    rbn_WriteJsonString(file, results[i].name);
+    fprintf(file, ", \"ns_per_op\": %.4f, \"iterations\": %zu}%s\n", results[i].nsPerOp, results[i].iterations, (i + 1 < resultCount) ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+
+  const bool failed = ferror(file) != 0;
+  if (fclose(file) != 0 || failed){
+    SET_ERROR_RETURN(ERR_FILE_WRITE_FAILED, "Failed to write the report to %s.", path);
+  }
+
+  return ERR_SUCCESS;
+}
+
+static enum reh_error_code_e rbn_ReadFile(const char *path, char **text){
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr){
+    SET_ERROR_RETURN(ERR_FILE_NOT_FOUND, "Failed to open the baseline %s: %s", path, strerror(errno));
+  }
+
+  size_t length = 0;
+  size_t capacity = 1 << 16;
+  char *buffer = malloc(capacity);
+  while (buffer != nullptr){
+    length += fread(buffer + length, 1, capacity - 1 - length, file);
+    if (length < capacity - 1) break;
+
+    char *grown = realloc(buffer, capacity * 2);
+    if (grown == nullptr){
+      free(buffer);
+      buffer = nullptr;
+      break;
+    }
+    buffer = grown;
+    capacity *= 2;
+  }
+
+  const bool failed = ferror(file) != 0;
+  fclose(file);
+  if (buffer == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the baseline buffer.");
+  }
+  else if (failed){
+    free(buffer);
+    SET_ERROR_RETURN(ERR_FILE_READ_FAILED, "Failed to read the baseline %s.", path);
+  }
+
+  buffer[length] = '\0';
+  *text = buffer;
+  return ERR_SUCCESS;
+}
+
+// finds "key": inside [start, end) and returns the first character of its value, nullptr if the object has no such key
+static const char* rbn_FindJsonValue(const char *start, const char *end, const char *key){
+  const size_t keyLength = strlen(key);
+  for (const char *c = start; c + keyLength + 2 < end; ++c){
+    if (c[0] != '"' || strncmp(c + 1, key, keyLength) != 0 || c[keyLength + 1] != '"') continue;
+
+    const char *value = c + keyLength + 2;
+    while (value < end && (*value == ' ' || *value == '\t' || *value == '\n' || *value == '\r')) ++value;
+    if (value == end || *value != ':') continue;
+    ++value;
+    while (value < end && (*value == ' ' || *value == '\t' || *value == '\n' || *value == '\r')) ++value;
+    return value;
+  }
+  return nullptr;
+}
+
+// copies the JSON string starting at value (its opening quote) into out, only the escapes rbn_WriteJson produces are understood
+static bool rbn_ReadJsonString(const char *value, const char *end, char *out, size_t size){
+  if (value == nullptr || value >= end || *value != '"') return false;
+
+  size_t length = 0;
+  for (const char *c = value + 1; c < end; ++c){
+    if (*c == '"'){
+      out[length] = '\0';
+      return true;
+    }
+
+    char decoded = *c;
+    if (*c == '\\' && c + 1 < end){
+      ++c;
+      if (*c == 'u' && c + 4 < end){
+        decoded = (char)strtol((char[]){c[1], c[2], c[3], c[4], '\0'}, nullptr, 16);
+        c += 4;
+      }
+      else if (*c == 'n') decoded = '\n';
+      else if (*c == 't') decoded = '\t';
+      else decoded = *c;
+    }
+    if (length + 1 < size) out[length++] = decoded;
+  }
+  return false;
+}
+
+static const struct rbn_result_t* rbn_FindBaseline(const struct rbn_result_t *baseline, size_t baselineCount, const struct rbn_result_t *result){
+  for (size_t i = 0; i < baselineCount; ++i){
+    if (strcmp(baseline[i].group, result->group) == 0 && strcmp(baseline[i].name, result->name) == 0){
+      return &baseline[i];
+    }
+  }
+  return nullptr;
+}
+
+// parses the results array of a report, one object per result
+static enum reh_error_code_e rbn_ParseBaseline(const char *text, struct rbn_result_t **baseline, size_t *baselineCount){
+  const char *end = text + strlen(text);
+  const char *array = rbn_FindJsonValue(text, end, "results");
+  if (array == nullptr || *array != '['){
+    SET_ERROR_RETURN(ERR_FILE_INVALID_FORMAT, "The baseline has no results array.");
+  }
+
+  size_t capacity = 0;
+  *baseline = nullptr;
+  *baselineCount = 0;
+  for (const char *object = strchr(array, '{'); object != nullptr; object = strchr(object, '{')){
+    const char *objectEnd = strchr(object, '}');
+    if (objectEnd == nullptr) break;
+
+    struct rbn_result_t entry = {0};
+    const char *ns = rbn_FindJsonValue(object, objectEnd, "ns_per_op");
+    if (rbn_ReadJsonString(rbn_FindJsonValue(object, objectEnd, "group"), objectEnd, entry.group, sizeof(entry.group)) == false ||
+        rbn_ReadJsonString(rbn_FindJsonValue(object, objectEnd, "name"), objectEnd, entry.name, sizeof(entry.name)) == false || ns == nullptr){
+      free(*baseline);
+      SET_ERROR_RETURN(ERR_FILE_INVALID_FORMAT, "Baseline result %zu lacks a group, name or ns_per_op.", *baselineCount);
+    }
+    entry.nsPerOp = strtod(ns, nullptr);
+
+    if (*baselineCount == capacity){
+      capacity = (capacity > 0) ? capacity * 2 : 256;
+      struct rbn_result_t *grown = realloc(*baseline, capacity * sizeof *grown);
+      if (grown == nullptr){
+        free(*baseline);
+        SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the baseline results.");
+      }
+      *baseline = grown;
+    }
+    (*baseline)[(*baselineCount)++] = entry;
+    object = objectEnd + 1;
+  }
+
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e rbn_CompareBaseline(const char *path, double threshold, int *regressions){
+  if (path == nullptr || regressions == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Path or regressions passed to rbn_CompareBaseline are NULL.");
+  }
+
+  char *text;
+  CHECK_ERROR_CTX(rbn_ReadFile(path, &text), "Failed to read the baseline.");
+
+  struct rbn_result_t *baseline;
+  size_t baselineCount;
+  enum reh_error_code_e err = rbn_ParseBaseline(text, &baseline, &baselineCount);
+  if (err != ERR_SUCCESS){
+    free(text);
+    CHECK_ERROR_CTX(err, "Failed to parse the baseline %s.", path);
+  }
+
+  // results of other kernels or without a JIT aren't comparable, say so instead of flagging every line
+  const char *end = text + strlen(text);
+  char isa[32];
+  if (rbn_ReadJsonString(rbn_FindJsonValue(text, end, "batch_kernels"), end, isa, sizeof(isa)) == true && strcmp(isa, ree_KernelIsaToStr(ree_GetBatchKernels()->isa)) != 0){
+    printf("warning: the baseline ran on %s batch kernels, this run on %s\n", isa, ree_KernelIsaToStr(ree_GetBatchKernels()->isa));
+  }
+  free(text);
+
+  printf("\ncomparison against %s (regression above +%.0f%%)\n", path, threshold * 100.0);
+  int improved = 0;
+  int missing = 0;
+  *regressions = 0;
+  for (size_t i = 0; i < resultCount; ++i){
+    const struct rbn_result_t *previous = rbn_FindBaseline(baseline, baselineCount, &results[i]);
+    if (previous == nullptr || previous->nsPerOp <= 0.0){
+      missing++;
+      continue;
+    }
+
+    const double change = results[i].nsPerOp / previous->nsPerOp - 1.0;
+    const char *verdict = "";
+    if (change > threshold){
+      verdict = "REGRESSION";
+      (*regressions)++;
+    }
+    else if (change < -threshold){
+      verdict = "improved";
+      improved++;
+    }
+    printf("%-12s %-64s %10.2f -> %10.2f ns/op %+7.1f%% %s\n", results[i].group, results[i].name, previous->nsPerOp, results[i].nsPerOp, change * 100.0, verdict);
+  }
+  printf("%zu compared, %d regressions, %d improved, %d without a baseline\n", resultCount - (size_t)missing, *regressions, improved, missing);
+
+  free(baseline);
+  return ERR_SUCCESS;
+}
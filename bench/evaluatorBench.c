@@ -0,0 +1,826 @@
+#include "bench.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+#include "expressionEngine/batchKernels.h"
+#include "expressionEngine/evaluator.h"
+#include "expressionEngine/functionManager.h"
+#include "expressionEngine/jit.h"
+#include "expressionEngine/mathKernels.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define EVAL_BENCH_SAMPLES 200000
+#define EVAL_BENCH_BATCH   1024
+
+// expressions are chosen to stay inside their domain on [-10, 10] so no error path is benchmarked
+static char *evaluatorCorpus[] = {
+  "f(x) = x",
+  "f(x) = 3x^2 - 2x + 1",
+  "f(x) = sin(x) * cos(x) + abs(x)",
+  "f(x) = sin(cos(sin(x))) + cos(sin(cos(x)))",
+  "f(x) = x^5 - 4x^4 + 3x^3 - 2x^2 + x - 7",
+  "f(x) = sqrt(abs(x)) + ln(x^2 + 1) - log(abs(x) + 1)",
+  "f(x) = sin(x)^2 + cos(x)*sin(x) + sin(x) - cos(x)^2",
+};
+static const int evaluatorCorpusLength = sizeof(evaluatorCorpus) / sizeof(evaluatorCorpus[0]);
+
+// undefined on half of [-10, 10], benchmarks how domain failures are reported
+static char *domainCorpus[] = {
+  "f(x) = ln(x)",
+  "f(x) = sqrt(x) + log(x)",
+};
+static const int domainCorpusLength = sizeof(domainCorpus) / sizeof(domainCorpus[0]);
+
+// erroring mode (formatted reh_SetError per undefined sample, cleared by the caller) against status bytes
+static void rbn_DomainFailureBench(void){
+  volatile float sink = 0.0f;
+
+  for (int i = 0; i < domainCorpusLength; ++i){
+    struct ree_function_manager_t manager;
+    ree_InitFunctionManager(&manager);
+
+    if (ree_AddFunction(&manager, domainCorpus[i], &functionColorArray[0]) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      ree_DestroyFunctionManager(&manager);
+      continue;
+    }
+    struct ree_function_t *function = &manager.functions[0];
+
+    const float step = 20.0f / EVAL_BENCH_SAMPLES;
+
+    double start = rbn_NowNs();
+    for (size_t s = 0; s < EVAL_BENCH_SAMPLES; ++s){
+      float y = 0.0f;
+      float variables[] = {-10.0f + (float)s * step};
+      if (ree_EvaluateProgram(&function->program, variables, &y) != ERR_SUCCESS){
+        reh_ClearError();
+        continue;
+      }
+      sink += y;
+    }
+    double erroringNs = (rbn_NowNs() - start) / EVAL_BENCH_SAMPLES;
+
+    start = rbn_NowNs();
+    for (size_t s = 0; s < EVAL_BENCH_SAMPLES; ++s){
+      float y = 0.0f;
+      uint8_t status;
+      float variables[] = {-10.0f + (float)s * step};
+      ree_EvaluateProgramStatus(&function->program, variables, &y, &status);
+      if (status != REE_EVAL_OK) continue;
+      sink += y;
+    }
+    double statusNs = (rbn_NowNs() - start) / EVAL_BENCH_SAMPLES;
+
+    char name[128];
+    snprintf(name, sizeof(name), "erroring %s", domainCorpus[i]);
+    rbn_Report("domain", name, erroringNs, EVAL_BENCH_SAMPLES);
+    snprintf(name, sizeof(name), "status   %s", domainCorpus[i]);
+    rbn_Report("domain", name, statusNs, EVAL_BENCH_SAMPLES);
+    printf("%-12s speedup: status %.2fx\n", "", erroringNs / statusNs);
+
+    ree_DestroyFunctionManager(&manager);
+  }
+
+  (void)sink;
+}
+
+#define PRECISION_BENCH_SAMPLES 4096
+
+// (x - 1)^3 expanded, cancels catastrophically around x = 1 so the tiers differ visibly when zoomed in there
+static char *precisionCorpus[] = {
+  "f(x) = x^3 - 3x^2 + 3x - 1",
+  "f(x) = sin(x) * cos(x) + sqrt(abs(x))",
+};
+static const int precisionCorpusLength = sizeof(precisionCorpus) / sizeof(precisionCorpus[0]);
+
+// cost of every precision tier per sample, and its error against double-double in a deep zoom
+static void rbn_PrecisionBench(void){
+  static double xs[PRECISION_BENCH_SAMPLES];
+  static double ys[PRECISION_BENCH_SAMPLES];
+  static double reference[PRECISION_BENCH_SAMPLES];
+  static uint8_t status[PRECISION_BENCH_SAMPLES];
+  const enum ree_precision_e tiers[] = {REE_PRECISION_FLOAT, REE_PRECISION_DOUBLE, REE_PRECISION_DOUBLE_DOUBLE};
+  const int tierCount = sizeof(tiers) / sizeof(tiers[0]);
+  volatile double sink = 0.0;
+
+  for (int i = 0; i < precisionCorpusLength; ++i){
+    struct ree_function_manager_t manager;
+    ree_InitFunctionManager(&manager);
+
+    if (ree_AddFunction(&manager, precisionCorpus[i], &functionColorArray[0]) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      ree_DestroyFunctionManager(&manager);
+      continue;
+    }
+    const struct ree_program_t *program = &manager.functions[0].program;
+
+    // zoomed into a window of 1e-9 right next to x = 1
+    const double zoomMin = 1.0 + 1e-6;
+    const double zoomStep = 1e-9 / PRECISION_BENCH_SAMPLES;
+    ree_SampleProgram(program, REE_PRECISION_DOUBLE_DOUBLE, REE_MATH_EXACT, zoomMin, zoomStep, PRECISION_BENCH_SAMPLES, xs, reference, status);
+
+    // errors are relative to how much the function moves inside the window, above 1 the curve is mostly noise
+    double referenceMin = reference[0];
+    double referenceMax = reference[0];
+    for (size_t s = 1; s < PRECISION_BENCH_SAMPLES; ++s){
+      referenceMin = fmin(referenceMin, reference[s]);
+      referenceMax = fmax(referenceMax, reference[s]);
+    }
+    const double referenceSpan = referenceMax - referenceMin;
+
+    for (int t = 0; t < tierCount; ++t){
+      const double step = 20.0 / PRECISION_BENCH_SAMPLES;
+      const size_t rounds = 50;
+
+      double start = rbn_NowNs();
+      for (size_t r = 0; r < rounds; ++r){
+        ree_SampleProgram(program, tiers[t], REE_MATH_EXACT, -10.0, step, PRECISION_BENCH_SAMPLES, xs, ys, status);
+        sink += ys[r];
+      }
+      double ns = (rbn_NowNs() - start) / (double)(PRECISION_BENCH_SAMPLES * rounds);
+
+      ree_SampleProgram(program, tiers[t], REE_MATH_EXACT, zoomMin, zoomStep, PRECISION_BENCH_SAMPLES, xs, ys, status);
+      double maxError = 0.0;
+      for (size_t s = 0; s < PRECISION_BENCH_SAMPLES; ++s){
+        double error = fabs(ys[s] - reference[s]);
+        if (error > maxError) maxError = error;
+      }
+
+      char name[128];
+      snprintf(name, sizeof(name), "%-13s %s", ree_PrecisionToStr(tiers[t]), precisionCorpus[i]);
+      rbn_Report("precision", name, ns, PRECISION_BENCH_SAMPLES * rounds);
+      printf("%-12s max error in a 1e-9 zoom at x = 1: %.3g of the visible y span\n", "", maxError / referenceSpan);
+    }
+
+    ree_DestroyFunctionManager(&manager);
+  }
+
+  (void)sink;
+}
+
+// checks the native code against the RPN evaluator on every sample (domain failures included), returns the mismatch count
+static size_t rbn_JitDifferential(struct ree_function_t *function, const float *xs, const float *ys, const uint8_t *status, size_t count){
+  size_t mismatches = 0;
+
+  for (size_t s = 0; s < count; ++s){
+    float y = 0.0f;
+    struct ree_variable_t variables[] = {{function->parameter, xs[s]}};
+    bool defined = ree_EvaluateRpn(function->rpn, (size_t)function->rpnCount, variables, 1, &y) == ERR_SUCCESS;
+    reh_ClearError();
+
+    // REE_BATCH_MAX_ULP is 0, so defined samples have to match bit for bit
+    if (defined != (status[s] == REE_EVAL_OK) || (defined && memcmp(&y, &ys[s], sizeof(float)) != 0)){
+      mismatches++;
+    }
+  }
+
+  return mismatches;
+}
+
+// native code against the interpreters, over both the valid and the domain failure corpus
+static void rbn_JitBench(void){
+  static float xs[EVAL_BENCH_SAMPLES];
+  static float ys[EVAL_BENCH_SAMPLES];
+  static uint8_t status[EVAL_BENCH_SAMPLES];
+  volatile float sink = 0.0f;
+
+  if (!ree_JitIsSupported()){
+    printf("%-12s no JIT backend on this platform, skipped\n", "jit");
+    return;
+  }
+
+  const float step = 20.0f / EVAL_BENCH_SAMPLES;
+  for (size_t s = 0; s < EVAL_BENCH_SAMPLES; ++s) xs[s] = -10.0f + (float)s * step;
+
+  for (int i = 0; i < evaluatorCorpusLength + domainCorpusLength; ++i){
+    char *definition = (i < evaluatorCorpusLength) ? evaluatorCorpus[i] : domainCorpus[i - evaluatorCorpusLength];
+    struct ree_function_manager_t manager;
+    ree_InitFunctionManager(&manager);
+
+    if (ree_AddFunction(&manager, definition, &functionColorArray[0]) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      ree_DestroyFunctionManager(&manager);
+      continue;
+    }
+    struct ree_function_t *function = &manager.functions[0];
+
+    // bytecode interpreter
+    double start = rbn_NowNs();
+    for (size_t s = 0; s < EVAL_BENCH_SAMPLES; ++s){
+      float y = 0.0f;
+      uint8_t sampleStatus;
+      ree_EvaluateProgramStatus(&function->program, &xs[s], &y, &sampleStatus);
+      sink += y;
+    }
+    double programNs = (rbn_NowNs() - start) / EVAL_BENCH_SAMPLES;
+
+    // batch evaluator, still interpreted
+    start = rbn_NowNs();
+    for (size_t s = 0; s < EVAL_BENCH_SAMPLES; s += EVAL_BENCH_BATCH){
+      size_t count = (EVAL_BENCH_SAMPLES - s < EVAL_BENCH_BATCH) ? EVAL_BENCH_SAMPLES - s : EVAL_BENCH_BATCH;
+      ree_EvaluateBatch(&function->program, xs + s, count, ys + s, status + s);
+      sink += ys[s];
+    }
+    double batchNs = (rbn_NowNs() - start) / EVAL_BENCH_SAMPLES;
+
+    if (ree_JitCompile(&function->program, REE_MATH_EXACT) != ERR_SUCCESS){
+      rl_LogLastError(RL_WARNING);
+      reh_ClearError();
+      ree_DestroyFunctionManager(&manager);
+      continue;
+    }
+
+    // same batches, ree_EvaluateBatch now runs the native code
+    start = rbn_NowNs();
+    for (size_t s = 0; s < EVAL_BENCH_SAMPLES; s += EVAL_BENCH_BATCH){
+      size_t count = (EVAL_BENCH_SAMPLES - s < EVAL_BENCH_BATCH) ? EVAL_BENCH_SAMPLES - s : EVAL_BENCH_BATCH;
+      ree_EvaluateBatch(&function->program, xs + s, count, ys + s, status + s);
+      sink += ys[s];
+    }
+    double jitNs = (rbn_NowNs() - start) / EVAL_BENCH_SAMPLES;
+
+    size_t mismatches = rbn_JitDifferential(function, xs, ys, status, EVAL_BENCH_SAMPLES);
+
+    char name[128];
+    snprintf(name, sizeof(name), "bytecode %s", definition);
+    rbn_Report("jit", name, programNs, EVAL_BENCH_SAMPLES);
+    snprintf(name, sizeof(name), "batch    %s", definition);
+    rbn_Report("jit", name, batchNs, EVAL_BENCH_SAMPLES);
+    snprintf(name, sizeof(name), "native   %s", definition);
+    rbn_Report("jit", name, jitNs, EVAL_BENCH_SAMPLES);
+    printf("%-12s speedup: native %.2fx over bytecode, %.2fx over batch, %zu bytes of code, %zu mismatches against ree_EvaluateRpn\n", "",
+           programNs / jitNs, batchNs / jitNs, function->program.jit->codeSize, mismatches);
+
+    ree_DestroyFunctionManager(&manager);
+  }
+
+  (void)sink;
+}
+
+#define INTERVAL_BENCH_CHUNK 1024
+
+// expensive and mostly far above a [-5, 5] viewport, or with poles the sampler has to find between samples
+static char *intervalCorpus[] = {
+  "f(x) = sin(sin(sin(x))) * 100 + 200",
+  "f(x) = x^6 - 3x^4 + x",
+  "f(x) = tan(x)",
+  "f(x) = 1 / (x^2 - 2)",
+};
+static const int intervalCorpusLength = sizeof(intervalCorpus) / sizeof(intervalCorpus[0]);
+
+// cost of bounding a chunk of samples against evaluating it, and how many chunks of [-10, 10] are provably offscreen
+static void rbn_IntervalBench(void){
+  static float xs[EVAL_BENCH_SAMPLES];
+  static float ys[EVAL_BENCH_SAMPLES];
+  static uint8_t status[EVAL_BENCH_SAMPLES];
+  const double viewMin = -5.0;
+  const double viewMax = 5.0;
+  const float step = 20.0f / EVAL_BENCH_SAMPLES;
+  const size_t chunkCount = EVAL_BENCH_SAMPLES / INTERVAL_BENCH_CHUNK;
+  const size_t sampleCount = chunkCount * INTERVAL_BENCH_CHUNK;
+  volatile float sink = 0.0f;
+
+  for (size_t s = 0; s < EVAL_BENCH_SAMPLES; ++s) xs[s] = -10.0f + (float)s * step;
+
+  for (int i = 0; i < intervalCorpusLength; ++i){
+    struct ree_function_manager_t manager;
+    ree_InitFunctionManager(&manager);
+
+    if (ree_AddFunction(&manager, intervalCorpus[i], &functionColorArray[0]) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      ree_DestroyFunctionManager(&manager);
+      continue;
+    }
+    const struct ree_program_t *program = &manager.functions[0].program;
+
+    // every sample through the batch evaluator
+    double start = rbn_NowNs();
+    ree_EvaluateBatch(program, xs, sampleCount, ys, status);
+    sink += ys[0];
+    double batchNs = (rbn_NowNs() - start) / (double)sampleCount;
+
+    // one interval per chunk, only chunks that may be visible or undefined are evaluated
+    size_t culled = 0;
+    size_t undefined = 0;
+    start = rbn_NowNs();
+    for (size_t c = 0; c < chunkCount; ++c){
+      const size_t first = c * INTERVAL_BENCH_CHUNK;
+      struct rm_interval_t x = {(double)xs[first], (double)xs[first + INTERVAL_BENCH_CHUNK - 1]};
+      struct rm_interval_t y;
+      bool mayBeUndefined;
+      ree_EvaluateInterval(program, x, &y, &mayBeUndefined);
+
+      if (mayBeUndefined){
+        undefined++;
+      }
+      else if (y.hi < viewMin || y.lo > viewMax){
+        culled++;
+        continue;
+      }
+      ree_EvaluateBatch(program, xs + first, INTERVAL_BENCH_CHUNK, ys + first, status + first);
+      sink += ys[first];
+    }
+    double culledNs = (rbn_NowNs() - start) / (double)sampleCount;
+
+    char name[128];
+    snprintf(name, sizeof(name), "batch    %s", intervalCorpus[i]);
+    rbn_Report("interval", name, batchNs, sampleCount);
+    snprintf(name, sizeof(name), "culled   %s", intervalCorpus[i]);
+    rbn_Report("interval", name, culledNs, sampleCount);
+    printf("%-12s speedup: culled %.2fx, %zu of %zu chunks provably offscreen, %zu may hold a pole or undefined point\n", "",
+           batchNs / culledNs, culled, chunkCount, undefined);
+
+    ree_DestroyFunctionManager(&manager);
+  }
+
+  (void)sink;
+}
+
+#define DERIVATIVE_BENCH_SAMPLES 4096
+
+static char *derivativeCorpus[] = {
+  "f(x) = sin(x) * cos(x) + sqrt(abs(x))",
+  "f(x) = x^3 - 3x^2 + 3x - 1",
+  "f(x) = ln(x^2 + 1) / (x^2 + 2)",
+};
+static const int derivativeCorpusLength = sizeof(derivativeCorpus) / sizeof(derivativeCorpus[0]);
+
+// central difference in double with a step small enough to stay far below float's error, used as the reference slope
+static double rbn_ReferenceDerivative(const struct ree_program_t *program, double x){
+  const double h = 1e-6 * fmax(1.0, fabs(x));
+  double left[] = {x - h};
+  double right[] = {x + h};
+  double yLeft, yRight;
+  uint8_t statusLeft, statusRight;
+  ree_EvaluateProgramDouble(program, left, &yLeft, &statusLeft);
+  ree_EvaluateProgramDouble(program, right, &yRight, &statusRight);
+  return (statusLeft == REE_EVAL_OK && statusRight == REE_EVAL_OK) ? (yRight - yLeft) / (2.0 * h) : (double)NAN;
+}
+
+// value and slope in one dual pass against two extra float evaluations for a central difference, and the slope error of both
+static void rbn_DerivativeBench(void){
+  static float xs[DERIVATIVE_BENCH_SAMPLES];
+  static float ys[DERIVATIVE_BENCH_SAMPLES];
+  static float derivatives[DERIVATIVE_BENCH_SAMPLES];
+  static float differences[DERIVATIVE_BENCH_SAMPLES];
+  static float left[DERIVATIVE_BENCH_SAMPLES];
+  static float right[DERIVATIVE_BENCH_SAMPLES];
+  static float yLeft[DERIVATIVE_BENCH_SAMPLES];
+  static float yRight[DERIVATIVE_BENCH_SAMPLES];
+  static uint8_t status[DERIVATIVE_BENCH_SAMPLES];
+  const float step = 20.0f / DERIVATIVE_BENCH_SAMPLES;
+  // optimal central difference step in float, cbrt(FLT_EPSILON) scaled by |x|
+  const float h = 4.9e-3f;
+  const size_t rounds = 50;
+  volatile float sink = 0.0f;
+
+  for (size_t s = 0; s < DERIVATIVE_BENCH_SAMPLES; ++s){
+    xs[s] = -10.0f + (float)s * step;
+    const float hs = h * fmaxf(1.0f, fabsf(xs[s]));
+    left[s] = xs[s] - hs;
+    right[s] = xs[s] + hs;
+  }
+
+  for (int i = 0; i < derivativeCorpusLength; ++i){
+    struct ree_function_manager_t manager;
+    ree_InitFunctionManager(&manager);
+
+    if (ree_AddFunction(&manager, derivativeCorpus[i], &functionColorArray[0]) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      ree_DestroyFunctionManager(&manager);
+      continue;
+    }
+    const struct ree_program_t *program = &manager.functions[0].program;
+
+    double start = rbn_NowNs();
+    for (size_t r = 0; r < rounds; ++r){
+      ree_EvaluateDualBatch(program, xs, DERIVATIVE_BENCH_SAMPLES, ys, derivatives, status);
+      sink += derivatives[r];
+    }
+    double dualNs = (rbn_NowNs() - start) / (double)(DERIVATIVE_BENCH_SAMPLES * rounds);
+
+    // the values come from the batch evaluator as the sampler does it, the slopes from two more batches
+    start = rbn_NowNs();
+    for (size_t r = 0; r < rounds; ++r){
+      ree_EvaluateBatch(program, xs, DERIVATIVE_BENCH_SAMPLES, ys, status);
+      ree_EvaluateBatch(program, left, DERIVATIVE_BENCH_SAMPLES, yLeft, status);
+      ree_EvaluateBatch(program, right, DERIVATIVE_BENCH_SAMPLES, yRight, status);
+      for (size_t s = 0; s < DERIVATIVE_BENCH_SAMPLES; ++s) differences[s] = (yRight[s] - yLeft[s]) / (right[s] - left[s]);
+      sink += differences[r];
+    }
+    double differenceNs = (rbn_NowNs() - start) / (double)(DERIVATIVE_BENCH_SAMPLES * rounds);
+
+    // relative to the largest slope so that errors near roots of f' don't dominate
+    ree_EvaluateDualBatch(program, xs, DERIVATIVE_BENCH_SAMPLES, ys, derivatives, status);
+    double maxSlope = 0.0;
+    double dualError = 0.0;
+    double differenceError = 0.0;
+    for (size_t s = 0; s < DERIVATIVE_BENCH_SAMPLES; ++s){
+      double reference = rbn_ReferenceDerivative(program, (double)xs[s]);
+      if (status[s] != REE_EVAL_OK || !isfinite(reference) || !isfinite(differences[s])) continue;
+      maxSlope = fmax(maxSlope, fabs(reference));
+      dualError = fmax(dualError, fabs((double)derivatives[s] - reference));
+      differenceError = fmax(differenceError, fabs((double)differences[s] - reference));
+    }
+
+    char name[128];
+    snprintf(name, sizeof(name), "dual       %s", derivativeCorpus[i]);
+    rbn_Report("derivative", name, dualNs, DERIVATIVE_BENCH_SAMPLES * rounds);
+    snprintf(name, sizeof(name), "difference %s", derivativeCorpus[i]);
+    rbn_Report("derivative", name, differenceNs, DERIVATIVE_BENCH_SAMPLES * rounds);
+    printf("%-12s speedup: dual %.2fx, max slope error: dual %.3g, difference %.3g of the largest slope\n", "",
+           differenceNs / dualNs, dualError / maxSlope, differenceError / maxSlope);
+
+    ree_DestroyFunctionManager(&manager);
+  }
+
+  (void)sink;
+}
+
+#define KERNEL_BENCH_SAMPLES 16384
+
+enum rbn_math_kernel_e {
+  RBN_KERNEL_SIN = 0,
+  RBN_KERNEL_COS,
+  RBN_KERNEL_TAN,
+  RBN_KERNEL_EXP,
+  RBN_KERNEL_LN,
+  RBN_KERNEL_LOG10,
+  RBN_KERNEL_POW,
+  RBN_KERNEL_COUNT,
+};
+
+static const char *kernelNames[RBN_KERNEL_COUNT] = {"sin", "cos", "tan", "exp", "ln", "log10", "pow"};
+
+// trig-heavy functions sampled in every math mode
+static char *mathModeCorpus[] = {
+  "f(x) = sin(x) * cos(x) + abs(x)",
+  "f(x) = sin(cos(sin(x))) + cos(sin(cos(x)))",
+  "f(x) = ln(x^2 + 1) + x^3 - tan(x / 7)",
+};
+static const int mathModeCorpusLength = sizeof(mathModeCorpus) / sizeof(mathModeCorpus[0]);
+
+// inputs spread over the range a plot usually sees, logarithms get several decades and pow mixes integer and real exponents
+static void rbn_FillKernelInput(enum rbn_math_kernel_e kernel, float *a, float *b, size_t count){
+  for (size_t s = 0; s < count; ++s){
+    const double t = (double)s / (double)(count - 1);
+    switch (kernel){
+      case RBN_KERNEL_EXP:   a[s] = (float)(-80.0 + 160.0 * t); break;
+      case RBN_KERNEL_LN:
+      case RBN_KERNEL_LOG10: a[s] = (float)pow(10.0, -6.0 + 12.0 * t); break;
+      case RBN_KERNEL_POW:
+        a[s] = (float)(0.1 + 9.9 * t);
+        b[s] = (s % 2 == 0) ? (float)((int)(s % 9) - 4) : (float)(-3.0 + 6.0 * t);
+        break;
+      default:               a[s] = (float)(-100.0 + 200.0 * t); break;
+    }
+  }
+}
+
+static void rbn_RunKernel(const struct ree_math_kernels_t *math, enum rbn_math_kernel_e kernel, float *a, const float *b, uint8_t *poles, size_t count){
+  switch (kernel){
+    case RBN_KERNEL_SIN:   math->sin(a, count); break;
+    case RBN_KERNEL_COS:   math->cos(a, count); break;
+    case RBN_KERNEL_TAN:   math->tan(a, poles, count); break;
+    case RBN_KERNEL_EXP:   math->exp(a, count); break;
+    case RBN_KERNEL_LN:    math->ln(a, count); break;
+    case RBN_KERNEL_LOG10: math->log10(a, count); break;
+    case RBN_KERNEL_POW:   math->pow(a, b, count); break;
+    default: break;
+  }
+}
+
+static double rbn_KernelReference(enum rbn_math_kernel_e kernel, float a, float b){
+  switch (kernel){
+    case RBN_KERNEL_SIN:   return sin((double)a);
+    case RBN_KERNEL_COS:   return cos((double)a);
+    case RBN_KERNEL_TAN:   return tan((double)a);
+    case RBN_KERNEL_EXP:   return exp((double)a);
+    case RBN_KERNEL_LN:    return log((double)a);
+    case RBN_KERNEL_LOG10: return log10((double)a);
+    case RBN_KERNEL_POW:   return pow((double)a, (double)b);
+    default:               return NAN;
+  }
+}
+
+// distance to the reference in units in the last place of the correctly rounded float
+static double rbn_UlpError(double reference, float value){
+  const float rounded = (float)reference;
+  if (!isfinite(rounded)) return 0.0;
+  int exponent;
+  frexp(fmax(fabs((double)rounded), (double)FLT_MIN), &exponent);
+  return fabs((double)value - reference) / ldexp(1.0, exponent - FLT_MANT_DIG);
+}
+
+// throughput of every kernel per mode and instruction set, with its worst ulp and relative error against double libm
+static void rbn_MathKernelBench(void){
+  static float input[KERNEL_BENCH_SAMPLES];
+  static float exponents[KERNEL_BENCH_SAMPLES];
+  static float output[KERNEL_BENCH_SAMPLES];
+  static uint8_t poles[KERNEL_BENCH_SAMPLES];
+  const enum ree_kernel_isa_e isas[] = {REE_ISA_SSE2, REE_ISA_AVX2};
+  const size_t rounds = 50;
+  volatile float sink = 0.0f;
+
+  for (int k = 0; k < RBN_KERNEL_COUNT; ++k){
+    const enum rbn_math_kernel_e kernel = (enum rbn_math_kernel_e)k;
+    rbn_FillKernelInput(kernel, input, exponents, KERNEL_BENCH_SAMPLES);
+
+    for (int m = REE_MATH_EXACT; m <= REE_MATH_DRAW; ++m){
+      for (size_t i = 0; i < sizeof(isas) / sizeof(isas[0]); ++i){
+        const struct ree_math_kernels_t *math = ree_GetMathKernelsForIsa((enum ree_math_mode_e)m, isas[i]);
+        // exact kernels are the same libm loop everywhere, unsupported instruction sets fall back to the portable kernels
+        if (math->isa != isas[i] && i > 0) continue;
+
+        double start = rbn_NowNs();
+        for (size_t r = 0; r < rounds; ++r){
+          memcpy(output, input, sizeof(output));
+          rbn_RunKernel(math, kernel, output, exponents, poles, KERNEL_BENCH_SAMPLES);
+          sink += output[r];
+        }
+        double ns = (rbn_NowNs() - start) / (double)(KERNEL_BENCH_SAMPLES * rounds);
+
+        // trig errors are relative to max(|f|, 1) like the draw bound, poles are skipped
+        double maxUlp = 0.0;
+        double maxError = 0.0;
+        for (size_t s = 0; s < KERNEL_BENCH_SAMPLES; ++s){
+          const double reference = rbn_KernelReference(kernel, input[s], exponents[s]);
+          if ((kernel == RBN_KERNEL_TAN && poles[s]) || !isfinite(reference)) continue;
+          const double scale = kernel <= RBN_KERNEL_TAN ? fmax(fabs(reference), 1.0) : fabs(reference);
+          maxUlp = fmax(maxUlp, rbn_UlpError(reference, output[s]));
+          if (scale > 0.0) maxError = fmax(maxError, fabs((double)output[s] - reference) / scale);
+        }
+
+        char name[128];
+        snprintf(name, sizeof(name), "%-5s %-5s %s", kernelNames[k], ree_MathModeToStr(math->mode), ree_KernelIsaToStr(math->isa));
+        rbn_Report("kernels", name, ns, KERNEL_BENCH_SAMPLES * rounds);
+        printf("%-12s max error: %.2f ulp, %.3g relative\n", "", maxUlp, maxError);
+
+        // the bounds the modes document, a build that rewrites the kernel arithmetic (-ffast-math) breaks them
+        char reason[128];
+        if (math->mode == REE_MATH_FAST && maxUlp > REE_MATH_FAST_MAX_ULP){
+          snprintf(reason, sizeof(reason), "max error %.2f ulp exceeds REE_MATH_FAST_MAX_ULP (%d)", maxUlp, REE_MATH_FAST_MAX_ULP);
+          rbn_ReportFailure("kernels", name, reason);
+        }
+        else if (math->mode == REE_MATH_DRAW && maxError > REE_MATH_DRAW_MAX_ERROR){
+          snprintf(reason, sizeof(reason), "max error %.3g relative exceeds REE_MATH_DRAW_MAX_ERROR (%.3g)", maxError, REE_MATH_DRAW_MAX_ERROR);
+          rbn_ReportFailure("kernels", name, reason);
+        }
+      }
+    }
+  }
+
+  // whole programs in the float tier, the way the renderer samples them
+  for (int i = 0; i < mathModeCorpusLength; ++i){
+    struct ree_function_manager_t manager;
+    ree_InitFunctionManager(&manager);
+
+    if (ree_AddFunction(&manager, mathModeCorpus[i], &functionColorArray[0]) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      ree_DestroyFunctionManager(&manager);
+      continue;
+    }
+    const struct ree_program_t *program = &manager.functions[0].program;
+    rbn_FillKernelInput(RBN_KERNEL_SIN, input, exponents, KERNEL_BENCH_SAMPLES);
+
+    double exactNs = 0.0;
+    for (int m = REE_MATH_EXACT; m <= REE_MATH_DRAW; ++m){
+      double start = rbn_NowNs();
+      for (size_t r = 0; r < rounds; ++r){
+        ree_EvaluateBatchMode(program, (enum ree_math_mode_e)m, input, KERNEL_BENCH_SAMPLES, output, poles);
+        sink += output[r];
+      }
+      double ns = (rbn_NowNs() - start) / (double)(KERNEL_BENCH_SAMPLES * rounds);
+      if (m == REE_MATH_EXACT) exactNs = ns;
+
+      char name[128];
+      snprintf(name, sizeof(name), "batch %-5s %s", ree_MathModeToStr((enum ree_math_mode_e)m), mathModeCorpus[i]);
+      rbn_Report("kernels", name, ns, KERNEL_BENCH_SAMPLES * rounds);
+      if (m != REE_MATH_EXACT) printf("%-12s speedup: %.2fx over exact\n", "", exactNs / ns);
+    }
+
+    ree_DestroyFunctionManager(&manager);
+  }
+
+  (void)sink;
+}
+
+// h calls f and g at five sites, f(g(x)) nests them and g(x) is called twice, which CSE merges only once it's inlined
+static char *compositionCorpus[] = {
+  "f(x) = x^2 + 1",
+  "g(x) = sin(x) * cos(x)",
+  "h(x) = f(x)^2 + g(2x) + f(g(x)) * g(x)",
+};
+static const int compositionCorpusLength = sizeof(compositionCorpus) / sizeof(compositionCorpus[0]);
+
+// the inlined caller against evaluating the callee once per call site and combining the results, as a nested call would
+static void rbn_CompositionBench(void){
+  struct ree_function_manager_t manager;
+  ree_InitFunctionManager(&manager);
+
+  for (int i = 0; i < compositionCorpusLength; ++i){
+    if (ree_AddFunction(&manager, compositionCorpus[i], &functionColorArray[0]) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      ree_DestroyFunctionManager(&manager);
+      return;
+    }
+  }
+  const struct ree_program_t *f = &manager.functions[0].program;
+  const struct ree_program_t *g = &manager.functions[1].program;
+  const struct ree_program_t *h = &manager.functions[2].program;
+
+  const float step = 20.0f / EVAL_BENCH_SAMPLES;
+  float xs[EVAL_BENCH_BATCH];
+  float doubled[EVAL_BENCH_BATCH];
+  float ys[EVAL_BENCH_BATCH];
+  float calls[5][EVAL_BENCH_BATCH];
+  uint8_t status[EVAL_BENCH_BATCH];
+  volatile float sink = 0.0f;
+  float maxError = 0.0f;
+  // read at runtime, a constant 2 would let the compiler turn the combining powf into a multiplication the evaluator doesn't do
+  volatile float two = 2.0f;
+  const float square = two;
+
+  double inlinedNs = 0.0;
+  double perCallNs = 0.0;
+  for (size_t s = 0; s < EVAL_BENCH_SAMPLES; s += EVAL_BENCH_BATCH){
+    size_t count = (EVAL_BENCH_SAMPLES - s < EVAL_BENCH_BATCH) ? EVAL_BENCH_SAMPLES - s : EVAL_BENCH_BATCH;
+    for (size_t j = 0; j < count; ++j){
+      xs[j] = -10.0f + (float)(s + j) * step;
+      doubled[j] = 2.0f * xs[j];
+    }
+
+    double start = rbn_NowNs();
+    ree_EvaluateBatch(h, xs, count, ys, status);
+    inlinedNs += rbn_NowNs() - start;
+
+    start = rbn_NowNs();
+    ree_EvaluateBatch(f, xs, count, calls[0], status);
+    ree_EvaluateBatch(g, doubled, count, calls[1], status);
+    ree_EvaluateBatch(g, xs, count, calls[2], status);
+    ree_EvaluateBatch(f, calls[2], count, calls[3], status);
+    ree_EvaluateBatch(g, xs, count, calls[4], status);
+    for (size_t j = 0; j < count; ++j) calls[0][j] = powf(calls[0][j], square) + calls[1][j] + calls[3][j] * calls[4][j];
+    perCallNs += rbn_NowNs() - start;
+
+    for (size_t j = 0; j < count; ++j) maxError = fmaxf(maxError, fabsf(ys[j] - calls[0][j]) / fmaxf(1.0f, fabsf(calls[0][j])));
+    sink += ys[0];
+  }
+  inlinedNs /= EVAL_BENCH_SAMPLES;
+  perCallNs /= EVAL_BENCH_SAMPLES;
+
+  char name[128];
+  snprintf(name, sizeof(name), "inlined  %s", compositionCorpus[2]);
+  rbn_Report("composition", name, inlinedNs, EVAL_BENCH_SAMPLES);
+  snprintf(name, sizeof(name), "per call %s", compositionCorpus[2]);
+  rbn_Report("composition", name, perCallNs, EVAL_BENCH_SAMPLES);
+  printf("%-12s speedup: inlined %.2fx, bytecode %d vs %d bytes over the call sites, max relative difference %.3g\n", "",
+         perCallNs / inlinedNs, h->codeSize, 2 * f->codeSize + 3 * g->codeSize, (double)maxError);
+
+  ree_DestroyFunctionManager(&manager);
+  (void)sink;
+}
+
+#define PARAMETER_BENCH_STEPS   200
+#define PARAMETER_BENCH_SAMPLES 2001
+
+// a slider on k moves two of the eight plotted functions, the rest don't read it
+static char *parameterCorpus[] = {
+  "f(x) = a sin(k x)",
+  "g(x) = x^3 - 2x",
+  "h(x) = sin(x) * cos(x) + abs(x)",
+  "p(x) = ln(x^2 + 1) + k",
+  "q(x) = sqrt(abs(x)) + ln(x^2 + 1)",
+  "r(x) = sin(cos(sin(x))) + cos(sin(cos(x)))",
+  "s(x) = x^5 - 4x^4 + 3x^3 - 2x^2 + x - 7",
+  "t(x) = a / (x^2 + 1)",
+};
+static const int parameterCorpusLength = sizeof(parameterCorpus) / sizeof(parameterCorpus[0]);
+
+// a parameter sweep resampling only the functions whose revision changed against resampling every function each step
+static void rbn_ParameterBench(void){
+  struct ree_function_manager_t manager;
+  ree_InitFunctionManager(&manager);
+
+  for (int i = 0; i < parameterCorpusLength; ++i){
+    if (ree_AddFunction(&manager, parameterCorpus[i], &functionColorArray[0]) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      ree_DestroyFunctionManager(&manager);
+      return;
+    }
+  }
+
+  static float xs[PARAMETER_BENCH_SAMPLES];
+  static float ys[sizeof(parameterCorpus) / sizeof(parameterCorpus[0])][PARAMETER_BENCH_SAMPLES];
+  static uint8_t status[PARAMETER_BENCH_SAMPLES];
+  uint32_t sampledRevision[sizeof(parameterCorpus) / sizeof(parameterCorpus[0])];
+  for (size_t j = 0; j < PARAMETER_BENCH_SAMPLES; ++j){
+    xs[j] = -10.0f + (float)j * 0.01f;
+  }
+
+  double ns[2] = {0.0, 0.0};
+  int resampled[2] = {0, 0};
+  for (int dependentsOnly = 0; dependentsOnly < 2; ++dependentsOnly){
+    for (int f = 0; f < manager.functionCount; ++f){
+      ree_EvaluateBatch(&manager.functions[f].program, xs, PARAMETER_BENCH_SAMPLES, ys[f], status);
+      sampledRevision[f] = manager.functions[f].revision;
+    }
+
+    double start = rbn_NowNs();
+    for (int step = 0; step < PARAMETER_BENCH_STEPS; ++step){
+      ree_SetParameter(&manager, "k", 0.5f + (float)step * 0.01f);
+      for (int f = 0; f < manager.functionCount; ++f){
+        if (dependentsOnly == 1 && manager.functions[f].revision == sampledRevision[f]) continue;
+
+        ree_EvaluateBatch(&manager.functions[f].program, xs, PARAMETER_BENCH_SAMPLES, ys[f], status);
+        sampledRevision[f] = manager.functions[f].revision;
+        resampled[dependentsOnly]++;
+      }
+    }
+    ns[dependentsOnly] = (rbn_NowNs() - start) / PARAMETER_BENCH_STEPS;
+  }
+
+  rbn_Report("parameters", "sweep k, resample every function", ns[0], PARAMETER_BENCH_STEPS);
+  rbn_Report("parameters", "sweep k, resample its dependents", ns[1], PARAMETER_BENCH_STEPS);
+  printf("%-12s speedup: dependents only %.2fx, %d vs %d functions sampled per step\n", "",
+         ns[0] / ns[1], resampled[1] / PARAMETER_BENCH_STEPS, resampled[0] / PARAMETER_BENCH_STEPS);
+
+  ree_DestroyFunctionManager(&manager);
+}
+
+void rbn_EvaluatorBench(void){
+  volatile float sink = 0.0f;
+
+  for (int i = 0; i < evaluatorCorpusLength; ++i){
+    struct ree_function_manager_t manager;
+    ree_InitFunctionManager(&manager);
+
+    if (ree_AddFunction(&manager, evaluatorCorpus[i], &functionColorArray[0]) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      ree_DestroyFunctionManager(&manager);
+      continue;
+    }
+    struct ree_function_t *function = &manager.functions[0];
+
+    const float step = 20.0f / EVAL_BENCH_SAMPLES;
+
+    // reference: string dispatch over the RPN, as the sampler used to call it
+    double start = rbn_NowNs();
+    for (size_t s = 0; s < EVAL_BENCH_SAMPLES; ++s){
+      float y = 0.0f;
+      struct ree_variable_t variables[] = {{function->parameter, -10.0f + (float)s * step}};
+      ree_EvaluateRpn(function->rpn, (size_t)function->rpnCount, variables, 1, &y);
+      sink += y;
+    }
+    double rpnNs = (rbn_NowNs() - start) / EVAL_BENCH_SAMPLES;
+
+    // bytecode interpreter
+    start = rbn_NowNs();
+    for (size_t s = 0; s < EVAL_BENCH_SAMPLES; ++s){
+      float y = 0.0f;
+      float variables[] = {-10.0f + (float)s * step};
+      ree_EvaluateProgram(&function->program, variables, &y);
+      sink += y;
+    }
+    double programNs = (rbn_NowNs() - start) / EVAL_BENCH_SAMPLES;
+
+    // batch evaluator, the way the sampler calls it
+    float xs[EVAL_BENCH_BATCH];
+    float ys[EVAL_BENCH_BATCH];
+    uint8_t status[EVAL_BENCH_BATCH];
+    start = rbn_NowNs();
+    for (size_t s = 0; s < EVAL_BENCH_SAMPLES; s += EVAL_BENCH_BATCH){
+      size_t count = (EVAL_BENCH_SAMPLES - s < EVAL_BENCH_BATCH) ? EVAL_BENCH_SAMPLES - s : EVAL_BENCH_BATCH;
+      for (size_t j = 0; j < count; ++j) xs[j] = -10.0f + (float)(s + j) * step;
+      ree_EvaluateBatch(&function->program, xs, count, ys, status);
+      sink += ys[0];
+    }
+    double batchNs = (rbn_NowNs() - start) / EVAL_BENCH_SAMPLES;
+
+    char name[128];
+    snprintf(name, sizeof(name), "rpn      %s", evaluatorCorpus[i]);
+    rbn_Report("evaluator", name, rpnNs, EVAL_BENCH_SAMPLES);
+    snprintf(name, sizeof(name), "bytecode %s", evaluatorCorpus[i]);
+    rbn_Report("evaluator", name, programNs, EVAL_BENCH_SAMPLES);
+    snprintf(name, sizeof(name), "batch    %s", evaluatorCorpus[i]);
+    rbn_Report("evaluator", name, batchNs, EVAL_BENCH_SAMPLES);
+    printf("%-12s speedup: bytecode %.2fx, batch (%s) %.2fx\n", "", rpnNs / programNs, ree_KernelIsaToStr(ree_GetBatchKernels()->isa), rpnNs / batchNs);
+
+    ree_DestroyFunctionManager(&manager);
+  }
+
+  rbn_DomainFailureBench();
+  rbn_PrecisionBench();
+  rbn_JitBench();
+  rbn_IntervalBench();
+  rbn_DerivativeBench();
+  rbn_MathKernelBench();
+  rbn_CompositionBench();
+  rbn_ParameterBench();
+
+  (void)sink;
+}
@@ -0,0 +1,167 @@
+#include "bench.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+#include "expressionEngine/functionManager.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MANAGER_BENCH_FUNCTIONS 10000
+#define MANAGER_BENCH_CALLERS   1000
+#define PARSE_CACHE_BENCH_DEFS  2000
+
+// q + three letters, none of them a built-in function or y
+static void rbn_FunctionName(int index, char *name){
+  name[0] = 'q';
+  name[1] = (char)('a' + index / (26 * 26) % 26);
+  name[2] = (char)('a' + index / 26 % 26);
+  name[3] = (char)('a' + index % 26);
+  name[4] = '\0';
+}
+
+// the linear strcmp scan lookups used to be, as a reference for the name index
+static struct ree_function_t* rbn_ScanForFunction(struct ree_function_manager_t *manager, const char *name){
+  for (int i = 0; i < manager->functionCount; ++i){
+    if (strcmp(manager->functions[i].name, name) == 0) return &manager->functions[i];
+  }
+  return nullptr;
+}
+
+// adds the same body under different names (parse cache hits) against bodies differing in a constant (misses)
+static void rbn_ParseCacheBench(void){
+  const char *body = "sin(x)^2 + cos(2x) / (1 + x^2) - 3x^3 + sqrt(x + 4) * abs(x - 1)";
+  double ns[2] = {0.0, 0.0};
+  struct ree_parse_cache_stats_t stats[2];
+  char name[8];
+  char definition[128];
+
+  for (int pass = 0; pass < 2; ++pass){
+    struct ree_function_manager_t manager;
+    if (ree_InitFunctionManager(&manager) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      return;
+    }
+
+    const double start = rbn_NowNs();
+    for (int i = 0; i < PARSE_CACHE_BENCH_DEFS; ++i){
+      rbn_FunctionName(i, name);
+      if (pass == 0){
+        snprintf(definition, sizeof(definition), "%s(x) = %s", name, body);
+      }
+      else {
+        snprintf(definition, sizeof(definition), "%s(x) = %s + %d", name, body, i);
+      }
+      if (ree_AddFunction(&manager, definition, &functionColorArray[0]) != ERR_SUCCESS){
+        rl_LogLastError(RL_ERROR);
+        ree_DestroyFunctionManager(&manager);
+        return;
+      }
+    }
+    ns[pass] = (rbn_NowNs() - start) / PARSE_CACHE_BENCH_DEFS;
+    ree_GetParseCacheStats(&manager.parseCache, &stats[pass]);
+
+    ree_DestroyFunctionManager(&manager);
+  }
+
+  rbn_Report("manager", "add, same body under every name (parse cache hits)", ns[0], PARSE_CACHE_BENCH_DEFS);
+  rbn_Report("manager", "add, distinct bodies (parse cache misses)", ns[1], PARSE_CACHE_BENCH_DEFS);
+  for (int pass = 0; pass < 2; ++pass){
+    printf("%-12s parse cache: %llu hits, %llu misses, %d entries\n", "", (unsigned long long)stats[pass].hits, (unsigned long long)stats[pass].misses, stats[pass].entryCount);
+  }
+}
+
+void rbn_ManagerBench(void){
+  struct ree_function_manager_t manager;
+  if (ree_InitFunctionManager(&manager) != ERR_SUCCESS){
+    rl_LogLastError(RL_ERROR);
+    return;
+  }
+
+  static char names[MANAGER_BENCH_FUNCTIONS][8];
+  static int order[MANAGER_BENCH_FUNCTIONS];
+  static struct ree_function_handle_t handles[MANAGER_BENCH_FUNCTIONS];
+  char definition[64];
+  for (int i = 0; i < MANAGER_BENCH_FUNCTIONS; ++i){
+    rbn_FunctionName(i, names[i]);
+    order[i] = i;
+  }
+
+  // removal in random order, so it isn't always the last function (xorshift keeps it reproducible)
+  uint32_t state = 2463534242u;
+  for (int i = MANAGER_BENCH_FUNCTIONS - 1; i > 0; --i){
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    const int j = (int)(state % (uint32_t)(i + 1));
+    const int swap = order[i];
+    order[i] = order[j];
+    order[j] = swap;
+  }
+
+  // the last ones call an earlier function, so parsing resolves calls through the index as well
+  double start = rbn_NowNs();
+  for (int i = 0; i < MANAGER_BENCH_FUNCTIONS; ++i){
+    if (i >= MANAGER_BENCH_FUNCTIONS - MANAGER_BENCH_CALLERS){
+      snprintf(definition, sizeof(definition), "%.7s(x) = %.7s(x) + 1", names[i], names[i - MANAGER_BENCH_CALLERS]);
+    }
+    else {
+      snprintf(definition, sizeof(definition), "%.7s(x) = x^2 + %d", names[i], i);
+    }
+    if (ree_AddFunction(&manager, definition, &functionColorArray[0]) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      ree_DestroyFunctionManager(&manager);
+      return;
+    }
+  }
+  const double addNs = (rbn_NowNs() - start) / MANAGER_BENCH_FUNCTIONS;
+
+  size_t found = 0;
+  start = rbn_NowNs();
+  for (int i = 0; i < MANAGER_BENCH_FUNCTIONS; ++i){
+    const struct ree_function_t *function = ree_GetFunction(&manager, names[order[i]]);
+    handles[order[i]] = function->handle;
+    found += (function != nullptr);
+  }
+  const double lookupNs = (rbn_NowNs() - start) / MANAGER_BENCH_FUNCTIONS;
+
+  start = rbn_NowNs();
+  for (int i = 0; i < MANAGER_BENCH_FUNCTIONS; ++i){
+    found += (ree_ResolveFunction(&manager, handles[order[i]]) != nullptr);
+  }
+  const double resolveNs = (rbn_NowNs() - start) / MANAGER_BENCH_FUNCTIONS;
+
+  start = rbn_NowNs();
+  for (int i = 0; i < MANAGER_BENCH_FUNCTIONS; ++i){
+    found += (rbn_ScanForFunction(&manager, names[order[i]]) != nullptr);
+  }
+  const double scanNs = (rbn_NowNs() - start) / MANAGER_BENCH_FUNCTIONS;
+
+  // a callee is refused while its caller is still there, those are removed in a second pass once the callers are gone
+  int attempts = 0;
+  int refused = 0;
+  start = rbn_NowNs();
+  for (int pass = 0; pass < 2; ++pass){
+    for (int i = 0; i < MANAGER_BENCH_FUNCTIONS; ++i){
+      if (ree_ResolveFunction(&manager, handles[order[i]]) == nullptr) continue;
+      refused += (ree_RemoveFunction(&manager, names[order[i]]) != ERR_SUCCESS);
+      attempts++;
+    }
+  }
+  const double removeNs = (rbn_NowNs() - start) / attempts;
+
+  char name[128];
+  snprintf(name, sizeof(name), "add %d functions (%d calling another)", MANAGER_BENCH_FUNCTIONS, MANAGER_BENCH_CALLERS);
+  rbn_Report("manager", name, addNs, MANAGER_BENCH_FUNCTIONS);
+  rbn_Report("manager", "lookup by name, hashed", lookupNs, MANAGER_BENCH_FUNCTIONS);
+  rbn_Report("manager", "lookup by name, linear scan", scanNs, MANAGER_BENCH_FUNCTIONS);
+  rbn_Report("manager", "resolve handle", resolveNs, MANAGER_BENCH_FUNCTIONS);
+  snprintf(name, sizeof(name), "remove in random order (%d refused while called)", refused);
+  rbn_Report("manager", name, removeNs, (size_t)attempts);
+  printf("%-12s %zu of %d lookups found, %d functions left\n", "", found, 3 * MANAGER_BENCH_FUNCTIONS, manager.functionCount);
+
+  ree_DestroyFunctionManager(&manager);
+
+  rbn_ParseCacheBench();
+}
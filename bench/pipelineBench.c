@@ -0,0 +1,406 @@
+#include "bench.h"
+#include "core/arena.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+#include "core/threadPool.h"
+#include "expressionEngine/evaluator.h"
+#include "expressionEngine/functionManager.h"
+#include "expressionEngine/jit.h"
+#include "expressionEngine/lexer.h"
+#include "expressionEngine/parser/functionParser.h"
+#include "expressionEngine/parser/shuntingYard.h"
+#include "renderer/functionSampler.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// work per measurement, in characters lexed, tokens parsed or RPN tokens evaluated, so long expressions don't run for ages
+#define PIPELINE_BENCH_LEX_CHARS    400000
+#define PIPELINE_BENCH_PARSE_TOKENS 100000
+#define PIPELINE_BENCH_RPN_TOKENS   2000000
+#define PIPELINE_BENCH_BATCH        1024
+
+// samples taken per width, at least one frame is always timed
+#define PIPELINE_BENCH_FRAME_SAMPLES 1000000
+
+// the renderer samples every 0.01 world units, the default viewport is 20 units high at a 4:3 aspect ratio
+#define PIPELINE_BENCH_STEP 0.01
+static const double viewportWidths[] = {20.0 * 4.0 / 3.0, 200.0, 2000.0};
+#define VIEWPORT_WIDTH_COUNT (sizeof(viewportWidths) / sizeof(viewportWidths[0]))
+
+// lengths (in terms) of the generated expressions
+static const int generatedTerms[] = {64, 256};
+#define GENERATED_COUNT (sizeof(generatedTerms) / sizeof(generatedTerms[0]))
+
+struct rbn_pipeline_entry_t {
+  const char *kind;         /**< Which part of the corpus the expression belongs to */
+  char *definition;         /**< Definition as the user would type it, heap allocated for the generated ones */
+};
+
+// there are no piecewise built-ins, abs kinks and domain gaps make the same branchy, partly undefined curves
+static struct rbn_pipeline_entry_t fixedCorpus[] = {
+  {"polynomial", "a(x) = 3x^2 - 2x + 1"},
+  {"polynomial", "b(x) = x^7 - 3x^6 + 5x^5 - x^4 + 2x^3 - 9x^2 + 4x - 1"},
+  {"nested trig", "c(x) = sin(cos(sin(cos(x))))"},
+  {"nested trig", "d(x) = sin(x + cos(2x + sin(3x))) * cos(sin(x)^2)"},
+  {"piecewise", "e(x) = abs(x - 1) + abs(x + 1) - abs(2x)"},
+  {"piecewise", "g(x) = (abs(x) + x)/2 * sin(x) + (abs(x) - x)/2 * cos(x)"},
+  {"piecewise", "h(x) = sqrt(x - 2) + sqrt(-x - 2) + abs(abs(x) - 3)"},
+  {"piecewise", "k(x) = 1/x + tan(x)"},
+};
+#define FIXED_CORPUS_LENGTH (sizeof(fixedCorpus) / sizeof(fixedCorpus[0]))
+#define PIPELINE_CORPUS_LENGTH (FIXED_CORPUS_LENGTH + GENERATED_COUNT)
+
+// a sum of random terms, the same one on every run (a linear congruential generator with a fixed seed)
+static char* rbn_GenerateDefinition(const char *name, int termCount){
+  const size_t capacity = 32 + (size_t)termCount * 32;
+  char *definition = malloc(capacity);
+  if (definition == nullptr) return nullptr;
+
+  uint32_t state = 12345u + (uint32_t)termCount;
+  size_t length = (size_t)snprintf(definition, capacity, "%s(x) = 1", name);
+  for (int t = 0; t < termCount; ++t){
+    state = state * 1664525u + 1013904223u;
+    const int a = (int)(state >> 8 & 7) + 1;
+    const int b = (int)(state >> 12 & 7) + 1;
+    const char sign = (state >> 16 & 1) ? '+' : '-';
+    switch (state >> 28 & 7){
+      case 0: length += (size_t)snprintf(definition + length, capacity - length, " %c %dx^%d", sign, a, b % 5 + 1); break;
+      case 1: length += (size_t)snprintf(definition + length, capacity - length, " %c sin(%dx)", sign, a); break;
+      case 2: length += (size_t)snprintf(definition + length, capacity - length, " %c cos(x + %d)/%d", sign, a, b); break;
+      case 3: length += (size_t)snprintf(definition + length, capacity - length, " %c abs(x - %d)", sign, a); break;
+      case 4: length += (size_t)snprintf(definition + length, capacity - length, " %c sqrt(x^2 + %d)", sign, a); break;
+      case 5: length += (size_t)snprintf(definition + length, capacity - length, " %c %d*sin(x)*cos(%dx)", sign, a, b); break;
+      case 6: length += (size_t)snprintf(definition + length, capacity - length, " %c ln(abs(x) + %d)", sign, a); break;
+      default: length += (size_t)snprintf(definition + length, capacity - length, " %c (x - %d)^2/%d", sign, a, b * 10); break;
+    }
+  }
+
+  return definition;
+}
+
+// label of an entry in the report, the generated definitions are too long to print
+static void rbn_EntryLabel(const struct rbn_pipeline_entry_t *entry, size_t index, char *label, size_t size){
+  if (index < FIXED_CORPUS_LENGTH){
+    snprintf(label, size, "%-11s %s", entry->kind, entry->definition);
+  }
+  else {
+    snprintf(label, size, "%-11s %d terms", entry->kind, generatedTerms[index - FIXED_CORPUS_LENGTH]);
+  }
+}
+
+// times lexing the whole definition, returns ns per definition
+static double rbn_TimeLexer(struct rma_arena_t *scratch, char *definition, size_t iterations){
+  double start = rbn_NowNs();
+  for (size_t i = 0; i < iterations; ++i){
+    struct ree_token_t *tokens = nullptr;
+    int tokenCount = 0;
+    int tokenCapacity = 0;
+    if (ree_Lexer(scratch, definition, &tokens, &tokenCount, &tokenCapacity) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      rma_ResetArena(scratch);
+      return 0.0;
+    }
+    rma_ResetArena(scratch);
+  }
+  return (rbn_NowNs() - start) / (double)iterations;
+}
+
+// times the stages from lexed body tokens to the RPN (implicit multiplication, unary operators, shunting yard), returns ns per definition
+static double rbn_TimeParser(struct rma_arena_t *scratch, const char *body, const struct ree_token_t *lexed, int lexedCount, size_t iterations){
+  double start = rbn_NowNs();
+  for (size_t i = 0; i < iterations; ++i){
+    // the stages work in place, every round starts from a fresh copy of the tokens like a definition would
+    int tokenCount = lexedCount;
+    int tokenCapacity = lexedCount;
+    struct ree_token_t *tokens = rma_Alloc(scratch, (size_t)lexedCount * sizeof *tokens);
+    if (tokens == nullptr){
+      rl_LogMsg(RL_ERROR, "Failed to allocate the tokens to parse.");
+      rma_ResetArena(scratch);
+      return 0.0;
+    }
+    memcpy(tokens, lexed, (size_t)lexedCount * sizeof *tokens);
+
+    enum reh_error_code_e err = ree_ImplicitMultiplication(scratch, body, &tokens, &tokenCount, &tokenCapacity);
+    struct ree_output_token_t *rpn = (err == ERR_SUCCESS) ? rma_Alloc(scratch, (size_t)tokenCount * sizeof *rpn) : nullptr;
+    int rpnCount = 0;
+    if (rpn == nullptr ||
+        ree_MarkUnaryOperators(tokens, tokenCount) != ERR_SUCCESS ||
+        ree_ParseToPostfix(scratch, body, tokens, tokenCount, rpn, &rpnCount) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      rma_ResetArena(scratch);
+      return 0.0;
+    }
+    rma_ResetArena(scratch);
+  }
+  return (rbn_NowNs() - start) / (double)iterations;
+}
+
+// lexer and parser of one definition, the parser is fed the body alone as the function parser does after the header
+static void rbn_FrontEndBench(struct ree_function_manager_t *manager, char *definition, const char *label){
+  char name[128];
+  const size_t length = strlen(definition);
+  size_t iterations = PIPELINE_BENCH_LEX_CHARS / length + 1;
+  rbn_Report("lexer", label, rbn_TimeLexer(&manager->scratch, definition, iterations), iterations);
+
+  char *body = strchr(definition, '=');
+  if (body == nullptr){
+    rl_LogMsg(RL_ERROR, "%s has no body to parse.", label);
+    return;
+  }
+  body++;
+
+  struct ree_token_t *tokens = nullptr;
+  int tokenCount = 0;
+  int tokenCapacity = 0;
+  if (ree_Lexer(&manager->scratch, body, &tokens, &tokenCount, &tokenCapacity) != ERR_SUCCESS){
+    rl_LogLastError(RL_ERROR);
+    rma_ResetArena(&manager->scratch);
+    return;
+  }
+  struct ree_token_t *lexed = malloc((size_t)tokenCount * sizeof *lexed);
+  if (lexed != nullptr) memcpy(lexed, tokens, (size_t)tokenCount * sizeof *lexed);
+  rma_ResetArena(&manager->scratch);
+
+  if (lexed != nullptr){
+    iterations = PIPELINE_BENCH_PARSE_TOKENS / (size_t)tokenCount + 1;
+    const double parseNs = rbn_TimeParser(&manager->scratch, body, lexed, tokenCount, iterations);
+    snprintf(name, sizeof(name), "%s, %d tokens", label, tokenCount);
+    rbn_Report("parser", name, parseNs, iterations);
+  }
+
+  free(lexed);
+}
+
+// the RPN evaluator per sample against the bytecode batch path, over the default viewport
+static void rbn_EvaluateBench(struct ree_function_t *function, const char *label){
+  static float xs[PIPELINE_BENCH_BATCH];
+  static float ys[PIPELINE_BENCH_BATCH];
+  static uint8_t status[PIPELINE_BENCH_BATCH];
+  volatile float sink = 0.0f;
+  char name[128];
+
+  const float step = (float)(viewportWidths[0] / PIPELINE_BENCH_BATCH);
+  for (size_t s = 0; s < PIPELINE_BENCH_BATCH; ++s) xs[s] = (float)(-viewportWidths[0] / 2.0) + (float)s * step;
+
+  const size_t rounds = PIPELINE_BENCH_RPN_TOKENS / ((size_t)function->rpnCount * PIPELINE_BENCH_BATCH) + 1;
+  double start = rbn_NowNs();
+  for (size_t r = 0; r < rounds; ++r){
+    for (size_t s = 0; s < PIPELINE_BENCH_BATCH; ++s){
+      float y = 0.0f;
+      struct ree_variable_t variables[] = {{function->parameter, xs[s]}};
+      if (ree_EvaluateRpn(function->rpn, (size_t)function->rpnCount, variables, 1, &y) != ERR_SUCCESS){
+        reh_ClearError();
+        continue;
+      }
+      sink += y;
+    }
+  }
+  const double rpnNs = (rbn_NowNs() - start) / (double)(rounds * PIPELINE_BENCH_BATCH);
+  snprintf(name, sizeof(name), "rpn   %s, %d tokens", label, function->rpnCount);
+  rbn_Report("evaluate", name, rpnNs, rounds * PIPELINE_BENCH_BATCH);
+
+  start = rbn_NowNs();
+  for (size_t r = 0; r < rounds; ++r){
+    ree_EvaluateBatch(&function->program, xs, PIPELINE_BENCH_BATCH, ys, status);
+    sink += ys[r % PIPELINE_BENCH_BATCH];
+  }
+  const double batchNs = (rbn_NowNs() - start) / (double)(rounds * PIPELINE_BENCH_BATCH);
+  snprintf(name, sizeof(name), "batch %s, %d tokens", label, function->rpnCount);
+  rbn_Report("evaluate", name, batchNs, rounds * PIPELINE_BENCH_BATCH);
+
+  (void)sink;
+}
+
+// samples the function over a viewport centered on the origin, the y range keeps the aspect ratio of the default one
+static enum reh_error_code_e rbn_SampleViewport(struct ree_function_t *function, struct rtp_thread_pool_t *pool, double width){
+  const double height = width * 3.0 / 4.0;
+  struct rfr_function_point_data_t points = {0};
+  enum reh_error_code_e err = rfr_SampleFunction(function, pool, -width / 2.0, width / 2.0, -height / 2.0, height / 2.0, PIPELINE_BENCH_STEP, &points);
+  free(points.vertices);
+  free(points.undefinedPoints);
+  return err;
+}
+
+// frames sampled per width, so the wide viewports don't take the whole run
+static size_t rbn_FramesFor(double width){
+  const size_t samples = (size_t)(width / PIPELINE_BENCH_STEP) + 1;
+  return PIPELINE_BENCH_FRAME_SAMPLES / samples + 1;
+}
+
+// the whole sampler (interval culling, discontinuity cuts, chunking) on the calling thread, once per viewport width
+static void rbn_SamplerBench(struct ree_function_t *function, const char *label){
+  char name[128];
+
+  // the renderer compiles functions it keeps resampling to native code, time them the way they are sampled every frame
+  for (int pass = 0; pass < REE_JIT_HOT_THRESHOLD; ++pass){
+    if (rbn_SampleViewport(function, nullptr, viewportWidths[0]) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      return;
+    }
+  }
+
+  for (size_t w = 0; w < VIEWPORT_WIDTH_COUNT; ++w){
+    const size_t frames = rbn_FramesFor(viewportWidths[w]);
+    const double start = rbn_NowNs();
+    for (size_t frame = 0; frame < frames; ++frame){
+      if (rbn_SampleViewport(function, nullptr, viewportWidths[w]) != ERR_SUCCESS){
+        rl_LogLastError(RL_ERROR);
+        return;
+      }
+    }
+    snprintf(name, sizeof(name), "%s, width %g", label, viewportWidths[w]);
+    rbn_Report("sampler", name, (rbn_NowNs() - start) / (double)frames, frames);
+  }
+}
+
+// samples every function of the manager over one viewport, together like the renderer does or one by one
+// both keep the samples of every function until the frame is done, like the renderer until it uploads them
+static enum reh_error_code_e rbn_SampleFrame(struct ree_function_manager_t *manager, struct rtp_thread_pool_t *pool, double width, bool together){
+  const size_t count = (size_t)manager->functionCount;
+  struct ree_function_t **functions = malloc(count * sizeof(*functions));
+  struct rfr_function_point_data_t *points = calloc(count, sizeof(*points));
+  if (functions == nullptr || points == nullptr){
+    free(functions);
+    free(points);
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the frame.");
+  }
+  for (size_t f = 0; f < count; ++f) functions[f] = &manager->functions[f];
+
+  const double height = width * 3.0 / 4.0;
+  enum reh_error_code_e err = ERR_SUCCESS;
+  if (together){
+    err = rfr_SampleFunctions(functions, count, pool, -width / 2.0, width / 2.0, -height / 2.0, height / 2.0, PIPELINE_BENCH_STEP, points);
+  } else {
+    for (size_t f = 0; f < count && err == ERR_SUCCESS; ++f){
+      err = rfr_SampleFunction(functions[f], pool, -width / 2.0, width / 2.0, -height / 2.0, height / 2.0, PIPELINE_BENCH_STEP, &points[f]);
+    }
+  }
+
+  for (size_t f = 0; f < count; ++f){
+    free(points[f].vertices);
+    free(points[f].undefinedPoints);
+  }
+  free(functions);
+  free(points);
+  return err;
+}
+
+// drops the native code of every function and restarts its count of samplings, as if all of them were just edited
+static void rbn_KeepInterpreted(struct ree_function_manager_t *manager){
+  for (int f = 0; f < manager->functionCount; ++f){
+    ree_JitFree(&manager->functions[f].program);
+    manager->functions[f].sampleCount = 0;
+  }
+}
+
+// every function of the set sampled as one frame on the default pool, what the renderer does when the viewport moves (without the upload)
+// the one by one rows sample the same functions without the fused pass, the interpreted rows time them right after an edit, before they get native code
+static void rbn_FrameBench(struct ree_function_manager_t *manager, const char *set, bool interpreted){
+  struct rtp_thread_pool_t pool;
+  if (rtp_InitThreadPool(&pool, 0) != ERR_SUCCESS){
+    rl_LogLastError(RL_ERROR);
+    return;
+  }
+
+  char name[160];
+  for (size_t w = 0; w < VIEWPORT_WIDTH_COUNT; ++w){
+    for (int together = 1; together >= 0; --together){
+      const size_t frames = rbn_FramesFor(viewportWidths[w]);
+      double elapsed = 0.0;
+      for (size_t frame = 0; frame < frames; ++frame){
+        if (interpreted) rbn_KeepInterpreted(manager);
+        const double start = rbn_NowNs();
+        if (rbn_SampleFrame(manager, &pool, viewportWidths[w], together) != ERR_SUCCESS){
+          rl_LogLastError(RL_ERROR);
+          rtp_DestroyThreadPool(&pool);
+          return;
+        }
+        elapsed += rbn_NowNs() - start;
+      }
+      snprintf(name, sizeof(name), "%d %s functions%s%s, width %g, pool of %d workers + caller", manager->functionCount, set,
+               interpreted ? " interpreted" : "", together ? "" : " one by one", viewportWidths[w], pool.threadCount);
+      rbn_Report("frame", name, elapsed / (double)frames, frames);
+    }
+  }
+
+  rtp_DestroyThreadPool(&pool);
+}
+
+// a dashboard of related curves, sums and products of the same few terms, where the fused pass shares the most work
+static char *dashboardSet[] = {
+  "p(x) = sin(x) * cos(2x) + x^2 / 10",
+  "q(x) = sin(x) * cos(2x) - x^2 / 10",
+  "r(x) = sin(x) * cos(2x) * sqrt(x^2 + 1)",
+  "s(x) = sqrt(x^2 + 1) + cos(2x)",
+  "t(x) = sin(x) * cos(2x) + sqrt(x^2 + 1) / 3",
+  "u(x) = x^2 / 10 + sqrt(x^2 + 1)",
+  "v(x) = cos(2x) * x^2 / 10",
+  "w(x) = sin(x) * cos(2x) + 1",
+};
+#define DASHBOARD_SET_LENGTH (sizeof(dashboardSet) / sizeof(dashboardSet[0]))
+
+static void rbn_DashboardBench(void){
+  struct ree_function_manager_t manager;
+  if (ree_InitFunctionManager(&manager) != ERR_SUCCESS){
+    rl_LogLastError(RL_ERROR);
+    return;
+  }
+
+  for (size_t i = 0; i < DASHBOARD_SET_LENGTH; ++i){
+    if (ree_AddFunction(&manager, dashboardSet[i], &functionColorArray[i % (size_t)functionColorArrayLength]) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      ree_DestroyFunctionManager(&manager);
+      return;
+    }
+  }
+
+  rbn_FrameBench(&manager, "dashboard", true);
+  rbn_FrameBench(&manager, "dashboard", false);
+  ree_DestroyFunctionManager(&manager);
+}
+
+void rbn_PipelineBench(void){
+  struct rbn_pipeline_entry_t corpus[PIPELINE_CORPUS_LENGTH];
+  memcpy(corpus, fixedCorpus, sizeof(fixedCorpus));
+  const char *generatedNames[GENERATED_COUNT] = {"m", "n"};
+  static_assert(sizeof(generatedNames) / sizeof(generatedNames[0]) == GENERATED_COUNT, "every generated expression needs a name");
+  for (size_t g = 0; g < GENERATED_COUNT; ++g){
+    corpus[FIXED_CORPUS_LENGTH + g] = (struct rbn_pipeline_entry_t){"generated", rbn_GenerateDefinition(generatedNames[g], generatedTerms[g])};
+  }
+
+  struct ree_function_manager_t manager;
+  if (ree_InitFunctionManager(&manager) != ERR_SUCCESS){
+    rl_LogLastError(RL_ERROR);
+    for (size_t g = 0; g < GENERATED_COUNT; ++g) free(corpus[FIXED_CORPUS_LENGTH + g].definition);
+    return;
+  }
+
+  char label[96];
+  for (size_t i = 0; i < PIPELINE_CORPUS_LENGTH; ++i){
+    if (corpus[i].definition == nullptr){
+      rl_LogMsg(RL_ERROR, "Failed to generate the corpus expression %zu.", i);
+      continue;
+    }
+    rbn_EntryLabel(&corpus[i], i, label, sizeof(label));
+    rbn_FrontEndBench(&manager, corpus[i].definition, label);
+
+    if (ree_AddFunction(&manager, corpus[i].definition, &functionColorArray[i % (size_t)functionColorArrayLength]) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      continue;
+    }
+
+    struct ree_function_t *function = &manager.functions[manager.functionCount - 1];
+    rbn_EvaluateBench(function, label);
+    rbn_SamplerBench(function, label);
+  }
+
+  rbn_FrameBench(&manager, "corpus", false);
+  rbn_DashboardBench();
+
+  ree_DestroyFunctionManager(&manager);
+  for (size_t g = 0; g < GENERATED_COUNT; ++g) free(corpus[FIXED_CORPUS_LENGTH + g].definition);
+}
@@ -0,0 +1,174 @@
+#include "bench.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+#include "core/threadPool.h"
+#include "expressionEngine/evaluator.h"
+#include "expressionEngine/functionManager.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SAMPLING_BENCH_SAMPLES 20001
+#define SAMPLING_BENCH_FRAMES  20
+
+// one expensive function over a wide viewport, cut into chunks like the renderer does
+#define SAMPLING_BENCH_WIDE_SAMPLES 200001
+#define SAMPLING_BENCH_CHUNK        512
+
+// a dozen functions on screen, as the renderer samples them every time the viewport moves
+static char *samplingCorpus[] = {
+  "a(x) = sin(x)",
+  "b(x) = 3x^2 - 2x + 1",
+  "c(x) = sin(x) * cos(x) + abs(x)",
+  "d(x) = sin(cos(sin(x))) + cos(sin(cos(x)))",
+  "e(x) = x^5 - 4x^4 + 3x^3 - 2x^2 + x - 7",
+  "f(x) = sqrt(abs(x)) + ln(x^2 + 1) - log(abs(x) + 1)",
+  "g(x) = sin(x)^2 + cos(x)*sin(x) + sin(x) - cos(x)^2",
+  "h(x) = 1/x",
+  "k(x) = tan(x)",
+  "m(x) = sqrt(x) + ln(x)",
+  "n(x) = sin(3x) + cos(5x) + sin(7x)",
+  "p(x) = abs(sin(x))^3",
+};
+#define SAMPLING_CORPUS_LENGTH (sizeof(samplingCorpus) / sizeof(samplingCorpus[0]))
+static_assert(SAMPLING_CORPUS_LENGTH * SAMPLING_BENCH_SAMPLES >= SAMPLING_BENCH_WIDE_SAMPLES, "the wide function reuses the output buffers of the corpus");
+
+// samples of one function (or a chunk of them) starting at xMin, every task writes its own output
+struct rbn_sampling_job_t {
+  const struct ree_program_t *program;
+  double xMin;
+  double step;
+  size_t count;
+  double *xs;
+  double *ys;
+  uint8_t *status;
+  enum reh_error_code_e err;
+};
+
+static void rbn_SamplingTask(void *userData, size_t index){
+  struct rbn_sampling_job_t *job = &((struct rbn_sampling_job_t *)userData)[index];
+  job->err = ree_SampleProgram(job->program, REE_PRECISION_FLOAT, REE_MATH_EXACT, job->xMin, job->step, job->count, job->xs, job->ys, job->status);
+}
+
+// runs every job once per frame, on the calling thread alone (pool is nullptr) or spread over the pool, returns ns per frame
+static double rbn_TimeFrames(struct rtp_thread_pool_t *pool, struct rbn_sampling_job_t *jobs, size_t jobCount){
+  double start = rbn_NowNs();
+  for (int frame = 0; frame < SAMPLING_BENCH_FRAMES; ++frame){
+    rtp_ParallelFor(pool, jobCount, rbn_SamplingTask, jobs);
+  }
+  return (rbn_NowNs() - start) / SAMPLING_BENCH_FRAMES;
+}
+
+// times the jobs alone and on pools of a few sizes, one report line each
+static void rbn_ReportScaling(const char *what, struct rbn_sampling_job_t *jobs, size_t jobCount){
+  char name[128];
+  const double serialNs = rbn_TimeFrames(nullptr, jobs, jobCount);
+  snprintf(name, sizeof(name), "%s, render thread alone", what);
+  rbn_Report("sampling", name, serialNs, SAMPLING_BENCH_FRAMES);
+
+  // one worker per hardware thread besides the calling one, and a few fixed counts to see the scaling
+  const int workerCounts[] = {1, 3, rtp_HardwareThreadCount() - 1};
+  for (size_t w = 0; w < sizeof(workerCounts) / sizeof(workerCounts[0]); ++w){
+    bool measured = false;
+    for (size_t previous = 0; previous < w; ++previous){
+      measured |= (workerCounts[previous] == workerCounts[w]);
+    }
+    if (workerCounts[w] <= 0 || measured) continue;
+
+    struct rtp_thread_pool_t pool;
+    if (rtp_InitThreadPool(&pool, workerCounts[w]) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      continue;
+    }
+    const double poolNs = rbn_TimeFrames(&pool, jobs, jobCount);
+    rtp_DestroyThreadPool(&pool);
+
+    snprintf(name, sizeof(name), "%s, pool of %d workers + caller", what, workerCounts[w]);
+    rbn_Report("sampling", name, poolNs, SAMPLING_BENCH_FRAMES);
+    printf("%-12s speedup: %.2fx on %d hardware threads\n", "", serialNs / poolNs, rtp_HardwareThreadCount());
+  }
+
+  for (size_t i = 0; i < jobCount; ++i){
+    if (jobs[i].err != ERR_SUCCESS){
+      rl_LogMsg(RL_ERROR, "Sampling job %zu of %s failed.", i, what);
+    }
+  }
+}
+
+void rbn_SamplingBench(void){
+  struct ree_function_manager_t manager;
+  if (ree_InitFunctionManager(&manager) != ERR_SUCCESS){
+    rl_LogLastError(RL_ERROR);
+    return;
+  }
+
+  struct rbn_sampling_job_t jobs[SAMPLING_CORPUS_LENGTH];
+  double *xs = malloc(SAMPLING_CORPUS_LENGTH * SAMPLING_BENCH_SAMPLES * sizeof *xs);
+  double *ys = malloc(SAMPLING_CORPUS_LENGTH * SAMPLING_BENCH_SAMPLES * sizeof *ys);
+  uint8_t *status = malloc(SAMPLING_CORPUS_LENGTH * SAMPLING_BENCH_SAMPLES * sizeof *status);
+  if (xs == nullptr || ys == nullptr || status == nullptr){
+    rl_LogMsg(RL_ERROR, "Failed to allocate the sampling benchmark buffers.");
+    free(xs);
+    free(ys);
+    free(status);
+    ree_DestroyFunctionManager(&manager);
+    return;
+  }
+
+  for (size_t i = 0; i < SAMPLING_CORPUS_LENGTH; ++i){
+    if (ree_AddFunction(&manager, samplingCorpus[i], &functionColorArray[0]) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      free(xs);
+      free(ys);
+      free(status);
+      ree_DestroyFunctionManager(&manager);
+      return;
+    }
+  }
+  // every function is added, pointers into the manager stay valid from here on
+  const double step = 20.0 / (SAMPLING_BENCH_SAMPLES - 1);
+  for (size_t i = 0; i < SAMPLING_CORPUS_LENGTH; ++i){
+    jobs[i] = (struct rbn_sampling_job_t){
+      .program = &ree_GetFunction(&manager, (char[]){samplingCorpus[i][0], '\0'})->program,
+      .xMin = -10.0,
+      .step = step,
+      .count = SAMPLING_BENCH_SAMPLES,
+      .xs = &xs[i * SAMPLING_BENCH_SAMPLES],
+      .ys = &ys[i * SAMPLING_BENCH_SAMPLES],
+      .status = &status[i * SAMPLING_BENCH_SAMPLES],
+    };
+  }
+
+  char what[96];
+  snprintf(what, sizeof(what), "%zu functions x %d samples", SAMPLING_CORPUS_LENGTH, SAMPLING_BENCH_SAMPLES);
+  rbn_ReportScaling(what, jobs, SAMPLING_CORPUS_LENGTH);
+
+  // a single function is only spread over the threads when its range is cut into chunks
+  const size_t chunkCount = (SAMPLING_BENCH_WIDE_SAMPLES + SAMPLING_BENCH_CHUNK - 1) / SAMPLING_BENCH_CHUNK;
+  struct rbn_sampling_job_t *chunks = malloc(chunkCount * sizeof *chunks);
+  if (chunks != nullptr){
+    const double wideStep = 2000.0 / (SAMPLING_BENCH_WIDE_SAMPLES - 1);
+    for (size_t c = 0; c < chunkCount; ++c){
+      const size_t first = c * SAMPLING_BENCH_CHUNK;
+      chunks[c] = (struct rbn_sampling_job_t){
+        .program = jobs[3].program,
+        .xMin = -1000.0 + (double)first * wideStep,
+        .step = wideStep,
+        .count = (SAMPLING_BENCH_WIDE_SAMPLES - first < SAMPLING_BENCH_CHUNK) ? SAMPLING_BENCH_WIDE_SAMPLES - first : SAMPLING_BENCH_CHUNK,
+        .xs = &xs[first],
+        .ys = &ys[first],
+        .status = &status[first],
+      };
+    }
+    snprintf(what, sizeof(what), "%.4s x %d samples, chunks of %d", samplingCorpus[3], SAMPLING_BENCH_WIDE_SAMPLES, SAMPLING_BENCH_CHUNK);
+    rbn_ReportScaling(what, chunks, chunkCount);
+  }
+  free(chunks);
+
+  free(xs);
+  free(ys);
+  free(status);
+  ree_DestroyFunctionManager(&manager);
+}
@@ -0,0 +1,182 @@
+/**
+  rev - Robkoo's Evaluator (headless)
+*/
+
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "core/errorHandler.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// x values read, evaluated and written at a time
+#define REV_BLOCK_SAMPLES 65536
+
+// size of the text input buffer, a single number can't be longer
+#define REV_TEXT_BUFFER_SIZE (1 << 20)
+
+enum rev_format_e {
+  REV_FORMAT_TEXT = 0,  /**< Decimal numbers: separated by whitespace or commas on input ('#' comments a line out), CSV rows on output */
+  REV_FORMAT_F32,       /**< Raw little-endian IEEE 754 binary32, no header */
+  REV_FORMAT_F64,       /**< Raw little-endian IEEE 754 binary64, no header */
+  REV_FORMAT_COLUMNS,   /**< Column file (see below), mapped into memory instead of streamed */
+};
+
+/*
+  Column file format (col), every integer and value is little-endian:
+    A file is a sequence of columns, each one a 64 byte header followed by count values of its dtype,
+    padded with zeros to a multiple of REV_COLUMN_ALIGNMENT bytes so the next column starts aligned.
+
+    offset  size  field
+         0     8  magic, "EQFNCOL" and a '\0'
+         8     4  version, REV_COLUMN_VERSION
+        12     4  dtype, REV_DTYPE_F32 or REV_DTYPE_F64
+        16     8  count, number of values
+        24     4  function id, index of the function in argument order or REV_COLUMN_X for x values
+        28     4  reserved, 0
+        32    32  name, '\0' terminated ("x" for x values)
+
+  As input the first column holds the x values (any dtype), as output there is one column per function
+  in argument order, f32 for the float precision and f64 for the double one. Undefined values are NaN.
+*/
+#define REV_COLUMN_MAGIC "EQFNCOL"
+#define REV_COLUMN_VERSION 1
+#define REV_COLUMN_HEADER_SIZE 64
+#define REV_COLUMN_ALIGNMENT 64
+#define REV_COLUMN_NAME_SIZE 32
+#define REV_COLUMN_X UINT32_MAX
+
+enum rev_dtype_e {
+  REV_DTYPE_F32 = 1,    /**< IEEE 754 binary32 */
+  REV_DTYPE_F64 = 2,    /**< IEEE 754 binary64 */
+};
+
+// decoded column header
+struct rev_column_header_t {
+  uint32_t version;                   /**< Format version */
+  enum rev_dtype_e dtype;             /**< Type of the values */
+  uint64_t count;                     /**< Number of values */
+  uint32_t functionId;                /**< Index of the function in argument order, REV_COLUMN_X for x values */
+  char name[REV_COLUMN_NAME_SIZE];    /**< Name of the function */
+};
+
+// a whole file mapped into memory
+struct rev_mapped_file_t {
+  unsigned char *data;          /**< Start of the mapping, nullptr if nothing is mapped */
+  size_t size;                  /**< Size of the file and the mapping */
+  bool writable;                /**< Mapped for writing, the changes go straight to the file */
+#ifdef _WIN32
+  void *file;                   /**< File handle */
+  void *mapping;                /**< File mapping handle */
+#else
+  int fd;                       /**< File descriptor */
+#endif
+};
+
+// streams x values in blocks from a file or stdin
+struct rev_reader_t {
+  FILE *stream;                 /**< Stream the values come from */
+  enum rev_format_e format;     /**< Encoding of the values */
+  char *text;                   /**< Text read so far but not parsed yet, or the raw bytes of a block */
+  size_t textStart;             /**< First unparsed character of text */
+  size_t textLength;            /**< Characters in text */
+  size_t textCapacity;          /**< Allocated length of text */
+  size_t line;                  /**< Line of the text input the reader is at, for error messages */
+  bool eof;                     /**< Set once the stream has nothing more */
+  const unsigned char *mapped;  /**< Values of a mapped column, read instead of the stream */
+  enum rev_dtype_e mappedType;  /**< Type of the mapped values */
+  size_t mappedCount;           /**< Number of mapped values */
+  size_t mappedNext;            /**< First mapped value not read yet */
+};
+
+// writes the x values and the values of every function in blocks to a file or stdout
+struct rev_writer_t {
+  FILE *stream;                 /**< Stream the results go to */
+  enum rev_format_e format;     /**< Encoding of the results */
+  int digits;                   /**< Significant digits of the text output, enough to round trip the evaluated precision */
+  unsigned char *raw;           /**< Interleaved row buffer of the raw formats */
+  size_t rawCapacity;           /**< Allocated size of raw in bytes */
+};
+
+/**
+  @brief Parses a format name (text, csv, f32, f64)
+*/
+enum reh_error_code_e rev_ParseFormat(const char *name, enum rev_format_e *format);
+
+/**
+  @brief Prepares a reader for a stream, the buffers are allocated on the first block
+*/
+void rev_InitReader(struct rev_reader_t *reader, FILE *stream, enum rev_format_e format);
+
+/**
+  @brief Prepares a reader for the values of a mapped column (see rev_ReadColumn), the mapping has to outlive the reader
+*/
+void rev_InitMappedReader(struct rev_reader_t *reader, const unsigned char *values, enum rev_dtype_e dtype, size_t count);
+
+/**
+  @brief Releases the buffers of a reader (the stream stays open)
+*/
+void rev_DestroyReader(struct rev_reader_t *reader);
+
+/**
+  @brief Reads up to capacity x values, count is 0 once the input is exhausted
+*/
+enum reh_error_code_e rev_ReadBlock(struct rev_reader_t *reader, double *xs, size_t capacity, size_t *count);
+
+/**
+  @brief Prepares a writer for a stream, digits is the number of significant digits of the text output
+*/
+void rev_InitWriter(struct rev_writer_t *writer, FILE *stream, enum rev_format_e format, int digits);
+
+/**
+  @brief Releases the buffers of a writer and flushes the stream (the stream stays open)
+*/
+enum reh_error_code_e rev_DestroyWriter(struct rev_writer_t *writer);
+
+/**
+  @brief Writes the CSV header line (x and the function names), raw formats have no header
+*/
+enum reh_error_code_e rev_WriteHeader(struct rev_writer_t *writer, const char *const *names, int columnCount);
+
+/**
+  @brief Writes count rows, row i holds xs[i] followed by columns[c][i] for every column
+  @note Raw formats leave x out, a row is the value of every function in order (the caller has the x values already)
+*/
+enum reh_error_code_e rev_WriteBlock(struct rev_writer_t *writer, const double *xs, const double *const *columns, int columnCount, size_t count);
+
+/**
+  @brief Size of a column of count values in a column file, header and padding included
+  @note size is 0 if it doesn't fit a size_t
+*/
+size_t rev_ColumnSize(enum rev_dtype_e dtype, uint64_t count);
+
+/**
+  @brief Maps a whole file into memory for reading
+*/
+enum reh_error_code_e rev_MapFile(const char *path, struct rev_mapped_file_t *file);
+
+/**
+  @brief Creates (or truncates) a file, sets its size and maps it into memory for writing
+  @note The file is sized with ftruncate, its blocks are allocated as the mapping is written
+*/
+enum reh_error_code_e rev_CreateMappedFile(const char *path, size_t size, struct rev_mapped_file_t *file);
+
+/**
+  @brief Unmaps and closes a file mapped by rev_MapFile or rev_CreateMappedFile, does nothing if nothing is mapped
+*/
+enum reh_error_code_e rev_UnmapFile(struct rev_mapped_file_t *file);
+
+/**
+  @brief Validates the column starting at offset of a mapped column file and points values at its data
+  @note The values are used in place, so columns can only be read on little-endian machines
+*/
+enum reh_error_code_e rev_ReadColumn(const struct rev_mapped_file_t *file, size_t offset, struct rev_column_header_t *header, const unsigned char **values);
+
+/**
+  @brief Encodes a column header into the first REV_COLUMN_HEADER_SIZE bytes of destination
+*/
+void rev_WriteColumnHeader(unsigned char *destination, const struct rev_column_header_t *header);
+
+#endif // EVAL_H
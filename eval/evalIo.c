@@ -0,0 +1,333 @@
+#include "eval.h"
+#include "core/errorHandler.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "core/logger.h"
+
+enum reh_error_code_e rev_ParseFormat(const char *name, enum rev_format_e *format){
+  if (name == nullptr || format == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Name or format passed to rev_ParseFormat is NULL.");
+  }
+
+  if (strcmp(name, "text") == 0 || strcmp(name, "csv") == 0) *format = REV_FORMAT_TEXT;
+  else if (strcmp(name, "f32") == 0) *format = REV_FORMAT_F32;
+  else if (strcmp(name, "f64") == 0) *format = REV_FORMAT_F64;
+  else if (strcmp(name, "col") == 0) *format = REV_FORMAT_COLUMNS;
+  else {
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Unknown format %s (expected text, csv, f32, f64 or col).", name);
+  }
+
+  return ERR_SUCCESS;
+}
+
+static bool rev_IsLittleEndian(void){
+  const uint16_t probe = 1;
+  unsigned char first;
+  memcpy(&first, &probe, 1);
+  return first == 1;
+}
+
+// the raw formats are little-endian on every machine
+static void rev_SwapBytes(unsigned char *data, size_t width, size_t count){
+  for (size_t i = 0; i < count; ++i){
+    unsigned char *value = data + i * width;
+    for (size_t b = 0; b < width / 2; ++b){
+      const unsigned char swap = value[b];
+      value[b] = value[width - 1 - b];
+      value[width - 1 - b] = swap;
+    }
+  }
+}
+
+static size_t rev_FormatWidth(enum rev_format_e format){
+  return (format == REV_FORMAT_F32) ? sizeof(float) : sizeof(double);
+}
+
+void rev_InitReader(struct rev_reader_t *reader, FILE *stream, enum rev_format_e format){
+  if (reader == nullptr) return;
+
+  memset(reader, 0, sizeof *reader);
+  reader->stream = stream;
+  reader->format = format;
+  reader->line = 1;
+}
+
+void rev_InitMappedReader(struct rev_reader_t *reader, const unsigned char *values, enum rev_dtype_e dtype, size_t count){
+  if (reader == nullptr) return;
+
+  memset(reader, 0, sizeof *reader);
+  reader->format = REV_FORMAT_COLUMNS;
+  reader->mapped = values;
+  reader->mappedType = dtype;
+  reader->mappedCount = count;
+  reader->line = 1;
+}
+
+void rev_DestroyReader(struct rev_reader_t *reader){
+  if (reader == nullptr) return;
+
+  free(reader->text);
+  reader->text = nullptr;
+  reader->textCapacity = 0;
+}
+
+// makes sure text can hold size bytes
+static enum reh_error_code_e rev_ReserveText(struct rev_reader_t *reader, size_t size){
+  if (reader->textCapacity >= size){
+    return ERR_SUCCESS;
+  }
+
+  char *text = realloc(reader->text, size);
+  if (text == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the input buffer (%zu bytes).", size);
+  }
+  reader->text = text;
+  reader->textCapacity = size;
+
+  return ERR_SUCCESS;
+}
+
+static enum reh_error_code_e rev_ReadRawBlock(struct rev_reader_t *reader, double *xs, size_t capacity, size_t *count){
+  const size_t width = rev_FormatWidth(reader->format);
+  CHECK_ERROR_CTX(rev_ReserveText(reader, capacity * width), "Failed to allocate the raw input buffer.");
+
+  const size_t bytes = fread(reader->text, 1, capacity * width, reader->stream);
+  if (bytes < capacity * width && ferror(reader->stream)){
+    SET_ERROR_RETURN(ERR_FILE_READ_FAILED, "Failed to read the input: %s", strerror(errno));
+  }
+  if (bytes % width != 0){
+    SET_ERROR_RETURN(ERR_FILE_INVALID_FORMAT, "Input ends inside a value (%zu trailing bytes).", bytes % width);
+  }
+
+  *count = bytes / width;
+  if (rev_IsLittleEndian() == false){
+    rev_SwapBytes((unsigned char*)reader->text, width, *count);
+  }
+
+  if (reader->format == REV_FORMAT_F32){
+    for (size_t i = 0; i < *count; ++i){
+      float x;
+      memcpy(&x, reader->text + i * sizeof x, sizeof x);
+      xs[i] = (double)x;
+    }
+  }
+  else {
+    memcpy(xs, reader->text, *count * sizeof *xs);
+  }
+
+  return ERR_SUCCESS;
+}
+
+static void rev_ReadMappedBlock(struct rev_reader_t *reader, double *xs, size_t capacity, size_t *count){
+  const size_t remaining = reader->mappedCount - reader->mappedNext;
+  *count = (remaining < capacity) ? remaining : capacity;
+
+  if (reader->mappedType == REV_DTYPE_F32){
+    const float *values = (const float*)reader->mapped + reader->mappedNext;
+    for (size_t i = 0; i < *count; ++i){
+      xs[i] = (double)values[i];
+    }
+  }
+  else {
+    memcpy(xs, (const double*)reader->mapped + reader->mappedNext, *count * sizeof *xs);
+  }
+  reader->mappedNext += *count;
+}
+
+static bool rev_IsSeparator(char c){
+  return c == ',' || isspace((unsigned char)c) != 0;
+}
+
+// moves the unparsed text to the front and appends what the stream has, sets eof once it's exhausted
+static enum reh_error_code_e rev_RefillText(struct rev_reader_t *reader){
+  const size_t remaining = reader->textLength - reader->textStart;
+  if (remaining == reader->textCapacity - 1){
+    SET_ERROR_RETURN(ERR_FILE_INVALID_FORMAT, "Token on line %zu is longer than %d bytes.", reader->line, REV_TEXT_BUFFER_SIZE);
+  }
+
+  memmove(reader->text, reader->text + reader->textStart, remaining);
+  reader->textStart = 0;
+  reader->textLength = remaining;
+
+  // one byte stays free, strtod reads up to a terminator written after the token
+  const size_t bytes = fread(reader->text + remaining, 1, reader->textCapacity - 1 - remaining, reader->stream);
+  if (bytes == 0){
+    if (ferror(reader->stream)){
+      SET_ERROR_RETURN(ERR_FILE_READ_FAILED, "Failed to read the input: %s", strerror(errno));
+    }
+    reader->eof = true;
+  }
+  reader->textLength += bytes;
+
+  return ERR_SUCCESS;
+}
+
+static enum reh_error_code_e rev_ReadTextBlock(struct rev_reader_t *reader, double *xs, size_t capacity, size_t *count){
+  CHECK_ERROR_CTX(rev_ReserveText(reader, REV_TEXT_BUFFER_SIZE), "Failed to allocate the text input buffer.");
+
+  while (*count < capacity){
+    // skip separators and comments, a comment runs to the end of its line
+    char *text = reader->text;
+    size_t pos = reader->textStart;
+    while (pos < reader->textLength && (rev_IsSeparator(text[pos]) == true || text[pos] == '#')){
+      if (text[pos] == '#'){
+        const char *newline = memchr(text + pos, '\n', reader->textLength - pos);
+        if (newline == nullptr && reader->eof == false) break;
+        pos = (newline == nullptr) ? reader->textLength : (size_t)(newline - text);
+        continue;
+      }
+      if (text[pos] == '\n') reader->line++;
+      pos++;
+    }
+    reader->textStart = pos;
+
+    // a token is complete once a separator follows it or the stream ended
+    size_t end = pos;
+    while (end < reader->textLength && rev_IsSeparator(text[end]) == false && text[end] != '#') end++;
+    if ((pos == reader->textLength || end == reader->textLength || text[pos] == '#') && reader->eof == false){
+      CHECK_ERROR_CTX(rev_RefillText(reader), "Failed to read more x values.");
+      continue;
+    }
+    if (pos == reader->textLength){
+      break;
+    }
+
+    const char saved = text[end];
+    text[end] = '\0';
+    char *parsedEnd;
+    const double x = strtod(text + pos, &parsedEnd);
+    text[end] = saved;
+    if (parsedEnd != text + end){
+      SET_ERROR_RETURN(ERR_FILE_INVALID_FORMAT, "Invalid x value on line %zu: %.*s", reader->line, (int)(end - pos > 32 ? 32 : end - pos), text + pos);
+    }
+
+    xs[(*count)++] = x;
+    reader->textStart = end;
+  }
+
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e rev_ReadBlock(struct rev_reader_t *reader, double *xs, size_t capacity, size_t *count){
+  if (reader == nullptr || (reader->stream == nullptr && reader->mapped == nullptr)){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Reader passed to rev_ReadBlock is NULL or has no stream.");
+  }
+  else if (xs == nullptr || count == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Output pointers passed to rev_ReadBlock are NULL.");
+  }
+
+  *count = 0;
+  if (reader->mapped != nullptr){
+    rev_ReadMappedBlock(reader, xs, capacity, count);
+    return ERR_SUCCESS;
+  }
+  if (reader->format == REV_FORMAT_TEXT){
+    return rev_ReadTextBlock(reader, xs, capacity, count);
+  }
+  return rev_ReadRawBlock(reader, xs, capacity, count);
+}
+
+void rev_InitWriter(struct rev_writer_t *writer, FILE *stream, enum rev_format_e format, int digits){
+  if (writer == nullptr) return;
+
+  memset(writer, 0, sizeof *writer);
+  writer->stream = stream;
+  writer->format = format;
+  writer->digits = digits;
+}
+
+enum reh_error_code_e rev_DestroyWriter(struct rev_writer_t *writer){
+  if (writer == nullptr) return ERR_SUCCESS;
+
+  free(writer->raw);
+  writer->raw = nullptr;
+  writer->rawCapacity = 0;
+
+  if (writer->stream != nullptr && fflush(writer->stream) != 0){
+    SET_ERROR_RETURN(ERR_FILE_WRITE_FAILED, "Failed to flush the output: %s", strerror(errno));
+  }
+
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e rev_WriteHeader(struct rev_writer_t *writer, const char *const *names, int columnCount){
+  if (writer == nullptr || writer->stream == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Writer passed to rev_WriteHeader is NULL or has no stream.");
+  }
+  else if (names == nullptr && columnCount > 0){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Names passed to rev_WriteHeader are NULL.");
+  }
+
+  if (writer->format != REV_FORMAT_TEXT){
+    return ERR_SUCCESS;
+  }
+
+  fputs("x", writer->stream);
+  for (int c = 0; c < columnCount; ++c){
+    fprintf(writer->stream, ",%s", names[c]);
+  }
+  fputc('\n', writer->stream);
+
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e rev_WriteBlock(struct rev_writer_t *writer, const double *xs, const double *const *columns, int columnCount, size_t count){
+  if (writer == nullptr || writer->stream == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Writer passed to rev_WriteBlock is NULL or has no stream.");
+  }
+  else if (xs == nullptr || (columns == nullptr && columnCount > 0)){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Values passed to rev_WriteBlock are NULL.");
+  }
+
+  if (writer->format == REV_FORMAT_TEXT){
+    for (size_t i = 0; i < count; ++i){
+      fprintf(writer->stream, "%.*g", writer->digits, xs[i]);
+      for (int c = 0; c < columnCount; ++c){
+        fprintf(writer->stream, ",%.*g", writer->digits, columns[c][i]);
+      }
+      fputc('\n', writer->stream);
+    }
+  }
+  else {
+    const size_t width = rev_FormatWidth(writer->format);
+    const size_t size = count * (size_t)columnCount * width;
+    if (size > writer->rawCapacity){
+      unsigned char *raw = realloc(writer->raw, size);
+      if (raw == nullptr){
+        SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the output buffer (%zu bytes).", size);
+      }
+      writer->raw = raw;
+      writer->rawCapacity = size;
+    }
+
+    unsigned char *out = writer->raw;
+    for (size_t i = 0; i < count; ++i){
+      for (int c = 0; c < columnCount; ++c){
+        if (writer->format == REV_FORMAT_F32){
+          const float y = (float)columns[c][i];
+          memcpy(out, &y, sizeof y);
+        }
+        else {
+          memcpy(out, &columns[c][i], sizeof columns[c][i]);
+        }
+        out += width;
+      }
+    }
+    if (rev_IsLittleEndian() == false){
+      rev_SwapBytes(writer->raw, width, count * (size_t)columnCount);
+    }
+
+    if (size > 0 && fwrite(writer->raw, 1, size, writer->stream) != size){
+      SET_ERROR_RETURN(ERR_FILE_WRITE_FAILED, "Failed to write the results: %s", strerror(errno));
+    }
+  }
+
+  if (ferror(writer->stream)){
+    SET_ERROR_RETURN(ERR_FILE_WRITE_FAILED, "Failed to write the results: %s", strerror(errno));
+  }
+
+  return ERR_SUCCESS;
+}
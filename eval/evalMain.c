@@ -0,0 +1,682 @@
+#include "eval.h"
+#include "core/errorHandler.h"
+#include "core/threadPool.h"
+#include "expressionEngine/evaluator.h"
+#include "expressionEngine/functionManager.h"
+#include "expressionEngine/jit.h"
+#include "expressionEngine/mathKernels.h"
+#include "math/utility.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "core/logger.h"
+
+// samples evaluated per pool task, a multiple of the batch lanes
+#define REV_CHUNK_SAMPLES (REE_BATCH_LANES * 64)
+
+struct rev_options_t {
+  const char *inputPath;              /**< File the x values are read from, nullptr for stdin */
+  const char *outputPath;             /**< File the results are written to, nullptr for stdout */
+  enum rev_format_e inputFormat;      /**< Encoding of the x values */
+  enum rev_format_e outputFormat;     /**< Encoding of the results */
+  enum ree_precision_e precision;     /**< REE_PRECISION_FLOAT (batch evaluator) or REE_PRECISION_DOUBLE */
+  enum ree_math_mode_e mathMode;      /**< Math kernels of the float tier */
+  bool generate;                      /**< Evaluate an evenly spaced range instead of reading x values */
+  double rangeMin;                    /**< First x of the generated range */
+  double rangeMax;                    /**< Last x of the generated range */
+  size_t rangeCount;                  /**< Number of x values of the generated range */
+  int threadCount;                    /**< Threads evaluating, the calling one included (0 for one per hardware thread) */
+  bool quiet;                         /**< Don't print the throughput summary */
+  bool verbose;                       /**< Log debug messages */
+};
+
+// one block of x values evaluated for every function, split into chunks handed out by the pool
+struct rev_block_job_t {
+  const struct ree_program_t *const *programs;  /**< Program of every column */
+  int columnCount;                              /**< Number of functions */
+  enum ree_precision_e precision;               /**< Tier every chunk is evaluated in */
+  enum ree_math_mode_e mathMode;                /**< Kernels of the float tier */
+  const double *xs;                             /**< x values of the block */
+  float *xsFloat;                               /**< x values narrowed for the float tier */
+  size_t count;                                 /**< Number of x values */
+  size_t chunkCount;                            /**< Chunks per column */
+  double **ys;                                  /**< Results, one column per function */
+  float *ysFloat;                               /**< Float tier results, a block of REV_BLOCK_SAMPLES per column */
+  uint8_t *status;                              /**< Per sample status, a block of REV_BLOCK_SAMPLES per column */
+  enum reh_error_code_e *errors;                /**< Outcome of every chunk, the error state of a worker stays on its thread */
+};
+
+// every x value evaluated for every function straight from the mapped input into the mapped output, one chunk per task
+struct rev_mapped_job_t {
+  const struct ree_program_t *const *programs;  /**< Program of every column */
+  enum ree_precision_e precision;               /**< Tier every chunk is evaluated in, f32 output for float and f64 for double */
+  enum ree_math_mode_e mathMode;                /**< Kernels of the float tier */
+  const unsigned char *xs;                      /**< Mapped x values, nullptr if they are generated */
+  enum rev_dtype_e xType;                       /**< Type of the mapped x values */
+  double rangeMin;                              /**< First generated x */
+  double rangeStep;                             /**< Distance of the generated x values */
+  size_t count;                                 /**< Number of x values */
+  size_t chunkCount;                            /**< Chunks per column */
+  unsigned char **columns;                      /**< Values of every output column inside the mapped output file */
+  enum reh_error_code_e *errors;                /**< Outcome of every chunk */
+};
+
+static void rev_PrintUsage(void){
+  fprintf(stderr,
+    "usage: equafun-eval [options] definition... [name=value]... [f']...\n"
+    "  Compiles the definitions once and evaluates them for every x value, one output row per x.\n"
+    "  name=value sets a parameter, f' adds the derivative of a function defined before it.\n"
+    "\n"
+    "  -i FILE            read the x values from FILE instead of stdin\n"
+    "  -o FILE            write the results to FILE instead of stdout\n"
+    "  -r MIN MAX COUNT   evaluate COUNT evenly spaced x values from MIN to MAX instead of reading them\n"
+    "  --in FORMAT        encoding of the x values: text (default), f32, f64 or col\n"
+    "  --out FORMAT       encoding of the results: csv (default), f32, f64 or col\n"
+    "  -p PRECISION       float (default, batch evaluator) or double\n"
+    "  -m MODE            math kernels of the float precision: exact (default), fast or draw\n"
+    "  -j THREADS         threads evaluating, 0 (default) for one per hardware thread\n"
+    "  -q                 don't print the throughput summary to stderr\n"
+    "  -v                 log debug messages to stderr\n"
+    "\n"
+    "  text input: numbers separated by whitespace or commas, '#' comments out the rest of a line\n"
+    "  csv output: a header line (x and the function names), then x and every function value per row\n"
+    "  f32 / f64:  little-endian floats without a header, output rows hold every function value (x left out)\n"
+    "  col:        column file (64 byte header with dtype, count and function id, then the values) mapped into\n"
+    "              memory, needs -i / -o files; the x values are its first column, the output has a column per\n"
+    "              function (f32 or f64 by precision) and needs the x count up front (col input or -r)\n"
+    "  undefined values (domain errors) are written as nan\n");
+}
+
+static double rev_NowSeconds(void){
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// reads the next argument as the value of an option
+static enum reh_error_code_e rev_OptionValue(int argc, char **argv, int *i, const char **value){
+  if (*i + 1 >= argc){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Option %s needs a value.", argv[*i]);
+  }
+  *value = argv[++*i];
+  return ERR_SUCCESS;
+}
+
+static enum reh_error_code_e rev_ParseNumber(const char *text, double *value){
+  char *end;
+  *value = strtod(text, &end);
+  if (end == text || *end != '\0' || isfinite(*value) == false){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "%s isn't a finite number.", text);
+  }
+  return ERR_SUCCESS;
+}
+
+// splits the options from the definitions (which never start with '-'), definitions collects the other arguments in order
+static enum reh_error_code_e rev_ParseOptions(int argc, char **argv, struct rev_options_t *options, char **definitions, int *definitionCount, bool *help){
+  memset(options, 0, sizeof *options);
+  options->inputFormat = REV_FORMAT_TEXT;
+  options->outputFormat = REV_FORMAT_TEXT;
+  options->precision = REE_PRECISION_FLOAT;
+  options->mathMode = REE_MATH_EXACT;
+  *help = false;
+  *definitionCount = 0;
+
+  for (int i = 1; i < argc; ++i){
+    const char *option = argv[i];
+    const char *value;
+
+    if (option[0] != '-'){
+      definitions[(*definitionCount)++] = argv[i];
+    }
+    else if (strcmp(option, "-h") == 0 || strcmp(option, "--help") == 0){
+      *help = true;
+    }
+    else if (strcmp(option, "-q") == 0){
+      options->quiet = true;
+    }
+    else if (strcmp(option, "-v") == 0){
+      options->verbose = true;
+    }
+    else if (strcmp(option, "-i") == 0){
+      CHECK_ERROR_CTX(rev_OptionValue(argc, argv, &i, &options->inputPath), "Invalid input option.");
+    }
+    else if (strcmp(option, "-o") == 0){
+      CHECK_ERROR_CTX(rev_OptionValue(argc, argv, &i, &options->outputPath), "Invalid output option.");
+    }
+    else if (strcmp(option, "--in") == 0 || strcmp(option, "--out") == 0){
+      CHECK_ERROR_CTX(rev_OptionValue(argc, argv, &i, &value), "Invalid format option.");
+      CHECK_ERROR_CTX(rev_ParseFormat(value, (option[2] == 'i') ? &options->inputFormat : &options->outputFormat), "Invalid format option.");
+    }
+    else if (strcmp(option, "-r") == 0){
+      if (i + 3 >= argc){
+        SET_ERROR_RETURN(ERR_INVALID_INPUT, "Option -r needs MIN, MAX and COUNT.");
+      }
+      double count;
+      CHECK_ERROR_CTX(rev_ParseNumber(argv[i + 1], &options->rangeMin), "Invalid range minimum.");
+      CHECK_ERROR_CTX(rev_ParseNumber(argv[i + 2], &options->rangeMax), "Invalid range maximum.");
+      CHECK_ERROR_CTX(rev_ParseNumber(argv[i + 3], &count), "Invalid range count.");
+      if (count < 1.0 || !rm_IsEqual(count, floor(count)) || count > 1e15){
+        SET_ERROR_RETURN(ERR_INVALID_INPUT, "Range count %s isn't a positive integer.", argv[i + 3]);
+      }
+      options->rangeCount = (size_t)count;
+      options->generate = true;
+      i += 3;
+    }
+    else if (strcmp(option, "-p") == 0){
+      CHECK_ERROR_CTX(rev_OptionValue(argc, argv, &i, &value), "Invalid precision option.");
+      if (strcmp(value, "float") == 0) options->precision = REE_PRECISION_FLOAT;
+      else if (strcmp(value, "double") == 0) options->precision = REE_PRECISION_DOUBLE;
+      else {
+        SET_ERROR_RETURN(ERR_INVALID_INPUT, "Unknown precision %s (expected float or double).", value);
+      }
+    }
+    else if (strcmp(option, "-m") == 0){
+      CHECK_ERROR_CTX(rev_OptionValue(argc, argv, &i, &value), "Invalid math mode option.");
+      if (strcmp(value, "exact") == 0) options->mathMode = REE_MATH_EXACT;
+      else if (strcmp(value, "fast") == 0) options->mathMode = REE_MATH_FAST;
+      else if (strcmp(value, "draw") == 0) options->mathMode = REE_MATH_DRAW;
+      else {
+        SET_ERROR_RETURN(ERR_INVALID_INPUT, "Unknown math mode %s (expected exact, fast or draw).", value);
+      }
+    }
+    else if (strcmp(option, "-j") == 0){
+      double threads;
+      CHECK_ERROR_CTX(rev_OptionValue(argc, argv, &i, &value), "Invalid thread option.");
+      CHECK_ERROR_CTX(rev_ParseNumber(value, &threads), "Invalid thread count.");
+      if (threads < 0.0 || !rm_IsEqual(threads, floor(threads)) || threads > RTP_MAX_THREADS + 1){
+        SET_ERROR_RETURN(ERR_INVALID_INPUT, "Thread count %s isn't between 0 and %d.", value, RTP_MAX_THREADS + 1);
+      }
+      options->threadCount = (int)threads;
+    }
+    else {
+      SET_ERROR_RETURN(ERR_INVALID_INPUT, "Unknown option %s (see -h).", option);
+    }
+  }
+
+  // column files are mapped, not streamed, and the output is sized before anything is evaluated
+  if (options->inputFormat == REV_FORMAT_COLUMNS && options->generate == false && options->inputPath == nullptr && *help == false){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Column input is mapped from a file, it needs -i FILE.");
+  }
+  if (options->outputFormat == REV_FORMAT_COLUMNS && *help == false){
+    if (options->outputPath == nullptr){
+      SET_ERROR_RETURN(ERR_INVALID_INPUT, "Column output is mapped to a file, it needs -o FILE.");
+    }
+    else if (options->generate == false && options->inputFormat != REV_FORMAT_COLUMNS){
+      SET_ERROR_RETURN(ERR_INVALID_INPUT, "Column output needs the number of x values up front, use -r or column input.");
+    }
+  }
+
+  return ERR_SUCCESS;
+}
+
+// adds the definitions, parameters and derivatives in argument order, columns keeps the handle of every function in that order
+static enum reh_error_code_e rev_AddFunctions(struct ree_function_manager_t *manager, char **definitions, int definitionCount, struct ree_function_handle_t *columns, int *columnCount){
+  *columnCount = 0;
+  for (int i = 0; i < definitionCount; ++i){
+    char *argument = definitions[i];
+    const size_t length = strlen(argument);
+
+    char parameterName[REE_MAX_PARAMETER_NAME_LEN + 1];
+    float parameterValue;
+    if (ree_ParseParameterAssignment(argument, parameterName, sizeof parameterName, &parameterValue) == true){
+      CHECK_ERROR_CTX(ree_SetParameter(manager, parameterName, parameterValue), "Failed to set the parameter %s.", parameterName);
+      continue;
+    }
+
+    if (strchr(argument, '=') == nullptr && length > 1 && argument[length - 1] == '\''){
+      argument[length - 1] = '\0';
+      enum reh_error_code_e err = ree_AddDerivative(manager, argument, &functionColorArray[0]);
+      argument[length - 1] = '\'';
+      CHECK_ERROR_CTX(err, "Failed to add the derivative %s.", argument);
+    }
+    else {
+      CHECK_ERROR_CTX(ree_AddFunction(manager, argument, &functionColorArray[0]), "Failed to add the definition %s.", argument);
+    }
+    columns[(*columnCount)++] = manager->functions[manager->functionCount - 1].handle;
+  }
+
+  if (*columnCount == 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "No function definitions given (see -h).");
+  }
+  return ERR_SUCCESS;
+}
+
+// evaluates one chunk of one column, runs on the pool
+static void rev_EvaluateChunk(void *userData, size_t index){
+  struct rev_block_job_t *job = userData;
+  const size_t column = index / job->chunkCount;
+  const size_t first = (index % job->chunkCount) * REV_CHUNK_SAMPLES;
+  const size_t count = (first + REV_CHUNK_SAMPLES < job->count) ? REV_CHUNK_SAMPLES : job->count - first;
+  const struct ree_program_t *program = job->programs[column];
+  double *ys = job->ys[column] + first;
+
+  enum reh_error_code_e err = ERR_SUCCESS;
+  if (job->precision == REE_PRECISION_FLOAT){
+    float *ysFloat = job->ysFloat + column * REV_BLOCK_SAMPLES + first;
+    uint8_t *status = job->status + column * REV_BLOCK_SAMPLES + first;
+    err = ree_EvaluateBatchMode(program, job->mathMode, job->xsFloat + first, count, ysFloat, status);
+    for (size_t i = 0; i < count && err == ERR_SUCCESS; ++i){
+      ys[i] = (status[i] == REE_EVAL_OK) ? (double)ysFloat[i] : (double)NAN;
+    }
+  }
+  else {
+    for (size_t i = 0; i < count && err == ERR_SUCCESS; ++i){
+      uint8_t status;
+      err = ree_EvaluateProgramDouble(program, &job->xs[first + i], &ys[i], &status);
+      if (status != REE_EVAL_OK) ys[i] = NAN;
+    }
+  }
+
+  job->errors[index] = err;
+  if (err != ERR_SUCCESS){
+    reh_ClearError();
+  }
+}
+
+// resolves the program and name of every column, compiling the float tier to native code
+static void rev_PreparePrograms(const struct rev_options_t *options, struct ree_function_manager_t *manager, const struct ree_function_handle_t *handles, int columnCount, const struct ree_program_t **programs, const char **names){
+  for (int c = 0; c < columnCount; ++c){
+    struct ree_function_t *function = ree_ResolveFunction(manager, handles[c]);
+    programs[c] = &function->program;
+    names[c] = function->name;
+
+    // every block is a large batch, so compile to native code right away instead of waiting for the function to get hot
+    if (options->precision == REE_PRECISION_FLOAT && function->program.jit == nullptr && ree_JitIsSupported() == true){
+      if (ree_JitCompile(&function->program, options->mathMode) != ERR_SUCCESS){
+        rl_LogMsg(RL_DEBUG, "Function %s stays interpreted: %s", function->name, reh_GetLastError()->message);
+        reh_ClearError();
+      }
+    }
+  }
+}
+
+static enum reh_error_code_e rev_Run(const struct rev_options_t *options, struct ree_function_manager_t *manager, const struct ree_function_handle_t *handles, int columnCount, struct rtp_thread_pool_t *pool, struct rev_reader_t *reader, struct rev_writer_t *writer, size_t *sampleCount, double *evaluationSeconds){
+  const struct ree_program_t **programs = calloc((size_t)columnCount, sizeof *programs);
+  const char **names = calloc((size_t)columnCount, sizeof *names);
+  double **ys = calloc((size_t)columnCount, sizeof *ys);
+  double *xs = malloc(REV_BLOCK_SAMPLES * sizeof *xs);
+  float *xsFloat = malloc(REV_BLOCK_SAMPLES * sizeof *xsFloat);
+  double *ysData = malloc((size_t)columnCount * REV_BLOCK_SAMPLES * sizeof *ysData);
+  float *ysFloat = malloc((size_t)columnCount * REV_BLOCK_SAMPLES * sizeof *ysFloat);
+  uint8_t *status = malloc((size_t)columnCount * REV_BLOCK_SAMPLES * sizeof *status);
+  const size_t maxChunks = (size_t)columnCount * ((REV_BLOCK_SAMPLES + REV_CHUNK_SAMPLES - 1) / REV_CHUNK_SAMPLES);
+  enum reh_error_code_e *errors = malloc(maxChunks * sizeof *errors);
+
+  enum reh_error_code_e err = ERR_SUCCESS;
+  if (programs == nullptr || names == nullptr || ys == nullptr || xs == nullptr || xsFloat == nullptr || ysData == nullptr || ysFloat == nullptr || status == nullptr || errors == nullptr){
+    reh_SetError(ERR_OUT_OF_MEMORY, __FILE__, __LINE__, __func__, "Failed to allocate the evaluation buffers.", nullptr);
+    err = ERR_OUT_OF_MEMORY;
+  }
+
+  if (err == ERR_SUCCESS){
+    rev_PreparePrograms(options, manager, handles, columnCount, programs, names);
+    for (int c = 0; c < columnCount; ++c){
+      ys[c] = ysData + (size_t)c * REV_BLOCK_SAMPLES;
+    }
+    err = rev_WriteHeader(writer, names, columnCount);
+  }
+
+  struct rev_block_job_t job = {
+    .programs = programs,
+    .columnCount = columnCount,
+    .precision = options->precision,
+    .mathMode = options->mathMode,
+    .xs = xs,
+    .xsFloat = xsFloat,
+    .ys = ys,
+    .ysFloat = ysFloat,
+    .status = status,
+    .errors = errors,
+  };
+
+  size_t generated = 0;
+  *sampleCount = 0;
+  *evaluationSeconds = 0.0;
+  while (err == ERR_SUCCESS){
+    size_t count = 0;
+    if (options->generate == true){
+      const double step = (options->rangeCount > 1) ? (options->rangeMax - options->rangeMin) / (double)(options->rangeCount - 1) : 0.0;
+      while (count < REV_BLOCK_SAMPLES && generated < options->rangeCount){
+        xs[count++] = options->rangeMin + (double)generated++ * step;
+      }
+    }
+    else {
+      err = rev_ReadBlock(reader, xs, REV_BLOCK_SAMPLES, &count);
+    }
+    if (err != ERR_SUCCESS || count == 0) break;
+
+    const double start = rev_NowSeconds();
+    if (options->precision == REE_PRECISION_FLOAT){
+      for (size_t i = 0; i < count; ++i){
+        xsFloat[i] = (float)xs[i];
+      }
+    }
+    job.count = count;
+    job.chunkCount = (count + REV_CHUNK_SAMPLES - 1) / REV_CHUNK_SAMPLES;
+    const size_t taskCount = (size_t)columnCount * job.chunkCount;
+    rtp_ParallelFor(pool, taskCount, rev_EvaluateChunk, &job);
+    *evaluationSeconds += rev_NowSeconds() - start;
+
+    for (size_t t = 0; t < taskCount && err == ERR_SUCCESS; ++t){
+      if (errors[t] != ERR_SUCCESS){
+        char message[128];
+        snprintf(message, sizeof(message), "Evaluating %s failed.", names[t / job.chunkCount]);
+        err = errors[t];
+        reh_SetError(err, __FILE__, __LINE__, __func__, message, nullptr);
+      }
+    }
+    if (err == ERR_SUCCESS){
+      err = rev_WriteBlock(writer, xs, (const double *const *)ys, columnCount, count);
+      *sampleCount += count * (size_t)columnCount;
+    }
+  }
+
+  free(programs);
+  free(names);
+  free(ys);
+  free(xs);
+  free(xsFloat);
+  free(ysData);
+  free(ysFloat);
+  free(status);
+  free(errors);
+  return err;
+}
+
+static double rev_MappedX(const struct rev_mapped_job_t *job, size_t i){
+  if (job->xs == nullptr) return job->rangeMin + (double)i * job->rangeStep;
+  if (job->xType == REV_DTYPE_F32) return (double)((const float*)job->xs)[i];
+  return ((const double*)job->xs)[i];
+}
+
+// evaluates one chunk of one column in place, runs on the pool
+static void rev_EvaluateMappedChunk(void *userData, size_t index){
+  struct rev_mapped_job_t *job = userData;
+  const size_t column = index / job->chunkCount;
+  const size_t first = (index % job->chunkCount) * REV_CHUNK_SAMPLES;
+  const size_t count = (first + REV_CHUNK_SAMPLES < job->count) ? REV_CHUNK_SAMPLES : job->count - first;
+  const struct ree_program_t *program = job->programs[column];
+
+  enum reh_error_code_e err = ERR_SUCCESS;
+  if (job->precision == REE_PRECISION_FLOAT){
+    float *ys = (float*)job->columns[column] + first;
+    uint8_t status[REV_CHUNK_SAMPLES];
+
+    // f32 x values are evaluated where they are mapped, the others are narrowed a chunk at a time
+    if (job->xs != nullptr && job->xType == REV_DTYPE_F32){
+      err = ree_EvaluateBatchMode(program, job->mathMode, (const float*)job->xs + first, count, ys, status);
+    }
+    else {
+      float narrowed[REV_CHUNK_SAMPLES];
+      for (size_t i = 0; i < count; ++i){
+        narrowed[i] = (float)rev_MappedX(job, first + i);
+      }
+      err = ree_EvaluateBatchMode(program, job->mathMode, narrowed, count, ys, status);
+    }
+    for (size_t i = 0; i < count && err == ERR_SUCCESS; ++i){
+      if (status[i] != REE_EVAL_OK) ys[i] = NAN;
+    }
+  }
+  else {
+    double *ys = (double*)job->columns[column] + first;
+    for (size_t i = 0; i < count && err == ERR_SUCCESS; ++i){
+      const double x = rev_MappedX(job, first + i);
+      uint8_t status;
+      err = ree_EvaluateProgramDouble(program, &x, &ys[i], &status);
+      if (status != REE_EVAL_OK) ys[i] = NAN;
+    }
+  }
+
+  job->errors[index] = err;
+  if (err != ERR_SUCCESS){
+    reh_ClearError();
+  }
+}
+
+// evaluates every x value (mapped or generated) into a column file created at the output path, no block is staged in between
+static enum reh_error_code_e rev_RunMapped(const struct rev_options_t *options, struct ree_function_manager_t *manager, const struct ree_function_handle_t *handles, int columnCount, struct rtp_thread_pool_t *pool, const unsigned char *xs, const struct rev_column_header_t *xHeader, size_t *sampleCount, double *evaluationSeconds){
+  const uint64_t count = (xs != nullptr) ? xHeader->count : (uint64_t)options->rangeCount;
+  const enum rev_dtype_e outputType = (options->precision == REE_PRECISION_DOUBLE) ? REV_DTYPE_F64 : REV_DTYPE_F32;
+  const size_t columnSize = rev_ColumnSize(outputType, count);
+  if (columnSize == 0 || columnSize > SIZE_MAX / (size_t)columnCount){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "%llu values per column don't fit in memory.", (unsigned long long)count);
+  }
+
+  const size_t chunkCount = ((size_t)count + REV_CHUNK_SAMPLES - 1) / REV_CHUNK_SAMPLES;
+  const struct ree_program_t **programs = calloc((size_t)columnCount, sizeof *programs);
+  const char **names = calloc((size_t)columnCount, sizeof *names);
+  unsigned char **columns = calloc((size_t)columnCount, sizeof *columns);
+  enum reh_error_code_e *errors = calloc((size_t)columnCount * chunkCount + 1, sizeof *errors);
+  if (programs == nullptr || names == nullptr || columns == nullptr || errors == nullptr){
+    free(programs);
+    free(names);
+    free(columns);
+    free(errors);
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the evaluation job.");
+  }
+
+  struct rev_mapped_file_t output;
+  enum reh_error_code_e err = rev_CreateMappedFile(options->outputPath, columnSize * (size_t)columnCount, &output);
+  if (err == ERR_SUCCESS){
+    rev_PreparePrograms(options, manager, handles, columnCount, programs, names);
+    for (int c = 0; c < columnCount; ++c){
+      struct rev_column_header_t header = {
+        .version = REV_COLUMN_VERSION,
+        .dtype = outputType,
+        .count = count,
+        .functionId = (uint32_t)c,
+      };
+      strncpy(header.name, names[c], sizeof header.name - 1);
+
+      columns[c] = output.data + (size_t)c * columnSize;
+      rev_WriteColumnHeader(columns[c], &header);
+      columns[c] += REV_COLUMN_HEADER_SIZE;
+    }
+
+    struct rev_mapped_job_t job = {
+      .programs = programs,
+      .precision = options->precision,
+      .mathMode = options->mathMode,
+      .xs = xs,
+      .xType = (xs != nullptr) ? xHeader->dtype : REV_DTYPE_F64,
+      .rangeMin = options->rangeMin,
+      .rangeStep = (options->rangeCount > 1) ? (options->rangeMax - options->rangeMin) / (double)(options->rangeCount - 1) : 0.0,
+      .count = (size_t)count,
+      .chunkCount = chunkCount,
+      .columns = columns,
+      .errors = errors,
+    };
+
+    const size_t taskCount = (size_t)columnCount * chunkCount;
+    const double start = rev_NowSeconds();
+    rtp_ParallelFor(pool, taskCount, rev_EvaluateMappedChunk, &job);
+    *evaluationSeconds = rev_NowSeconds() - start;
+    *sampleCount = (size_t)count * (size_t)columnCount;
+
+    for (size_t t = 0; t < taskCount && err == ERR_SUCCESS; ++t){
+      if (errors[t] != ERR_SUCCESS){
+        char message[128];
+        snprintf(message, sizeof(message), "Evaluating %s failed.", names[t / chunkCount]);
+        err = errors[t];
+        reh_SetError(err, __FILE__, __LINE__, __func__, message, nullptr);
+      }
+    }
+
+    if (rev_UnmapFile(&output) != ERR_SUCCESS && err == ERR_SUCCESS){
+      err = ERR_FILE_WRITE_FAILED;
+    }
+  }
+
+  free(programs);
+  free(names);
+  free(columns);
+  free(errors);
+  return err;
+}
+
+int main(int argc, char **argv){
+  // the results may go to stdout, the log never does
+  rl_SetLogOutput(stderr, RL_WARNING);
+
+  // every argument is a definition at most, so both lists are sized by argc
+  char **definitions = calloc((size_t)argc, sizeof *definitions);
+  struct ree_function_handle_t *handles = calloc((size_t)argc, sizeof *handles);
+  if (definitions == nullptr || handles == nullptr){
+    rl_LogMsg(RL_ERROR, "Failed to allocate the function list.");
+    free(definitions);
+    free(handles);
+    return 1;
+  }
+
+  struct rev_options_t options;
+  int definitionCount;
+  bool help;
+  if (rev_ParseOptions(argc, argv, &options, definitions, &definitionCount, &help) != ERR_SUCCESS){
+    rl_LogLastError(RL_ERROR);
+    free(definitions);
+    free(handles);
+    return 2;
+  }
+  if (help == true || definitionCount == 0){
+    rev_PrintUsage();
+    free(definitions);
+    free(handles);
+    return (help == true) ? 0 : 2;
+  }
+  if (options.verbose == true){
+    rl_SetLogOutput(stderr, RL_DEBUG);
+  }
+
+  struct ree_function_manager_t manager;
+  if (ree_InitFunctionManager(&manager) != ERR_SUCCESS){
+    rl_LogLastError(RL_ERROR);
+    free(definitions);
+    free(handles);
+    return 1;
+  }
+
+  int exitCode = 1;
+  int columnCount = 0;
+  if (rev_AddFunctions(&manager, definitions, definitionCount, handles, &columnCount) != ERR_SUCCESS){
+    rl_LogLastError(RL_ERROR);
+    free(definitions);
+    free(handles);
+    ree_DestroyFunctionManager(&manager);
+    return 1;
+  }
+
+  // column input is mapped and read in place, the other formats are streamed
+  FILE *input = stdin;
+  FILE *output = stdout;
+  struct rev_mapped_file_t inputFile = {0};
+  struct rev_column_header_t xHeader;
+  const unsigned char *xs = nullptr;
+  bool ready = true;
+  if (options.generate == false && options.inputFormat == REV_FORMAT_COLUMNS){
+    input = nullptr;
+    if (rev_MapFile(options.inputPath, &inputFile) != ERR_SUCCESS || rev_ReadColumn(&inputFile, 0, &xHeader, &xs) != ERR_SUCCESS){
+      rl_LogLastError(RL_ERROR);
+      ready = false;
+    }
+  }
+  else if (options.inputPath != nullptr && options.generate == false){
+    input = fopen(options.inputPath, "rb");
+    if (input == nullptr){
+      rl_LogMsg(RL_ERROR, "Failed to open %s for reading.", options.inputPath);
+      ready = false;
+    }
+  }
+
+  // column output is created once the evaluation knows its size
+  if (options.outputFormat == REV_FORMAT_COLUMNS){
+    output = nullptr;
+  }
+  else if (options.outputPath != nullptr){
+    output = fopen(options.outputPath, "wb");
+    if (output == nullptr){
+      rl_LogMsg(RL_ERROR, "Failed to open %s for writing.", options.outputPath);
+      ready = false;
+    }
+  }
+
+  // the caller evaluates along, so a pool for n threads has n - 1 workers
+  struct rtp_thread_pool_t pool;
+  bool poolStarted = false;
+  const int threadCount = (options.threadCount == 0) ? rtp_HardwareThreadCount() : options.threadCount;
+  if (ready == true && threadCount > 1){
+    if (rtp_InitThreadPool(&pool, threadCount - 1) == ERR_SUCCESS){
+      poolStarted = true;
+    }
+    else {
+      rl_LogLastError(RL_WARNING);
+      rl_LogMsg(RL_WARNING, "Evaluating on the calling thread only.");
+    }
+  }
+
+  if (ready == true){
+    size_t sampleCount = 0;
+    double evaluationSeconds = 0.0;
+    const double start = rev_NowSeconds();
+    enum reh_error_code_e err;
+    if (options.outputFormat == REV_FORMAT_COLUMNS){
+      err = rev_RunMapped(&options, &manager, handles, columnCount, poolStarted ? &pool : nullptr, xs, &xHeader, &sampleCount, &evaluationSeconds);
+      if (err != ERR_SUCCESS){
+        rl_LogLastError(RL_ERROR);
+      }
+    }
+    else {
+      struct rev_reader_t reader;
+      struct rev_writer_t writer;
+      if (xs != nullptr){
+        rev_InitMappedReader(&reader, xs, xHeader.dtype, (size_t)xHeader.count);
+      }
+      else {
+        rev_InitReader(&reader, input, options.inputFormat);
+      }
+      rev_InitWriter(&writer, output, options.outputFormat, (options.precision == REE_PRECISION_DOUBLE) ? 17 : 9);
+
+      err = rev_Run(&options, &manager, handles, columnCount, poolStarted ? &pool : nullptr, &reader, &writer, &sampleCount, &evaluationSeconds);
+      if (err != ERR_SUCCESS){
+        rl_LogLastError(RL_ERROR);
+      }
+      if (rev_DestroyWriter(&writer) != ERR_SUCCESS && err == ERR_SUCCESS){
+        rl_LogLastError(RL_ERROR);
+        err = ERR_FILE_WRITE_FAILED;
+      }
+      rev_DestroyReader(&reader);
+    }
+    const double totalSeconds = rev_NowSeconds() - start;
+
+    if (err == ERR_SUCCESS){
+      exitCode = 0;
+      if (options.quiet == false){
+        const int usedThreads = poolStarted ? pool.threadCount + 1 : 1;
+        const double rate = (evaluationSeconds > 0.0) ? (double)sampleCount / evaluationSeconds : 0.0;
+        fprintf(stderr, "equafun-eval: %zu samples (%d functions, %s, %s) in %.3f s evaluating, %.3f s total\n",
+                sampleCount, columnCount, ree_PrecisionToStr(options.precision), ree_MathModeToStr(options.mathMode), evaluationSeconds, totalSeconds);
+        fprintf(stderr, "equafun-eval: %.2f M samples/s on %d threads, %.2f M samples/s per core\n", rate * 1e-6, usedThreads, rate * 1e-6 / usedThreads);
+      }
+    }
+  }
+
+  if (poolStarted == true){
+    rtp_DestroyThreadPool(&pool);
+  }
+  if (input != nullptr && input != stdin){
+    fclose(input);
+  }
+  if (rev_UnmapFile(&inputFile) != ERR_SUCCESS){
+    rl_LogLastError(RL_WARNING);
+  }
+  if (output != nullptr && output != stdout && fclose(output) != 0){
+    rl_LogMsg(RL_ERROR, "Failed to close %s.", options.outputPath);
+    exitCode = 1;
+  }
+  free(definitions);
+  free(handles);
+  ree_DestroyFunctionManager(&manager);
+
+  return exitCode;
+}
@@ -0,0 +1,254 @@
+// ftruncate and madvise aren't part of strict ISO C, ask glibc for the default feature set before any include
+#define _DEFAULT_SOURCE
+
+#include "eval.h"
+#include "core/errorHandler.h"
+
+#include <errno.h>
+#include <string.h>
+
+#ifdef _WIN32
+  #define NOGDI
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+static size_t rev_DtypeWidth(enum rev_dtype_e dtype){
+  return (dtype == REV_DTYPE_F32) ? sizeof(float) : sizeof(double);
+}
+
+size_t rev_ColumnSize(enum rev_dtype_e dtype, uint64_t count){
+  const size_t width = rev_DtypeWidth(dtype);
+  if (count > (SIZE_MAX - REV_COLUMN_HEADER_SIZE - REV_COLUMN_ALIGNMENT) / width){
+    return 0;
+  }
+
+  const size_t size = REV_COLUMN_HEADER_SIZE + (size_t)count * width;
+  return (size + REV_COLUMN_ALIGNMENT - 1) / REV_COLUMN_ALIGNMENT * REV_COLUMN_ALIGNMENT;
+}
+
+enum reh_error_code_e rev_MapFile(const char *path, struct rev_mapped_file_t *file){
+  if (path == nullptr || file == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Path or file passed to rev_MapFile is NULL.");
+  }
+
+  memset(file, 0, sizeof *file);
+
+#ifdef _WIN32
+  HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (handle == INVALID_HANDLE_VALUE){
+    SET_ERROR_RETURN(ERR_FILE_NOT_FOUND, "Failed to open %s for reading (error %lu).", path, GetLastError());
+  }
+
+  LARGE_INTEGER size;
+  if (GetFileSizeEx(handle, &size) == 0 || size.QuadPart == 0){
+    CloseHandle(handle);
+    SET_ERROR_RETURN(ERR_FILE_INVALID_FORMAT, "%s is empty or its size can't be read.", path);
+  }
+
+  HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  void *data = (mapping != nullptr) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (data == nullptr){
+    if (mapping != nullptr) CloseHandle(mapping);
+    CloseHandle(handle);
+    SET_ERROR_RETURN(ERR_FILE_READ_FAILED, "Failed to map %s (error %lu).", path, GetLastError());
+  }
+
+  file->file = handle;
+  file->mapping = mapping;
+  file->size = (size_t)size.QuadPart;
+#else
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0){
+    SET_ERROR_RETURN(ERR_FILE_NOT_FOUND, "Failed to open %s for reading: %s", path, strerror(errno));
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0){
+    close(fd);
+    SET_ERROR_RETURN(ERR_FILE_INVALID_FORMAT, "%s is empty or its size can't be read.", path);
+  }
+
+  void *data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED){
+    close(fd);
+    SET_ERROR_RETURN(ERR_FILE_READ_FAILED, "Failed to map %s: %s", path, strerror(errno));
+  }
+  // the columns are read front to back, let the kernel read ahead aggressively
+  madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+  file->fd = fd;
+  file->size = (size_t)info.st_size;
+#endif
+
+  file->data = data;
+  file->writable = false;
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e rev_CreateMappedFile(const char *path, size_t size, struct rev_mapped_file_t *file){
+  if (path == nullptr || file == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Path or file passed to rev_CreateMappedFile is NULL.");
+  }
+  else if (size == 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Mapped files can't be empty.");
+  }
+
+  memset(file, 0, sizeof *file);
+
+#ifdef _WIN32
+  HANDLE handle = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (handle == INVALID_HANDLE_VALUE){
+    SET_ERROR_RETURN(ERR_FILE_WRITE_FAILED, "Failed to create %s (error %lu).", path, GetLastError());
+  }
+
+  // a mapping larger than the file extends it, the equivalent of ftruncate
+  const uint64_t size64 = (uint64_t)size;
+  HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READWRITE, (DWORD)(size64 >> 32), (DWORD)(size64 & 0xFFFFFFFFu), nullptr);
+  void *data = (mapping != nullptr) ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size) : nullptr;
+  if (data == nullptr){
+    if (mapping != nullptr) CloseHandle(mapping);
+    CloseHandle(handle);
+    SET_ERROR_RETURN(ERR_FILE_WRITE_FAILED, "Failed to map %s (error %lu).", path, GetLastError());
+  }
+
+  file->file = handle;
+  file->mapping = mapping;
+#else
+  const int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0){
+    SET_ERROR_RETURN(ERR_FILE_WRITE_FAILED, "Failed to create %s: %s", path, strerror(errno));
+  }
+
+  if (ftruncate(fd, (off_t)size) != 0){
+    const int error = errno;
+    close(fd);
+    SET_ERROR_RETURN(ERR_FILE_WRITE_FAILED, "Failed to size %s to %zu bytes: %s", path, size, strerror(error));
+  }
+
+  void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED){
+    const int error = errno;
+    close(fd);
+    SET_ERROR_RETURN(ERR_FILE_WRITE_FAILED, "Failed to map %s: %s", path, strerror(error));
+  }
+
+  file->fd = fd;
+#endif
+
+  file->data = data;
+  file->size = size;
+  file->writable = true;
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e rev_UnmapFile(struct rev_mapped_file_t *file){
+  if (file == nullptr || file->data == nullptr) return ERR_SUCCESS;
+
+  bool failed = false;
+#ifdef _WIN32
+  if (file->writable == true && FlushViewOfFile(file->data, 0) == 0) failed = true;
+  if (UnmapViewOfFile(file->data) == 0) failed = true;
+  CloseHandle(file->mapping);
+  CloseHandle(file->file);
+#else
+  // the pages of a shared mapping reach the file on their own, munmap doesn't wait for them
+  if (munmap(file->data, file->size) != 0) failed = true;
+  if (close(file->fd) != 0) failed = true;
+#endif
+
+  const bool writable = file->writable;
+  memset(file, 0, sizeof *file);
+  if (failed == true){
+    SET_ERROR_RETURN(writable ? ERR_FILE_WRITE_FAILED : ERR_FILE_READ_FAILED, "Failed to unmap a file.");
+  }
+
+  return ERR_SUCCESS;
+}
+
+static uint32_t rev_LoadU32(const unsigned char *bytes){
+  return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+static uint64_t rev_LoadU64(const unsigned char *bytes){
+  return (uint64_t)rev_LoadU32(bytes) | (uint64_t)rev_LoadU32(bytes + 4) << 32;
+}
+
+static void rev_StoreU32(unsigned char *bytes, uint32_t value){
+  for (int i = 0; i < 4; ++i){
+    bytes[i] = (unsigned char)(value >> (8 * i));
+  }
+}
+
+static void rev_StoreU64(unsigned char *bytes, uint64_t value){
+  rev_StoreU32(bytes, (uint32_t)value);
+  rev_StoreU32(bytes + 4, (uint32_t)(value >> 32));
+}
+
+static bool rev_IsLittleEndianHost(void){
+  const uint16_t probe = 1;
+  unsigned char first;
+  memcpy(&first, &probe, 1);
+  return first == 1;
+}
+
+enum reh_error_code_e rev_ReadColumn(const struct rev_mapped_file_t *file, size_t offset, struct rev_column_header_t *header, const unsigned char **values){
+  if (file == nullptr || file->data == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "File passed to rev_ReadColumn is NULL or not mapped.");
+  }
+  else if (header == nullptr || values == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Output pointers passed to rev_ReadColumn are NULL.");
+  }
+
+  if (offset > file->size || file->size - offset < REV_COLUMN_HEADER_SIZE){
+    SET_ERROR_RETURN(ERR_FILE_INVALID_FORMAT, "Column file is too small for a column header at offset %zu.", offset);
+  }
+
+  const unsigned char *bytes = file->data + offset;
+  if (memcmp(bytes, REV_COLUMN_MAGIC, sizeof REV_COLUMN_MAGIC) != 0){
+    SET_ERROR_RETURN(ERR_FILE_INVALID_FORMAT, "Not a column file (the magic doesn't match).");
+  }
+
+  memset(header, 0, sizeof *header);
+  header->version = rev_LoadU32(bytes + 8);
+  const uint32_t dtype = rev_LoadU32(bytes + 12);
+  header->count = rev_LoadU64(bytes + 16);
+  header->functionId = rev_LoadU32(bytes + 24);
+  memcpy(header->name, bytes + 32, REV_COLUMN_NAME_SIZE - 1);
+
+  if (header->version != REV_COLUMN_VERSION){
+    SET_ERROR_RETURN(ERR_FILE_INVALID_FORMAT, "Column file version %u isn't supported (expected %d).", header->version, REV_COLUMN_VERSION);
+  }
+  else if (dtype != REV_DTYPE_F32 && dtype != REV_DTYPE_F64){
+    SET_ERROR_RETURN(ERR_FILE_INVALID_FORMAT, "Unknown column dtype %u.", dtype);
+  }
+  header->dtype = (enum rev_dtype_e)dtype;
+
+  const size_t available = file->size - offset - REV_COLUMN_HEADER_SIZE;
+  if (header->count > available / rev_DtypeWidth(header->dtype)){
+    SET_ERROR_RETURN(ERR_FILE_INVALID_FORMAT, "Column %s is truncated: %llu values announced, room for %zu.", header->name, (unsigned long long)header->count, available / rev_DtypeWidth(header->dtype));
+  }
+  else if (rev_IsLittleEndianHost() == false){
+    SET_ERROR_RETURN(ERR_FILE_INVALID_FORMAT, "Column files are used in place, which needs a little-endian machine.");
+  }
+
+  *values = bytes + REV_COLUMN_HEADER_SIZE;
+  return ERR_SUCCESS;
+}
+
+void rev_WriteColumnHeader(unsigned char *destination, const struct rev_column_header_t *header){
+  if (destination == nullptr || header == nullptr) return;
+
+  memset(destination, 0, REV_COLUMN_HEADER_SIZE);
+  memcpy(destination, REV_COLUMN_MAGIC, sizeof REV_COLUMN_MAGIC);
+  rev_StoreU32(destination + 8, header->version);
+  rev_StoreU32(destination + 12, (uint32_t)header->dtype);
+  rev_StoreU64(destination + 16, header->count);
+  rev_StoreU32(destination + 24, header->functionId);
+  // the header is zeroed above, so a name cut at the last byte stays terminated
+  memcpy(destination + 32, header->name, strnlen(header->name, REV_COLUMN_NAME_SIZE - 1));
+}
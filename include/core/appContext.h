@@ -10,6 +10,11 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+// samples and vertex buffer of one function, kept between frames (see renderer/functionRenderer.h)
+struct rfr_function_cache_t;
+// worker threads the functions are sampled on (see core/threadPool.h)
+struct rtp_thread_pool_t;
+
 /**
   @brief Application context structure holding resources and state
 */
@@ -31,9 +36,12 @@ struct ra_app_context_t {
   /* Function resources
      EBO is not necessary as glDrawArrays() will be used. */
   GLuint fVAO;                  /**< Vertex Array Object for functions; 0 on failure. */
-  GLuint fVBO;                  /**< Vertex Buffer Object for functions; 0 on failure. */
+  GLuint fVBO;                  /**< Vertex Buffer Object the attribute layout of fVAO is set up with; 0 on failure. */
   GLuint fProgram;              /**< Shader program for functions; 0 on failure. */
-  GLsizeiptr fVertexCapacityBytes; /**< Allocated capacity for function vertex buffer in bytes. */
+  struct rfr_function_cache_t *fCache; /**< Owned per-function samples and vertex buffers, one entry per function handle. */
+  int fCacheCount;              /**< Number of cache entries in use. */
+  int fCacheCapacity;           /**< Number of cache entries allocated. */
+  struct rtp_thread_pool_t *fPool; /**< Owned thread pool sampling the functions; nullptr on failure. */
 
   /* FreeType */
   FT_Library ft;                /**< FreeType library handle. */
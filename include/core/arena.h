@@ -0,0 +1,97 @@
+/**
+  rma - Robkoo's Memory Arena
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "core/errorHandler.h"
+
+#include <stddef.h>
+
+// default size of a pooled arena block in bytes
+#define RMA_DEFAULT_BLOCK_SIZE 4096
+// default amount of free blocks a pool keeps around for reuse
+#define RMA_DEFAULT_MAX_FREE_BLOCKS 64
+
+/*
+  Allocator hooks, embedders can route every arena block through their own allocator.
+  Only whole blocks go through the hooks, individual arena allocations never do.
+*/
+struct rma_allocator_t {
+  void* (*alloc)(size_t size, void *userData); /**< Allocates size bytes, returns nullptr on failure */
+  void  (*free)(void *ptr, void *userData);    /**< Frees memory returned by alloc */
+  void *userData;                              /**< Passed through to the hooks */
+};
+
+struct rma_block_t {
+  struct rma_block_t *next;  /**< Previously filled block (in an arena) or next free block (in a pool) */
+  size_t capacity;           /**< Usable bytes in data */
+  size_t used;               /**< Bytes handed out so far */
+  max_align_t data[];        /**< Block memory, aligned for any type */
+};
+
+/*
+  Shared source of blocks for several arenas.
+  Blocks released by an arena reset go back to the pool, so adding and removing functions doesn't hit malloc.
+*/
+struct rma_pool_t {
+  struct rma_allocator_t allocator;  /**< Hooks used for every block of the pool */
+  size_t blockSize;                  /**< Capacity of pooled blocks, larger requests get a dedicated block */
+  struct rma_block_t *freeBlocks;    /**< Blocks ready for reuse */
+  int freeBlockCount;                /**< Number of blocks in freeBlocks */
+  int maxFreeBlocks;                 /**< Blocks above this count are returned to the allocator */
+};
+
+/*
+  Bump allocator, everything allocated from it is released at once with rma_ResetArena.
+*/
+struct rma_arena_t {
+  struct rma_pool_t *pool;    /**< Pool the blocks come from and go back to */
+  struct rma_block_t *head;   /**< Block currently allocated from, older blocks are linked through next */
+  size_t lastOffset;          /**< Offset of the most recent allocation in head, lets rma_Realloc grow it in place */
+};
+
+/**
+  @brief Sets the allocator hooks used by pools initialized afterwards without explicit hooks (nullptr restores malloc / free)
+*/
+void rma_SetDefaultAllocator(const struct rma_allocator_t *allocator);
+
+/**
+  @brief Gets the current default allocator hooks
+*/
+const struct rma_allocator_t* rma_GetDefaultAllocator(void);
+
+/**
+  @brief Initializes a block pool, allocator can be nullptr to use the default allocator
+*/
+enum reh_error_code_e rma_InitPool(struct rma_pool_t *pool, size_t blockSize, int maxFreeBlocks, const struct rma_allocator_t *allocator);
+
+/**
+  @brief Frees every block held by the pool, arenas using it must be reset before
+*/
+void rma_DestroyPool(struct rma_pool_t *pool);
+
+/**
+  @brief Initializes an empty arena drawing blocks from the pool
+*/
+void rma_InitArena(struct rma_arena_t *arena, struct rma_pool_t *pool);
+
+/**
+  @brief Allocates size bytes from the arena, aligned for any type
+  @return nullptr if the allocator ran out of memory
+*/
+void* rma_Alloc(struct rma_arena_t *arena, size_t size);
+
+/**
+  @brief Resizes an allocation, the most recent allocation is resized in place when it fits
+  @return nullptr if the allocator ran out of memory (ptr stays valid)
+*/
+void* rma_Realloc(struct rma_arena_t *arena, void *ptr, size_t oldSize, size_t newSize);
+
+/**
+  @brief Releases everything allocated from the arena in one go, the blocks go back to the pool
+*/
+void rma_ResetArena(struct rma_arena_t *arena);
+
+#endif // ARENA_H
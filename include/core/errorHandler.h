@@ -72,6 +72,7 @@ enum reh_error_code_e {
 
   // Generic errors (9xx)
   ERR_INVALID_INPUT = 900,
+  ERR_UNSUPPORTED = 901,
   ERR_UNKNOWN = 999
 };
 
@@ -131,6 +132,7 @@ struct reh_error_context_t {
 
 /**
   @brief Sets the current error context.
+  @note The error context is per thread, an error set on a worker thread isn't seen by reh_GetLastError on any other
 */
 void reh_SetError(enum reh_error_code_e code, const char* file, int line, const char* fnName, const char* message, const char* technicalInfo);
 
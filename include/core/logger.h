@@ -7,6 +7,8 @@
 
 #include "core/errorHandler.h"
 
+#include <stdio.h>
+
 // ASCII codes for colors for the different levels
 #ifdef __linux__
   #define RL_DEBUG_COLOR     "\x1B[1;36m"
@@ -39,6 +41,12 @@ enum rl_log_level_e {
   RL_FAILURE = 3 // program cant continue functioning
 };
 
+/**
+  @brief Redirects log messages to a stream (nullptr for stdout) and drops the ones less severe than minimumLevel.
+  @note Tools writing their results to stdout send the log to stderr, so it never mixes with the data.
+*/
+void rl_SetLogOutput(FILE *stream, enum rl_log_level_e minimumLevel);
+
 /**
   @brief Logs a message to the console with a given severity.
 */
@@ -0,0 +1,68 @@
+/**
+  rtp - Robkoo's Thread Pool
+*/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "core/errorHandler.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// upper bound on worker threads, a pool never starts more even on larger machines
+#define RTP_MAX_THREADS 64
+
+/**
+  @brief Task run by the pool, called once for every index of a batch
+*/
+typedef void (*rtp_task_t)(void *userData, size_t index);
+
+/*
+  Fixed set of worker threads that run batches of independent tasks.
+  rtp_ParallelFor hands out the indices of a batch one at a time, so uneven tasks still keep every thread busy, and the calling thread works along.
+*/
+struct rtp_thread_pool_t {
+  pthread_t threads[RTP_MAX_THREADS]; /**< Worker threads, the calling thread isn't one of them */
+  int threadCount;                    /**< Number of started worker threads */
+
+  pthread_mutex_t mutex;              /**< Guards everything below except nextTask */
+  pthread_cond_t wake;                /**< Signalled when a batch starts or the pool stops */
+  pthread_cond_t idle;                /**< Signalled when the last busy worker leaves a batch */
+
+  rtp_task_t task;                    /**< Task of the current batch */
+  void *userData;                     /**< Passed through to task */
+  size_t taskCount;                   /**< Number of indices in the current batch */
+  atomic_size_t nextTask;             /**< Next index to hand out, claimed without the mutex */
+  uint64_t batch;                     /**< Incremented for every batch, workers compare it to the last one they joined */
+  int busyWorkers;                    /**< Workers that joined the current batch and haven't left it */
+  bool stopping;                      /**< Set by rtp_DestroyThreadPool, workers exit */
+};
+
+/**
+  @brief Number of hardware threads of the machine, 1 if it can't be determined
+*/
+int rtp_HardwareThreadCount(void);
+
+/**
+  @brief Starts a pool with threadCount workers, 0 starts one less than rtp_HardwareThreadCount (the caller is the last one)
+  @note threadCount is clamped to RTP_MAX_THREADS, a pool without workers runs every batch on the calling thread
+*/
+enum reh_error_code_e rtp_InitThreadPool(struct rtp_thread_pool_t *pool, int threadCount);
+
+/**
+  @brief Stops and joins every worker of the pool
+*/
+void rtp_DestroyThreadPool(struct rtp_thread_pool_t *pool);
+
+/**
+  @brief Runs task for every index in [0, taskCount) on the workers and the calling thread, returns once all of them finished
+  @note A pool of nullptr runs every task on the calling thread
+  @note Tasks must not call rtp_ParallelFor on the same pool, and only one thread may start batches at a time
+  @note Errors set inside a task stay on the thread that ran it (the error state is per thread), tasks have to hand them back through userData
+*/
+void rtp_ParallelFor(struct rtp_thread_pool_t *pool, size_t taskCount, rtp_task_t task, void *userData);
+
+#endif // THREAD_POOL_H
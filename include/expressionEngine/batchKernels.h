@@ -0,0 +1,47 @@
+/**
+  ree - Robkoo's Expression Engine
+*/
+
+#ifndef BATCH_KERNELS_H
+#define BATCH_KERNELS_H
+
+#include <stddef.h>
+
+enum ree_kernel_isa_e {
+  REE_ISA_SCALAR = 0, /**< Portable C loops */
+  REE_ISA_SSE2   = 1, /**< 4-wide SSE2 kernels */
+  REE_ISA_AVX2   = 2, /**< 8-wide AVX2 kernels */
+};
+
+/*
+  Lane-wise kernels used by the batch evaluator.
+  Binary kernels compute a[i] = a[i] op b[i], unary kernels compute a[i] = op a[i].
+  All kernels only use correctly rounded IEEE 754 operations, so every ISA gives bit-identical results.
+*/
+struct ree_batch_kernels_t {
+  enum ree_kernel_isa_e isa;                             /**< Instruction set the kernels were built for */
+  void (*add)(float *a, const float *b, size_t count);   /**< a = a + b */
+  void (*sub)(float *a, const float *b, size_t count);   /**< a = a - b */
+  void (*mul)(float *a, const float *b, size_t count);   /**< a = a * b */
+  void (*div)(float *a, const float *b, size_t count);   /**< a = a / b */
+  void (*neg)(float *a, size_t count);                   /**< a = -a */
+  void (*abs)(float *a, size_t count);                   /**< a = |a| */
+  void (*sqrt)(float *a, size_t count);                  /**< a = sqrt(a) */
+};
+
+/**
+  @brief Converts a kernel instruction set to its string representation
+*/
+const char* ree_KernelIsaToStr(enum ree_kernel_isa_e isa);
+
+/**
+  @brief Gets the batch kernels for the best instruction set supported by the running CPU
+*/
+const struct ree_batch_kernels_t* ree_GetBatchKernels(void);
+
+/**
+  @brief Gets the batch kernels for a specific instruction set, falls back to scalar if unsupported
+*/
+const struct ree_batch_kernels_t* ree_GetBatchKernelsForIsa(enum ree_kernel_isa_e isa);
+
+#endif // BATCH_KERNELS_H
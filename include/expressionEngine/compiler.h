@@ -0,0 +1,111 @@
+/**
+  ree - Robkoo's Expression Engine
+*/
+
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "core/arena.h"
+#include "core/errorHandler.h"
+#include "expressionEngine/parameters.h"
+#include "expressionEngine/parser/shuntingYard.h"
+
+#include <stdint.h>
+
+// maximum amount of variable slots a program can reference (slot index is stored in one byte)
+#define REE_MAX_VARIABLE_SLOTS 256
+// maximum amount of temporary slots for shared subexpressions (slot index is stored in one byte)
+#define REE_MAX_TEMP_SLOTS 256
+// deepest evaluation stack a program may need, the interpreters keep a fixed stack of this size instead of sizing one per call
+#define REE_MAX_STACK_DEPTH 256
+
+/*
+  Bytecode layout:
+    every instruction starts with a one-byte opcode
+    OP_CONST is followed by an inline float (sizeof(float) bytes, native endianness)
+    OP_VAR is followed by a one-byte variable slot index
+    OP_PARAM is followed by a one-byte global parameter index (see parameters.h)
+    OP_STORE and OP_LOAD are followed by a one-byte temporary slot index
+    every other opcode has no operands
+
+  OP_STORE copies the top of the stack into a temporary slot without popping it,
+  OP_LOAD pushes a temporary slot, together they compute shared subexpressions only once
+
+  Operand counts are checked once, when the RPN is compiled (see ree_MeasureRpnStack): every instruction of a program
+  finds its operands on the stack, the stack never gets deeper than maxStackDepth and exactly one value is left at the end.
+  The interpreters rely on it and don't check for stack underflow or overflow per instruction.
+*/
+enum ree_opcode_e {
+  OP_CONST = 0, OP_VAR,
+  OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_POW,
+  OP_FACT, OP_NEG, OP_POS,
+  OP_SIN, OP_COS, OP_TAN, OP_SQRT, OP_ABS, OP_LN, OP_LOG,
+  OP_STORE, OP_LOAD, OP_PARAM,
+  OP_COUNT
+};
+
+struct ree_jit_program_t;
+
+struct ree_program_t {
+  uint8_t *code;     /**< Opcode stream with inline operands, owned by the arena it was compiled into */
+  int codeSize;      /**< Size of the opcode stream in bytes */
+  int opCount;       /**< Number of instructions in the opcode stream */
+  int maxStackDepth; /**< Maximum evaluation stack depth, computed at compile time, never above REE_MAX_STACK_DEPTH */
+  int tempCount;     /**< Number of temporary slots used by OP_STORE / OP_LOAD */
+  const float *parameters; /**< Values of the parameter table OP_PARAM reads, nullptr if the program reads none */
+  uint64_t parameterMask;  /**< Bit i is set if the program reads parameter i */
+  struct ree_jit_program_t *jit; /**< Native code for hot programs, nullptr while interpreted (see jit.h) */
+};
+
+/*
+  Several programs over the same variables compiled into one, so a single pass evaluates all of them.
+  Subexpressions the programs have in common are computed once into a temporary slot and loaded by every other user.
+  Unlike a plain program it leaves one value per fused program on the stack, in the order the programs were given.
+*/
+struct ree_fused_program_t {
+  struct ree_program_t program;  /**< Bytecode computing every output, never native code */
+  int outputCount;               /**< Number of programs fused, stack entry i holds the result of program i at the end */
+};
+
+/**
+  @brief Converts an opcode to its string representation
+*/
+const char* ree_OpcodeToStr(enum ree_opcode_e opcode);
+
+/**
+  @brief Gets the size of an instruction (opcode + inline operands) in bytes
+*/
+int ree_OpcodeSize(enum ree_opcode_e opcode);
+
+/**
+  @brief Gets the number of stack operands an opcode consumes (OP_STORE peeks, so it consumes none)
+*/
+int ree_OpcodeArity(enum ree_opcode_e opcode);
+
+/**
+  @brief Checks that every RPN token finds its operands and that exactly one value is left, and computes the deepest the stack gets
+  @note Expressions needing more than REE_MAX_STACK_DEPTH stack entries are rejected
+*/
+enum reh_error_code_e ree_MeasureRpnStack(const struct ree_output_token_t *rpn, int rpnCount, int *maxStackDepth);
+
+/**
+  @brief Compiles an RPN token array into bytecode, resolving variables to slot indices
+  @note Identifiers that aren't variables are global parameters, declared in the table if new (without a table they're an error)
+  @note Identical subtrees are merged into a DAG and computed once into a temporary slot
+  @note The DAG is built in the scratch arena, the bytecode is allocated from arena and released with it
+*/
+enum reh_error_code_e ree_CompileRpn(struct rma_arena_t *scratch, struct rma_arena_t *arena, struct ree_output_token_t *rpn, int rpnCount, const char **variableNames, int variableCount, struct ree_parameter_table_t *parameters, struct ree_program_t *program);
+
+/**
+  @brief Fuses compiled programs into one, merging the DAGs of all of them so shared subexpressions are computed once
+  @note Every program has to read the same parameter table, fails with ERR_INVALID_INPUT if the fused program would need more stack or temporary slots than a program may have
+  @note The DAG is built in the scratch arena, the bytecode is allocated from arena and released with it
+*/
+enum reh_error_code_e ree_FusePrograms(struct rma_arena_t *scratch, struct rma_arena_t *arena, const struct ree_program_t *const *programs, int programCount, struct ree_fused_program_t *fused);
+
+/**
+  @brief Prints the bytecode of a compiled program (for debugging)
+*/
+void ree_PrintProgram(const struct ree_program_t *program);
+
+#endif // COMPILER_H
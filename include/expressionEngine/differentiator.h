@@ -0,0 +1,23 @@
+/**
+  ree - Robkoo's Expression Engine
+*/
+
+#ifndef DIFFERENTIATOR_H
+#define DIFFERENTIATOR_H
+
+#include "core/arena.h"
+#include "core/errorHandler.h"
+#include "expressionEngine/parser/shuntingYard.h"
+
+// largest RPN a derivative may expand to, subexpressions shared in the derivative are written out once per use
+#define REE_MAX_DERIVATIVE_RPN 65536
+
+/**
+  @brief Differentiates an RPN array symbolically with respect to the variable with the given symbol id
+  @note Other variables are treated as constants, the result isn't simplified (run ree_OptimizeRpn on it)
+  @note The tree is built in the scratch arena, the derivative RPN is allocated from arena
+  @note Factorials of expressions depending on the variable have no symbolic derivative (ERR_UNSUPPORTED)
+*/
+enum reh_error_code_e ree_DifferentiateRpn(struct rma_arena_t *scratch, struct rma_arena_t *arena, const struct ree_output_token_t *rpn, int rpnCount, uint16_t variable, struct ree_output_token_t **derivative, int *derivativeCount);
+
+#endif // DIFFERENTIATOR_H
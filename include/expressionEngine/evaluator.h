@@ -6,7 +6,56 @@
 #define EVALUATOR_H
 
 #include "core/errorHandler.h"
+#include "expressionEngine/compiler.h"
+#include "expressionEngine/mathKernels.h"
 #include "expressionEngine/parser/shuntingYard.h"
+#include "math/doubleDouble.h"
+#include "math/dual.h"
+#include "math/interval.h"
+
+#include <stdint.h>
+
+// number of samples evaluated together per block in ree_EvaluateBatch
+#define REE_BATCH_LANES 64
+
+/*
+  ULP budget of ree_EvaluateBatch against ree_EvaluateProgram for valid samples.
+  Both paths use the same libm calls and correctly rounded IEEE 754 arithmetic, so results are bit-identical.
+  Other math modes of ree_EvaluateBatchMode are bounded per transcendental call by the mode (see ree_math_mode_e).
+*/
+#define REE_BATCH_MAX_ULP 0
+
+// largest factorial the float tier computes exactly (rm_Factorial works on int), larger arguments are a domain failure
+#define REE_MAX_FACTORIAL_FLOAT 12
+
+/*
+  Per-sample outcome of the non-erroring evaluation mode (fits in one status byte).
+  Domain failures come back as a status and a NaN result instead of going through reh_SetError,
+  real faults (bad stack state, unknown opcode, ...) are still reported as errors.
+*/
+enum ree_eval_status_e {
+  REE_EVAL_OK = 0,            /**< Sample is defined */
+  REE_EVAL_DIVISION_BY_ZERO,  /**< Divisor was (close to) zero */
+  REE_EVAL_FACTORIAL_DOMAIN,  /**< Factorial of a negative, non-integer or too large value */
+  REE_EVAL_TAN_DOMAIN,        /**< Tan at one of its poles */
+  REE_EVAL_SQRT_DOMAIN,       /**< Sqrt of a negative value */
+  REE_EVAL_LN_DOMAIN,         /**< Natural log of a non-positive value */
+  REE_EVAL_LOG_DOMAIN,        /**< Log with base 10 of a non-positive value */
+};
+
+/*
+  Precision tiers of the evaluator, higher tiers keep curves smooth deeper into a zoom but cost more per sample.
+  Bytecode constants are plain floats in every tier, the optimizer only folds constants float can hold exactly.
+*/
+enum ree_precision_e {
+  REE_PRECISION_AUTO = 0,       /**< Picked per sampling call from the sampled range and step */
+  REE_PRECISION_FLOAT,          /**< 24-bit mantissa, batch evaluator with SIMD kernels */
+  REE_PRECISION_DOUBLE,         /**< 53-bit mantissa, scalar interpreter */
+  REE_PRECISION_DOUBLE_DOUBLE,  /**< About 106-bit mantissa in software (rm_dd_t), scalar interpreter */
+};
+
+// a tier is picked while its rounding error at the sampled magnitude stays this many times below the sampling step
+#define REE_PRECISION_HEADROOM 64.0
 
 struct ree_variable_t {
   const char* name;      /**< Name of the variable */
@@ -15,7 +64,91 @@ struct ree_variable_t {
 
 /**
   @brief Evaluates a function in Reverse Polish Notation (RPN) with given variables to substitute for
+  @note Reference path for checking the compiled evaluators, the stack is checked per token so malformed RPN fails with ERR_INVALID_STACK_STATE
 */
 enum reh_error_code_e ree_EvaluateRpn(struct ree_output_token_t *rpn, size_t rpnCount, struct ree_variable_t *variables, size_t variableCount, float *result);
 
+/**
+  @brief Converts an evaluation status to its string representation
+*/
+const char* ree_EvalStatusToStr(enum ree_eval_status_e status);
+
+/**
+  @brief Evaluates a compiled program with the given variable slot values
+  @note Domain failures are reported as errors, use ree_EvaluateProgramStatus when sampling
+*/
+enum reh_error_code_e ree_EvaluateProgram(const struct ree_program_t *program, const float *variables, float *result);
+
+/**
+  @brief Evaluates a compiled program without raising errors for domain failures
+  @note status is set to a ree_eval_status_e, result is NaN unless it's REE_EVAL_OK
+  @note On errors result is NaN and status REE_EVAL_OK, the error code tells what went wrong
+*/
+enum reh_error_code_e ree_EvaluateProgramStatus(const struct ree_program_t *program, const float *variables, float *result, uint8_t *status);
+
+/**
+  @brief Evaluates a compiled program for every x in xs, writing the results into ys
+  @note status[i] is set to the first domain failure hit while evaluating xs[i] (ys[i] is NaN there) or REE_EVAL_OK
+*/
+enum reh_error_code_e ree_EvaluateBatch(const struct ree_program_t *program, const float *xs, size_t count, float *ys, uint8_t *status);
+
+/**
+  @brief Same as ree_EvaluateBatch with the transcendental functions computed by the math kernels of the given mode
+  @note Domain failures are detected the same way in every mode, REE_MATH_EXACT is ree_EvaluateBatch
+*/
+enum reh_error_code_e ree_EvaluateBatchMode(const struct ree_program_t *program, enum ree_math_mode_e mode, const float *xs, size_t count, float *ys, uint8_t *status);
+
+/**
+  @brief Evaluates a fused program for every x in xs, the result of fused program p for xs[i] goes to ys[p * outputStride + i] and its status likewise
+  @note Every output matches ree_EvaluateBatchMode of its own program bit for bit, statuses included
+*/
+enum reh_error_code_e ree_EvaluateFusedBatch(const struct ree_fused_program_t *fused, enum ree_math_mode_e mode, const float *xs, size_t count, float *ys, uint8_t *status, size_t outputStride);
+
+/**
+  @brief Converts a precision tier to its string representation
+*/
+const char* ree_PrecisionToStr(enum ree_precision_e precision);
+
+/**
+  @brief Resolves REE_PRECISION_AUTO to the cheapest tier that can still resolve step around the sampled range
+  @note Any other tier is returned as is
+*/
+enum ree_precision_e ree_SelectPrecision(enum ree_precision_e requested, double rangeMin, double rangeMax, double step);
+
+/**
+  @brief Evaluates a compiled program in double precision, domain failures are reported like in ree_EvaluateProgramStatus
+*/
+enum reh_error_code_e ree_EvaluateProgramDouble(const struct ree_program_t *program, const double *variables, double *result, uint8_t *status);
+
+/**
+  @brief Evaluates a compiled program in double-double precision, domain failures are reported like in ree_EvaluateProgramStatus
+*/
+enum reh_error_code_e ree_EvaluateProgramDoubleDouble(const struct ree_program_t *program, const struct rm_dd_t *variables, struct rm_dd_t *result, uint8_t *status);
+
+/**
+  @brief Samples a compiled program at x = xMin + i * step for i in [0, count) in the given precision tier
+  @note x is computed in the tier's precision too, xs and ys receive the samples rounded to double, status[i] is a ree_eval_status_e
+  @note mathMode picks the transcendental kernels of the float tier, the double tiers always call libm
+*/
+enum reh_error_code_e ree_SampleProgram(const struct ree_program_t *program, enum ree_precision_e precision, enum ree_math_mode_e mathMode, double xMin, double step, size_t count, double *xs, double *ys, uint8_t *status);
+
+/**
+  @brief Bounds a compiled program over every x in an interval, for culling and discontinuity detection while sampling
+  @note mayBeUndefined is false only if no x in the interval hits a domain failure or a non-finite result,
+        result then contains the exact value of the expression for every x (float rounding of the evaluators isn't modelled)
+*/
+enum reh_error_code_e ree_EvaluateInterval(const struct ree_program_t *program, struct rm_interval_t x, struct rm_interval_t *result, bool *mayBeUndefined);
+
+/**
+  @brief Evaluates a compiled program on dual numbers, giving the value and the derivative along the seeded variables in one pass
+  @note Domain failures are reported like in ree_EvaluateProgramStatus, both parts of result are NaN then
+*/
+enum reh_error_code_e ree_EvaluateProgramDual(const struct ree_program_t *program, const struct rm_dual_t *variables, struct rm_dual_t *result, uint8_t *status);
+
+/**
+  @brief Evaluates a compiled program and its derivative d/dx for every x in xs, writing them into ys and derivatives
+  @note Only variable slot 0 is bound like in ree_EvaluateBatch, ys matches ree_EvaluateProgramStatus bit for bit
+*/
+enum reh_error_code_e ree_EvaluateDualBatch(const struct ree_program_t *program, const float *xs, size_t count, float *ys, float *derivatives, uint8_t *status);
+
 #endif // EVALUATOR_H
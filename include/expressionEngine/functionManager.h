@@ -5,14 +5,23 @@
 #ifndef FUNCTION_MANAGER_H
 #define FUNCTION_MANAGER_H
 
+#include "core/arena.h"
 #include "core/errorHandler.h"
+#include "expressionEngine/compiler.h"
+#include "expressionEngine/evaluator.h"
+#include "expressionEngine/parameters.h"
+#include "expressionEngine/parseCache.h"
 #include "expressionEngine/parser/shuntingYard.h"
 #include "math/Vec3.h"
 
-#define MAX_FN_NAME_LEN    1
-#define MAX_PARAM_NAME_LEN 1
+#include <stdint.h>
 
-#define REE_MAX_FUNCTIONS      16
+#define MAX_FN_NAME_LEN    15
+#define MAX_PARAM_NAME_LEN 15
+
+// derivatives are named after their source with a ' per order (f -> f' -> f'')
+#define REE_MAX_DERIVATIVE_ORDER 3
+#define MAX_DERIVED_NAME_LEN     (MAX_FN_NAME_LEN + REE_MAX_DERIVATIVE_ORDER)
 
 #define WHITE  {1.0f, 1.0f, 1.0f}       // RGB: 255, 255, 255
 #define RED    {1.0f, 0.0f, 0.0f}       // RGB: 255, 0, 0
@@ -24,26 +33,69 @@
 #define PINK   {1.0f, 0.41f, 0.71f}     // RGB: 255, 105, 180
 #define GRAY   {0.5f, 0.5f, 0.5f}       // RGB: 128, 128, 128
 
+// marks an empty entry of the slot list and the name index
+#define REE_NO_SLOT UINT32_MAX
+
 extern struct rm_vec3_t functionColorArray[];
 extern const int functionColorArrayLength;
 
+/*
+  Stable reference to a function of a manager.
+  Pointers to functions move when others are added or removed, a handle stays valid until its own function is removed
+  and never refers to another function afterwards (the slot's generation moves on).
+*/
+struct ree_function_handle_t {
+  uint32_t slot;                          /**< Index into the slot table of the manager */
+  uint32_t generation;                    /**< Generation of the slot when the function was added, 0 never refers to a function */
+};
+
 struct ree_function_t {
-  char name[MAX_FN_NAME_LEN + 1];         /**< Function name, e.g., f, g, h */
+  char name[MAX_DERIVED_NAME_LEN + 1];    /**< Function name, e.g., f, g, h or f' for a derivative */
   char parameter[MAX_PARAM_NAME_LEN + 1]; /**< Parameter name, e.g., 'x' */
+  struct ree_function_handle_t handle;    /**< Handle of the function, stays the same while other functions are added or removed */
+  struct ree_function_handle_t source;    /**< Handle of the function this one is the derivative of, generation 0 for user definitions */
+  int referenceCount;                     /**< Call sites in other functions plus derivatives taken of it, removal only looks for dependents if it isn't 0 */
 
-  struct ree_token_t *tokens;             /**< Tokens from the lexer without 'f(x) =' */
-  int tokenCount;                         /**< Token count */
-  int tokenCapacity;
-
-  struct ree_output_token_t *rpn;         /**< RPN of the function definition */
+  struct rma_arena_t arena;               /**< Owns the RPN and the bytecode, released in one reset on removal */
+  struct ree_output_token_t *rpn;         /**< RPN of the function definition, with the bodies of called functions inlined */
   int rpnCount;                           /**< RPN token count */
+  struct ree_output_token_t *sourceRpn;   /**< RPN as parsed, still holding the calls of other functions, NULL if it has none */
+  int sourceRpnCount;                     /**< Source RPN token count */
+  struct ree_program_t program;           /**< Bytecode compiled from the RPN, used for evaluation */
+  struct ree_parse_cache_entry_t *cached; /**< Parse cache entry the RPN and bytecode are shared from, nullptr if the arena owns them */
+  enum ree_precision_e precision;         /**< Precision tier the function is sampled in, REE_PRECISION_AUTO picks it from the viewport */
+  enum ree_math_mode_e mathMode;          /**< Accuracy of the transcendental kernels in the float tier */
+  int sampleCount;                        /**< Number of sampling passes so far, the program is compiled to native code once it's hot */
+  uint32_t revision;                      /**< Bumped whenever the samples change for the same viewport (rebuilt or a parameter it reads was set) */
   bool isVisible;                         /**< Flag to determine whether the function is to be rendered */
   struct rm_vec3_t color;                 /**< Color of the function */
 };
 
+// entry of the slot table, maps a handle to the position of its function in the dense array
+struct ree_function_slot_t {
+  uint32_t index;                                      /**< Position in functions while the slot is used, next free slot otherwise */
+  uint32_t generation;                                 /**< Bumped on removal, so handles to the removed function stop resolving */
+};
+
+/*
+  Functions are kept densely packed (iterate functions[0, functionCount)), removal moves the last one into the hole.
+  Handles go through the slot table, names through an open addressing index, both are O(1).
+  Every table is allocated through the allocator hooks of the pool and grows by doubling.
+*/
 struct ree_function_manager_t {
-  struct ree_function_t functions[REE_MAX_FUNCTIONS];  /**< Array of functions managed */
+  struct ree_function_t *functions;                    /**< Dense array of the functions, in no particular order once any was removed */
   int functionCount;                                   /**< Current number of functions */
+  int functionCapacity;                                /**< Allocated length of functions */
+  struct ree_function_slot_t *slots;                   /**< Slot table the handles index into */
+  uint32_t slotCount;                                  /**< Number of slots handed out so far, used or free */
+  uint32_t slotCapacity;                               /**< Allocated length of slots */
+  uint32_t freeSlot;                                   /**< Head of the free slot list, REE_NO_SLOT if empty */
+  uint32_t *nameIndex;                                 /**< Slots of the named functions by hash of the name, REE_NO_SLOT if empty (y definitions aren't in it) */
+  uint32_t nameIndexCapacity;                          /**< Length of nameIndex, a power of two kept at most half full */
+  struct rma_pool_t pool;                              /**< Blocks shared by the function arenas and the scratch arena */
+  struct rma_arena_t scratch;                          /**< Temporary memory of the parse / compile pipeline, reset after every definition */
+  struct ree_parameter_table_t parameters;             /**< Global parameters read by the programs, the manager must not move once they are compiled */
+  struct ree_parse_cache_t parseCache;                 /**< Compiled bodies shared by the definitions that repeat them */
 };
 
 /**
@@ -51,20 +103,70 @@ struct ree_function_manager_t {
 */
 enum reh_error_code_e ree_InitFunctionManager(struct ree_function_manager_t *manager);
 
+/**
+  @brief Initializes the function manager with custom allocator hooks for all of its memory
+*/
+enum reh_error_code_e ree_InitFunctionManagerWithAllocator(struct ree_function_manager_t *manager, const struct rma_allocator_t *allocator);
+
+/**
+  @brief Releases every function and all memory held by the function manager
+*/
+void ree_DestroyFunctionManager(struct ree_function_manager_t *manager);
+
 /**
   @brief Adds a function to the function manager
 */
 enum reh_error_code_e ree_AddFunction(struct ree_function_manager_t *manager, char *definition, struct rm_vec3_t *functionColor);
 
 /**
-  @brief Removes a function from the function manager
+  @brief Adds the symbolic derivative of a function to the function manager, named after it with a ' appended (f -> f')
+  @note The derivative is simplified and compiled like a user definition, it's removed together with its source
+*/
+enum reh_error_code_e ree_AddDerivative(struct ree_function_manager_t *manager, const char *name, struct rm_vec3_t *functionColor);
+
+/**
+  @brief Replaces the definition of a function with the same name, keeping its id, color and visibility
+  @note Every function calling it and every derivative taken of it is recompiled, nothing changes if any of them fails
+  @note Definitions that would make the function call itself (directly or through other functions) are rejected
+*/
+enum reh_error_code_e ree_RedefineFunction(struct ree_function_manager_t *manager, char *definition);
+
+/**
+  @brief Removes a function from the function manager, along with every derivative taken of it
+  @note Fails with ERR_INVALID_INPUT naming the callers if other functions call it (or one of its derivatives), nothing is removed then
+  @note O(1) unless other functions depend on it, then the manager is scanned for them once
 */
 enum reh_error_code_e ree_RemoveFunction(struct ree_function_manager_t *manager, const char* name);
 
 /**
-  @brief Retrieves a function from the function manager based on name
+  @brief Sets a global parameter (a, b, k, ...), defining it if no function uses it yet
+  @note Nothing is recompiled, only the revision of the functions reading it is bumped so just those get resampled
+*/
+enum reh_error_code_e ree_SetParameter(struct ree_function_manager_t *manager, const char *name, float value);
+
+/**
+  @brief Retrieves the current value of a global parameter
+*/
+enum reh_error_code_e ree_GetParameter(const struct ree_function_manager_t *manager, const char *name, float *value);
+
+/**
+  @brief Counts a sampling pass of a function and compiles it to native code once it gets hot
+  @note Compilation failures (unsupported platform or instruction) are not errors, the function keeps being interpreted
+*/
+void ree_MarkFunctionSampled(struct ree_function_t *function);
+
+/**
+  @brief Looks up a function by name in O(1), returns nullptr if there's none
+  @note y = ... definitions share their name, the first one is returned (found by a scan)
+  @note The pointer is invalidated by adding, redefining or removing functions, keep the handle instead
+*/
+struct ree_function_t* ree_GetFunction(struct ree_function_manager_t *manager, const char *name);
+
+/**
+  @brief Resolves a handle to its function, returns nullptr if the function was removed
+  @note The pointer is invalidated by adding, redefining or removing functions
 */
-int ree_GetFunction(struct ree_function_manager_t *manager, const char *name, struct ree_function_t *function);
+struct ree_function_t* ree_ResolveFunction(struct ree_function_manager_t *manager, struct ree_function_handle_t handle);
 
 /**
   @brief Checks if a function is in the function manager
@@ -0,0 +1,38 @@
+/**
+  ree - Robkoo's Expression Engine
+*/
+
+#ifndef INLINER_H
+#define INLINER_H
+
+#include "core/arena.h"
+#include "core/errorHandler.h"
+#include "expressionEngine/parser/shuntingYard.h"
+
+#include <stdint.h>
+
+// largest RPN a definition may expand to once its calls are inlined, arguments are written out once per use of the parameter
+#define REE_MAX_INLINED_RPN 65536
+
+// a function that calls to can be inlined from, its RPN must not contain calls itself
+struct ree_inline_callee_t {
+  uint16_t symbol;                        /**< Symbol id of the function name, as the call tokens carry it */
+  uint16_t parameter;                     /**< Symbol id of the parameter, replaced by the argument of the call */
+  const struct ree_output_token_t *rpn;   /**< RPN of the function body */
+  int rpnCount;                           /**< RPN token count */
+};
+
+/**
+  @brief Checks whether an RPN token is a call of a user defined function (a function token that isn't built in)
+*/
+bool ree_IsCallToken(const struct ree_output_token_t *token);
+
+/**
+  @brief Replaces every call in an RPN array by the body of the callee, with the parameter substituted by the argument
+  @note Every call must resolve to one of the callees (ERR_INVALID_INPUT otherwise), the result isn't simplified (run ree_OptimizeRpn on it)
+  @note Arguments used more than once are duplicated, the compiler merges them back into a single computation
+  @note The inlined RPN is allocated from arena, the scratch arena only holds temporary memory
+*/
+enum reh_error_code_e ree_InlineRpn(struct rma_arena_t *scratch, struct rma_arena_t *arena, const struct ree_output_token_t *rpn, int rpnCount, const struct ree_inline_callee_t *callees, int calleeCount, struct ree_output_token_t **inlined, int *inlinedCount);
+
+#endif // INLINER_H
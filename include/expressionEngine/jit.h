@@ -0,0 +1,64 @@
+/**
+  ree - Robkoo's Expression Engine
+*/
+
+#ifndef JIT_H
+#define JIT_H
+
+#include "core/errorHandler.h"
+#include "expressionEngine/compiler.h"
+#include "expressionEngine/mathKernels.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// native code is only emitted for x86-64 System V targets (Linux, macOS), everything else keeps interpreting
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__)) && !defined(REE_DISABLE_JIT)
+  #define REE_JIT_AVAILABLE 1
+#else
+  #define REE_JIT_AVAILABLE 0
+#endif
+
+// number of samples the native code evaluates per iteration, every stack slot spans REE_JIT_VECTORS SSE registers
+#define REE_JIT_LANES   16
+#define REE_JIT_VECTORS (REE_JIT_LANES / 4)
+
+// number of sampling passes after which a function counts as hot and gets compiled to native code
+#define REE_JIT_HOT_THRESHOLD 8
+
+/*
+  Entry point of the emitted code, evaluates groupCount groups of REE_JIT_LANES samples.
+  Status bytes follow the ree_eval_status_e rules of ree_EvaluateBatch.
+*/
+typedef void (*ree_jit_fn_t)(const float *xs, float *ys, uint8_t *status, size_t groupCount);
+
+struct ree_jit_program_t {
+  void *code;                 /**< Executable mapping holding the emitted code */
+  size_t mappedSize;          /**< Size of the mapping in bytes */
+  size_t codeSize;            /**< Bytes of machine code actually emitted */
+  enum ree_math_mode_e mode;  /**< Math kernels the helpers call, batches in another mode keep interpreting */
+  ree_jit_fn_t fn;            /**< Entry point inside code */
+};
+
+/**
+  @brief Checks whether native code can be emitted on this platform
+*/
+bool ree_JitIsSupported(void);
+
+/**
+  @brief Compiles a program into straight-line SSE code, batches evaluated in the same math mode use it from then on
+  @note Fails with ERR_UNSUPPORTED on platforms without a JIT, the program keeps working through the interpreter
+*/
+enum reh_error_code_e ree_JitCompile(struct ree_program_t *program, enum ree_math_mode_e mode);
+
+/**
+  @brief Releases the native code of a program (no-op if it wasn't compiled)
+*/
+void ree_JitFree(struct ree_program_t *program);
+
+/**
+  @brief Evaluates native code for every x in xs, same contract as ree_EvaluateBatch
+*/
+enum reh_error_code_e ree_EvaluateJit(const struct ree_jit_program_t *jit, const float *xs, size_t count, float *ys, uint8_t *status);
+
+#endif // JIT_H
@@ -5,12 +5,17 @@
 #define LEXER_H
 
 #include "tokens.h"
+#include "core/arena.h"
 #include "core/errorHandler.h"
-#define MAX_BUF_SIZE 256
 
+/*
+  Tokens don't copy their text, they point back into the lexed expression (start + length).
+  The expression has to outlive the tokens, use ree_TokenText to read the text of a token.
+*/
 struct ree_token_t {
   enum ree_token_type_e token_type; /**< type of the token */
-  char value[MAX_BUF_SIZE];         /**< string representation of the token */
+  int start;                        /**< offset of the token in the lexed expression */
+  int length;                       /**< length of the token in characters, 0 for synthesized tokens */
 };
 
 struct ree_data_t {
@@ -22,10 +27,20 @@ struct ree_data_t {
   char* expression;    /**< the expression being lexed */
 };
 
+/**
+  @brief Gets a pointer to the text of a token inside the lexed expression (not null-terminated, see token->length)
+*/
+const char* ree_TokenText(const char *expression, const struct ree_token_t *token);
+
+/**
+  @brief Compares the text of a token with a null-terminated string
+*/
+bool ree_TokenEquals(const char *expression, const struct ree_token_t *token, const char *str);
+
 /**
   @brief Prints a token's details (for debugging)
 */
-void ree_Print(struct ree_token_t *tokenVal);
+void ree_Print(const char *expression, struct ree_token_t *tokenVal);
 
 /**
   @brief Skips whitespace characters in the input data
@@ -40,12 +55,12 @@ void ree_Advance(struct ree_data_t *data);
 /**
   @brief Reads a number from the input data
 */
-void ree_ReadNumber(struct ree_data_t *data, char* number);
+void ree_ReadNumber(struct ree_data_t *data, struct ree_token_t *number);
 
 /**
   @brief Reads an identifier from the input data
 */
-void ree_ReadIdentifier(struct ree_data_t *data, char* identifier);
+void ree_ReadIdentifier(struct ree_data_t *data, struct ree_token_t *identifier);
 
 /**
   @brief Retrieves the next token from the input data
@@ -53,13 +68,14 @@ void ree_ReadIdentifier(struct ree_data_t *data, char* identifier);
 enum reh_error_code_e ree_NextToken(struct ree_data_t *data, struct ree_token_t *nextToken);
 
 /**
-  @brief Counts the number of tokens in the expression
+  @brief Appends a token to a growable token buffer allocated from the arena, growing it when full
 */
-enum reh_error_code_e ree_CountTokens(char* expression, int *tokenCount);
+enum reh_error_code_e ree_PushToken(struct rma_arena_t *arena, struct ree_token_t **tokens, int *tokenCount, int *tokenCapacity, struct ree_token_t token);
 
 /**
-  @brief Lexes the expression into tokens
+  @brief Lexes the expression into tokens in a single pass, appending them to a growable buffer
+  @note *tokens may be nullptr with a capacity of 0, the buffer lives in the arena
 */
-enum reh_error_code_e ree_Lexer(char* expression, struct ree_token_t *tokens);
+enum reh_error_code_e ree_Lexer(struct rma_arena_t *arena, char* expression, struct ree_token_t **tokens, int *tokenCount, int *tokenCapacity);
 
 #endif // LEXER_H
@@ -0,0 +1,59 @@
+/**
+  ree - Robkoo's Expression Engine
+*/
+
+#ifndef MATH_KERNELS_H
+#define MATH_KERNELS_H
+
+#include "expressionEngine/batchKernels.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Accuracy modes of the transcendental kernels, cheaper modes trade precision the plot can't show for throughput.
+  Fast and draw kernels are range-reduced polynomials evaluated a whole vector at a time,
+  lanes outside of the range they're accurate in (huge trig arguments, denormals, infinities, NaN) fall back to libm.
+*/
+enum ree_math_mode_e {
+  REE_MATH_EXACT = 0, /**< libm calls, bit-identical to the scalar evaluators */
+  REE_MATH_FAST,      /**< At most REE_MATH_FAST_MAX_ULP from the correctly rounded result */
+  REE_MATH_DRAW,      /**< Error of at most REE_MATH_DRAW_MAX_ERROR relative to max(|f|, 1) for trig, to |f| otherwise */
+};
+
+#define REE_MATH_FAST_MAX_ULP   4
+#define REE_MATH_DRAW_MAX_ERROR 1.52587890625e-5 // 2^-16, a 65536 pixel tall viewport still doesn't show it
+
+/*
+  Block kernels of the transcendental functions, every kernel computes a[i] = f(a[i]) (a[i] = a[i]^b[i] for pow).
+  Within a mode every instruction set gives bit-identical results, only the mode changes them.
+*/
+struct ree_math_kernels_t {
+  enum ree_math_mode_e mode;                                  /**< Accuracy mode the kernels were built for */
+  enum ree_kernel_isa_e isa;                                  /**< Instruction set the kernels were built for */
+  void (*sin)(float *a, size_t count);                        /**< a = sin(a) */
+  void (*cos)(float *a, size_t count);                        /**< a = cos(a) */
+  void (*tan)(float *a, uint8_t *poles, size_t count);        /**< a = tan(a), poles[i] tells whether |cos(a[i])| < FLT_EPSILON (a[i] is unspecified there) */
+  void (*exp)(float *a, size_t count);                        /**< a = e^a */
+  void (*ln)(float *a, size_t count);                         /**< a = ln(a) */
+  void (*log10)(float *a, size_t count);                      /**< a = log10(a) */
+  void (*pow)(float *a, const float *b, size_t count);        /**< a = a^b */
+};
+
+/**
+  @brief Converts an accuracy mode to its string representation
+*/
+const char* ree_MathModeToStr(enum ree_math_mode_e mode);
+
+/**
+  @brief Gets the math kernels of a mode for the best instruction set supported by the running CPU
+*/
+const struct ree_math_kernels_t* ree_GetMathKernels(enum ree_math_mode_e mode);
+
+/**
+  @brief Gets the math kernels of a mode for a specific instruction set, falls back to the portable ones if unsupported
+  @note Exact kernels are libm loops on every instruction set
+*/
+const struct ree_math_kernels_t* ree_GetMathKernelsForIsa(enum ree_math_mode_e mode, enum ree_kernel_isa_e isa);
+
+#endif // MATH_KERNELS_H
@@ -0,0 +1,372 @@
+/**
+  ree - Robkoo's Expression Engine
+*/
+
+// no include guard, this is a template and not a public header
+
+/*
+  Vector bodies of the fast and draw math kernels, mathKernels.c includes this once per instruction set.
+  The includer defines REE_MK_WIDTH (lanes per vector), the REE_MK_VF / REE_MK_VI vector types of that width
+  and REE_MK(name) which gives every function the suffix of the instruction set.
+  REE_MK_MOVEMASK(mask) may map the sign bits of a mask to an int when the instruction set has it,
+  REE_MK_ROUND(x) may round to the nearest integer with an instruction of the instruction set.
+  Only correctly rounded IEEE 754 operations are used (no FMA), so every width gives bit-identical results.
+*/
+
+static inline REE_MK_VF REE_MK(ree_MkSelect)(REE_MK_VI mask, REE_MK_VF a, REE_MK_VF b){
+  return (REE_MK_VF)(((REE_MK_VI)a & mask) | ((REE_MK_VI)b & ~mask));
+}
+
+static inline REE_MK_VF REE_MK(ree_MkAbs)(REE_MK_VF x){
+  return (REE_MK_VF)((REE_MK_VI)x & 0x7FFFFFFF);
+}
+
+// round to nearest even, valid for |x| < 2^22 which covers every reduction below
+// an instruction when there is one, the magic number addition is folded away by -ffast-math (see mathKernels.c)
+static inline REE_MK_VF REE_MK(ree_MkRound)(REE_MK_VF x){
+#ifdef REE_MK_ROUND
+  return REE_MK_ROUND(x);
+#else
+  return (x + REE_MK_ROUND_MAGIC) - REE_MK_ROUND_MAGIC;
+#endif
+}
+
+// 2^n for n in [-126, 127]
+static inline REE_MK_VF REE_MK(ree_MkPow2i)(REE_MK_VI n){
+  return (REE_MK_VF)((n + 127) << 23);
+}
+
+// loads up to a vector of lanes, missing lanes are 1 which is inside the domain of every kernel
+static inline REE_MK_VF REE_MK(ree_MkLoad)(const float *a, size_t lanes){
+  REE_MK_VF v;
+  if (lanes == REE_MK_WIDTH){
+    memcpy(&v, a, sizeof(v));
+    return v;
+  }
+  for (size_t l = 0; l < REE_MK_WIDTH; ++l) v[l] = 1.0f;
+  memcpy(&v, a, lanes * sizeof(float));
+  return v;
+}
+
+static inline void REE_MK(ree_MkStore)(float *a, REE_MK_VF v, size_t lanes){
+  if (lanes == REE_MK_WIDTH){
+    memcpy(a, &v, sizeof(v));
+    return;
+  }
+  memcpy(a, &v, lanes * sizeof(float));
+}
+
+// whether any lane of a mask is set, fallbacks are rare so the lanes are only walked when it is
+static inline bool REE_MK(ree_MkAny)(REE_MK_VI mask){
+#ifdef REE_MK_MOVEMASK
+  return REE_MK_MOVEMASK(mask) != 0;
+#else
+  int32_t any = 0;
+  for (size_t l = 0; l < REE_MK_WIDTH; ++l) any |= mask[l];
+  return any != 0;
+#endif
+}
+
+/*
+  ########
+  # TRIG #
+  ########
+*/
+
+/*
+  Reduces x by the nearest multiple q of pi/2 into [-pi/4, pi/4] (three part Cody-Waite).
+  The rounding of q * REE_MK_PI_2_C leaves an absolute error of about |q| * 2^-48 in the remainder,
+  close to a zero of the result (tiny remainders) that's more than a few ulp, so fast kernels flag those lanes as inexact.
+*/
+static inline REE_MK_VF REE_MK(ree_MkReduce)(REE_MK_VF x, REE_MK_VI *quadrant, REE_MK_VI *inexact){
+  REE_MK_VF q = REE_MK(ree_MkRound)(x * REE_MK_2_PI);
+  *quadrant = __builtin_convertvector(q, REE_MK_VI);
+  REE_MK_VF r = ((x - q * REE_MK_PI_2_A) - q * REE_MK_PI_2_B) - q * REE_MK_PI_2_C;
+  *inexact = ~(REE_MK(ree_MkAbs)(x) <= REE_MK_TRIG_MAX) | (REE_MK(ree_MkAbs)(r) < REE_MK(ree_MkAbs)(q) * REE_MK_REDUCE_SLACK);
+  return r;
+}
+
+static inline REE_MK_VF REE_MK(ree_MkSinPoly)(REE_MK_VF r, bool draw){
+  REE_MK_VF z = r * r;
+  if (draw){
+    return r + r * z * (REE_MK_DRAW_SIN_1 + z * REE_MK_DRAW_SIN_2);
+  }
+  return ((REE_MK_SIN_1 * z + REE_MK_SIN_2) * z + REE_MK_SIN_3) * z * r + r;
+}
+
+static inline REE_MK_VF REE_MK(ree_MkCosPoly)(REE_MK_VF r, bool draw){
+  REE_MK_VF z = r * r;
+  if (draw){
+    return (1.0f - 0.5f * z) + z * z * (REE_MK_DRAW_COS_1 + z * REE_MK_DRAW_COS_2);
+  }
+  return ((REE_MK_COS_1 * z + REE_MK_COS_2) * z + REE_MK_COS_3) * z * z - 0.5f * z + 1.0f;
+}
+
+// sin(x) for quadrant offset 0, cos(x) for offset 1 (cos(x) = sin(x + pi/2))
+static inline REE_MK_VF REE_MK(ree_MkSinCos)(REE_MK_VF x, int offset, bool draw, REE_MK_VI *special){
+  REE_MK_VI quadrant, inexact;
+  REE_MK_VF r = REE_MK(ree_MkReduce)(x, &quadrant, &inexact);
+  quadrant += offset;
+
+  REE_MK_VI odd = (quadrant & 1) != 0;
+  REE_MK_VF y = REE_MK(ree_MkSelect)(odd, REE_MK(ree_MkCosPoly)(r, draw), REE_MK(ree_MkSinPoly)(r, draw));
+  y = (REE_MK_VF)((REE_MK_VI)y ^ ((quadrant & 2) << 30));
+
+  // the cosine branch is close to 1 and draw mode is bounded absolutely, only huge arguments fall back there
+  *special = ~(REE_MK(ree_MkAbs)(x) <= REE_MK_TRIG_MAX);
+  if (!draw){
+    *special |= inexact & ~odd;
+  }
+  return y;
+}
+
+static inline REE_MK_VF REE_MK(ree_MkTan)(REE_MK_VF x, bool draw, REE_MK_VI *poles, REE_MK_VI *special){
+  REE_MK_VI quadrant, inexact;
+  REE_MK_VF r = REE_MK(ree_MkReduce)(x, &quadrant, &inexact);
+  REE_MK_VF z = r * r;
+
+  REE_MK_VF y;
+  if (draw){
+    y = r + r * z * (REE_MK_DRAW_TAN_1 + z * (REE_MK_DRAW_TAN_2 + z * (REE_MK_DRAW_TAN_3 + z * REE_MK_DRAW_TAN_4)));
+  }
+  else {
+    y = (((((REE_MK_TAN_1 * z + REE_MK_TAN_2) * z + REE_MK_TAN_3) * z + REE_MK_TAN_4) * z + REE_MK_TAN_5) * z + REE_MK_TAN_6) * z * r + r;
+  }
+
+  // odd quadrants are tan(r - pi/2) = -1/tan(r), cos(x) = -+sin(r) vanishes with r there
+  REE_MK_VI odd = (quadrant & 1) != 0;
+  y = REE_MK(ree_MkSelect)(odd, -1.0f / y, y);
+
+  // both tan(r) and -1/tan(r) carry the relative error of the remainder
+  *poles = odd & (REE_MK(ree_MkAbs)(r) < FLT_EPSILON);
+  *special = draw ? ~(REE_MK(ree_MkAbs)(x) <= REE_MK_TRIG_MAX) : inexact;
+  return y;
+}
+
+/*
+  ###############
+  # EXPONENTIAL #
+  ###############
+*/
+
+// 2^f for f in [-0.5, 0.5]
+static inline REE_MK_VF REE_MK(ree_MkExp2Poly)(REE_MK_VF f, bool draw){
+  if (draw){
+    return 1.0f + f * (REE_MK_DRAW_EXP2_1 + f * (REE_MK_DRAW_EXP2_2 + f * (REE_MK_DRAW_EXP2_3 + f * REE_MK_DRAW_EXP2_4)));
+  }
+  return 1.0f + f * (REE_MK_EXP2_1 + f * (REE_MK_EXP2_2 + f * (REE_MK_EXP2_3 + f * (REE_MK_EXP2_4 + f * REE_MK_EXP2_5))));
+}
+
+static inline REE_MK_VF REE_MK(ree_MkExp)(REE_MK_VF x, bool draw, REE_MK_VI *special){
+  *special = ~((x >= REE_MK_EXP_MIN) & (x <= REE_MK_EXP_MAX));
+
+  if (draw){
+    REE_MK_VF t = x * REE_MK_LOG2_E;
+    REE_MK_VF n = REE_MK(ree_MkRound)(t);
+    return REE_MK(ree_MkExp2Poly)(t - n, true) * REE_MK(ree_MkPow2i)(__builtin_convertvector(n, REE_MK_VI));
+  }
+
+  REE_MK_VF n = REE_MK(ree_MkRound)(x * REE_MK_LOG2_E);
+  REE_MK_VF r = (x - n * REE_MK_LN_2_A) - n * REE_MK_LN_2_B;
+  REE_MK_VF z = r * r;
+  REE_MK_VF p = (((((REE_MK_EXP_1 * r + REE_MK_EXP_2) * r + REE_MK_EXP_3) * r + REE_MK_EXP_4) * r + REE_MK_EXP_5) * r + REE_MK_EXP_6) * z + r + 1.0f;
+  return p * REE_MK(ree_MkPow2i)(__builtin_convertvector(n, REE_MK_VI));
+}
+
+/*
+  ###############
+  # LOGARITHMIC #
+  ###############
+*/
+
+// splits x = 2^e * (1 + f) with 1 + f in [sqrt(1/2), sqrt(2))
+static inline REE_MK_VF REE_MK(ree_MkSplit)(REE_MK_VF x, REE_MK_VF *exponent){
+  REE_MK_VI bits = (REE_MK_VI)x;
+  REE_MK_VI e = ((bits >> 23) & 0xFF) - 126;
+  REE_MK_VF m = (REE_MK_VF)((bits & 0x007FFFFF) | 0x3F000000);
+
+  REE_MK_VI small = m < REE_MK_SQRT_HALF;
+  *exponent = __builtin_convertvector(e + small, REE_MK_VF);
+  return REE_MK(ree_MkSelect)(small, m + m - 1.0f, m - 1.0f);
+}
+
+// ln(1 + f) - f for the f of ree_MkSplit
+static inline REE_MK_VF REE_MK(ree_MkLog1pTail)(REE_MK_VF f, bool draw){
+  REE_MK_VF z = f * f;
+  if (draw){
+    return f * z * (REE_MK_DRAW_LN_1 + f * (REE_MK_DRAW_LN_2 + f * (REE_MK_DRAW_LN_3 + f * (REE_MK_DRAW_LN_4 + f * REE_MK_DRAW_LN_5)))) - 0.5f * z;
+  }
+  REE_MK_VF p = REE_MK_LN_1 * f + REE_MK_LN_2;
+  p = p * f + REE_MK_LN_3;
+  p = p * f + REE_MK_LN_4;
+  p = p * f + REE_MK_LN_5;
+  p = p * f + REE_MK_LN_6;
+  p = p * f + REE_MK_LN_7;
+  p = p * f + REE_MK_LN_8;
+  p = p * f + REE_MK_LN_9;
+  return p * f * z - 0.5f * z;
+}
+
+static inline REE_MK_VF REE_MK(ree_MkLn)(REE_MK_VF x, bool draw, REE_MK_VI *special){
+  *special = ~((x >= FLT_MIN) & (x <= FLT_MAX));
+
+  REE_MK_VF e;
+  REE_MK_VF f = REE_MK(ree_MkSplit)(x, &e);
+  REE_MK_VF y = REE_MK(ree_MkLog1pTail)(f, draw);
+  return (f + (y + e * REE_MK_LN_2_B)) + e * REE_MK_LN_2_A;
+}
+
+static inline REE_MK_VF REE_MK(ree_MkLog10)(REE_MK_VF x, bool draw, REE_MK_VI *special){
+  *special = ~((x >= FLT_MIN) & (x <= FLT_MAX));
+
+  REE_MK_VF e;
+  REE_MK_VF f = REE_MK(ree_MkSplit)(x, &e);
+  REE_MK_VF y = REE_MK(ree_MkLog1pTail)(f, draw);
+
+  // log10(e) and log10(2) split in a short head and a tail so the large products stay exact
+  REE_MK_VF z = (f + y) * REE_MK_LOG10_E_B;
+  z += y * REE_MK_LOG10_E_A;
+  z += f * REE_MK_LOG10_E_A;
+  z += e * REE_MK_LOG10_2_B;
+  return z + e * REE_MK_LOG10_2_A;
+}
+
+/*
+  #######
+  # POW #
+  #######
+*/
+
+/*
+  a^n by binary exponentiation for the lanes whose exponent is an integer in [-maxExponent + 1, maxExponent],
+  the reciprocal of a^|n| for negative exponents.
+*/
+static inline REE_MK_VF REE_MK(ree_MkPowInteger)(REE_MK_VF a, REE_MK_VF b, int maxExponent, REE_MK_VI *integer){
+  *integer = (REE_MK(ree_MkRound)(b) == b) & (b <= (float)maxExponent) & (b > (float)-maxExponent);
+
+  REE_MK_VI n = __builtin_convertvector(REE_MK(ree_MkSelect)(*integer, b, (REE_MK_VF){}), REE_MK_VI);
+  REE_MK_VI negative = n < 0;
+  REE_MK_VI k = (n ^ negative) - negative;
+
+  REE_MK_VF result = (REE_MK_VF){} + 1.0f;
+  REE_MK_VF base = a;
+  for (int bit = 1; bit <= maxExponent; bit <<= 1){
+    result = REE_MK(ree_MkSelect)((k & bit) != 0, result * base, result);
+    base *= base;
+  }
+
+  return REE_MK(ree_MkSelect)(negative, 1.0f / result, result);
+}
+
+static inline REE_MK_VF REE_MK(ree_MkPow)(REE_MK_VF a, REE_MK_VF b, bool draw, REE_MK_VI *special){
+  REE_MK_VI integer;
+  if (!draw){
+    REE_MK_VF y = REE_MK(ree_MkPowInteger)(a, b, REE_MK_FAST_POW_MAX, &integer);
+    *special = ~integer;
+    return y;
+  }
+
+  REE_MK_VF y = REE_MK(ree_MkPowInteger)(a, b, REE_MK_DRAW_POW_MAX, &integer);
+
+  // 2^(b * log2(a)) for positive bases, the fast logarithm keeps the product accurate enough for the draw bound
+  REE_MK_VF e;
+  REE_MK_VF f = REE_MK(ree_MkSplit)(a, &e);
+  REE_MK_VF log2a = (f + REE_MK(ree_MkLog1pTail)(f, false)) * REE_MK_LOG2_E + e;
+  REE_MK_VF t = b * log2a;
+  REE_MK_VF n = REE_MK(ree_MkRound)(t);
+  REE_MK_VF general = REE_MK(ree_MkExp2Poly)(t - n, false) * REE_MK(ree_MkPow2i)(__builtin_convertvector(REE_MK(ree_MkSelect)((t >= -126.0f) & (t <= 127.0f), n, (REE_MK_VF){}), REE_MK_VI));
+
+  REE_MK_VI generalOk = (a >= FLT_MIN) & (a <= FLT_MAX) & (REE_MK(ree_MkAbs)(t) <= REE_MK_DRAW_POW_RANGE);
+  *special = ~(integer | generalOk);
+  return REE_MK(ree_MkSelect)(integer, y, general);
+}
+
+/*
+  ###########
+  # DRIVERS #
+  ###########
+*/
+
+/*
+  Runs a vector body over a block, lanes the body flags as special are recomputed with the libm fallback.
+*/
+#define REE_MK_UNARY_DRIVER(name, body, draw, fallback)                             \
+  static void REE_MK(name)(float *a, size_t count){                                 \
+    for (size_t i = 0; i < count; i += REE_MK_WIDTH){                               \
+      const size_t lanes = count - i < REE_MK_WIDTH ? count - i : REE_MK_WIDTH;     \
+      REE_MK_VF x = REE_MK(ree_MkLoad)(a + i, lanes);                               \
+      REE_MK_VI special;                                                            \
+      REE_MK(ree_MkStore)(a + i, REE_MK(body)(x, draw, &special), lanes);           \
+      if (!REE_MK(ree_MkAny)(special)) continue;                                    \
+      for (size_t l = 0; l < lanes; ++l){                                           \
+        if (special[l]) a[i + l] = fallback(x[l]);                                  \
+      }                                                                             \
+    }                                                                               \
+  }
+
+REE_MK_UNARY_DRIVER(ree_MkFastExp, ree_MkExp, false, expf)
+REE_MK_UNARY_DRIVER(ree_MkFastLn, ree_MkLn, false, logf)
+REE_MK_UNARY_DRIVER(ree_MkFastLog10, ree_MkLog10, false, log10f)
+REE_MK_UNARY_DRIVER(ree_MkDrawExp, ree_MkExp, true, expf)
+REE_MK_UNARY_DRIVER(ree_MkDrawLn, ree_MkLn, true, logf)
+REE_MK_UNARY_DRIVER(ree_MkDrawLog10, ree_MkLog10, true, log10f)
+
+#define REE_MK_SIN_COS_DRIVER(name, offset, draw, fallback)                         \
+  static void REE_MK(name)(float *a, size_t count){                                 \
+    for (size_t i = 0; i < count; i += REE_MK_WIDTH){                               \
+      const size_t lanes = count - i < REE_MK_WIDTH ? count - i : REE_MK_WIDTH;     \
+      REE_MK_VF x = REE_MK(ree_MkLoad)(a + i, lanes);                               \
+      REE_MK_VI special;                                                            \
+      REE_MK(ree_MkStore)(a + i, REE_MK(ree_MkSinCos)(x, offset, draw, &special), lanes); \
+      if (!REE_MK(ree_MkAny)(special)) continue;                                    \
+      for (size_t l = 0; l < lanes; ++l){                                           \
+        if (special[l]) a[i + l] = fallback(x[l]);                                  \
+      }                                                                             \
+    }                                                                               \
+  }
+
+REE_MK_SIN_COS_DRIVER(ree_MkFastSin, 0, false, sinf)
+REE_MK_SIN_COS_DRIVER(ree_MkFastCos, 1, false, cosf)
+REE_MK_SIN_COS_DRIVER(ree_MkDrawSin, 0, true, sinf)
+REE_MK_SIN_COS_DRIVER(ree_MkDrawCos, 1, true, cosf)
+
+#define REE_MK_TAN_DRIVER(name, draw)                                               \
+  static void REE_MK(name)(float *a, uint8_t *poles, size_t count){                 \
+    for (size_t i = 0; i < count; i += REE_MK_WIDTH){                               \
+      const size_t lanes = count - i < REE_MK_WIDTH ? count - i : REE_MK_WIDTH;     \
+      REE_MK_VF x = REE_MK(ree_MkLoad)(a + i, lanes);                               \
+      REE_MK_VI pole, special;                                                      \
+      REE_MK(ree_MkStore)(a + i, REE_MK(ree_MkTan)(x, draw, &pole, &special), lanes); \
+      for (size_t l = 0; l < lanes; ++l) poles[i + l] = pole[l] != 0;               \
+      if (!REE_MK(ree_MkAny)(special)) continue;                                    \
+      for (size_t l = 0; l < lanes; ++l){                                           \
+        if (special[l]) ree_ExactTanLane(a + i + l, poles + i + l, x[l]);           \
+      }                                                                             \
+    }                                                                               \
+  }
+
+REE_MK_TAN_DRIVER(ree_MkFastTan, false)
+REE_MK_TAN_DRIVER(ree_MkDrawTan, true)
+
+#define REE_MK_POW_DRIVER(name, draw)                                               \
+  static void REE_MK(name)(float *a, const float *b, size_t count){                 \
+    for (size_t i = 0; i < count; i += REE_MK_WIDTH){                               \
+      const size_t lanes = count - i < REE_MK_WIDTH ? count - i : REE_MK_WIDTH;     \
+      REE_MK_VF x = REE_MK(ree_MkLoad)(a + i, lanes);                               \
+      REE_MK_VF y = REE_MK(ree_MkLoad)(b + i, lanes);                               \
+      REE_MK_VI special;                                                            \
+      REE_MK(ree_MkStore)(a + i, REE_MK(ree_MkPow)(x, y, draw, &special), lanes);   \
+      if (!REE_MK(ree_MkAny)(special)) continue;                                    \
+      for (size_t l = 0; l < lanes; ++l){                                           \
+        if (special[l]) a[i + l] = powf(x[l], y[l]);                                \
+      }                                                                             \
+    }                                                                               \
+  }
+
+REE_MK_POW_DRIVER(ree_MkFastPow, false)
+REE_MK_POW_DRIVER(ree_MkDrawPow, true)
+
+#undef REE_MK_UNARY_DRIVER
+#undef REE_MK_SIN_COS_DRIVER
+#undef REE_MK_TAN_DRIVER
+#undef REE_MK_POW_DRIVER
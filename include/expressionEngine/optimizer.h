@@ -0,0 +1,17 @@
+/**
+  ree - Robkoo's Expression Engine
+*/
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "core/errorHandler.h"
+#include "expressionEngine/parser/shuntingYard.h"
+
+/**
+  @brief Folds constant subexpressions and applies algebraic identities to an RPN array in place
+  @note Subexpressions that would raise a domain error (e.g. ln(-1)) are left for the evaluator to report
+*/
+enum reh_error_code_e ree_OptimizeRpn(struct rma_arena_t *arena, struct ree_output_token_t *rpn, int *rpnCount);
+
+#endif // OPTIMIZER_H
@@ -0,0 +1,47 @@
+/**
+  ree - Robkoo's Expression Engine
+*/
+
+#ifndef PARAMETERS_H
+#define PARAMETERS_H
+
+#include "core/errorHandler.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// maximum amount of global parameters, a program records the ones it reads in a 64-bit mask
+#define REE_MAX_PARAMETERS         64
+#define REE_MAX_PARAMETER_NAME_LEN 15
+
+// value a parameter gets when a definition uses it before it was set
+#define REE_PARAMETER_DEFAULT 1.0f
+
+/*
+  Global named parameters (a, b, k, ...) shared by every function of a manager.
+  Programs read them by index (OP_PARAM) from values while evaluating, so setting one never recompiles anything.
+*/
+struct ree_parameter_table_t {
+  char names[REE_MAX_PARAMETERS][REE_MAX_PARAMETER_NAME_LEN + 1]; /**< Parameter names, index i belongs to values[i] */
+  float values[REE_MAX_PARAMETERS];                              /**< Current values, read by the compiled programs */
+  int count;                                                     /**< Number of parameters defined so far */
+};
+
+/**
+  @brief Looks up a parameter by name, returns its index or -1 if it isn't defined
+*/
+int ree_FindParameter(const struct ree_parameter_table_t *table, const char *name);
+
+/**
+  @brief Looks up a parameter by name and defines it with REE_PARAMETER_DEFAULT if it doesn't exist yet
+  @note Indices never change once handed out, compiled programs keep referring to them
+*/
+enum reh_error_code_e ree_DeclareParameter(struct ree_parameter_table_t *table, const char *name, int *index);
+
+/**
+  @brief Splits an assignment like "a=2" (or "k = 0.5") into a parameter name and value, returns false if it isn't one
+  @note Definitions have a '(' before the '=' or are named y, so they never match
+*/
+bool ree_ParseParameterAssignment(const char *text, char *name, size_t nameSize, float *value);
+
+#endif // PARAMETERS_H
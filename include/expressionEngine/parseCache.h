@@ -0,0 +1,91 @@
+/**
+  ree - Robkoo's Expression Engine
+*/
+
+#ifndef PARSE_CACHE_H
+#define PARSE_CACHE_H
+
+#include "core/arena.h"
+#include "core/errorHandler.h"
+#include "expressionEngine/compiler.h"
+#include "expressionEngine/parser/shuntingYard.h"
+
+#include <stdint.h>
+
+// maximum number of distinct definition bodies kept compiled, unused ones are evicted to make room
+#define REE_PARSE_CACHE_CAPACITY 128
+
+// a compiled definition body shared by every function defined with it
+struct ree_parse_cache_entry_t {
+  uint64_t hash;                          /**< Hash of the key, 0 marks an empty entry */
+  char *key;                              /**< Parameter name, a '\0' and the normalized body, allocated from arena */
+  size_t keyLength;                       /**< Length of the key including the separating '\0' */
+  struct rma_arena_t arena;               /**< Owns the key, the RPN and the bytecode */
+  struct ree_output_token_t *rpn;         /**< Optimized RPN of the body */
+  int rpnCount;                           /**< RPN token count */
+  struct ree_program_t program;           /**< Bytecode compiled from the RPN, never compiled to native code (jit stays nullptr) */
+  int referenceCount;                     /**< Functions sharing the entry, it can only be evicted at 0 */
+};
+
+// counters of the parse cache, for metrics
+struct ree_parse_cache_stats_t {
+  uint64_t hits;                          /**< Definitions that reused a compiled body */
+  uint64_t misses;                        /**< Cacheable definitions that had to be compiled */
+  uint64_t evictions;                     /**< Unused entries dropped to make room for another body */
+  int entryCount;                         /**< Bodies currently cached */
+};
+
+/*
+  Content addressed cache of compiled definition bodies, keyed by the parameter name and the body text with
+  insignificant whitespace removed ("f(x) = x^2 + 1" and "g(x)=x^2+1" share one entry).
+  Only bodies that don't depend on the other functions of the manager are cached, calls are resolved by name.
+  Programs refer to the parameter table of their manager, so every manager has its own cache.
+*/
+struct ree_parse_cache_t {
+  struct rma_pool_t *pool;                /**< Pool of the manager, the entry arenas and the table come from it */
+  struct ree_parse_cache_entry_t *entries;/**< REE_PARSE_CACHE_CAPACITY entries, allocated on the first insertion */
+  int entryCount;                         /**< Number of used entries */
+  int evictCursor;                        /**< Where the next search for an unused entry to evict starts */
+  struct ree_parse_cache_stats_t stats;   /**< Hit / miss counters */
+};
+
+/**
+  @brief Initializes an empty parse cache, its memory comes from the pool
+*/
+void ree_InitParseCache(struct ree_parse_cache_t *cache, struct rma_pool_t *pool);
+
+/**
+  @brief Releases every entry of the parse cache
+  @note Functions still sharing an entry must be released first
+*/
+void ree_DestroyParseCache(struct ree_parse_cache_t *cache);
+
+/**
+  @brief Builds the cache key of a definition body, cacheable is false if the body may depend on other functions
+  @note Whitespace is only kept where it separates two tokens (2 3, a b), the key is allocated from scratch
+*/
+enum reh_error_code_e ree_ParseCacheKey(struct rma_arena_t *scratch, const char *parameter, const char *body, char **key, size_t *keyLength, uint64_t *hash, bool *cacheable);
+
+/**
+  @brief Looks up a compiled body by its key, returns nullptr if it isn't cached
+  @note Counts a hit or a miss, the reference count of the entry isn't changed
+*/
+struct ree_parse_cache_entry_t* ree_FindParseCacheEntry(struct ree_parse_cache_t *cache, const char *key, size_t keyLength, uint64_t hash);
+
+/**
+  @brief Caches a compiled body, taking over the arena holding its RPN and bytecode (the arena is left empty)
+  @note entry is nullptr if every entry is in use, the arena is left alone then
+*/
+enum reh_error_code_e ree_InsertParseCacheEntry(struct ree_parse_cache_t *cache, const char *key, size_t keyLength, uint64_t hash, struct rma_arena_t *arena, struct ree_output_token_t *rpn, int rpnCount, const struct ree_program_t *program, struct ree_parse_cache_entry_t **entry);
+
+/**
+  @brief Drops a reference to an entry, unused entries stay cached until they are evicted
+*/
+void ree_ReleaseParseCacheEntry(struct ree_parse_cache_entry_t *entry);
+
+/**
+  @brief Retrieves the hit / miss counters of a parse cache
+*/
+enum reh_error_code_e ree_GetParseCacheStats(const struct ree_parse_cache_t *cache, struct ree_parse_cache_stats_t *stats);
+
+#endif // PARSE_CACHE_H
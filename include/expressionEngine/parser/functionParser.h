@@ -11,10 +11,18 @@
 /**
   @brief Inserts multiplication token where implicit multiplication is detected
 */
-enum reh_error_code_e ree_ImplicitMultiplication(struct ree_token_t **tokens, int *tokenCount, int *tokenCapacity);
+enum reh_error_code_e ree_ImplicitMultiplication(struct rma_arena_t *arena, const char *expression, struct ree_token_t **tokens, int *tokenCount, int *tokenCapacity);
+
+/**
+  @brief Inlines the functions called by the parsed RPN of a function, then optimizes and compiles it into the function arena
+  @note Callees are looked up by name in the manager, the parsed RPN is kept as the source RPN when there are calls
+*/
+enum reh_error_code_e ree_CompileFunction(struct ree_function_manager_t *manager, struct ree_function_t *function);
 
 /**
   @brief Parses a function definition string into a function structure
+  @note Identifiers of functions in the manager followed by '(' are calls, their bodies are inlined into the definition
+  @note The name isn't checked against the manager, adding and redefining functions handle clashes
 */
 enum reh_error_code_e ree_ParseFunction(char *definition, struct ree_function_t *function, struct ree_function_manager_t *manager, struct rm_vec3_t *functionColor);
 
@@ -5,28 +5,30 @@
 #ifndef POSTFIX_PARSER_H
 #define POSTFIX_PARSER_H
 
+#include "core/arena.h"
 #include "core/errorHandler.h"
 #include "expressionEngine/lexer.h"
 #include "expressionEngine/tokens.h"
 
-#define REE_MAX_TOKENS 256
+#include <stdint.h>
 
 enum ree_output_type_e {
   OUTPUT_NUMBER = 0,
   OUTPUT_OPERATOR = 1,
   OUTPUT_FUNCTION = 2,
+  OUTPUT_VARIABLE = 3,
 };
 
+/*
+  Compact RPN token (8 bytes), the text lives in the symbol table (see ree_SymbolToStr)
+*/
 struct ree_output_token_t {
-  enum ree_output_type_e type;  /**< Type of the output token */
-  int arity;                    /**< Arity of the operator or function */
-  char symbol[MAX_BUF_SIZE];    /**< Symbol representation */
+  uint8_t type;                 /**< Type of the output token (enum ree_output_type_e) */
+  uint8_t arity;                /**< Arity of the operator or function */
+  uint16_t symbol;              /**< Symbol id (enum ree_symbol_e), interned identifier id for variables */
   float value;                  /**< Numerical value for number tokens */
 };
 
-extern const char* validFunctions[];
-extern const int functionArrLength;
-
 /**
   @brief Converts an output token type to its string representation
 */
@@ -49,7 +51,9 @@ enum reh_error_code_e ree_MarkUnaryOperators(struct ree_token_t *tokens, const i
 
 /**
   @brief Parses an array of tokens into postfix notation using the Shunting Yard algorithm
+  @note expression is the string the tokens were lexed from, identifiers are interned from it
+  @note the operator stack is scratch memory taken from the arena
 */
-enum reh_error_code_e ree_ParseToPostfix(struct ree_token_t *tokens, const int tokenCount, struct ree_output_token_t *outputQueue, int *outputCount);
+enum reh_error_code_e ree_ParseToPostfix(struct rma_arena_t *arena, const char *expression, struct ree_token_t *tokens, const int tokenCount, struct ree_output_token_t *outputQueue, int *outputCount);
 
 #endif // POSTFIX_PARSER_H
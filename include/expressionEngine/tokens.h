@@ -5,6 +5,10 @@
 #ifndef TOKENS_H
 #define TOKENS_H
 
+#include "core/errorHandler.h"
+
+#include <stdint.h>
+
 enum ree_token_type_e {
   TOKEN_NUMBER, TOKEN_IDENTIFIER, TOKEN_FUNCTION,
   TOKEN_OPERATOR, TOKEN_PAREN_OPEN, TOKEN_PAREN_CLOSE,
@@ -14,9 +18,41 @@ enum ree_token_type_e {
   TOKEN_EQUALS, TOKEN_ILLEGAL, TOKEN_EOF
 };
 
+/*
+  Symbol ids stored in the RPN instead of strings.
+  Operators and built-in functions have fixed ids, identifiers (variables) are interned
+  at runtime and get ids starting at SYMBOL_COUNT.
+*/
+enum ree_symbol_e {
+  SYMBOL_NONE = 0,
+  SYMBOL_ADD, SYMBOL_SUB, SYMBOL_MUL, SYMBOL_DIV, SYMBOL_POW,
+  SYMBOL_FACT, SYMBOL_NEG, SYMBOL_POS,
+  SYMBOL_SIN, SYMBOL_COS, SYMBOL_TAN, SYMBOL_SQRT, SYMBOL_ABS, SYMBOL_LN, SYMBOL_LOG,
+  SYMBOL_COUNT
+};
+
+// maximum amount of symbols (built-in + interned identifiers), ids are stored in 16 bits
+#define REE_MAX_SYMBOLS 65536
+
 /**
   @brief Converts a token type to its string representation
 */
 const char* ree_TokenToStr(enum ree_token_type_e tokenType);
 
+/**
+  @brief Converts a symbol id to its string representation (operator, function or interned identifier name)
+*/
+const char* ree_SymbolToStr(uint16_t symbol);
+
+/**
+  @brief Checks whether a symbol id is one of the built-in functions (sin, cos, ...)
+*/
+bool ree_IsFunctionSymbol(uint16_t symbol);
+
+/**
+  @brief Interns a name of the given length, built-in function names resolve to their fixed ids
+  @note The same name always yields the same id for the lifetime of the program
+*/
+enum reh_error_code_e ree_InternSymbol(const char *name, int length, uint16_t *symbol);
+
 #endif
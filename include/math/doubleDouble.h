@@ -0,0 +1,81 @@
+/*
+  rm - Robkoo's Math
+*/
+
+#ifndef DOUBLE_DOUBLE_H
+#define DOUBLE_DOUBLE_H
+
+/*
+  Double-double number, the unevaluated sum hi + lo with |lo| <= ulp(hi) / 2.
+  Gives about 106 bits of mantissa using only double arithmetic.
+
+  Unlike the vector functions these don't validate their inputs, NaN and infinities simply propagate
+  (they sit in the evaluator's inner loop, which reports domain failures on its own).
+*/
+struct rm_dd_t {
+  double hi; /**< Leading part, the value rounded to double */
+  double lo; /**< Rounding error of hi */
+};
+
+/**
+  @brief Converts a double into a double-double
+*/
+struct rm_dd_t rm_DdFromDouble(double value);
+
+/**
+  @brief Rounds a double-double to the nearest double
+*/
+double rm_DdToDouble(struct rm_dd_t a);
+
+/**
+  @brief Adds two double-doubles
+*/
+struct rm_dd_t rm_DdAdd(struct rm_dd_t a, struct rm_dd_t b);
+
+/**
+  @brief Subtracts b from a
+*/
+struct rm_dd_t rm_DdSub(struct rm_dd_t a, struct rm_dd_t b);
+
+/**
+  @brief Multiplies two double-doubles
+*/
+struct rm_dd_t rm_DdMul(struct rm_dd_t a, struct rm_dd_t b);
+
+/**
+  @brief Divides a by b
+*/
+struct rm_dd_t rm_DdDiv(struct rm_dd_t a, struct rm_dd_t b);
+
+/**
+  @brief Negates a double-double
+*/
+struct rm_dd_t rm_DdNeg(struct rm_dd_t a);
+
+/**
+  @brief Absolute value of a double-double
+*/
+struct rm_dd_t rm_DdAbs(struct rm_dd_t a);
+
+/**
+  @brief Square root of a double-double (NaN for negative values)
+*/
+struct rm_dd_t rm_DdSqrt(struct rm_dd_t a);
+
+/**
+  @brief Raises a to the power of b, exact repeated squaring for small integer exponents
+  @note Other exponents are only accurate to a few ulps of double, plus a first-order correction for the low parts
+*/
+struct rm_dd_t rm_DdPow(struct rm_dd_t a, struct rm_dd_t b);
+
+/**
+  @brief Sine, cosine, tangent, natural log and log with base 10 of a double-double
+  @note Computed in double at hi with a first-order correction for lo, so neighbouring inputs stay smooth
+*/
+struct rm_dd_t rm_DdSin(struct rm_dd_t a);
+struct rm_dd_t rm_DdCos(struct rm_dd_t a);
+struct rm_dd_t rm_DdTan(struct rm_dd_t a);
+struct rm_dd_t rm_DdLn(struct rm_dd_t a);
+struct rm_dd_t rm_DdLog10(struct rm_dd_t a);
+
+#endif // DOUBLE_DOUBLE_H
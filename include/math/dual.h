@@ -0,0 +1,51 @@
+/*
+  rm - Robkoo's Math
+*/
+
+#ifndef DUAL_H
+#define DUAL_H
+
+/*
+  Dual number value + derivative * e with e^2 = 0, every operation carries the derivative along by the chain rule.
+  Values are computed with the same float operations as the evaluators, so they match them bit for bit.
+
+  A zero derivative stays zero (constants don't pick up 0 * inf = NaN from a steep function),
+  at a kink (abs at 0) the derivative is 0. Like the double-double functions these don't check domains.
+*/
+struct rm_dual_t {
+  float value;      /**< Function value */
+  float derivative; /**< Derivative along the seeded direction */
+};
+
+/**
+  @brief Creates a constant (derivative 0) and a variable (derivative 1)
+*/
+struct rm_dual_t rm_DualConst(float value);
+struct rm_dual_t rm_DualVariable(float value);
+
+/**
+  @brief Dual arithmetic
+*/
+struct rm_dual_t rm_DualAdd(struct rm_dual_t a, struct rm_dual_t b);
+struct rm_dual_t rm_DualSub(struct rm_dual_t a, struct rm_dual_t b);
+struct rm_dual_t rm_DualMul(struct rm_dual_t a, struct rm_dual_t b);
+struct rm_dual_t rm_DualDiv(struct rm_dual_t a, struct rm_dual_t b);
+struct rm_dual_t rm_DualNeg(struct rm_dual_t a);
+struct rm_dual_t rm_DualAbs(struct rm_dual_t a);
+
+/**
+  @brief Raises a to the power of b, d(a^b) = b * a^(b - 1) * da + a^b * ln(a) * db
+*/
+struct rm_dual_t rm_DualPow(struct rm_dual_t a, struct rm_dual_t b);
+
+/**
+  @brief Square root, sine, cosine, tangent, natural log and log with base 10 of a dual number
+*/
+struct rm_dual_t rm_DualSqrt(struct rm_dual_t a);
+struct rm_dual_t rm_DualSin(struct rm_dual_t a);
+struct rm_dual_t rm_DualCos(struct rm_dual_t a);
+struct rm_dual_t rm_DualTan(struct rm_dual_t a);
+struct rm_dual_t rm_DualLn(struct rm_dual_t a);
+struct rm_dual_t rm_DualLog10(struct rm_dual_t a);
+
+#endif // DUAL_H
@@ -0,0 +1,73 @@
+/*
+  rm - Robkoo's Math
+*/
+
+#ifndef INTERVAL_H
+#define INTERVAL_H
+
+#include <stdbool.h>
+
+/*
+  Closed interval [lo, hi] of doubles, every operation rounds its bounds outwards by one ulp
+  so the result contains the exact value of the operation for every point of the operands.
+
+  Operands outside of a function's domain are clamped to it (sqrt of [-1, 4] is [0, 2]),
+  results that can't be bounded (division by an interval containing 0, NaN bounds, ...) are the entire real line.
+  Deciding whether a domain failure may happen is up to the caller.
+*/
+struct rm_interval_t {
+  double lo; /**< Lower bound, may be -INFINITY */
+  double hi; /**< Upper bound, may be INFINITY */
+};
+
+/**
+  @brief Creates an interval from its bounds, rounded outwards (NaN bounds give the entire real line)
+*/
+struct rm_interval_t rm_IntervalMake(double lo, double hi);
+
+/**
+  @brief Creates the interval [-INFINITY, INFINITY]
+*/
+struct rm_interval_t rm_IntervalEntire(void);
+
+/**
+  @brief Checks whether an interval contains a value
+*/
+bool rm_IntervalContains(struct rm_interval_t a, double value);
+
+/**
+  @brief Checks whether both bounds of an interval are finite
+*/
+bool rm_IntervalIsBounded(struct rm_interval_t a);
+
+/**
+  @brief Interval arithmetic, rm_IntervalDiv gives the entire real line if b contains 0
+*/
+struct rm_interval_t rm_IntervalAdd(struct rm_interval_t a, struct rm_interval_t b);
+struct rm_interval_t rm_IntervalSub(struct rm_interval_t a, struct rm_interval_t b);
+struct rm_interval_t rm_IntervalMul(struct rm_interval_t a, struct rm_interval_t b);
+struct rm_interval_t rm_IntervalDiv(struct rm_interval_t a, struct rm_interval_t b);
+struct rm_interval_t rm_IntervalNeg(struct rm_interval_t a);
+struct rm_interval_t rm_IntervalAbs(struct rm_interval_t a);
+
+/**
+  @brief Raises a to the power of b
+  @note Exact integer exponents work for any base, other exponents need a >= 0 (the entire real line otherwise)
+*/
+struct rm_interval_t rm_IntervalPow(struct rm_interval_t a, struct rm_interval_t b);
+
+/**
+  @brief Square root, natural log and log with base 10 of the part of a inside their domain
+*/
+struct rm_interval_t rm_IntervalSqrt(struct rm_interval_t a);
+struct rm_interval_t rm_IntervalLn(struct rm_interval_t a);
+struct rm_interval_t rm_IntervalLog10(struct rm_interval_t a);
+
+/**
+  @brief Sine, cosine and tangent, rm_IntervalTan gives the entire real line if a contains a pole
+*/
+struct rm_interval_t rm_IntervalSin(struct rm_interval_t a);
+struct rm_interval_t rm_IntervalCos(struct rm_interval_t a);
+struct rm_interval_t rm_IntervalTan(struct rm_interval_t a);
+
+#endif // INTERVAL_H
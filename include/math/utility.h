@@ -28,4 +28,10 @@ enum rm_num_classes_e rm_ClassifyNum(float num);
 */
 enum reh_error_code_e rm_Factorial(int n, int *result);
 
+/**
+  @brief Checks whether two numbers are exactly equal (0 and -0 are, NaN equals nothing), for places that need == on purpose
+  @note Doesn't trip -Wfloat-equal, floats convert to double exactly
+*/
+bool rm_IsEqual(double a, double b);
+
 #endif // MATH_UTILITES_H
@@ -6,14 +6,28 @@
 #define FUNCTION_RENDERER_H
 
 #include "core/appContext.h"
+#include "core/threadPool.h"
 #include "expressionEngine/functionManager.h"
+#include "renderer/functionSampler.h"
 #include "core/errorHandler.h"
 
-struct rfr_function_point_data_t {
-  float *vertices;                /**< Array of vertex positions */
-  size_t vertexCount;             /**< Number of vertices */
-  float *undefinedPoints;         /**< Array of undefined point positions */
-  size_t undefinedPointsCount;    /**< Number of undefined points */
+#include <stdint.h>
+
+/*
+  Samples of a function kept between frames, they are taken again only when the viewport moves or the revision of the function changes.
+  Setting a parameter only bumps the revision of the functions reading it, so just those are resampled and uploaded.
+*/
+struct rfr_function_cache_t {
+  struct ree_function_handle_t function;   /**< Handle of the function the entry belongs to */
+  uint32_t revision;                       /**< Revision of the function when it was sampled */
+  float xMin;                              /**< Viewport the samples were taken for */
+  float xMax;
+  float yMin;
+  float yMax;
+  double step;                             /**< Sampling step, 0 while the entry holds no samples */
+  struct rfr_function_point_data_t points; /**< Owned samples and undefined points */
+  GLuint vbo;                              /**< Vertex buffer holding the samples */
+  GLsizeiptr vboCapacityBytes;             /**< Allocated capacity of the vertex buffer in bytes */
 };
 
 /**
@@ -22,13 +36,14 @@ struct rfr_function_point_data_t {
 enum reh_error_code_e rfr_Init(struct ra_app_context_t *context);
 
 /**
-  @brief Samples a function over a specified range and step size
+  @brief Renders the sampled function points
+  @note Functions are resampled only when the viewport or their revision changed since the previous frame
 */
-enum reh_error_code_e rfr_SampleFunction(struct ree_function_t *function, float worldXRangeMin, float worldXRangeMax, float worldStep, struct rfr_function_point_data_t *pointsData);
+enum reh_error_code_e rfr_Render(struct ra_app_context_t *context, struct ree_function_manager_t *functions, float **projectionMatrixPtr);
 
 /**
-  @brief Renders the sampled function points
+  @brief Releases the samples and vertex buffers cached for every function
 */
-enum reh_error_code_e rfr_Render(struct ra_app_context_t *context, struct ree_function_manager_t *functions, float **projectionMatrixPtr);
+void rfr_ReleaseCache(struct ra_app_context_t *context);
 
 #endif//FUNCTION_RENDERER_H
\ No newline at end of file
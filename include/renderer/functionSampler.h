@@ -0,0 +1,144 @@
+/*
+  rfr - Robkoo's Function Renderer
+*/
+
+#ifndef FUNCTION_SAMPLER_H
+#define FUNCTION_SAMPLER_H
+
+#include "core/arena.h"
+#include "core/errorHandler.h"
+#include "core/threadPool.h"
+#include "expressionEngine/compiler.h"
+#include "expressionEngine/functionManager.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Turns a function into the vertices of its curve for a viewport, on the CPU only (no GL),
+  so the renderer uploads what it produces and the benchmarks can time it without a window.
+*/
+
+struct rfr_function_point_data_t {
+  float *vertices;                /**< Array of vertex positions */
+  size_t vertexCount;             /**< Number of vertices */
+  float *undefinedPoints;         /**< Array of undefined point positions */
+  size_t undefinedPointsCount;    /**< Number of undefined points */
+};
+
+enum rfr_chunk_kind_e {
+  RFR_CHUNK_SPAN,      // culled or split further by rfr_SampleSpan
+  RFR_CHUNK_DIRECT,    // part of a fully visible span, every sample is evaluated
+  RFR_CHUNK_ENDS       // provably offscreen span, only its end points are evaluated
+};
+
+// a piece of the x range sampled as one task, on any thread
+struct rfr_sampling_chunk_t {
+  enum rfr_chunk_kind_e kind;               /**< How the samples of the chunk are taken */
+  size_t first;                             /**< Index of the first sample of the chunk */
+  size_t count;                             /**< Number of samples in the chunk */
+  size_t vertexCount;                       /**< Vertices the chunk produced */
+  size_t undefinedPointsCount;              /**< Undefined points the chunk produced */
+  enum reh_error_code_e err;                /**< Result of sampling the chunk */
+  struct reh_error_context_t error;         /**< Error context of the thread that sampled it if err isn't ERR_SUCCESS */
+};
+
+// a function's x range cut into chunks, planned on the calling thread
+struct rfr_sampling_plan_t {
+  struct ree_function_t *function;                  /**< Function being sampled */
+  enum ree_precision_e precision;                   /**< Precision tier picked once for the whole range */
+  double xMin;                                      /**< x of the first sample */
+  double step;                                      /**< Distance between two samples */
+  double yMin;                                      /**< Bottom of the viewport, spans entirely below it are culled */
+  double yMax;                                      /**< Top of the viewport, spans entirely above it are culled */
+  size_t sampleCount;                               /**< Number of samples in the range */
+  struct rfr_function_point_data_t *pointsData;     /**< Output, allocated for every sample */
+  const float *sampledXs;                           /**< x of every sample when a fused pass took them ahead, nullptr to evaluate while sampling */
+  const float *sampledYs;                           /**< y of every sample taken ahead */
+  const uint8_t *sampledStatus;                     /**< Status of every sample taken ahead */
+  struct rfr_sampling_chunk_t *chunks;              /**< Owned chunks covering the sample range in order */
+  size_t chunkCount;                                /**< Number of chunks */
+  size_t chunkCapacity;                             /**< Number of chunks allocated */
+};
+
+/*
+  Plans over the same range whose samples are evaluated in one pass before their chunks run:
+  the programs are fused into one (see ree_FusePrograms), every block of x is evaluated for all of them at once
+  and subexpressions they share are computed once. Chunks then take their samples from the pass instead of evaluating them.
+*/
+struct rfr_fused_sampling_t {
+  struct rfr_sampling_plan_t **plans;     /**< Owned list of the fused plans, plan i gets output i of the program */
+  size_t planCount;                       /**< Number of fused plans, 0 if fewer than two plans could be fused */
+  enum ree_math_mode_e mathMode;          /**< Math kernels of every fused plan */
+  double xMin;                            /**< x of the first sample */
+  double step;                            /**< Distance between two samples */
+  size_t sampleCount;                     /**< Number of samples of every fused plan */
+  struct rma_pool_t pool;                 /**< Blocks of the arenas below */
+  struct rma_arena_t scratch;             /**< DAG of the fused program while it's compiled */
+  struct rma_arena_t arena;               /**< Bytecode of the fused program */
+  struct ree_fused_program_t program;     /**< Programs of the fused plans compiled into one */
+  float *xs;                              /**< x of every sample, shared by the fused plans */
+  float *ys;                              /**< y of sample i of plan p at ys[p * sampleCount + i] */
+  uint8_t *status;                        /**< Status bytes laid out like ys */
+  size_t blockCount;                      /**< Number of blocks the pass is cut into */
+  enum reh_error_code_e *blockErrors;     /**< Result of evaluating every block */
+};
+
+/**
+  @brief Validates the range, allocates the output for every sample and cuts the range into chunks
+  @note Spans provably above or below [worldYRangeMin, worldYRangeMax] are culled to their end points
+*/
+enum reh_error_code_e rfr_PlanSampling(struct ree_function_t *function, double worldXRangeMin, double worldXRangeMax, double worldYRangeMin, double worldYRangeMax, double worldStep, struct rfr_function_point_data_t *pointsData, struct rfr_sampling_plan_t *plan);
+
+/**
+  @brief Samples one chunk of a plan into its part of the output
+  @note Safe to run for different chunks of the same plan at once, the outcome is kept in the chunk
+*/
+void rfr_SampleChunk(const struct rfr_sampling_plan_t *plan, size_t chunkIndex);
+
+/**
+  @brief Moves the parts of every chunk together in order and releases the chunks
+  @note The output is freed if any chunk failed, its error becomes the error of the calling thread
+*/
+enum reh_error_code_e rfr_FinishSampling(struct rfr_sampling_plan_t *plan);
+
+/**
+  @brief Picks the plans whose samples can be evaluated together (float tier, same math mode and samples, mostly on screen) and fuses their programs
+  @note Fewer than two such plans, or too little work shared between them, leave planCount at 0, the plans are then sampled one by one as without the pass
+*/
+enum reh_error_code_e rfr_PlanFusedSampling(struct rfr_sampling_plan_t *plans, size_t planCount, struct rfr_fused_sampling_t *fused);
+
+/**
+  @brief Evaluates one block of samples for every fused plan
+  @note Safe to run for different blocks at once, the outcome is kept per block
+*/
+void rfr_SampleFusedBlock(const struct rfr_fused_sampling_t *fused, size_t blockIndex);
+
+/**
+  @brief Hands the samples of the pass to the fused plans, must be called after every block ran and before any chunk of the plans
+  @note If a block failed the plans evaluate their samples themselves, as if nothing was fused
+*/
+void rfr_AttachFusedSamples(struct rfr_fused_sampling_t *fused);
+
+/**
+  @brief Releases the fused program and the samples of the pass, once every chunk of the fused plans ran
+*/
+void rfr_ReleaseFusedSampling(struct rfr_fused_sampling_t *fused);
+
+/**
+  @brief Samples a function over a specified range and step size
+  @note The precision tier comes from the function, REE_PRECISION_AUTO picks it from the range and step
+  @note Spans the interval evaluator proves outside [worldYRangeMin, worldYRangeMax] only keep their end points, discontinuities are cut where a pole may lie between two samples
+  @note The range is sampled in fixed-size chunks spread over the pool (nullptr samples on the calling thread), the output is the same for any thread count
+*/
+enum reh_error_code_e rfr_SampleFunction(struct ree_function_t *function, struct rtp_thread_pool_t *pool, double worldXRangeMin, double worldXRangeMax, double worldYRangeMin, double worldYRangeMax, double worldStep, struct rfr_function_point_data_t *pointsData);
+
+/**
+  @brief Samples several functions over the same range and step size, pointsData[i] receives the samples of functions[i]
+  @note Every function gets the output rfr_SampleFunction gives it, float tier ones sharing enough work are evaluated together in one fused pass
+  @note The chunks of every function run as one batch on the pool, a function whose sampling failed is left without output
+        (vertices is nullptr) and the first failure is returned after the others were sampled
+*/
+enum reh_error_code_e rfr_SampleFunctions(struct ree_function_t *const *functions, size_t functionCount, struct rtp_thread_pool_t *pool, double worldXRangeMin, double worldXRangeMax, double worldYRangeMin, double worldYRangeMax, double worldStep, struct rfr_function_point_data_t *pointsData);
+
+#endif // FUNCTION_SAMPLER_H
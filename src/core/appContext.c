@@ -1,5 +1,7 @@
 #include "core/appContext.h"
 #include "core/logger.h"
+#include "core/threadPool.h"
+#include "renderer/functionRenderer.h"
 
 #include "freetype/freetype.h"
 #include "glad/glad.h"
@@ -54,6 +56,14 @@ void ra_AppContextCleanup(struct ra_app_context_t *context, const char *msg){
   if (context->fProgram != 0){
     glDeleteProgram(context->fProgram);
   }
+  if (context->fCache != nullptr){
+    rfr_ReleaseCache(context);
+  }
+  if (context->fPool != nullptr){
+    rtp_DestroyThreadPool(context->fPool);
+    free(context->fPool);
+    context->fPool = nullptr;
+  }
   if (context->face != nullptr){
     FT_Done_Face(context->face);
   }
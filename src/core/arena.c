@@ -0,0 +1,177 @@
+#include "core/arena.h"
+#include "core/errorHandler.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void* rma_MallocHook(size_t size, void *userData){
+  (void)userData;
+  return malloc(size);
+}
+
+static void rma_FreeHook(void *ptr, void *userData){
+  (void)userData;
+  free(ptr);
+}
+
+static struct rma_allocator_t defaultAllocator = {rma_MallocHook, rma_FreeHook, nullptr};
+
+// rounds a size up so that every allocation starts aligned for any type
+static size_t rma_AlignSize(size_t size){
+  const size_t alignment = _Alignof(max_align_t);
+  return (size + alignment - 1) & ~(alignment - 1);
+}
+
+void rma_SetDefaultAllocator(const struct rma_allocator_t *allocator){
+  if (allocator == nullptr || allocator->alloc == nullptr || allocator->free == nullptr){
+    defaultAllocator = (struct rma_allocator_t){rma_MallocHook, rma_FreeHook, nullptr};
+    return;
+  }
+
+  defaultAllocator = *allocator;
+}
+
+const struct rma_allocator_t* rma_GetDefaultAllocator(void){
+  return &defaultAllocator;
+}
+
+enum reh_error_code_e rma_InitPool(struct rma_pool_t *pool, size_t blockSize, int maxFreeBlocks, const struct rma_allocator_t *allocator){
+  if (pool == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pool passed to rma_InitPool is NULL.");
+  }
+  else if (blockSize == 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Block size passed to rma_InitPool is 0.");
+  }
+  else if (allocator != nullptr && (allocator->alloc == nullptr || allocator->free == nullptr)){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Allocator passed to rma_InitPool is missing its alloc or free hook.");
+  }
+
+  pool->allocator = (allocator != nullptr) ? *allocator : defaultAllocator;
+  pool->blockSize = rma_AlignSize(blockSize);
+  pool->freeBlocks = nullptr;
+  pool->freeBlockCount = 0;
+  pool->maxFreeBlocks = (maxFreeBlocks > 0) ? maxFreeBlocks : 0;
+
+  return ERR_SUCCESS;
+}
+
+void rma_DestroyPool(struct rma_pool_t *pool){
+  if (pool == nullptr) return;
+
+  while (pool->freeBlocks != nullptr){
+    struct rma_block_t *next = pool->freeBlocks->next;
+    pool->allocator.free(pool->freeBlocks, pool->allocator.userData);
+    pool->freeBlocks = next;
+  }
+  pool->freeBlockCount = 0;
+}
+
+void rma_InitArena(struct rma_arena_t *arena, struct rma_pool_t *pool){
+  if (arena == nullptr) return;
+
+  arena->pool = pool;
+  arena->head = nullptr;
+  arena->lastOffset = 0;
+}
+
+// gets a block with at least capacity usable bytes, reusing a pooled one when the size allows
+static struct rma_block_t* rma_AcquireBlock(struct rma_pool_t *pool, size_t capacity){
+  if (capacity <= pool->blockSize && pool->freeBlocks != nullptr){
+    struct rma_block_t *block = pool->freeBlocks;
+    pool->freeBlocks = block->next;
+    pool->freeBlockCount--;
+    block->used = 0;
+    return block;
+  }
+
+  if (capacity < pool->blockSize){
+    capacity = pool->blockSize;
+  }
+
+  struct rma_block_t *block = pool->allocator.alloc(sizeof(struct rma_block_t) + capacity, pool->allocator.userData);
+  if (block == nullptr){
+    return nullptr;
+  }
+
+  block->capacity = capacity;
+  block->used = 0;
+  return block;
+}
+
+void* rma_Alloc(struct rma_arena_t *arena, size_t size){
+  if (arena == nullptr || arena->pool == nullptr){
+    return nullptr;
+  }
+
+  size = rma_AlignSize(size == 0 ? 1 : size);
+
+  if (arena->head == nullptr || arena->head->capacity - arena->head->used < size){
+    struct rma_block_t *block = rma_AcquireBlock(arena->pool, size);
+    if (block == nullptr){
+      return nullptr;
+    }
+
+    block->next = arena->head;
+    arena->head = block;
+  }
+
+  arena->lastOffset = arena->head->used;
+  arena->head->used += size;
+
+  return (unsigned char*)arena->head->data + arena->lastOffset;
+}
+
+void* rma_Realloc(struct rma_arena_t *arena, void *ptr, size_t oldSize, size_t newSize){
+  if (ptr == nullptr){
+    return rma_Alloc(arena, newSize);
+  }
+  if (arena == nullptr || arena->head == nullptr){
+    return nullptr;
+  }
+
+  // the most recent allocation can grow or shrink in place
+  unsigned char *last = (unsigned char*)arena->head->data + arena->lastOffset;
+  if ((unsigned char*)ptr == last){
+    size_t alignedSize = rma_AlignSize(newSize == 0 ? 1 : newSize);
+    if (alignedSize <= arena->head->capacity - arena->lastOffset){
+      arena->head->used = arena->lastOffset + alignedSize;
+      return ptr;
+    }
+  }
+
+  // arenas never give memory back early, a shrink just keeps the old allocation
+  if (newSize <= oldSize){
+    return ptr;
+  }
+
+  void *newPtr = rma_Alloc(arena, newSize);
+  if (newPtr == nullptr){
+    return nullptr;
+  }
+
+  memcpy(newPtr, ptr, oldSize);
+  return newPtr;
+}
+
+void rma_ResetArena(struct rma_arena_t *arena){
+  if (arena == nullptr || arena->pool == nullptr) return;
+
+  struct rma_pool_t *pool = arena->pool;
+
+  while (arena->head != nullptr){
+    struct rma_block_t *block = arena->head;
+    arena->head = block->next;
+
+    // only standard sized blocks are pooled, dedicated large blocks go straight back to the allocator
+    if (block->capacity == pool->blockSize && pool->freeBlockCount < pool->maxFreeBlocks){
+      block->next = pool->freeBlocks;
+      pool->freeBlocks = block;
+      pool->freeBlockCount++;
+    }
+    else {
+      pool->allocator.free(block, pool->allocator.userData);
+    }
+  }
+
+  arena->lastOffset = 0;
+}
@@ -2,7 +2,8 @@
 
 #include <string.h>
 
-static struct reh_error_context_t g_lastError = {0};
+// every thread has its own last error, workers of the thread pool can fail without clobbering each other
+static thread_local struct reh_error_context_t g_lastError = {0};
 
 const struct reh_error_context_t *reh_GetLastError(void){
   return &g_lastError;
@@ -1,9 +1,24 @@
 #include "core/logger.h"
 #include "core/errorHandler.h"
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdarg.h>
 
+// a message is written with several printf calls, the lock keeps messages of different threads from interleaving
+static pthread_mutex_t rl_outputLock = PTHREAD_MUTEX_INITIALIZER;
+
+// where messages go and the least severe level that is printed, stdout and everything unless changed
+static FILE *rl_output = nullptr;
+static enum rl_log_level_e rl_minimumLevel = RL_DEBUG;
+
+void rl_SetLogOutput(FILE *stream, enum rl_log_level_e minimumLevel){
+  pthread_mutex_lock(&rl_outputLock);
+  rl_output = stream;
+  rl_minimumLevel = minimumLevel;
+  pthread_mutex_unlock(&rl_outputLock);
+}
+
 #ifdef _WIN32
 #define NOGDI // prevent inclusion of many stuff, amongst them being the RL_ERROR macro
 #include <windows.h>
@@ -45,16 +60,25 @@ void rl_LogMsg(enum rl_log_level_e severity, const char *restrict msg, ...){
     default:      color = RL_END;         tag = "LOG";     break;
   }
 
+  pthread_mutex_lock(&rl_outputLock);
+  if (severity < rl_minimumLevel){
+    pthread_mutex_unlock(&rl_outputLock);
+    return;
+  }
+  FILE *output = (rl_output != nullptr) ? rl_output : stdout;
+
   // print the bracket with colored tag
-  printf("[%s %-7s %s] ", color, tag, RL_END);
+  fprintf(output, "[%s %-7s %s] ", color, tag, RL_END);
 
   // print the message
   va_list args;
   va_start(args, msg);
-  vprintf(msg, args);
+  vfprintf(output, msg, args);
   va_end(args);
 
-  printf("\n");
+  fprintf(output, "\n");
+
+  pthread_mutex_unlock(&rl_outputLock);
 }
 
 void rl_LogError(const struct reh_error_context_t *ctx, enum rl_log_level_e severity){
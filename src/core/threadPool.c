@@ -0,0 +1,154 @@
+// sysconf isn't part of strict ISO C, ask glibc for the default feature set before any include
+#define _DEFAULT_SOURCE
+
+#include "core/threadPool.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+  #define NOGDI
+  #include <windows.h>
+#else
+  #include <unistd.h>
+#endif
+
+int rtp_HardwareThreadCount(void){
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (info.dwNumberOfProcessors > 0) ? (int)info.dwNumberOfProcessors : 1;
+#else
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return (count > 0) ? (int)count : 1;
+#endif
+}
+
+// claims indices of the batch until none are left
+static void rtp_RunTasks(struct rtp_thread_pool_t *pool, rtp_task_t task, void *userData, size_t taskCount){
+  for (size_t index = atomic_fetch_add(&pool->nextTask, 1); index < taskCount; index = atomic_fetch_add(&pool->nextTask, 1)){
+    task(userData, index);
+  }
+}
+
+static void* rtp_WorkerMain(void *argument){
+  struct rtp_thread_pool_t *pool = argument;
+  uint64_t joinedBatch = 0;
+
+  pthread_mutex_lock(&pool->mutex);
+  for (;;){
+    while (pool->stopping == false && pool->batch == joinedBatch){
+      pthread_cond_wait(&pool->wake, &pool->mutex);
+    }
+    if (pool->stopping == true) break;
+
+    // the batch can't be replaced while this worker is counted as busy, so the copies stay valid
+    joinedBatch = pool->batch;
+    rtp_task_t task = pool->task;
+    void *userData = pool->userData;
+    size_t taskCount = pool->taskCount;
+    pool->busyWorkers++;
+    pthread_mutex_unlock(&pool->mutex);
+
+    rtp_RunTasks(pool, task, userData, taskCount);
+
+    pthread_mutex_lock(&pool->mutex);
+    if (--pool->busyWorkers == 0){
+      pthread_cond_broadcast(&pool->idle);
+    }
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  return nullptr;
+}
+
+enum reh_error_code_e rtp_InitThreadPool(struct rtp_thread_pool_t *pool, int threadCount){
+  if (pool == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pool passed to rtp_InitThreadPool is NULL.");
+  }
+  else if (threadCount < 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Negative thread count (%d) passed to rtp_InitThreadPool.", threadCount);
+  }
+
+  memset(pool, 0, sizeof *pool);
+  if (threadCount == 0){
+    threadCount = rtp_HardwareThreadCount() - 1;
+  }
+  if (threadCount > RTP_MAX_THREADS){
+    threadCount = RTP_MAX_THREADS;
+  }
+
+  if (pthread_mutex_init(&pool->mutex, nullptr) != 0){
+    SET_ERROR_RETURN(ERR_UNKNOWN, "Failed to initialize the mutex of the thread pool.");
+  }
+  if (pthread_cond_init(&pool->wake, nullptr) != 0 || pthread_cond_init(&pool->idle, nullptr) != 0){
+    pthread_mutex_destroy(&pool->mutex);
+    SET_ERROR_RETURN(ERR_UNKNOWN, "Failed to initialize the condition variables of the thread pool.");
+  }
+
+  for (int i = 0; i < threadCount; ++i){
+    if (pthread_create(&pool->threads[i], nullptr, rtp_WorkerMain, pool) != 0){
+      // the pool still works with the workers started so far
+      rl_LogMsg(RL_WARNING, "Failed to start worker thread %d of %d, the pool continues with %d.", i + 1, threadCount, i);
+      break;
+    }
+    pool->threadCount++;
+  }
+
+  rl_LogMsg(RL_DEBUG, "Thread pool started with %d worker threads.", pool->threadCount);
+
+  return ERR_SUCCESS;
+}
+
+void rtp_DestroyThreadPool(struct rtp_thread_pool_t *pool){
+  if (pool == nullptr) return;
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->stopping = true;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->mutex);
+
+  for (int i = 0; i < pool->threadCount; ++i){
+    pthread_join(pool->threads[i], nullptr);
+  }
+
+  pthread_cond_destroy(&pool->wake);
+  pthread_cond_destroy(&pool->idle);
+  pthread_mutex_destroy(&pool->mutex);
+  memset(pool, 0, sizeof *pool);
+}
+
+void rtp_ParallelFor(struct rtp_thread_pool_t *pool, size_t taskCount, rtp_task_t task, void *userData){
+  if (task == nullptr || taskCount == 0) return;
+
+  // nothing to hand out, or a single task the calling thread can take without waking anyone
+  if (pool == nullptr || pool->threadCount == 0 || taskCount == 1){
+    for (size_t index = 0; index < taskCount; ++index){
+      task(userData, index);
+    }
+    return;
+  }
+
+  // a worker that woke up late may still be in the previous batch, the counter is reset only once it left
+  pthread_mutex_lock(&pool->mutex);
+  while (pool->busyWorkers > 0){
+    pthread_cond_wait(&pool->idle, &pool->mutex);
+  }
+  pool->task = task;
+  pool->userData = userData;
+  pool->taskCount = taskCount;
+  atomic_store(&pool->nextTask, 0);
+  pool->batch++;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->mutex);
+
+  rtp_RunTasks(pool, task, userData, taskCount);
+
+  // every index is claimed, the batch is done once the workers that claimed them are
+  pthread_mutex_lock(&pool->mutex);
+  while (pool->busyWorkers > 0){
+    pthread_cond_wait(&pool->idle, &pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+}
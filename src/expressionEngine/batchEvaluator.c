@@ -0,0 +1,240 @@
+#include "expressionEngine/evaluator.h"
+#include "core/errorHandler.h"
+#include "expressionEngine/batchKernels.h"
+#include "expressionEngine/compiler.h"
+#include "expressionEngine/jit.h"
+#include "math/utility.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+// marks a lane as undefined, the first failure of a lane is the one reported
+static inline void ree_FailLane(uint8_t *laneStatus, float *a, size_t lane, enum ree_eval_status_e status){
+  if (laneStatus[lane] == REE_EVAL_OK){
+    laneStatus[lane] = (uint8_t)status;
+  }
+  a[lane] = NAN;
+}
+
+enum reh_error_code_e ree_EvaluateBatch(const struct ree_program_t *program, const float *xs, size_t count, float *ys, uint8_t *status){
+  return ree_EvaluateBatchMode(program, REE_MATH_EXACT, xs, count, ys, status);
+}
+
+enum reh_error_code_e ree_EvaluateBatchMode(const struct ree_program_t *program, enum ree_math_mode_e mode, const float *xs, size_t count, float *ys, uint8_t *status){
+  if (program == nullptr || program->code == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Program provided to ree_EvaluateBatchMode is NULL.");
+  }
+  else if (xs == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "xs array provided to ree_EvaluateBatchMode is NULL.");
+  }
+  else if (ys == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "ys array provided to ree_EvaluateBatchMode is NULL.");
+  }
+  else if (status == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Status array provided to ree_EvaluateBatchMode is NULL.");
+  }
+
+  if (program->maxStackDepth <= 0 || program->maxStackDepth > REE_MAX_STACK_DEPTH){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Program provided to ree_EvaluateBatchMode has an invalid stack depth (%d).", program->maxStackDepth);
+  }
+  if (count == 0){
+    return ERR_SUCCESS;
+  }
+
+  // hot programs run as native code, same results and statuses lane for lane as long as the math mode matches
+  if (program->jit != nullptr && program->jit->mode == mode){
+    return ree_EvaluateJit(program->jit, xs, count, ys, status);
+  }
+
+  const struct ree_batch_kernels_t *kernels = ree_GetBatchKernels();
+  const struct ree_math_kernels_t *math = ree_GetMathKernels(mode);
+
+  // one block of lanes per stack entry and per temporary slot, fixed size like the scalar stack (the compiler bounds both)
+  float stack[REE_MAX_STACK_DEPTH * REE_BATCH_LANES];
+  float temps[REE_MAX_TEMP_SLOTS * REE_BATCH_LANES];
+
+  const uint8_t *end = program->code + program->codeSize;
+
+  for (size_t base = 0; base < count; base += REE_BATCH_LANES){
+    const size_t lanes = (count - base < REE_BATCH_LANES) ? count - base : REE_BATCH_LANES;
+    uint8_t *laneStatus = status + base;
+    memset(laneStatus, REE_EVAL_OK, lanes);
+
+    size_t stackIndex = 0;
+    const uint8_t *code = program->code;
+
+    while (code < end){
+      // top of the stack (a) and the entry below it (b is the top for binary operators)
+      float *a = (stackIndex >= 1) ? &stack[(stackIndex - 1) * REE_BATCH_LANES] : nullptr;
+
+      switch ((enum ree_opcode_e)*code++){
+        case OP_CONST: {
+          float value;
+          memcpy(&value, code, sizeof(float));
+          code += sizeof(float);
+          float *block = &stack[stackIndex++ * REE_BATCH_LANES];
+          for (size_t i = 0; i < lanes; ++i) block[i] = value;
+          break;
+        }
+        case OP_VAR: {
+          // only the function parameter (slot 0) is bound in batch mode
+          if (*code++ != 0){
+            SET_ERROR_RETURN(ERR_INVALID_INPUT, "ree_EvaluateBatchMode only binds variable slot 0, program references slot %u.", code[-1]);
+          }
+          memcpy(&stack[stackIndex++ * REE_BATCH_LANES], xs + base, lanes * sizeof(float));
+          break;
+        }
+        case OP_STORE: {
+          memcpy(&temps[*code++ * REE_BATCH_LANES], a, lanes * sizeof(float));
+          break;
+        }
+        case OP_LOAD: {
+          memcpy(&stack[stackIndex++ * REE_BATCH_LANES], &temps[*code++ * REE_BATCH_LANES], lanes * sizeof(float));
+          break;
+        }
+        case OP_PARAM: {
+          // read once per block, the same value for every lane like a constant
+          const float value = program->parameters[*code++];
+          float *block = &stack[stackIndex++ * REE_BATCH_LANES];
+          for (size_t i = 0; i < lanes; ++i) block[i] = value;
+          break;
+        }
+
+        /*
+          #############
+          # OPERATORS #
+          #############
+        */
+        case OP_ADD: {
+          stackIndex--;
+          a = &stack[(stackIndex - 1) * REE_BATCH_LANES];
+          kernels->add(a, &stack[stackIndex * REE_BATCH_LANES], lanes);
+          break;
+        }
+        case OP_SUB: {
+          stackIndex--;
+          a = &stack[(stackIndex - 1) * REE_BATCH_LANES];
+          kernels->sub(a, &stack[stackIndex * REE_BATCH_LANES], lanes);
+          break;
+        }
+        case OP_MUL: {
+          stackIndex--;
+          a = &stack[(stackIndex - 1) * REE_BATCH_LANES];
+          kernels->mul(a, &stack[stackIndex * REE_BATCH_LANES], lanes);
+          break;
+        }
+        case OP_DIV: {
+          stackIndex--;
+          a = &stack[(stackIndex - 1) * REE_BATCH_LANES];
+          const float *b = &stack[stackIndex * REE_BATCH_LANES];
+          kernels->div(a, b, lanes);
+          for (size_t i = 0; i < lanes; ++i){
+            if (fabsf(b[i]) < FLT_EPSILON){
+              ree_FailLane(laneStatus, a, i, REE_EVAL_DIVISION_BY_ZERO);
+            }
+          }
+          break;
+        }
+        case OP_POW: {
+          stackIndex--;
+          a = &stack[(stackIndex - 1) * REE_BATCH_LANES];
+          const float *b = &stack[stackIndex * REE_BATCH_LANES];
+          math->pow(a, b, lanes);
+          break;
+        }
+        case OP_FACT: {
+          for (size_t i = 0; i < lanes; ++i){
+            // non-negative integers up to REE_MAX_FACTORIAL_FLOAT, checked before the conversion to int so NaN and huge values never reach it
+            const float rounded = roundf(a[i]);
+            int localResult = 0;
+            if (!(fabsf(a[i] - rounded) < FLT_EPSILON) || !(rounded >= 0.0f && rounded <= REE_MAX_FACTORIAL_FLOAT) || rm_Factorial((int)rounded, &localResult) != ERR_SUCCESS){
+              ree_FailLane(laneStatus, a, i, REE_EVAL_FACTORIAL_DOMAIN);
+              continue;
+            }
+            a[i] = (float)localResult;
+          }
+          break;
+        }
+        case OP_NEG: {
+          kernels->neg(a, lanes);
+          break;
+        }
+        case OP_POS: {
+          break;
+        }
+
+        /*
+          #############
+          # FUNCTIONS #
+          #############
+        */
+        case OP_SIN: {
+          math->sin(a, lanes);
+          break;
+        }
+        case OP_COS: {
+          math->cos(a, lanes);
+          break;
+        }
+        case OP_TAN: {
+          uint8_t poles[REE_BATCH_LANES];
+          math->tan(a, poles, lanes);
+          for (size_t i = 0; i < lanes; ++i){
+            if (poles[i]){
+              ree_FailLane(laneStatus, a, i, REE_EVAL_TAN_DOMAIN);
+            }
+          }
+          break;
+        }
+        case OP_SQRT: {
+          for (size_t i = 0; i < lanes; ++i){
+            if (a[i] < 0){
+              ree_FailLane(laneStatus, a, i, REE_EVAL_SQRT_DOMAIN);
+            }
+          }
+          kernels->sqrt(a, lanes);
+          break;
+        }
+        case OP_ABS: {
+          kernels->abs(a, lanes);
+          break;
+        }
+        case OP_LN: {
+          for (size_t i = 0; i < lanes; ++i){
+            if (a[i] <= 0){
+              ree_FailLane(laneStatus, a, i, REE_EVAL_LN_DOMAIN);
+            }
+          }
+          math->ln(a, lanes);
+          break;
+        }
+        case OP_LOG: {
+          for (size_t i = 0; i < lanes; ++i){
+            if (a[i] <= 0){
+              ree_FailLane(laneStatus, a, i, REE_EVAL_LOG_DOMAIN);
+            }
+          }
+          math->log10(a, lanes);
+          break;
+        }
+
+        /*
+          ##################
+          # UNKNOWN OPCODE #
+          ##################
+        */
+        default:
+          SET_ERROR_RETURN(ERR_INVALID_OPERATOR, "Provided opcode (%u) is unknown.", code[-1]);
+      }
+    }
+
+    // a failed lane can turn back into a number (NaN^0 is 1), its result is NaN like in the scalar evaluator
+    memcpy(ys + base, stack, lanes * sizeof(float));
+    for (size_t i = 0; i < lanes; ++i){
+      if (laneStatus[i] != REE_EVAL_OK) ys[base + i] = NAN;
+    }
+  }
+
+  return ERR_SUCCESS;
+}
@@ -0,0 +1,157 @@
+#include "expressionEngine/batchKernels.h"
+
+#include <math.h>
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define REE_HAS_X86_KERNELS
+  #include <immintrin.h>
+#endif
+
+const char* ree_KernelIsaToStr(enum ree_kernel_isa_e isa){
+  switch (isa){
+    case REE_ISA_SCALAR: return "scalar";
+    case REE_ISA_SSE2:   return "sse2";
+    case REE_ISA_AVX2:   return "avx2";
+    default:             return "Unknown ISA";
+  }
+}
+
+/*
+  ##########
+  # SCALAR #
+  ##########
+*/
+static void ree_ScalarAdd(float *a, const float *b, size_t count){
+  for (size_t i = 0; i < count; ++i) a[i] += b[i];
+}
+static void ree_ScalarSub(float *a, const float *b, size_t count){
+  for (size_t i = 0; i < count; ++i) a[i] -= b[i];
+}
+static void ree_ScalarMul(float *a, const float *b, size_t count){
+  for (size_t i = 0; i < count; ++i) a[i] *= b[i];
+}
+static void ree_ScalarDiv(float *a, const float *b, size_t count){
+  for (size_t i = 0; i < count; ++i) a[i] /= b[i];
+}
+static void ree_ScalarNeg(float *a, size_t count){
+  for (size_t i = 0; i < count; ++i) a[i] = -a[i];
+}
+static void ree_ScalarAbs(float *a, size_t count){
+  for (size_t i = 0; i < count; ++i) a[i] = fabsf(a[i]);
+}
+static void ree_ScalarSqrt(float *a, size_t count){
+  for (size_t i = 0; i < count; ++i) a[i] = sqrtf(a[i]);
+}
+
+static const struct ree_batch_kernels_t scalarKernels = {
+  REE_ISA_SCALAR,
+  ree_ScalarAdd, ree_ScalarSub, ree_ScalarMul, ree_ScalarDiv,
+  ree_ScalarNeg, ree_ScalarAbs, ree_ScalarSqrt
+};
+
+#ifdef REE_HAS_X86_KERNELS
+
+/*
+  Generates a binary kernel: the vector body handles `width` lanes per iteration, the scalar tail handles the rest.
+*/
+#define REE_BINARY_KERNEL(name, isaName, vecType, width, load, store, op, scalarOp) \
+  __attribute__((target(isaName)))                                                  \
+  static void name(float *a, const float *b, size_t count){                         \
+    size_t i = 0;                                                                   \
+    for (; i + (width) <= count; i += (width)){                                     \
+      vecType va = load(a + i);                                                     \
+      vecType vb = load(b + i);                                                     \
+      store(a + i, op(va, vb));                                                     \
+    }                                                                               \
+    for (; i < count; ++i) a[i] = a[i] scalarOp b[i];                               \
+  }
+
+/*
+  Generates a unary kernel with the same vector body + scalar tail layout.
+*/
+#define REE_UNARY_KERNEL(name, isaName, vecType, width, load, store, vecExpr, scalarExpr) \
+  __attribute__((target(isaName)))                                                        \
+  static void name(float *a, size_t count){                                               \
+    size_t i = 0;                                                                         \
+    for (; i + (width) <= count; i += (width)){                                           \
+      vecType v = load(a + i);                                                            \
+      store(a + i, vecExpr);                                                              \
+    }                                                                                     \
+    for (; i < count; ++i) a[i] = scalarExpr;                                             \
+  }
+
+/*
+  ########
+  # SSE2 #
+  ########
+*/
+REE_BINARY_KERNEL(ree_Sse2Add, "sse2", __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps, +)
+REE_BINARY_KERNEL(ree_Sse2Sub, "sse2", __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_sub_ps, -)
+REE_BINARY_KERNEL(ree_Sse2Mul, "sse2", __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_mul_ps, *)
+REE_BINARY_KERNEL(ree_Sse2Div, "sse2", __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_div_ps, /)
+REE_UNARY_KERNEL(ree_Sse2Neg, "sse2", __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_xor_ps(v, _mm_set1_ps(-0.0f)), -a[i])
+REE_UNARY_KERNEL(ree_Sse2Abs, "sse2", __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_andnot_ps(_mm_set1_ps(-0.0f), v), fabsf(a[i]))
+REE_UNARY_KERNEL(ree_Sse2Sqrt, "sse2", __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_sqrt_ps(v), sqrtf(a[i]))
+
+static const struct ree_batch_kernels_t sse2Kernels = {
+  REE_ISA_SSE2,
+  ree_Sse2Add, ree_Sse2Sub, ree_Sse2Mul, ree_Sse2Div,
+  ree_Sse2Neg, ree_Sse2Abs, ree_Sse2Sqrt
+};
+
+/*
+  ########
+  # AVX2 #
+  ########
+*/
+REE_BINARY_KERNEL(ree_Avx2Add, "avx2", __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps, +)
+REE_BINARY_KERNEL(ree_Avx2Sub, "avx2", __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_sub_ps, -)
+REE_BINARY_KERNEL(ree_Avx2Mul, "avx2", __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_mul_ps, *)
+REE_BINARY_KERNEL(ree_Avx2Div, "avx2", __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_div_ps, /)
+REE_UNARY_KERNEL(ree_Avx2Neg, "avx2", __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_xor_ps(v, _mm256_set1_ps(-0.0f)), -a[i])
+REE_UNARY_KERNEL(ree_Avx2Abs, "avx2", __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v), fabsf(a[i]))
+REE_UNARY_KERNEL(ree_Avx2Sqrt, "avx2", __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_sqrt_ps(v), sqrtf(a[i]))
+
+static const struct ree_batch_kernels_t avx2Kernels = {
+  REE_ISA_AVX2,
+  ree_Avx2Add, ree_Avx2Sub, ree_Avx2Mul, ree_Avx2Div,
+  ree_Avx2Neg, ree_Avx2Abs, ree_Avx2Sqrt
+};
+
+#endif // REE_HAS_X86_KERNELS
+
+const struct ree_batch_kernels_t* ree_GetBatchKernelsForIsa(enum ree_kernel_isa_e isa){
+#ifdef REE_HAS_X86_KERNELS
+  __builtin_cpu_init();
+
+  if (isa == REE_ISA_AVX2 && __builtin_cpu_supports("avx2")){
+    return &avx2Kernels;
+  }
+  if (isa == REE_ISA_SSE2 && __builtin_cpu_supports("sse2")){
+    return &sse2Kernels;
+  }
+#else
+  (void)isa;
+#endif
+
+  return &scalarKernels;
+}
+
+// resolved once, the CPU doesn't change while we're running
+static const struct ree_batch_kernels_t *ree_batchKernels = nullptr;
+static pthread_once_t ree_batchKernelsOnce = PTHREAD_ONCE_INIT;
+
+static void ree_ResolveBatchKernels(void){
+  const struct ree_batch_kernels_t *kernels = ree_GetBatchKernelsForIsa(REE_ISA_AVX2);
+  if (kernels->isa == REE_ISA_SCALAR){
+    kernels = ree_GetBatchKernelsForIsa(REE_ISA_SSE2);
+  }
+  ree_batchKernels = kernels;
+}
+
+const struct ree_batch_kernels_t* ree_GetBatchKernels(void){
+  // pool workers ask for the kernels concurrently, pthread_once publishes the table to all of them
+  pthread_once(&ree_batchKernelsOnce, ree_ResolveBatchKernels);
+  return ree_batchKernels;
+}
@@ -0,0 +1,543 @@
+#include "expressionEngine/compiler.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+#include "expressionEngine/parser/shuntingYard.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// symbol to opcode lookup indexed by enum ree_symbol_e, SYMBOL_NONE has no opcode (OP_COUNT)
+static const enum ree_opcode_e symbolOpcodes[SYMBOL_COUNT] = {
+  [SYMBOL_NONE] = OP_COUNT,
+  [SYMBOL_ADD]  = OP_ADD,  [SYMBOL_SUB] = OP_SUB, [SYMBOL_MUL] = OP_MUL, [SYMBOL_DIV]  = OP_DIV, [SYMBOL_POW] = OP_POW,
+  [SYMBOL_FACT] = OP_FACT, [SYMBOL_NEG] = OP_NEG, [SYMBOL_POS] = OP_POS,
+  [SYMBOL_SIN]  = OP_SIN,  [SYMBOL_COS] = OP_COS, [SYMBOL_TAN] = OP_TAN, [SYMBOL_SQRT] = OP_SQRT,
+  [SYMBOL_ABS]  = OP_ABS,  [SYMBOL_LN]  = OP_LN,  [SYMBOL_LOG] = OP_LOG,
+};
+
+const char* ree_OpcodeToStr(enum ree_opcode_e opcode){
+  switch (opcode){
+    case OP_CONST: return "OP_CONST";
+    case OP_VAR:   return "OP_VAR";
+    case OP_ADD:   return "OP_ADD";
+    case OP_SUB:   return "OP_SUB";
+    case OP_MUL:   return "OP_MUL";
+    case OP_DIV:   return "OP_DIV";
+    case OP_POW:   return "OP_POW";
+    case OP_FACT:  return "OP_FACT";
+    case OP_NEG:   return "OP_NEG";
+    case OP_POS:   return "OP_POS";
+    case OP_SIN:   return "OP_SIN";
+    case OP_COS:   return "OP_COS";
+    case OP_TAN:   return "OP_TAN";
+    case OP_SQRT:  return "OP_SQRT";
+    case OP_ABS:   return "OP_ABS";
+    case OP_LN:    return "OP_LN";
+    case OP_LOG:   return "OP_LOG";
+    case OP_STORE: return "OP_STORE";
+    case OP_LOAD:  return "OP_LOAD";
+    case OP_PARAM: return "OP_PARAM";
+    default:       return "Unknown Opcode";
+  }
+}
+
+int ree_OpcodeSize(enum ree_opcode_e opcode){
+  switch (opcode){
+    case OP_CONST: return 1 + (int)sizeof(float);
+    case OP_VAR:
+    case OP_STORE:
+    case OP_LOAD:
+    case OP_PARAM: return 2;
+    default:       return 1;
+  }
+}
+
+int ree_OpcodeArity(enum ree_opcode_e opcode){
+  switch (opcode){
+    case OP_CONST:
+    case OP_VAR:
+    case OP_STORE:
+    case OP_LOAD:
+    case OP_PARAM:
+      return 0;
+
+    case OP_ADD:
+    case OP_SUB:
+    case OP_MUL:
+    case OP_DIV:
+    case OP_POW:
+      return 2;
+
+    default:
+      return 1;
+  }
+}
+
+// a node of the expression DAG, identical subtrees share one node
+struct ree_dag_node_t {
+  enum ree_opcode_e opcode;  /**< Opcode computing the node */
+  uint8_t slot;              /**< Variable slot (OP_VAR) or parameter index (OP_PARAM) */
+  float value;               /**< Inline constant (OP_CONST only) */
+  int children[2];           /**< Indices of the operand nodes, -1 if unused */
+  int useCount;              /**< Number of parent references */
+  int tempSlot;              /**< Temporary slot the value is stored in once computed, -1 if none */
+};
+
+struct ree_dag_t {
+  struct ree_dag_node_t *nodes; /**< Node storage, at most one node per RPN token */
+  int nodeCount;                /**< Number of nodes in use */
+  int *buckets;                 /**< Open addressing hash table of node indices, -1 if empty */
+  int bucketCount;              /**< Size of the hash table, always a power of two */
+};
+
+// state of the bytecode writer while walking the DAG
+struct ree_emitter_t {
+  uint8_t *code;             /**< Output buffer */
+  int codeSize;              /**< Bytes written so far */
+  int opCount;               /**< Instructions written so far */
+  int stackDepth;            /**< Current evaluation stack depth */
+  int maxStackDepth;         /**< Maximum evaluation stack depth reached */
+  int tempCount;             /**< Temporary slots handed out so far */
+};
+
+static uint32_t ree_HashDagNode(const struct ree_dag_node_t *node){
+  // FNV-1a over the fields that identify a node
+  uint32_t hash = 2166136261u;
+  uint32_t valueBits;
+  memcpy(&valueBits, &node->value, sizeof(valueBits));
+  const uint32_t fields[] = {(uint32_t)node->opcode, node->slot, valueBits, (uint32_t)node->children[0], (uint32_t)node->children[1]};
+
+  for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i){
+    for (int byte = 0; byte < 4; ++byte){
+      hash ^= (fields[i] >> (byte * 8)) & 0xFFu;
+      hash *= 16777619u;
+    }
+  }
+  return hash;
+}
+
+static bool ree_DagNodesEqual(const struct ree_dag_node_t *a, const struct ree_dag_node_t *b){
+  return a->opcode == b->opcode && a->slot == b->slot &&
+         memcmp(&a->value, &b->value, sizeof(float)) == 0 &&
+         a->children[0] == b->children[0] && a->children[1] == b->children[1];
+}
+
+// returns the index of an existing identical node, or inserts the candidate as a new one
+static int ree_InternDagNode(struct ree_dag_t *dag, const struct ree_dag_node_t *candidate){
+  uint32_t mask = (uint32_t)dag->bucketCount - 1;
+  uint32_t bucket = ree_HashDagNode(candidate) & mask;
+
+  while (dag->buckets[bucket] != -1){
+    if (ree_DagNodesEqual(&dag->nodes[dag->buckets[bucket]], candidate)){
+      return dag->buckets[bucket];
+    }
+    bucket = (bucket + 1) & mask;
+  }
+
+  int index = dag->nodeCount++;
+  dag->nodes[index] = *candidate;
+  dag->buckets[bucket] = index;
+
+  for (int c = 0; c < ree_OpcodeArity(candidate->opcode); ++c){
+    dag->nodes[candidate->children[c]].useCount++;
+  }
+  return index;
+}
+
+static void ree_EmitByte(struct ree_emitter_t *emitter, uint8_t byte){
+  emitter->code[emitter->codeSize++] = byte;
+}
+
+static void ree_AdjustStackDepth(struct ree_emitter_t *emitter, int delta){
+  emitter->stackDepth += delta;
+  if (emitter->stackDepth > emitter->maxStackDepth) emitter->maxStackDepth = emitter->stackDepth;
+}
+
+// emits the subtree rooted at index, computing every shared subtree only once
+static void ree_EmitDagNode(struct ree_dag_t *dag, int index, struct ree_emitter_t *emitter){
+  struct ree_dag_node_t *node = &dag->nodes[index];
+
+  // already computed, reuse the stored value
+  if (node->tempSlot != -1){
+    ree_EmitByte(emitter, OP_LOAD);
+    ree_EmitByte(emitter, (uint8_t)node->tempSlot);
+    emitter->opCount++;
+    ree_AdjustStackDepth(emitter, 1);
+    return;
+  }
+
+  const int arity = ree_OpcodeArity(node->opcode);
+  for (int c = 0; c < arity; ++c){
+    ree_EmitDagNode(dag, node->children[c], emitter);
+  }
+
+  ree_EmitByte(emitter, (uint8_t)node->opcode);
+  if (node->opcode == OP_CONST){
+    memcpy(&emitter->code[emitter->codeSize], &node->value, sizeof(float));
+    emitter->codeSize += (int)sizeof(float);
+  }
+  else if (node->opcode == OP_VAR || node->opcode == OP_PARAM){
+    ree_EmitByte(emitter, node->slot);
+  }
+  emitter->opCount++;
+  ree_AdjustStackDepth(emitter, 1 - arity);
+
+  // shared non-leaf subtree, keep a copy of the result for the other users
+  if (node->useCount > 1 && arity > 0 && emitter->tempCount < REE_MAX_TEMP_SLOTS){
+    node->tempSlot = emitter->tempCount++;
+    ree_EmitByte(emitter, OP_STORE);
+    ree_EmitByte(emitter, (uint8_t)node->tempSlot);
+    emitter->opCount++;
+  }
+}
+
+enum reh_error_code_e ree_MeasureRpnStack(const struct ree_output_token_t *rpn, int rpnCount, int *maxStackDepth){
+  if (rpn == nullptr || maxStackDepth == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "RPN or maxStackDepth provided to ree_MeasureRpnStack is NULL.");
+  }
+  if (rpnCount <= 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "rpnCount passed to ree_MeasureRpnStack is less than or equal to 0.");
+  }
+
+  int depth = 0;
+  int deepest = 0;
+  for (int i = 0; i < rpnCount; ++i){
+    int arity = 0;
+    if (rpn[i].type == OUTPUT_OPERATOR || rpn[i].type == OUTPUT_FUNCTION){
+      if (rpn[i].symbol >= SYMBOL_COUNT || symbolOpcodes[rpn[i].symbol] == OP_COUNT){
+        SET_ERROR_RETURN(ERR_INVALID_OPERATOR, "Provided RPN token (%s) has no matching opcode.", ree_SymbolToStr(rpn[i].symbol));
+      }
+      arity = ree_OpcodeArity(symbolOpcodes[rpn[i].symbol]);
+    }
+    else if (rpn[i].type != OUTPUT_NUMBER && rpn[i].type != OUTPUT_VARIABLE){
+      SET_ERROR_RETURN(ERR_INPUT_TOKEN_INVALID, "Unknown RPN token type: %d", rpn[i].type);
+    }
+
+    if (depth < arity){
+      SET_ERROR_RETURN(ERR_INVALID_STACK_STATE, "Not enough operands for RPN token (%s).", ree_SymbolToStr(rpn[i].symbol));
+    }
+    depth += 1 - arity;
+    if (depth > deepest) deepest = depth;
+  }
+
+  // result SHOULD be the only thing left on stack
+  if (depth != 1){
+    SET_ERROR_RETURN(ERR_INVALID_STACK_STATE, "Expression leaves %d values on the stack instead of 1.", depth);
+  }
+  else if (deepest > REE_MAX_STACK_DEPTH){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Expression is nested too deeply, it needs %d stack entries (at most %d).", deepest, REE_MAX_STACK_DEPTH);
+  }
+
+  *maxStackDepth = deepest;
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e ree_CompileRpn(struct rma_arena_t *scratch, struct rma_arena_t *arena, struct ree_output_token_t *rpn, int rpnCount, const char **variableNames, int variableCount, struct ree_parameter_table_t *parameters, struct ree_program_t *program){
+  if (scratch == nullptr || arena == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Arena provided to ree_CompileRpn is NULL.");
+  }
+  else if (rpn == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "RPN provided to ree_CompileRpn is NULL.");
+  }
+  else if (variableNames == nullptr && variableCount != 0){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Variable names provided to ree_CompileRpn are NULL.");
+  }
+  else if (program == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Program provided to ree_CompileRpn is NULL.");
+  }
+
+  if (rpnCount <= 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "rpnCount passed to ree_CompileRpn is less than or equal to 0.");
+  }
+  if (variableCount > REE_MAX_VARIABLE_SLOTS){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Too many variables passed to ree_CompileRpn (%d > %d).", variableCount, REE_MAX_VARIABLE_SLOTS);
+  }
+
+  // the only operand check, the bytecode is emitted in the same order with shared subtrees replaced by a single load,
+  // so it never needs a deeper stack than the RPN and the interpreters can run it unchecked
+  int rpnStackDepth;
+  CHECK_ERROR_CTX(ree_MeasureRpnStack(rpn, rpnCount, &rpnStackDepth), "Failed to validate the RPN.");
+
+  struct ree_dag_t dag;
+  dag.nodeCount = 0;
+  dag.bucketCount = 16;
+  while (dag.bucketCount < rpnCount * 2) dag.bucketCount *= 2;
+
+  dag.nodes = rma_Alloc(scratch, (size_t)rpnCount * sizeof(struct ree_dag_node_t));
+  dag.buckets = rma_Alloc(scratch, (size_t)dag.bucketCount * sizeof(int));
+  if (dag.nodes == nullptr || dag.buckets == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate memory for the expression DAG in ree_CompileRpn.");
+  }
+  memset(dag.buckets, -1, (size_t)dag.bucketCount * sizeof(int));
+
+  int stack[REE_MAX_STACK_DEPTH];
+  int stackIndex = 0;
+  uint64_t parameterMask = 0;
+
+  // build the DAG, hash-consing every node so identical subtrees collapse into one
+  for (int i = 0; i < rpnCount; ++i){
+    struct ree_dag_node_t candidate = {
+      .opcode = OP_CONST,
+      .slot = 0,
+      .value = 0.0f,
+      .children = {-1, -1},
+      .useCount = 0,
+      .tempSlot = -1
+    };
+
+    if (rpn[i].type == OUTPUT_VARIABLE){
+      // identifier, resolve it to a variable slot
+      const char *name = ree_SymbolToStr(rpn[i].symbol);
+      int slot = -1;
+      for (int j = 0; j < variableCount; ++j){
+        if (strcmp(name, variableNames[j]) == 0){
+          slot = j;
+          break;
+        }
+      }
+
+      if (slot != -1){
+        candidate.opcode = OP_VAR;
+        candidate.slot = (uint8_t)slot;
+      }
+      else if (parameters != nullptr){
+        // not a variable, so it's a global parameter read by index at evaluation time
+        int index;
+        CHECK_ERROR_CTX(ree_DeclareParameter(parameters, name, &index), "Failed to declare parameter %s.", name);
+        candidate.opcode = OP_PARAM;
+        candidate.slot = (uint8_t)index;
+        parameterMask |= UINT64_C(1) << index;
+      }
+      else {
+        SET_ERROR_RETURN(ERR_UNKNOWN_IDENTIFIER, "No variable slot found for identifier %s in ree_CompileRpn.", name);
+      }
+    }
+    else if (rpn[i].type == OUTPUT_NUMBER){
+      // plain number, inline the constant
+      candidate.value = rpn[i].value;
+    }
+    else if (rpn[i].type == OUTPUT_OPERATOR || rpn[i].type == OUTPUT_FUNCTION){
+      if (rpn[i].symbol >= SYMBOL_COUNT || symbolOpcodes[rpn[i].symbol] == OP_COUNT){
+        SET_ERROR_RETURN(ERR_INVALID_OPERATOR, "Provided RPN token (%s) has no matching opcode.", ree_SymbolToStr(rpn[i].symbol));
+      }
+
+      candidate.opcode = symbolOpcodes[rpn[i].symbol];
+    }
+    else {
+      SET_ERROR_RETURN(ERR_INPUT_TOKEN_INVALID, "Unknown RPN token type: %d", rpn[i].type);
+    }
+
+    // pop the operands
+    const int arity = ree_OpcodeArity(candidate.opcode);
+    for (int c = arity - 1; c >= 0; --c){
+      candidate.children[c] = stack[--stackIndex];
+    }
+
+    stack[stackIndex++] = ree_InternDagNode(&dag, &candidate);
+  }
+
+  // every token is at most an inline constant, every DAG node adds at most one store
+  struct ree_emitter_t emitter = {0};
+  const size_t bytecodeCapacity = (size_t)rpnCount * (size_t)ree_OpcodeSize(OP_CONST) + (size_t)dag.nodeCount * (size_t)ree_OpcodeSize(OP_STORE);
+  emitter.code = rma_Alloc(arena, bytecodeCapacity);
+  if (emitter.code == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate memory for bytecode in ree_CompileRpn.");
+  }
+
+  ree_EmitDagNode(&dag, stack[0], &emitter);
+  if (emitter.maxStackDepth > rpnStackDepth){
+    SET_ERROR_RETURN(ERR_INVALID_STACK_STATE, "Bytecode needs a deeper stack (%d) than its RPN (%d).", emitter.maxStackDepth, rpnStackDepth);
+  }
+
+  // give the unused tail back to the arena (in place, the buffer is its latest allocation)
+  uint8_t *shrunk = rma_Realloc(arena, emitter.code, bytecodeCapacity, (size_t)emitter.codeSize);
+  if (shrunk != nullptr){
+    emitter.code = shrunk;
+  }
+
+  program->code = emitter.code;
+  program->codeSize = emitter.codeSize;
+  program->opCount = emitter.opCount;
+  program->maxStackDepth = emitter.maxStackDepth;
+  program->tempCount = emitter.tempCount;
+  program->parameters = (parameterMask != 0) ? parameters->values : nullptr;
+  program->parameterMask = parameterMask;
+  program->jit = nullptr;
+
+  return ERR_SUCCESS;
+}
+
+/*
+  ##########
+  # FUSING #
+  ##########
+
+  The bytecode of every program is read back into one DAG: instructions become hash-consed nodes like RPN tokens do,
+  OP_STORE / OP_LOAD only name a node that already exists. Nodes of one program that another program computes as well
+  collapse into one, the roots are then emitted one after the other and the emitter stores what more than one of them needs.
+*/
+
+// adds the instructions of a compiled program to the DAG, returns its root
+static enum reh_error_code_e ree_AddProgramToDag(struct ree_dag_t *dag, const struct ree_program_t *program, int *root){
+  int stack[REE_MAX_STACK_DEPTH];
+  int stackIndex = 0;
+  int temps[REE_MAX_TEMP_SLOTS];
+
+  for (int pc = 0; pc < program->codeSize; pc += ree_OpcodeSize(program->code[pc])){
+    const enum ree_opcode_e opcode = program->code[pc];
+    if (opcode >= OP_COUNT){
+      SET_ERROR_RETURN(ERR_INVALID_OPERATOR, "Provided opcode (%u) is unknown.", (unsigned)opcode);
+    }
+
+    if (opcode == OP_STORE){
+      temps[program->code[pc + 1]] = stack[stackIndex - 1];
+      continue;
+    }
+    else if (opcode == OP_LOAD){
+      stack[stackIndex++] = temps[program->code[pc + 1]];
+      continue;
+    }
+
+    struct ree_dag_node_t candidate = {
+      .opcode = opcode,
+      .slot = 0,
+      .value = 0.0f,
+      .children = {-1, -1},
+      .useCount = 0,
+      .tempSlot = -1
+    };
+    if (opcode == OP_CONST){
+      memcpy(&candidate.value, &program->code[pc + 1], sizeof(float));
+    }
+    else if (opcode == OP_VAR || opcode == OP_PARAM){
+      candidate.slot = program->code[pc + 1];
+    }
+
+    // the compiler guarantees every instruction finds its operands
+    const int arity = ree_OpcodeArity(opcode);
+    for (int c = arity - 1; c >= 0; --c){
+      candidate.children[c] = stack[--stackIndex];
+    }
+
+    stack[stackIndex++] = ree_InternDagNode(dag, &candidate);
+  }
+
+  *root = stack[0];
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e ree_FusePrograms(struct rma_arena_t *scratch, struct rma_arena_t *arena, const struct ree_program_t *const *programs, int programCount, struct ree_fused_program_t *fused){
+  if (scratch == nullptr || arena == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Arena provided to ree_FusePrograms is NULL.");
+  }
+  else if (programs == nullptr || fused == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Programs or fused program provided to ree_FusePrograms are NULL.");
+  }
+  if (programCount <= 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "programCount passed to ree_FusePrograms is less than or equal to 0.");
+  }
+
+  // every instruction becomes at most one node
+  int instructionCount = 0;
+  const float *parameters = nullptr;
+  uint64_t parameterMask = 0;
+  for (int p = 0; p < programCount; ++p){
+    if (programs[p] == nullptr || programs[p]->code == nullptr){
+      SET_ERROR_RETURN(ERR_INVALID_POINTER, "Program %d provided to ree_FusePrograms is NULL.", p);
+    }
+    if (programs[p]->parameters != nullptr){
+      if (parameters != nullptr && parameters != programs[p]->parameters){
+        SET_ERROR_RETURN(ERR_INVALID_INPUT, "Program %d provided to ree_FusePrograms reads another parameter table.", p);
+      }
+      parameters = programs[p]->parameters;
+    }
+    parameterMask |= programs[p]->parameterMask;
+    instructionCount += programs[p]->opCount;
+  }
+
+  struct ree_dag_t dag;
+  dag.nodeCount = 0;
+  dag.bucketCount = 16;
+  while (dag.bucketCount < instructionCount * 2) dag.bucketCount *= 2;
+
+  dag.nodes = rma_Alloc(scratch, (size_t)instructionCount * sizeof(struct ree_dag_node_t));
+  dag.buckets = rma_Alloc(scratch, (size_t)dag.bucketCount * sizeof(int));
+  int *roots = rma_Alloc(scratch, (size_t)programCount * sizeof(int));
+  if (dag.nodes == nullptr || dag.buckets == nullptr || roots == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate memory for the expression DAG in ree_FusePrograms.");
+  }
+  memset(dag.buckets, -1, (size_t)dag.bucketCount * sizeof(int));
+
+  for (int p = 0; p < programCount; ++p){
+    CHECK_ERROR_CTX(ree_AddProgramToDag(&dag, programs[p], &roots[p]), "Failed to read program %d back into a DAG.", p);
+    // being an output is a use too, a root another program needs as well is stored for it
+    dag.nodes[roots[p]].useCount++;
+  }
+
+  // every shared node has to get a temporary slot, otherwise it would be emitted again for every user
+  int sharedCount = 0;
+  int edgeCount = programCount;
+  for (int n = 0; n < dag.nodeCount; ++n){
+    const int arity = ree_OpcodeArity(dag.nodes[n].opcode);
+    sharedCount += (dag.nodes[n].useCount > 1 && arity > 0);
+    edgeCount += arity;
+  }
+  if (sharedCount > REE_MAX_TEMP_SLOTS){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Programs share %d subexpressions, a program holds at most %d temporary slots.", sharedCount, REE_MAX_TEMP_SLOTS);
+  }
+
+  // every node is emitted once with an inline constant at most and a store, every reference is at most a load
+  struct ree_emitter_t emitter = {0};
+  const size_t bytecodeCapacity = (size_t)dag.nodeCount * (size_t)(ree_OpcodeSize(OP_CONST) + ree_OpcodeSize(OP_STORE)) + (size_t)edgeCount * (size_t)ree_OpcodeSize(OP_LOAD);
+  emitter.code = rma_Alloc(arena, bytecodeCapacity);
+  if (emitter.code == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate memory for bytecode in ree_FusePrograms.");
+  }
+
+  // the result of every program stays on the stack below the ones after it
+  for (int p = 0; p < programCount; ++p){
+    ree_EmitDagNode(&dag, roots[p], &emitter);
+  }
+  if (emitter.maxStackDepth > REE_MAX_STACK_DEPTH){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Fused program needs %d stack entries (at most %d).", emitter.maxStackDepth, REE_MAX_STACK_DEPTH);
+  }
+
+  uint8_t *shrunk = rma_Realloc(arena, emitter.code, bytecodeCapacity, (size_t)emitter.codeSize);
+  if (shrunk != nullptr){
+    emitter.code = shrunk;
+  }
+
+  fused->program = (struct ree_program_t){
+    .code = emitter.code,
+    .codeSize = emitter.codeSize,
+    .opCount = emitter.opCount,
+    .maxStackDepth = emitter.maxStackDepth,
+    .tempCount = emitter.tempCount,
+    .parameters = parameters,
+    .parameterMask = parameterMask,
+    .jit = nullptr,
+  };
+  fused->outputCount = programCount;
+
+  return ERR_SUCCESS;
+}
+
+void ree_PrintProgram(const struct ree_program_t *program){
+  if (program == nullptr || program->code == nullptr) return;
+
+  for (int pc = 0; pc < program->codeSize; pc += ree_OpcodeSize(program->code[pc])){
+    enum ree_opcode_e opcode = program->code[pc];
+
+    if (opcode == OP_CONST){
+      float value;
+      memcpy(&value, &program->code[pc + 1], sizeof(float));
+      printf("%4d: %s %g\n", pc, ree_OpcodeToStr(opcode), (double)value);
+    }
+    else if (opcode == OP_VAR || opcode == OP_STORE || opcode == OP_LOAD || opcode == OP_PARAM){
+      printf("%4d: %s %u\n", pc, ree_OpcodeToStr(opcode), program->code[pc + 1]);
+    }
+    else {
+      printf("%4d: %s\n", pc, ree_OpcodeToStr(opcode));
+    }
+  }
+}
@@ -0,0 +1,272 @@
+#include "expressionEngine/differentiator.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+#include "expressionEngine/parser/shuntingYard.h"
+#include "expressionEngine/tokens.h"
+
+// derivative of a subtree that doesn't depend on the variable, kept implicit so no 0 * ... terms are built
+#define REE_ZERO_DERIVATIVE -1
+
+// most nodes a single rule adds to the tree (the exponent-dependent case of the power rule)
+#define REE_MAX_RULE_NODES 8
+
+// a node of the expression tree, children always have a lower index than their parent
+// the derivative nodes are appended after the nodes of the source RPN and share its subtrees
+struct ree_diff_node_t {
+  struct ree_output_token_t token; /**< Token of the node */
+  int children[2];                 /**< Indices of the operands, -1 if unused */
+  int rpnSize;                     /**< Tokens the subtree expands to in RPN, saturated at REE_MAX_DERIVATIVE_RPN + 1 */
+};
+
+struct ree_diff_tree_t {
+  struct ree_diff_node_t *nodes;   /**< Node storage, sized for the worst case up front */
+  int nodeCount;                   /**< Number of nodes in use */
+};
+
+static int ree_DiffPush(struct ree_diff_tree_t *tree, struct ree_output_token_t token, int left, int right){
+  struct ree_diff_node_t *node = &tree->nodes[tree->nodeCount];
+  node->token = token;
+  node->children[0] = left;
+  node->children[1] = right;
+  node->rpnSize = 1;
+
+  for (int c = 0; c < 2; ++c){
+    if (node->children[c] >= 0){
+      node->rpnSize += tree->nodes[node->children[c]].rpnSize;
+    }
+  }
+  if (node->rpnSize > REE_MAX_DERIVATIVE_RPN){
+    node->rpnSize = REE_MAX_DERIVATIVE_RPN + 1;
+  }
+
+  return tree->nodeCount++;
+}
+
+static int ree_DiffNumber(struct ree_diff_tree_t *tree, float value){
+  return ree_DiffPush(tree, (struct ree_output_token_t){.type = OUTPUT_NUMBER, .arity = 0, .symbol = SYMBOL_NONE, .value = value}, -1, -1);
+}
+
+static int ree_DiffBinary(struct ree_diff_tree_t *tree, enum ree_symbol_e symbol, int left, int right){
+  return ree_DiffPush(tree, (struct ree_output_token_t){.type = OUTPUT_OPERATOR, .arity = 2, .symbol = (uint16_t)symbol}, left, right);
+}
+
+// unary operators are operator tokens, everything else is a built-in function, same as the shunting yard emits them
+static int ree_DiffUnary(struct ree_diff_tree_t *tree, enum ree_symbol_e symbol, int operand){
+  uint8_t type = (symbol == SYMBOL_NEG || symbol == SYMBOL_POS || symbol == SYMBOL_FACT) ? OUTPUT_OPERATOR : OUTPUT_FUNCTION;
+  return ree_DiffPush(tree, (struct ree_output_token_t){.type = type, .arity = 1, .symbol = (uint16_t)symbol}, operand, -1);
+}
+
+// a + b where either side may be a zero derivative
+static int ree_DiffSum(struct ree_diff_tree_t *tree, int a, int b){
+  if (a == REE_ZERO_DERIVATIVE) return b;
+  if (b == REE_ZERO_DERIVATIVE) return a;
+  return ree_DiffBinary(tree, SYMBOL_ADD, a, b);
+}
+
+// a - b where either side may be a zero derivative
+static int ree_DiffDifference(struct ree_diff_tree_t *tree, int a, int b){
+  if (b == REE_ZERO_DERIVATIVE) return a;
+  if (a == REE_ZERO_DERIVATIVE) return ree_DiffUnary(tree, SYMBOL_NEG, b);
+  return ree_DiffBinary(tree, SYMBOL_SUB, a, b);
+}
+
+// factor * derivative, zero if the derivative is
+static int ree_DiffScale(struct ree_diff_tree_t *tree, int factor, int derivative){
+  if (derivative == REE_ZERO_DERIVATIVE) return REE_ZERO_DERIVATIVE;
+  return ree_DiffBinary(tree, SYMBOL_MUL, factor, derivative);
+}
+
+/*
+  Derivative of the node at index from the derivatives of its operands.
+  The rules keep the domain of the operation they differentiate where they can (tan' is written as 1 + tan^2 instead of 1 / cos^2,
+  the quotient rule divides by b instead of b^2), so the derivative fails in the same places as the function.
+*/
+static enum reh_error_code_e ree_DiffNode(struct ree_diff_tree_t *tree, int index, const int *derivatives, uint16_t variable, int *result){
+  const struct ree_diff_node_t node = tree->nodes[index];
+  const int a = node.children[0];
+  const int b = node.children[1];
+  const int da = (a >= 0) ? derivatives[a] : REE_ZERO_DERIVATIVE;
+  const int db = (b >= 0) ? derivatives[b] : REE_ZERO_DERIVATIVE;
+
+  if (node.token.type == OUTPUT_NUMBER){
+    *result = REE_ZERO_DERIVATIVE;
+    return ERR_SUCCESS;
+  }
+  else if (node.token.type == OUTPUT_VARIABLE){
+    *result = (node.token.symbol == variable) ? ree_DiffNumber(tree, 1.0f) : REE_ZERO_DERIVATIVE;
+    return ERR_SUCCESS;
+  }
+
+  // nothing below depends on the variable
+  if (da == REE_ZERO_DERIVATIVE && db == REE_ZERO_DERIVATIVE){
+    *result = REE_ZERO_DERIVATIVE;
+    return ERR_SUCCESS;
+  }
+
+  switch ((enum ree_symbol_e)node.token.symbol){
+    /*
+      #############
+      # OPERATORS #
+      #############
+    */
+    // (a + b)' = a' + b', (a - b)' = a' - b'
+    case SYMBOL_ADD: *result = ree_DiffSum(tree, da, db); break;
+    case SYMBOL_SUB: *result = ree_DiffDifference(tree, da, db); break;
+    // (a * b)' = a' * b + a * b'
+    case SYMBOL_MUL: *result = ree_DiffSum(tree, ree_DiffScale(tree, b, da), ree_DiffScale(tree, a, db)); break;
+    // (a / b)' = (a' - a / b * b') / b
+    case SYMBOL_DIV: {
+      int quotient = ree_DiffBinary(tree, SYMBOL_DIV, a, b);
+      *result = ree_DiffBinary(tree, SYMBOL_DIV, ree_DiffDifference(tree, da, ree_DiffScale(tree, quotient, db)), b);
+      break;
+    }
+    case SYMBOL_POW: {
+      if (db == REE_ZERO_DERIVATIVE){
+        // (a ^ b)' = b * a ^ (b - 1) * a' for b not depending on the variable
+        int exponent = ree_DiffBinary(tree, SYMBOL_SUB, b, ree_DiffNumber(tree, 1.0f));
+        int slope = ree_DiffBinary(tree, SYMBOL_MUL, b, ree_DiffBinary(tree, SYMBOL_POW, a, exponent));
+        *result = ree_DiffScale(tree, slope, da);
+      }
+      else {
+        // (a ^ b)' = a ^ b * (b' * ln(a) + b * a' / a)
+        int power = ree_DiffBinary(tree, SYMBOL_POW, a, b);
+        int exponentTerm = ree_DiffScale(tree, ree_DiffUnary(tree, SYMBOL_LN, a), db);
+        int baseTerm = (da == REE_ZERO_DERIVATIVE) ? REE_ZERO_DERIVATIVE : ree_DiffBinary(tree, SYMBOL_MUL, b, ree_DiffBinary(tree, SYMBOL_DIV, da, a));
+        *result = ree_DiffBinary(tree, SYMBOL_MUL, power, ree_DiffSum(tree, exponentTerm, baseTerm));
+      }
+      break;
+    }
+    case SYMBOL_FACT: {
+      SET_ERROR_RETURN(ERR_UNSUPPORTED, "Factorial of an expression depending on %s has no symbolic derivative.", ree_SymbolToStr(variable));
+    }
+    case SYMBOL_NEG: *result = ree_DiffUnary(tree, SYMBOL_NEG, da); break;
+    case SYMBOL_POS: *result = da; break;
+
+    /*
+      #############
+      # FUNCTIONS #
+      #############
+    */
+    // sin(a)' = cos(a) * a', cos(a)' = -(sin(a) * a')
+    case SYMBOL_SIN: *result = ree_DiffScale(tree, ree_DiffUnary(tree, SYMBOL_COS, a), da); break;
+    case SYMBOL_COS: *result = ree_DiffUnary(tree, SYMBOL_NEG, ree_DiffScale(tree, ree_DiffUnary(tree, SYMBOL_SIN, a), da)); break;
+    // tan(a)' = (1 + tan(a) * tan(a)) * a'
+    case SYMBOL_TAN: {
+      int tangent = ree_DiffUnary(tree, SYMBOL_TAN, a);
+      int slope = ree_DiffBinary(tree, SYMBOL_ADD, ree_DiffNumber(tree, 1.0f), ree_DiffBinary(tree, SYMBOL_MUL, tangent, tangent));
+      *result = ree_DiffScale(tree, slope, da);
+      break;
+    }
+    // sqrt(a)' = a' / (2 * sqrt(a))
+    case SYMBOL_SQRT: {
+      int denominator = ree_DiffBinary(tree, SYMBOL_MUL, ree_DiffNumber(tree, 2.0f), ree_DiffUnary(tree, SYMBOL_SQRT, a));
+      *result = ree_DiffBinary(tree, SYMBOL_DIV, da, denominator);
+      break;
+    }
+    // |a|' = a / |a| * a', undefined at the kink
+    case SYMBOL_ABS: {
+      int sign = ree_DiffBinary(tree, SYMBOL_DIV, a, ree_DiffUnary(tree, SYMBOL_ABS, a));
+      *result = ree_DiffScale(tree, sign, da);
+      break;
+    }
+    // ln(a)' = a' / a, log(a)' = a' / (a * ln(10)), a is written as sqrt(a) * sqrt(a) so the derivative stays undefined for a < 0 like ln
+    case SYMBOL_LN: {
+      int root = ree_DiffUnary(tree, SYMBOL_SQRT, a);
+      *result = ree_DiffBinary(tree, SYMBOL_DIV, da, ree_DiffBinary(tree, SYMBOL_MUL, root, root));
+      break;
+    }
+    case SYMBOL_LOG: {
+      // ln(10) isn't exact in float, the optimizer keeps it as an operation so the double tiers stay exact
+      int root = ree_DiffUnary(tree, SYMBOL_SQRT, a);
+      int scale = ree_DiffUnary(tree, SYMBOL_LN, ree_DiffNumber(tree, 10.0f));
+      int denominator = ree_DiffBinary(tree, SYMBOL_MUL, ree_DiffBinary(tree, SYMBOL_MUL, root, root), scale);
+      *result = ree_DiffBinary(tree, SYMBOL_DIV, da, denominator);
+      break;
+    }
+
+    default:
+      SET_ERROR_RETURN(ERR_INVALID_OPERATOR, "RPN token (%s) has no derivative rule.", ree_SymbolToStr(node.token.symbol));
+  }
+
+  return ERR_SUCCESS;
+}
+
+// writes the subtree rooted at index into RPN (post-order), shared subtrees are written once per use
+static void ree_DiffEmit(const struct ree_diff_tree_t *tree, int index, struct ree_output_token_t *out, int *outCount){
+  const struct ree_diff_node_t *node = &tree->nodes[index];
+
+  for (int c = 0; c < 2; ++c){
+    if (node->children[c] >= 0){
+      ree_DiffEmit(tree, node->children[c], out, outCount);
+    }
+  }
+  out[(*outCount)++] = node->token;
+}
+
+enum reh_error_code_e ree_DifferentiateRpn(struct rma_arena_t *scratch, struct rma_arena_t *arena, const struct ree_output_token_t *rpn, int rpnCount, uint16_t variable, struct ree_output_token_t **derivative, int *derivativeCount){
+  if (scratch == nullptr || arena == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Arena passed to ree_DifferentiateRpn is NULL.");
+  }
+  else if (rpn == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "RPN passed to ree_DifferentiateRpn is NULL.");
+  }
+  else if (derivative == nullptr || derivativeCount == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Output pointers passed to ree_DifferentiateRpn are NULL.");
+  }
+
+  if (rpnCount <= 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "rpnCount passed to ree_DifferentiateRpn is less than or equal to 0.");
+  }
+
+  // every source token adds one node and at most REE_MAX_RULE_NODES derivative nodes
+  const size_t nodeCapacity = (size_t)rpnCount * (1 + REE_MAX_RULE_NODES) + 1;
+  struct ree_diff_tree_t tree;
+  tree.nodes = rma_Alloc(scratch, nodeCapacity * sizeof(struct ree_diff_node_t));
+  tree.nodeCount = 0;
+  int *stack = rma_Alloc(scratch, (size_t)rpnCount * sizeof(int));
+  int *derivatives = rma_Alloc(scratch, nodeCapacity * sizeof(int));
+  int stackIndex = 0;
+  if (tree.nodes == nullptr || stack == nullptr || derivatives == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the expression tree in ree_DifferentiateRpn.");
+  }
+
+  // rebuild the tree bottom-up, differentiating every node as soon as its operands are done
+  for (int i = 0; i < rpnCount; ++i){
+    int arity = (rpn[i].type == OUTPUT_NUMBER || rpn[i].type == OUTPUT_VARIABLE) ? 0 : rpn[i].arity;
+
+    if (arity < 0 || arity > 2 || stackIndex < arity){
+      SET_ERROR_RETURN(ERR_INVALID_STACK_STATE, "Not enough operands for RPN token (%s) in ree_DifferentiateRpn.", ree_SymbolToStr(rpn[i].symbol));
+    }
+
+    int children[2] = {-1, -1};
+    for (int c = arity - 1; c >= 0; --c){
+      children[c] = stack[--stackIndex];
+    }
+
+    int index = ree_DiffPush(&tree, rpn[i], children[0], children[1]);
+    CHECK_ERROR_CTX(ree_DiffNode(&tree, index, derivatives, variable, &derivatives[index]), "Failed to differentiate RPN token (%s).", ree_SymbolToStr(rpn[i].symbol));
+    stack[stackIndex++] = index;
+  }
+
+  if (stackIndex != 1){
+    SET_ERROR_RETURN(ERR_INVALID_STACK_STATE, "RPN passed to ree_DifferentiateRpn leaves %d values on the stack instead of 1.", stackIndex);
+  }
+
+  int root = derivatives[stack[0]];
+  if (root == REE_ZERO_DERIVATIVE){
+    root = ree_DiffNumber(&tree, 0.0f);
+  }
+  if (tree.nodes[root].rpnSize > REE_MAX_DERIVATIVE_RPN){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Derivative expands to more than %d RPN tokens.", REE_MAX_DERIVATIVE_RPN);
+  }
+
+  *derivative = rma_Alloc(arena, (size_t)tree.nodes[root].rpnSize * sizeof(struct ree_output_token_t));
+  if (*derivative == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate memory for the derivative RPN.");
+  }
+
+  *derivativeCount = 0;
+  ree_DiffEmit(&tree, root, *derivative, derivativeCount);
+
+  return ERR_SUCCESS;
+}
@@ -0,0 +1,379 @@
+#include "expressionEngine/evaluator.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+#include "expressionEngine/compiler.h"
+#include "math/dual.h"
+#include "math/utility.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Euler-Mascheroni constant, digamma(1) = -gamma
+#define REE_EULER_GAMMA 0.5772156649f
+
+// the compiler guarantees every instruction finds its operands, pops aren't checked
+#define POP_2_DUALS()                   \
+    b = stack[--stackIndex];            \
+    a = stack[--stackIndex];
+
+#define POP_1_DUAL()                    \
+    a = stack[--stackIndex];
+
+#define DOMAIN_FAILURE(code)            \
+    *status = (uint8_t)(code);          \
+    *result = (struct rm_dual_t){NAN, NAN}; \
+    return ERR_SUCCESS;
+
+/*
+  Factorial only exists on the non-negative integers, the derivative is the one of its continuation gamma(x + 1):
+  d/dx x! = x! * digamma(x + 1) = n! * (H(n) - gamma) at x = n
+*/
+static float ree_FactorialSlope(int n, float factorial){
+  float harmonic = 0.0f;
+  for (int i = 1; i <= n; ++i) harmonic += 1.0f / (float)i;
+  return factorial * (harmonic - REE_EULER_GAMMA);
+}
+
+static enum reh_error_code_e ree_RunProgramDual(const struct ree_program_t *program, const struct rm_dual_t *variables, struct rm_dual_t *result, uint8_t *status){
+  struct rm_dual_t stack[REE_MAX_STACK_DEPTH];
+  size_t stackIndex = 0;
+  struct rm_dual_t temps[REE_MAX_TEMP_SLOTS];
+  struct rm_dual_t a, b;
+
+  const uint8_t *code = program->code;
+  const uint8_t *end = program->code + program->codeSize;
+
+  while (code < end){
+    switch ((enum ree_opcode_e)*code++){
+      case OP_CONST: {
+        float value;
+        memcpy(&value, code, sizeof(float));
+        code += sizeof(float);
+        stack[stackIndex++] = rm_DualConst(value);
+        break;
+      }
+      case OP_VAR: {
+        if (variables == nullptr){
+          SET_ERROR_RETURN(ERR_INVALID_POINTER, "Program references a variable but no variables were provided to ree_EvaluateProgramDual.");
+        }
+        stack[stackIndex++] = variables[*code++];
+        break;
+      }
+      case OP_STORE: {
+        temps[*code++] = stack[stackIndex - 1];
+        break;
+      }
+      case OP_LOAD: {
+        stack[stackIndex++] = temps[*code++];
+        break;
+      }
+      case OP_PARAM: {
+        // parameters don't depend on the seeded variables
+        stack[stackIndex++] = rm_DualConst(program->parameters[*code++]);
+        break;
+      }
+
+      /*
+        #############
+        # OPERATORS #
+        #############
+      */
+      case OP_ADD: POP_2_DUALS(); stack[stackIndex++] = rm_DualAdd(a, b); break;
+      case OP_SUB: POP_2_DUALS(); stack[stackIndex++] = rm_DualSub(a, b); break;
+      case OP_MUL: POP_2_DUALS(); stack[stackIndex++] = rm_DualMul(a, b); break;
+      case OP_DIV: {
+        POP_2_DUALS();
+        if (fabsf(b.value) < FLT_EPSILON){
+          DOMAIN_FAILURE(REE_EVAL_DIVISION_BY_ZERO);
+        }
+        stack[stackIndex++] = rm_DualDiv(a, b);
+        break;
+      }
+      case OP_POW: POP_2_DUALS(); stack[stackIndex++] = rm_DualPow(a, b); break;
+      case OP_FACT: {
+        POP_1_DUAL();
+        // the checks of ree_EvaluateProgramStatus, all of them before the conversion to int
+        const float rounded = roundf(a.value);
+        if (!(fabsf(a.value - rounded) < FLT_EPSILON) || !(rounded >= 0.0f && rounded <= REE_MAX_FACTORIAL_FLOAT)){
+          DOMAIN_FAILURE(REE_EVAL_FACTORIAL_DOMAIN);
+        }
+
+        int n = (int)rounded;
+        int localResult;
+        CHECK_ERROR_CTX(rm_Factorial(n, &localResult), "Failed to calculate factorial.");
+        float factorial = (float)localResult;
+        float derivative = (fpclassify(a.derivative) == FP_ZERO) ? 0.0f : a.derivative * ree_FactorialSlope(n, factorial);
+        stack[stackIndex++] = (struct rm_dual_t){factorial, derivative};
+        break;
+      }
+      case OP_NEG: POP_1_DUAL(); stack[stackIndex++] = rm_DualNeg(a); break;
+      case OP_POS: break;
+
+      /*
+        #############
+        # FUNCTIONS #
+        #############
+      */
+      case OP_SIN: POP_1_DUAL(); stack[stackIndex++] = rm_DualSin(a); break;
+      case OP_COS: POP_1_DUAL(); stack[stackIndex++] = rm_DualCos(a); break;
+      case OP_TAN: {
+        POP_1_DUAL();
+        if (fabsf(cosf(a.value)) < FLT_EPSILON){
+          DOMAIN_FAILURE(REE_EVAL_TAN_DOMAIN);
+        }
+        stack[stackIndex++] = rm_DualTan(a);
+        break;
+      }
+      case OP_SQRT: {
+        POP_1_DUAL();
+        if (a.value < 0){
+          DOMAIN_FAILURE(REE_EVAL_SQRT_DOMAIN);
+        }
+        stack[stackIndex++] = rm_DualSqrt(a);
+        break;
+      }
+      case OP_ABS: POP_1_DUAL(); stack[stackIndex++] = rm_DualAbs(a); break;
+      case OP_LN: {
+        POP_1_DUAL();
+        if (a.value <= 0){
+          DOMAIN_FAILURE(REE_EVAL_LN_DOMAIN);
+        }
+        stack[stackIndex++] = rm_DualLn(a);
+        break;
+      }
+      case OP_LOG: {
+        POP_1_DUAL();
+        if (a.value <= 0){
+          DOMAIN_FAILURE(REE_EVAL_LOG_DOMAIN);
+        }
+        stack[stackIndex++] = rm_DualLog10(a);
+        break;
+      }
+
+      /*
+        ##################
+        # UNKNOWN OPCODE #
+        ##################
+      */
+      default:
+        SET_ERROR_RETURN(ERR_INVALID_OPERATOR, "Provided opcode (%u) is unknown.", code[-1]);
+    }
+  }
+
+  *result = stack[0];
+  *status = REE_EVAL_OK;
+
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e ree_EvaluateProgramDual(const struct ree_program_t *program, const struct rm_dual_t *variables, struct rm_dual_t *result, uint8_t *status){
+  if (program == nullptr || program->code == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Program provided to ree_EvaluateProgramDual is NULL.");
+  }
+  else if (result == nullptr || status == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Output pointers provided to ree_EvaluateProgramDual are NULL.");
+  }
+  if (program->maxStackDepth <= 0 || program->maxStackDepth > REE_MAX_STACK_DEPTH){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Program provided to ree_EvaluateProgramDual has an invalid stack depth (%d).", program->maxStackDepth);
+  }
+
+  return ree_RunProgramDual(program, variables, result, status);
+}
+
+// marks a lane as undefined, the first failure of a lane is the one reported
+static inline void ree_FailDualLane(uint8_t *laneStatus, struct rm_dual_t *a, size_t lane, enum ree_eval_status_e status){
+  if (laneStatus[lane] == REE_EVAL_OK){
+    laneStatus[lane] = (uint8_t)status;
+  }
+  a[lane] = (struct rm_dual_t){NAN, NAN};
+}
+
+/*
+  Same block-of-lanes scheme as ree_EvaluateBatch so the dispatch cost is paid once per block instead of once per sample,
+  lanes that hit a domain failure carry NaN through the rest of the program.
+*/
+enum reh_error_code_e ree_EvaluateDualBatch(const struct ree_program_t *program, const float *xs, size_t count, float *ys, float *derivatives, uint8_t *status){
+  if (program == nullptr || program->code == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Program provided to ree_EvaluateDualBatch is NULL.");
+  }
+  else if (xs == nullptr || ys == nullptr || derivatives == nullptr || status == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Sample arrays provided to ree_EvaluateDualBatch are NULL.");
+  }
+  if (program->maxStackDepth <= 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Program provided to ree_EvaluateDualBatch has an invalid stack depth (%d).", program->maxStackDepth);
+  }
+  if (count == 0){
+    return ERR_SUCCESS;
+  }
+
+  struct rm_dual_t *stack = malloc(sizeof(struct rm_dual_t) * REE_BATCH_LANES * (size_t)(program->maxStackDepth + program->tempCount));
+  if (stack == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the block stack in ree_EvaluateDualBatch.");
+  }
+  struct rm_dual_t *temps = stack + (size_t)program->maxStackDepth * REE_BATCH_LANES;
+
+  const uint8_t *end = program->code + program->codeSize;
+
+  for (size_t base = 0; base < count; base += REE_BATCH_LANES){
+    const size_t lanes = (count - base < REE_BATCH_LANES) ? count - base : REE_BATCH_LANES;
+    uint8_t *laneStatus = status + base;
+    memset(laneStatus, REE_EVAL_OK, lanes);
+
+    size_t stackIndex = 0;
+    const uint8_t *code = program->code;
+
+    while (code < end){
+      // top of the stack (a) and the entry below it (b is the top for binary operators)
+      struct rm_dual_t *a = (stackIndex >= 1) ? &stack[(stackIndex - 1) * REE_BATCH_LANES] : nullptr;
+      const struct rm_dual_t *b = nullptr;
+      const enum ree_opcode_e opcode = (enum ree_opcode_e)*code++;
+
+      if (opcode == OP_ADD || opcode == OP_SUB || opcode == OP_MUL || opcode == OP_DIV || opcode == OP_POW){
+        stackIndex--;
+        a = &stack[(stackIndex - 1) * REE_BATCH_LANES];
+        b = &stack[stackIndex * REE_BATCH_LANES];
+      }
+
+      switch (opcode){
+        case OP_CONST: {
+          float value;
+          memcpy(&value, code, sizeof(float));
+          code += sizeof(float);
+          struct rm_dual_t *block = &stack[stackIndex++ * REE_BATCH_LANES];
+          for (size_t i = 0; i < lanes; ++i) block[i] = rm_DualConst(value);
+          break;
+        }
+        case OP_VAR: {
+          // only the function parameter (slot 0) is bound, seeding it with derivative 1 makes the derivative part df/dx
+          if (*code++ != 0){
+            free(stack);
+            SET_ERROR_RETURN(ERR_INVALID_INPUT, "ree_EvaluateDualBatch only binds variable slot 0, program references slot %u.", code[-1]);
+          }
+          struct rm_dual_t *block = &stack[stackIndex++ * REE_BATCH_LANES];
+          for (size_t i = 0; i < lanes; ++i) block[i] = rm_DualVariable(xs[base + i]);
+          break;
+        }
+        case OP_STORE: {
+          memcpy(&temps[*code++ * REE_BATCH_LANES], a, lanes * sizeof(struct rm_dual_t));
+          break;
+        }
+        case OP_LOAD: {
+          memcpy(&stack[stackIndex++ * REE_BATCH_LANES], &temps[*code++ * REE_BATCH_LANES], lanes * sizeof(struct rm_dual_t));
+          break;
+        }
+        case OP_PARAM: {
+          const struct rm_dual_t value = rm_DualConst(program->parameters[*code++]);
+          struct rm_dual_t *block = &stack[stackIndex++ * REE_BATCH_LANES];
+          for (size_t i = 0; i < lanes; ++i) block[i] = value;
+          break;
+        }
+
+        /*
+          #############
+          # OPERATORS #
+          #############
+        */
+        case OP_ADD: for (size_t i = 0; i < lanes; ++i) a[i] = rm_DualAdd(a[i], b[i]); break;
+        case OP_SUB: for (size_t i = 0; i < lanes; ++i) a[i] = rm_DualSub(a[i], b[i]); break;
+        case OP_MUL: for (size_t i = 0; i < lanes; ++i) a[i] = rm_DualMul(a[i], b[i]); break;
+        case OP_DIV: {
+          for (size_t i = 0; i < lanes; ++i){
+            if (fabsf(b[i].value) < FLT_EPSILON){
+              ree_FailDualLane(laneStatus, a, i, REE_EVAL_DIVISION_BY_ZERO);
+              continue;
+            }
+            a[i] = rm_DualDiv(a[i], b[i]);
+          }
+          break;
+        }
+        case OP_POW: for (size_t i = 0; i < lanes; ++i) a[i] = rm_DualPow(a[i], b[i]); break;
+        case OP_FACT: {
+          for (size_t i = 0; i < lanes; ++i){
+            const float rounded = roundf(a[i].value);
+            int localResult = 0;
+            if (!(fabsf(a[i].value - rounded) < FLT_EPSILON) || !(rounded >= 0.0f && rounded <= REE_MAX_FACTORIAL_FLOAT) || rm_Factorial((int)rounded, &localResult) != ERR_SUCCESS){
+              ree_FailDualLane(laneStatus, a, i, REE_EVAL_FACTORIAL_DOMAIN);
+              continue;
+            }
+            float factorial = (float)localResult;
+            a[i].derivative = (fpclassify(a[i].derivative) == FP_ZERO) ? 0.0f : a[i].derivative * ree_FactorialSlope((int)rounded, factorial);
+            a[i].value = factorial;
+          }
+          break;
+        }
+        case OP_NEG: for (size_t i = 0; i < lanes; ++i) a[i] = rm_DualNeg(a[i]); break;
+        case OP_POS: break;
+
+        /*
+          #############
+          # FUNCTIONS #
+          #############
+        */
+        case OP_SIN: for (size_t i = 0; i < lanes; ++i) a[i] = rm_DualSin(a[i]); break;
+        case OP_COS: for (size_t i = 0; i < lanes; ++i) a[i] = rm_DualCos(a[i]); break;
+        case OP_TAN: {
+          for (size_t i = 0; i < lanes; ++i){
+            if (fabsf(cosf(a[i].value)) < FLT_EPSILON){
+              ree_FailDualLane(laneStatus, a, i, REE_EVAL_TAN_DOMAIN);
+              continue;
+            }
+            a[i] = rm_DualTan(a[i]);
+          }
+          break;
+        }
+        case OP_SQRT: {
+          for (size_t i = 0; i < lanes; ++i){
+            if (a[i].value < 0){
+              ree_FailDualLane(laneStatus, a, i, REE_EVAL_SQRT_DOMAIN);
+              continue;
+            }
+            a[i] = rm_DualSqrt(a[i]);
+          }
+          break;
+        }
+        case OP_ABS: for (size_t i = 0; i < lanes; ++i) a[i] = rm_DualAbs(a[i]); break;
+        case OP_LN: {
+          for (size_t i = 0; i < lanes; ++i){
+            if (a[i].value <= 0){
+              ree_FailDualLane(laneStatus, a, i, REE_EVAL_LN_DOMAIN);
+              continue;
+            }
+            a[i] = rm_DualLn(a[i]);
+          }
+          break;
+        }
+        case OP_LOG: {
+          for (size_t i = 0; i < lanes; ++i){
+            if (a[i].value <= 0){
+              ree_FailDualLane(laneStatus, a, i, REE_EVAL_LOG_DOMAIN);
+              continue;
+            }
+            a[i] = rm_DualLog10(a[i]);
+          }
+          break;
+        }
+
+        /*
+          ##################
+          # UNKNOWN OPCODE #
+          ##################
+        */
+        default:
+          free(stack);
+          SET_ERROR_RETURN(ERR_INVALID_OPERATOR, "Provided opcode (%u) is unknown.", code[-1]);
+      }
+    }
+
+    // failed lanes are NaN even if a later operator turned them back into a number, like in the scalar evaluator
+    for (size_t i = 0; i < lanes; ++i){
+      const bool failed = laneStatus[i] != REE_EVAL_OK;
+      ys[base + i] = failed ? NAN : stack[i].value;
+      derivatives[base + i] = failed ? NAN : stack[i].derivative;
+    }
+  }
+
+  free(stack);
+  return ERR_SUCCESS;
+}
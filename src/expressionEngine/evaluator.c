@@ -1,27 +1,49 @@
 #include "expressionEngine/evaluator.h"
 #include "core/errorHandler.h"
+#include "expressionEngine/compiler.h"
 #include "expressionEngine/parser/shuntingYard.h"
 #include "math/utility.h"
 #include "core/logger.h"
 
-#include <ctype.h>
 #include <float.h>
 #include <math.h>
 #include <string.h>
 
-#define POP_2_NUMS()                    \
+// ree_EvaluateRpn takes any RPN a caller hands it, so it keeps checking the stack per token
+#define RPN_PUSH(value)                 \
+    if (stackIndex >= REE_MAX_STACK_DEPTH){ \
+      SET_ERROR_RETURN(ERR_INVALID_STACK_STATE, "RPN needs more than %d stack entries.", REE_MAX_STACK_DEPTH); \
+    }                                   \
+    stack[stackIndex++] = (value);
+
+#define RPN_POP_2_NUMS()                \
     if (stackIndex < 2){                \
-      SET_ERROR_RETURN(ERR_INVALID_MEMORY_ACCESS, "Stack index whilst popping two numbers would've gone below 0. Stack index value: %zu", stackIndex);                                  \
+      SET_ERROR_RETURN(ERR_INVALID_STACK_STATE, "Not enough operands for RPN token (%s).", ree_SymbolToStr(rpn[i].symbol)); \
     }                                   \
     float num2 = stack[--stackIndex];   \
     float num1 = stack[--stackIndex];
 
-#define POP_1_NUM()                     \
+#define RPN_POP_1_NUM()                 \
     if (stackIndex < 1){                \
-      SET_ERROR_RETURN(ERR_INVALID_MEMORY_ACCESS, "Stack index whilst popping a number would've gone below 0.Stack index value: %zu", stackIndex);                                     \
+      SET_ERROR_RETURN(ERR_INVALID_STACK_STATE, "Not enough operands for RPN token (%s).", ree_SymbolToStr(rpn[i].symbol)); \
     }                                   \
     float num1 = stack[--stackIndex];
 
+// operand counts of programs are validated once per expression when it's compiled (see ree_MeasureRpnStack), so their pops are never checked
+#define POP_2_NUMS()                    \
+    float num2 = stack[--stackIndex];   \
+    float num1 = stack[--stackIndex];
+
+#define POP_1_NUM()                     \
+    float num1 = stack[--stackIndex];
+
+// stops the program on a domain failure, the result is NaN and the caller decides whether to format an error
+#define DOMAIN_FAILURE(code, value)     \
+    *status = (code);                   \
+    *operand = (value);                 \
+    *result = NAN;                      \
+    return ERR_SUCCESS;
+
 enum reh_error_code_e ree_EvaluateRpn(struct ree_output_token_t *rpn, size_t rpnCount, struct ree_variable_t *variables, size_t variableCount, float *result){
   if (rpn == nullptr){
     SET_ERROR_RETURN(ERR_INVALID_POINTER, "RPN provided to ree_EvaluateRpn is NULL.");
@@ -37,34 +59,35 @@ enum reh_error_code_e ree_EvaluateRpn(struct ree_output_token_t *rpn, size_t rpn
     SET_ERROR_RETURN(ERR_INVALID_INPUT, "rpnCount provided to ree_EvaluateRpn is 0.");
   }
 
-  float stack[rpnCount];
+  // fixed size, deeper RPN is rejected by RPN_PUSH
+  float stack[REE_MAX_STACK_DEPTH];
   size_t stackIndex = 0;
 
   for (size_t i = 0; i < rpnCount; ++i){
     // if the token is a number, push it to the stack
     if (rpn[i].type == OUTPUT_NUMBER){
-      // check if the number is a variable that we need to substitute for
-      if (isalpha((unsigned char)rpn[i].symbol[0]) && variableCount != 0){
-        bool variableFound = false;
-        for (size_t j = 0; j < variableCount; ++j){
-          if (strcmp(rpn[i].symbol, variables[j].name) == 0){
-            stack[stackIndex++] = variables[j].value;
-            variableFound = true;
-            break;
-          }
-        }
+      RPN_PUSH(rpn[i].value);
+    }
+    // if the token is a variable, substitute its value
+    else if (rpn[i].type == OUTPUT_VARIABLE){
+      const char *name = ree_SymbolToStr(rpn[i].symbol);
 
-        // variable not found, can't substitute
-        if (variableFound == false) SET_ERROR_RETURN(ERR_INVALID_INPUT, "No value provided for variable %s in ree_EvaluateRpn.", rpn[i].symbol);
-      }
       // error - symbol found but no variable (well, variableCount is just zero) was provided
-      else if (isalpha((unsigned char)rpn[i].symbol[0]) && variableCount == 0){
-       SET_ERROR_RETURN(ERR_INVALID_INPUT, "Found identifier (%s) in RPN expression, but no variable value was provided to substitute for it.", rpn[i].symbol);
+      if (variableCount == 0){
+       SET_ERROR_RETURN(ERR_INVALID_INPUT, "Found identifier (%s) in RPN expression, but no variable value was provided to substitute for it.", name);
       }
-      // its a number
-      else {
-        stack[stackIndex++] = rpn[i].value;
+
+      bool variableFound = false;
+      for (size_t j = 0; j < variableCount; ++j){
+        if (strcmp(name, variables[j].name) == 0){
+          RPN_PUSH(variables[j].value);
+          variableFound = true;
+          break;
+        }
       }
+
+      // variable not found, can't substitute
+      if (variableFound == false) SET_ERROR_RETURN(ERR_INVALID_INPUT, "No value provided for variable %s in ree_EvaluateRpn.", name);
     }
     // if the token is an operator or a function, pop the required amount of numbers from the stack, process the calcualtion and put the result to the stack
     else if (rpn[i].type == OUTPUT_OPERATOR || rpn[i].type == OUTPUT_FUNCTION){
@@ -73,55 +96,229 @@ enum reh_error_code_e ree_EvaluateRpn(struct ree_output_token_t *rpn, size_t rpn
         # OPERATORS #
         #############
       */
-      if (strcmp(rpn[i].symbol, "+") == 0){
-        POP_2_NUMS();
+      if (rpn[i].symbol == SYMBOL_ADD){
+        RPN_POP_2_NUMS();
         // perform operation and push it to the stack
-        stack[stackIndex++] = num1 + num2;
+        RPN_PUSH(num1 + num2);
       }
-      else if (strcmp(rpn[i].symbol, "-") == 0){
-        POP_2_NUMS();
+      else if (rpn[i].symbol == SYMBOL_SUB){
+        RPN_POP_2_NUMS();
         // perform operation and push it to the stack
-        stack[stackIndex++] = num1 - num2;
+        RPN_PUSH(num1 - num2);
       }
-      else if (strcmp(rpn[i].symbol, "*") == 0){
-        POP_2_NUMS();
+      else if (rpn[i].symbol == SYMBOL_MUL){
+        RPN_POP_2_NUMS();
         // perform operation and push it to the stack
-        stack[stackIndex++] = num1 * num2;
+        RPN_PUSH(num1 * num2);
       }
-      else if (strcmp(rpn[i].symbol, "/") == 0){
-        POP_2_NUMS();
+      else if (rpn[i].symbol == SYMBOL_DIV){
+        RPN_POP_2_NUMS();
         // check for division by zero
         if (fabsf(num2) < FLT_EPSILON){
           SET_ERROR_RETURN(ERR_DIVISION_BY_ZERO, "Attempted to divide by zero while evaluation expression.");
         }
         // perform operation and push it to the stack
-        stack[stackIndex++] = num1 / num2;
+        RPN_PUSH(num1 / num2);
       }
-      else if (strcmp(rpn[i].symbol, "^") == 0){
-        POP_2_NUMS();
-        stack[stackIndex++] = powf(num1, num2);
+      else if (rpn[i].symbol == SYMBOL_POW){
+        RPN_POP_2_NUMS();
+        RPN_PUSH(powf(num1, num2));
       }
-      else if (strcmp(rpn[i].symbol, "!") == 0){
-        POP_1_NUM();
+      else if (rpn[i].symbol == SYMBOL_FACT){
+        RPN_POP_1_NUM();
         // check if num1 is an int
-        if (!(fabsf(num1 - roundf(num1)) < FLT_EPSILON)){
+        const float rounded = roundf(num1);
+        if (!(fabsf(num1 - rounded) < FLT_EPSILON)){
           // not an int (result of the calculation above is bigger than FLT_EPSILON)
           SET_ERROR_RETURN(ERR_INVALID_INPUT, "Non-integer value provided for factorial calculation.");
         }
+        // the range is checked before the conversion to int, rm_Factorial overflows past REE_MAX_FACTORIAL_FLOAT
+        if (!(rounded >= 0.0f && rounded <= REE_MAX_FACTORIAL_FLOAT)){
+          SET_ERROR_RETURN(ERR_INVALID_INPUT, "Negative or too large value (%f) provided for factorial calculation.", (double)num1);
+        }
 
         // declared so we dont pass a raw float into the factorial function
-        int n = (int)roundf(num1);
+        int n = (int)rounded;
         int localResult;
         CHECK_ERROR_CTX(rm_Factorial(n, &localResult), "Failed to calculate factorial.");
+        RPN_PUSH((float)localResult);
+      }
+      else if (rpn[i].symbol == SYMBOL_NEG){
+        RPN_POP_1_NUM();
+        RPN_PUSH(-num1);
+      }
+      else if (rpn[i].symbol == SYMBOL_POS){
+        RPN_POP_1_NUM();
+        RPN_PUSH(+num1);
+      }
+
+      /*
+        #############
+        # FUNCTIONS #
+        #############
+      */
+      else if (rpn[i].symbol == SYMBOL_SIN){
+        RPN_POP_1_NUM();
+        RPN_PUSH(sinf(num1));
+      }
+      else if (rpn[i].symbol == SYMBOL_COS){
+        RPN_POP_1_NUM();
+        RPN_PUSH(cosf(num1));
+      }
+      else if (rpn[i].symbol == SYMBOL_TAN){
+        RPN_POP_1_NUM();
+        if (fabsf(cosf(num1)) < FLT_EPSILON){
+          SET_ERROR_RETURN(ERR_TAN_OUT_OF_DOMAIN, "Tan is undefined for x = %f", (double)num1);
+        }
+        RPN_PUSH(tanf(num1));
+      }
+      else if (rpn[i].symbol == SYMBOL_SQRT){
+        RPN_POP_1_NUM();
+        if (num1 < 0){
+          SET_ERROR_RETURN(ERR_INVALID_SQRT, "Sqrt is undefined for x = %f", (double)num1);
+        }
+        RPN_PUSH(sqrtf(num1));
+      }
+      else if (rpn[i].symbol == SYMBOL_ABS){
+        RPN_POP_1_NUM();
+        RPN_PUSH(fabsf(num1));
+      }
+      else if (rpn[i].symbol == SYMBOL_LN){
+        RPN_POP_1_NUM();
+        if (num1 <= 0){
+          SET_ERROR_RETURN(ERR_LN_OUT_OF_DOMAIN, "Natural log of x is undefined for %f", (double)num1);
+        }
+        // should be lnf() ;)
+        RPN_PUSH(logf(num1));
+      }
+      else if (rpn[i].symbol == SYMBOL_LOG){
+        RPN_POP_1_NUM();
+        if (num1 <= 0){
+          SET_ERROR_RETURN(ERR_LOG_OUT_OF_DOMAIN, "Log with base 10 of x is undefined for %f", (double)num1);
+        }
+        // should be logf() ;)
+        RPN_PUSH(log10f(num1));
+      }
+      /*
+        #####################
+        # UNKNOWN RPN TOKEN #
+        #####################
+      */
+      else {
+        SET_ERROR_RETURN(ERR_INVALID_OPERATOR, "Provided RPN token (%s) is unknown.", ree_SymbolToStr(rpn[i].symbol));
+      }
+    }
+  }
+
+  // result SHOULD be the only thing left on stack
+  if (stackIndex != 1){
+    SET_ERROR_RETURN(ERR_INVALID_STACK_STATE, "RPN leaves %zu values on the stack instead of 1.", stackIndex);
+  }
+  *result = stack[0];
+
+  return ERR_SUCCESS;
+}
+
+/*
+  Shared interpreter of ree_EvaluateProgram and ree_EvaluateProgramStatus.
+  Only real faults (bad stack state, unknown opcode, missing variables) go through SET_ERROR_RETURN,
+  a domain failure stops the evaluation and is reported through status / operand without formatting anything.
+*/
+static enum reh_error_code_e ree_RunProgram(const struct ree_program_t *program, const float *variables, float *result, enum ree_eval_status_e *status, float *operand){
+  // fixed size, the compiler guarantees the program never goes deeper
+  float stack[REE_MAX_STACK_DEPTH];
+  size_t stackIndex = 0;
+  // temporary slots holding shared subexpressions
+  float temps[REE_MAX_TEMP_SLOTS];
+
+  const uint8_t *code = program->code;
+  const uint8_t *end = program->code + program->codeSize;
+
+  while (code < end){
+    switch ((enum ree_opcode_e)*code++){
+      case OP_CONST: {
+        float value;
+        memcpy(&value, code, sizeof(float));
+        code += sizeof(float);
+        stack[stackIndex++] = value;
+        break;
+      }
+      case OP_VAR: {
+        if (variables == nullptr){
+          SET_ERROR_RETURN(ERR_INVALID_POINTER, "Program references a variable but no variables were provided to ree_EvaluateProgram.");
+        }
+        stack[stackIndex++] = variables[*code++];
+        break;
+      }
+      case OP_STORE: {
+        temps[*code++] = stack[stackIndex - 1];
+        break;
+      }
+      case OP_LOAD: {
+        stack[stackIndex++] = temps[*code++];
+        break;
+      }
+      case OP_PARAM: {
+        stack[stackIndex++] = program->parameters[*code++];
+        break;
+      }
+
+      /*
+        #############
+        # OPERATORS #
+        #############
+      */
+      case OP_ADD: {
+        POP_2_NUMS();
+        stack[stackIndex++] = num1 + num2;
+        break;
+      }
+      case OP_SUB: {
+        POP_2_NUMS();
+        stack[stackIndex++] = num1 - num2;
+        break;
+      }
+      case OP_MUL: {
+        POP_2_NUMS();
+        stack[stackIndex++] = num1 * num2;
+        break;
+      }
+      case OP_DIV: {
+        POP_2_NUMS();
+        if (fabsf(num2) < FLT_EPSILON){
+          DOMAIN_FAILURE(REE_EVAL_DIVISION_BY_ZERO, num2);
+        }
+        stack[stackIndex++] = num1 / num2;
+        break;
+      }
+      case OP_POW: {
+        POP_2_NUMS();
+        stack[stackIndex++] = powf(num1, num2);
+        break;
+      }
+      case OP_FACT: {
+        POP_1_NUM();
+        // same rules as the batch evaluator, checked up front so rm_Factorial never has to report the error itself
+        // and the conversion to int only sees integers it can hold
+        const float rounded = roundf(num1);
+        if (!(fabsf(num1 - rounded) < FLT_EPSILON) || !(rounded >= 0.0f && rounded <= REE_MAX_FACTORIAL_FLOAT)){
+          DOMAIN_FAILURE(REE_EVAL_FACTORIAL_DOMAIN, num1);
+        }
+
+        int localResult;
+        CHECK_ERROR_CTX(rm_Factorial((int)rounded, &localResult), "Failed to calculate factorial.");
         stack[stackIndex++] = (float)localResult;
+        break;
       }
-      else if (strcmp(rpn[i].symbol, "NEG") == 0){
+      case OP_NEG: {
         POP_1_NUM();
         stack[stackIndex++] = -num1;
+        break;
       }
-      else if (strcmp(rpn[i].symbol, "POS") == 0){
+      case OP_POS: {
         POP_1_NUM();
         stack[stackIndex++] = +num1;
+        break;
       }
 
       /*
@@ -129,64 +326,155 @@ enum reh_error_code_e ree_EvaluateRpn(struct ree_output_token_t *rpn, size_t rpn
         # FUNCTIONS #
         #############
       */
-      else if (strcmp(rpn[i].symbol, "sin") == 0){
+      case OP_SIN: {
         POP_1_NUM();
         stack[stackIndex++] = sinf(num1);
+        break;
       }
-      else if (strcmp(rpn[i].symbol, "cos") == 0){
+      case OP_COS: {
         POP_1_NUM();
         stack[stackIndex++] = cosf(num1);
+        break;
       }
-      else if (strcmp(rpn[i].symbol, "tan") == 0){
+      case OP_TAN: {
         POP_1_NUM();
         if (fabsf(cosf(num1)) < FLT_EPSILON){
-          SET_ERROR_RETURN(ERR_TAN_OUT_OF_DOMAIN, "Tan is undefined for x = %f", (double)num1);
+          DOMAIN_FAILURE(REE_EVAL_TAN_DOMAIN, num1);
         }
         stack[stackIndex++] = tanf(num1);
+        break;
       }
-      else if (strcmp(rpn[i].symbol, "sqrt") == 0){
+      case OP_SQRT: {
         POP_1_NUM();
         if (num1 < 0){
-          SET_ERROR_RETURN(ERR_INVALID_SQRT, "Sqrt is undefined for x = %f", (double)num1);
+          DOMAIN_FAILURE(REE_EVAL_SQRT_DOMAIN, num1);
         }
         stack[stackIndex++] = sqrtf(num1);
+        break;
       }
-      else if (strcmp(rpn[i].symbol, "abs") == 0){
+      case OP_ABS: {
         POP_1_NUM();
         stack[stackIndex++] = fabsf(num1);
+        break;
       }
-      else if (strcmp(rpn[i].symbol, "ln") == 0){
+      case OP_LN: {
         POP_1_NUM();
         if (num1 <= 0){
-          SET_ERROR_RETURN(ERR_LN_OUT_OF_DOMAIN, "Natural log of x is undefined for %f", (double)num1);
+          DOMAIN_FAILURE(REE_EVAL_LN_DOMAIN, num1);
         }
-        // should be lnf() ;)
         stack[stackIndex++] = logf(num1);
+        break;
       }
-      else if (strcmp(rpn[i].symbol, "log") == 0){
+      case OP_LOG: {
         POP_1_NUM();
         if (num1 <= 0){
-          SET_ERROR_RETURN(ERR_LOG_OUT_OF_DOMAIN, "Log with base 10 of x is undefined for %f", (double)num1);
+          DOMAIN_FAILURE(REE_EVAL_LOG_DOMAIN, num1);
         }
-        // should be logf() ;)
         stack[stackIndex++] = log10f(num1);
+        break;
       }
+
       /*
-        #####################
-        # UNKNOWN RPN TOKEN #
-        #####################
+        ##################
+        # UNKNOWN OPCODE #
+        ##################
       */
-      else {
-        SET_ERROR_RETURN(ERR_INVALID_OPERATOR, "Provided RPN token (%s) is unknown.", rpn[i].symbol);
-      }
+      default:
+        SET_ERROR_RETURN(ERR_INVALID_OPERATOR, "Provided opcode (%u) is unknown.", code[-1]);
     }
   }
 
-  // result SHOULD be the only thing left on stack
-  if (stackIndex != 1){
-    SET_ERROR_RETURN(ERR_INVALID_STACK_STATE, "There is more than the result on the stack left. (stackIndex: %zu)", stackIndex);
-  }
+  // the result is the only value left, the compiler checked it
   *result = stack[0];
+  *status = REE_EVAL_OK;
+
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e ree_EvaluateProgram(const struct ree_program_t *program, const float *variables, float *result){
+  if (program == nullptr || program->code == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Program provided to ree_EvaluateProgram is NULL.");
+  }
+  if (result == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Result provided to ree_EvaluateProgram is NULL.");
+  }
+
+  if (program->opCount <= 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Program provided to ree_EvaluateProgram has no instructions.");
+  }
+  else if (program->maxStackDepth <= 0 || program->maxStackDepth > REE_MAX_STACK_DEPTH){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Program provided to ree_EvaluateProgram has an invalid stack depth (%d).", program->maxStackDepth);
+  }
 
+  enum ree_eval_status_e status;
+  float operand = 0.0f;
+  enum reh_error_code_e err = ree_RunProgram(program, variables, result, &status, &operand);
+  if (err != ERR_SUCCESS){
+    return err;
+  }
+
+  // domain failures are only formatted here, callers which don't need the message use ree_EvaluateProgramStatus
+  switch (status){
+    case REE_EVAL_OK:
+      return ERR_SUCCESS;
+    case REE_EVAL_DIVISION_BY_ZERO:
+      SET_ERROR_RETURN(ERR_DIVISION_BY_ZERO, "Attempted to divide by zero while evaluation expression.");
+    case REE_EVAL_FACTORIAL_DOMAIN:
+      SET_ERROR_RETURN(ERR_INVALID_INPUT, "Non-integer, negative or too large value (%f) provided for factorial calculation.", (double)operand);
+    case REE_EVAL_TAN_DOMAIN:
+      SET_ERROR_RETURN(ERR_TAN_OUT_OF_DOMAIN, "Tan is undefined for x = %f", (double)operand);
+    case REE_EVAL_SQRT_DOMAIN:
+      SET_ERROR_RETURN(ERR_INVALID_SQRT, "Sqrt is undefined for x = %f", (double)operand);
+    case REE_EVAL_LN_DOMAIN:
+      SET_ERROR_RETURN(ERR_LN_OUT_OF_DOMAIN, "Natural log of x is undefined for %f", (double)operand);
+    case REE_EVAL_LOG_DOMAIN:
+      SET_ERROR_RETURN(ERR_LOG_OUT_OF_DOMAIN, "Log with base 10 of x is undefined for %f", (double)operand);
+  }
+
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e ree_EvaluateProgramStatus(const struct ree_program_t *program, const float *variables, float *result, uint8_t *status){
+  if (program == nullptr || program->code == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Program provided to ree_EvaluateProgramStatus is NULL.");
+  }
+  if (result == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Result provided to ree_EvaluateProgramStatus is NULL.");
+  }
+  if (status == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Status provided to ree_EvaluateProgramStatus is NULL.");
+  }
+
+  if (program->opCount <= 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Program provided to ree_EvaluateProgramStatus has no instructions.");
+  }
+  else if (program->maxStackDepth <= 0 || program->maxStackDepth > REE_MAX_STACK_DEPTH){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Program provided to ree_EvaluateProgramStatus has an invalid stack depth (%d).", program->maxStackDepth);
+  }
+
+  enum ree_eval_status_e sampleStatus = REE_EVAL_OK;
+  float operand = 0.0f;
+  enum reh_error_code_e err = ree_RunProgram(program, variables, result, &sampleStatus, &operand);
+  if (err != ERR_SUCCESS){
+    // a fault isn't a domain failure, the run may have stopped before setting either
+    *result = NAN;
+    *status = REE_EVAL_OK;
+    return err;
+  }
+
+  *status = (uint8_t)sampleStatus;
   return ERR_SUCCESS;
 }
+
+const char* ree_EvalStatusToStr(enum ree_eval_status_e status){
+  switch (status){
+    case REE_EVAL_OK:               return "REE_EVAL_OK";
+    case REE_EVAL_DIVISION_BY_ZERO: return "REE_EVAL_DIVISION_BY_ZERO";
+    case REE_EVAL_FACTORIAL_DOMAIN: return "REE_EVAL_FACTORIAL_DOMAIN";
+    case REE_EVAL_TAN_DOMAIN:       return "REE_EVAL_TAN_DOMAIN";
+    case REE_EVAL_SQRT_DOMAIN:      return "REE_EVAL_SQRT_DOMAIN";
+    case REE_EVAL_LN_DOMAIN:        return "REE_EVAL_LN_DOMAIN";
+    case REE_EVAL_LOG_DOMAIN:       return "REE_EVAL_LOG_DOMAIN";
+    default:                        return "UNKNOWN";
+  }
+}
@@ -1,6 +1,16 @@
 #include "expressionEngine/functionManager.h"
 #include "core/errorHandler.h"
+#include "expressionEngine/compiler.h"
+#include "expressionEngine/differentiator.h"
+#include "expressionEngine/inliner.h"
+#include "expressionEngine/jit.h"
+#include "expressionEngine/optimizer.h"
 #include "expressionEngine/parser/functionParser.h"
+#include "expressionEngine/tokens.h"
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "core/logger.h"
@@ -8,44 +18,396 @@
 struct rm_vec3_t functionColorArray[] = {RED, ORANGE, YELLOW, GREEN, BLUE, PURPLE, PINK, GRAY, WHITE};
 const int functionColorArrayLength = sizeof(functionColorArray) / sizeof(functionColorArray[0]);
 
+// every table of the manager goes through the allocator hooks of its pool, like the arena blocks
+static void* ree_ManagerAlloc(struct ree_function_manager_t *manager, size_t size){
+  return manager->pool.allocator.alloc(size, manager->pool.allocator.userData);
+}
+
+static void ree_ManagerFree(struct ree_function_manager_t *manager, void *ptr){
+  if (ptr == nullptr) return;
+  manager->pool.allocator.free(ptr, manager->pool.allocator.userData);
+}
+
 enum reh_error_code_e ree_InitFunctionManager(struct ree_function_manager_t *manager){
+  return ree_InitFunctionManagerWithAllocator(manager, nullptr);
+}
+
+enum reh_error_code_e ree_InitFunctionManagerWithAllocator(struct ree_function_manager_t *manager, const struct rma_allocator_t *allocator){
   if (manager == nullptr){
     SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to manager passed to ree_InitFunctionManager is NULL.");
   }
 
+  // the tables are allocated on the first definition
+  memset(manager, 0, sizeof *manager);
+  manager->freeSlot = REE_NO_SLOT;
+
+  CHECK_ERROR_CTX(rma_InitPool(&manager->pool, RMA_DEFAULT_BLOCK_SIZE, RMA_DEFAULT_MAX_FREE_BLOCKS, allocator), "Failed to initialize the function manager memory pool.");
+  rma_InitArena(&manager->scratch, &manager->pool);
+  ree_InitParseCache(&manager->parseCache, &manager->pool);
+
+  return ERR_SUCCESS;
+}
+
+// releases everything a function owns, a body shared with the parse cache stays cached
+static void ree_ReleaseFunction(struct ree_function_t *function){
+  ree_JitFree(&function->program);
+  ree_ReleaseParseCacheEntry(function->cached);
+  function->cached = nullptr;
+  rma_ResetArena(&function->arena);
+}
+
+void ree_DestroyFunctionManager(struct ree_function_manager_t *manager){
+  if (manager == nullptr) return;
+
+  for (int i = 0; i < manager->functionCount; ++i){
+    ree_ReleaseFunction(&manager->functions[i]);
+  }
+  ree_DestroyParseCache(&manager->parseCache);
+  ree_ManagerFree(manager, manager->functions);
+  ree_ManagerFree(manager, manager->slots);
+  ree_ManagerFree(manager, manager->nameIndex);
+
+  manager->functions = nullptr;
   manager->functionCount = 0;
-  memset(manager->functions, 0, sizeof(manager->functions));
+  manager->functionCapacity = 0;
+  manager->slots = nullptr;
+  manager->slotCount = 0;
+  manager->slotCapacity = 0;
+  manager->freeSlot = REE_NO_SLOT;
+  manager->nameIndex = nullptr;
+  manager->nameIndexCapacity = 0;
+  memset(&manager->parameters, 0, sizeof(manager->parameters));
+
+  rma_ResetArena(&manager->scratch);
+  rma_DestroyPool(&manager->pool);
+}
+
+/*
+  ##########
+  # TABLES #
+  ##########
+
+  functions is dense, so iterating it never skips holes and removal moves the last function into the freed position.
+  A handle names a slot, the slot knows where its function currently is. Freed slots are chained through index
+  and get a new generation, so handles of removed functions never resolve to the function reusing the slot.
+  nameIndex maps names to slots with linear probing, entries are removed by shifting the rest of their cluster back.
+*/
+
+static bool ree_SameHandle(struct ree_function_handle_t a, struct ree_function_handle_t b){
+  return a.slot == b.slot && a.generation == b.generation;
+}
+
+// y = ... definitions can repeat, so they aren't in the name index
+static bool ree_IsIndexedName(const char *name){
+  return strcmp(name, "y") != 0;
+}
+
+static uint32_t ree_HashFunctionName(const char *name){
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  for (; *name != '\0'; ++name){
+    hash ^= (uint8_t)*name;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// probes for a name, returns the bucket holding it or the empty bucket ending its cluster
+static uint32_t ree_FindNameBucket(const struct ree_function_manager_t *manager, const char *name){
+  const uint32_t mask = manager->nameIndexCapacity - 1;
+  uint32_t bucket = ree_HashFunctionName(name) & mask;
+  while (manager->nameIndex[bucket] != REE_NO_SLOT){
+    const struct ree_function_t *function = &manager->functions[manager->slots[manager->nameIndex[bucket]].index];
+    if (strcmp(function->name, name) == 0) break;
+    bucket = (bucket + 1) & mask;
+  }
+  return bucket;
+}
+
+// doubles the name index and inserts every named function again
+static enum reh_error_code_e ree_GrowNameIndex(struct ree_function_manager_t *manager){
+  if (manager->nameIndexCapacity > UINT32_MAX / 4){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Name index of the function manager can't grow past %u buckets.", manager->nameIndexCapacity);
+  }
+  const uint32_t capacity = (manager->nameIndexCapacity > 0) ? manager->nameIndexCapacity * 2 : 32;
+  uint32_t *nameIndex = ree_ManagerAlloc(manager, (size_t)capacity * sizeof *nameIndex);
+  if (nameIndex == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to grow the name index to %u buckets.", capacity);
+  }
+  memset(nameIndex, 0xFF, (size_t)capacity * sizeof *nameIndex);
+
+  ree_ManagerFree(manager, manager->nameIndex);
+  manager->nameIndex = nameIndex;
+  manager->nameIndexCapacity = capacity;
+
+  for (int i = 0; i < manager->functionCount; ++i){
+    if (ree_IsIndexedName(manager->functions[i].name) == false) continue;
+    manager->nameIndex[ree_FindNameBucket(manager, manager->functions[i].name)] = manager->functions[i].handle.slot;
+  }
+
+  return ERR_SUCCESS;
+}
+
+static void ree_EraseName(struct ree_function_manager_t *manager, const char *name){
+  if (manager->nameIndexCapacity == 0) return;
+
+  const uint32_t mask = manager->nameIndexCapacity - 1;
+  uint32_t hole = ree_FindNameBucket(manager, name);
+  if (manager->nameIndex[hole] == REE_NO_SLOT) return;
+  manager->nameIndex[hole] = REE_NO_SLOT;
+
+  // an entry after the hole moves into it unless the hole lies before its home bucket, probes would stop at the hole otherwise
+  for (uint32_t next = (hole + 1) & mask; manager->nameIndex[next] != REE_NO_SLOT; next = (next + 1) & mask){
+    const struct ree_function_t *function = &manager->functions[manager->slots[manager->nameIndex[next]].index];
+    const uint32_t home = ree_HashFunctionName(function->name) & mask;
+    if (((next - home) & mask) >= ((next - hole) & mask)){
+      manager->nameIndex[hole] = manager->nameIndex[next];
+      manager->nameIndex[next] = REE_NO_SLOT;
+      hole = next;
+    }
+  }
+}
+
+// makes room for one more function and its slot, the functions move if the array grows
+static enum reh_error_code_e ree_ReserveFunction(struct ree_function_manager_t *manager){
+  if (manager->functionCount == manager->functionCapacity){
+    if (manager->functionCapacity > INT_MAX / 2){
+      SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Function manager can't grow past %d functions.", manager->functionCapacity);
+    }
+    const int capacity = (manager->functionCapacity > 0) ? manager->functionCapacity * 2 : 16;
+    struct ree_function_t *functions = ree_ManagerAlloc(manager, (size_t)capacity * sizeof *functions);
+    if (functions == nullptr){
+      SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to grow the function array to %d functions.", capacity);
+    }
+    if (manager->functionCount > 0){
+      memcpy(functions, manager->functions, (size_t)manager->functionCount * sizeof *functions);
+    }
+    memset(&functions[manager->functionCount], 0, (size_t)(capacity - manager->functionCount) * sizeof *functions);
+
+    ree_ManagerFree(manager, manager->functions);
+    manager->functions = functions;
+    manager->functionCapacity = capacity;
+  }
+
+  if (manager->freeSlot == REE_NO_SLOT && manager->slotCount == manager->slotCapacity){
+    if (manager->slotCapacity > UINT32_MAX / 4){
+      SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Slot table of the function manager can't grow past %u slots.", manager->slotCapacity);
+    }
+    const uint32_t capacity = (manager->slotCapacity > 0) ? manager->slotCapacity * 2 : 16;
+    struct ree_function_slot_t *slots = ree_ManagerAlloc(manager, (size_t)capacity * sizeof *slots);
+    if (slots == nullptr){
+      SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to grow the slot table to %u slots.", capacity);
+    }
+    if (manager->slotCount > 0){
+      memcpy(slots, manager->slots, (size_t)manager->slotCount * sizeof *slots);
+    }
+
+    ree_ManagerFree(manager, manager->slots);
+    manager->slots = slots;
+    manager->slotCapacity = capacity;
+  }
+
   return ERR_SUCCESS;
 }
 
-int ree_GetFunction(struct ree_function_manager_t *manager, const char *name, struct ree_function_t *function){
+// adds delta to the reference count of everything a function depends on, its source and every function it calls
+static void ree_CountReferences(struct ree_function_manager_t *manager, const struct ree_function_t *function, int delta){
+  struct ree_function_t *source = ree_ResolveFunction(manager, function->source);
+  if (source != nullptr){
+    source->referenceCount += delta;
+  }
+
+  for (int i = 0; i < function->sourceRpnCount; ++i){
+    if (ree_IsCallToken(&function->sourceRpn[i]) == false) continue;
+
+    struct ree_function_t *callee = ree_GetFunction(manager, ree_SymbolToStr(function->sourceRpn[i].symbol));
+    if (callee != nullptr){
+      callee->referenceCount += delta;
+    }
+  }
+}
+
+// hands a slot to the function built in functions[functionCount] and indexes its name, ree_ReserveFunction made room for both
+static enum reh_error_code_e ree_RegisterFunction(struct ree_function_manager_t *manager, struct ree_function_handle_t source){
+  struct ree_function_t *function = &manager->functions[manager->functionCount];
+
+  // grow first, nothing has changed yet if it fails
+  const bool indexed = ree_IsIndexedName(function->name);
+  if (indexed == true && 2 * ((uint32_t)manager->functionCount + 1) > manager->nameIndexCapacity){
+    CHECK_ERROR_CTX(ree_GrowNameIndex(manager), "Failed to grow the name index.");
+  }
+
+  uint32_t slot = manager->freeSlot;
+  if (slot != REE_NO_SLOT){
+    manager->freeSlot = manager->slots[slot].index;
+  }
+  else {
+    slot = manager->slotCount++;
+    manager->slots[slot].generation = 1;
+  }
+  manager->slots[slot].index = (uint32_t)manager->functionCount;
+
+  function->handle = (struct ree_function_handle_t){slot, manager->slots[slot].generation};
+  function->source = source;
+  function->referenceCount = 0;
+  if (indexed == true){
+    manager->nameIndex[ree_FindNameBucket(manager, function->name)] = slot;
+  }
+  manager->functionCount++;
+
+  ree_CountReferences(manager, function, 1);
+  return ERR_SUCCESS;
+}
+
+struct ree_function_t* ree_GetFunction(struct ree_function_manager_t *manager, const char *name){
+  if (manager == nullptr || name == nullptr){
+    return nullptr;
+  }
+
+  if (ree_IsIndexedName(name) == false){
+    for (int i = 0; i < manager->functionCount; ++i){
+      if (strcmp(manager->functions[i].name, name) == 0){
+        return &manager->functions[i];
+      }
+    }
+    return nullptr;
+  }
+
+  if (manager->nameIndexCapacity == 0){
+    return nullptr;
+  }
+  const uint32_t slot = manager->nameIndex[ree_FindNameBucket(manager, name)];
+  return (slot != REE_NO_SLOT) ? &manager->functions[manager->slots[slot].index] : nullptr;
+}
+
+struct ree_function_t* ree_ResolveFunction(struct ree_function_manager_t *manager, struct ree_function_handle_t handle){
+  if (manager == nullptr || handle.generation == 0 || handle.slot >= manager->slotCount){
+    return nullptr;
+  }
+
+  // freed slots moved on to the next generation, a removed function's handle doesn't match anymore
+  const struct ree_function_slot_t *slot = &manager->slots[handle.slot];
+  if (slot->generation != handle.generation){
+    return nullptr;
+  }
+  return &manager->functions[slot->index];
+}
+
+bool ree_IsFunctionInManager(struct ree_function_manager_t *manager, const char* name){
+  return ree_GetFunction(manager, name) != nullptr;
+}
+
+
+void ree_MarkFunctionSampled(struct ree_function_t *function){
+  if (function == nullptr) return;
+
+  if (++function->sampleCount != REE_JIT_HOT_THRESHOLD || !ree_JitIsSupported()) return;
+
+  if (ree_JitCompile(&function->program, function->mathMode) != ERR_SUCCESS){
+    rl_LogMsg(RL_DEBUG, "Function %s stays interpreted: %s", function->name, reh_GetLastError()->message);
+    reh_ClearError();
+    return;
+  }
+  rl_LogMsg(RL_DEBUG, "Function %s compiled to %zu bytes of native code.", function->name, function->program.jit->codeSize);
+}
+
+enum reh_error_code_e ree_SetParameter(struct ree_function_manager_t *manager, const char *name, float value){
   if (manager == nullptr){
-    return -1;
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Manager passed to ree_SetParameter is NULL.");
   }
   else if (name == nullptr){
-    return -1;
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Name passed to ree_SetParameter is NULL.");
   }
-  else if (function == nullptr){
-    return -1;
+  else if (!isfinite(value)){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Value of parameter %s isn't finite.", name);
   }
 
+  // definitions can only refer to alphabetic identifiers, y and the built in functions are taken
+  uint16_t symbol;
+  if (name[0] == '\0'){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Parameter name passed to ree_SetParameter is empty.");
+  }
+  for (const char *c = name; *c != '\0'; ++c){
+    if (!isalpha((unsigned char)*c)){
+      SET_ERROR_RETURN(ERR_INVALID_INPUT, "Parameter name %s isn't an identifier.", name);
+    }
+  }
+  CHECK_ERROR_CTX(ree_InternSymbol(name, (int)strlen(name), &symbol), "Failed to intern parameter %s.", name);
+  if (strcmp(name, "y") == 0 || ree_IsFunctionSymbol(symbol) == true){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "%s is reserved and can't be used as a parameter.", name);
+  }
+
+  int index;
+  CHECK_ERROR_CTX(ree_DeclareParameter(&manager->parameters, name, &index), "Failed to declare parameter %s.", name);
+  // the same bits evaluate to the same samples, nothing has to be sampled again
+  if (memcmp(&manager->parameters.values[index], &value, sizeof value) == 0){
+    return ERR_SUCCESS;
+  }
+  manager->parameters.values[index] = value;
+
+  // the programs read the table directly, only the functions reading the parameter have to be sampled again
+  const uint64_t bit = UINT64_C(1) << index;
   for (int i = 0; i < manager->functionCount; ++i){
-    if (strcmp(manager->functions[i].name, name) == 0){
-      *function = manager->functions[i];
-      return 0; // success
+    if ((manager->functions[i].program.parameterMask & bit) != 0){
+      manager->functions[i].revision++;
     }
   }
 
-  return -1; // uh oh
+  return ERR_SUCCESS;
 }
 
-bool ree_IsFunctionInManager(struct ree_function_manager_t *manager, const char* name){
-  for (int i = 0; i < manager->functionCount; ++i){
-    if (strcmp(manager->functions[i].name, name) == 0){
-      return true; // yes it is
+enum reh_error_code_e ree_GetParameter(const struct ree_function_manager_t *manager, const char *name, float *value){
+  if (manager == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Manager passed to ree_GetParameter is NULL.");
+  }
+  else if (name == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Name passed to ree_GetParameter is NULL.");
+  }
+  else if (value == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to value in ree_GetParameter is NULL.");
+  }
+
+  const int index = ree_FindParameter(&manager->parameters, name);
+  if (index < 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Parameter %s passed to ree_GetParameter isn't defined.", name);
+  }
+  *value = manager->parameters.values[index];
+
+  return ERR_SUCCESS;
+}
+
+// checks whether the source RPN of a function calls the function with the given name
+static bool ree_FunctionCalls(const struct ree_function_t *function, const char *name){
+  for (int i = 0; i < function->sourceRpnCount; ++i){
+    if (ree_IsCallToken(&function->sourceRpn[i]) == true && strcmp(ree_SymbolToStr(function->sourceRpn[i].symbol), name) == 0){
+      return true;
     }
   }
-  return false; // no its not
+  return false;
+}
+
+// checks whether a function has to be rebuilt when other changes, either it's a derivative of it or it calls it
+static bool ree_DependsOn(const struct ree_function_t *function, const struct ree_function_t *other){
+  return ree_SameHandle(function->source, other->handle) || ree_FunctionCalls(function, other->name);
+}
+
+// checks whether a function is the one with the given handle or a derivative taken of it (directly or of one of its derivatives)
+static bool ree_IsDerivedFrom(struct ree_function_manager_t *manager, const struct ree_function_t *function, struct ree_function_handle_t handle){
+  for (; function != nullptr; function = ree_ResolveFunction(manager, function->source)){
+    if (ree_SameHandle(function->handle, handle) == true) return true;
+  }
+  return false;
+}
+
+// checks whether the source RPN of a function calls the function with the given handle or one of its derivatives
+static bool ree_CallsDerivedFrom(struct ree_function_manager_t *manager, const struct ree_function_t *function, struct ree_function_handle_t handle){
+  for (int i = 0; i < function->sourceRpnCount; ++i){
+    if (ree_IsCallToken(&function->sourceRpn[i]) == false) continue;
+
+    const struct ree_function_t *callee = ree_GetFunction(manager, ree_SymbolToStr(function->sourceRpn[i].symbol));
+    if (ree_IsDerivedFrom(manager, callee, handle) == true) return true;
+  }
+  return false;
 }
 
 enum reh_error_code_e ree_AddFunction(struct ree_function_manager_t *manager, char *definition, struct rm_vec3_t *functionColor){
@@ -55,58 +417,380 @@ enum reh_error_code_e ree_AddFunction(struct ree_function_manager_t *manager, ch
   else if (definition == nullptr){
     SET_ERROR_RETURN(ERR_INVALID_POINTER, "Definition passed to ree_AddFunction is NULL.");
   }
-  else if (manager->functionCount >= REE_MAX_FUNCTIONS){
-    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Function manager has reached maximum function capacity.");
-  }
   else if (functionColor == nullptr){
     rl_LogMsg(RL_WARNING, "No function color (NULL) provided to ree_AddFunction, assigning next available color.");
     // assign a color from the array based on the current function count
     functionColor = &functionColorArray[manager->functionCount % functionColorArrayLength];
   }
 
+  CHECK_ERROR_CTX(ree_ReserveFunction(manager), "Failed to make room for another function.");
+
   // add the function to the manager
-  CHECK_ERROR_CTX(ree_ParseFunction(definition, &manager->functions[manager->functionCount], manager, functionColor), "Failed to parse function definition.");
+  struct ree_function_t *function = &manager->functions[manager->functionCount];
+  CHECK_ERROR_CTX(ree_ParseFunction(definition, function, manager, functionColor), "Failed to parse function definition.");
 
-  manager->functionCount++;
+  // y = ... definitions can repeat, every other name is unique (calls are resolved by name)
+  if (ree_IsIndexedName(function->name) == true && ree_IsFunctionInManager(manager, function->name) == true){
+    char name[MAX_DERIVED_NAME_LEN + 1];
+    strcpy(name, function->name);
+    ree_ReleaseFunction(function);
+    memset(function, 0, sizeof *function);
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function with the same name (%s) already exists!", name);
+  }
+
+  enum reh_error_code_e err = ree_RegisterFunction(manager, (struct ree_function_handle_t){0, 0});
+  if (err != ERR_SUCCESS){
+    ree_ReleaseFunction(function);
+    memset(function, 0, sizeof *function);
+  }
+  CHECK_ERROR_CTX(err, "Failed to register the function.");
 
   return ERR_SUCCESS;
 }
 
-enum reh_error_code_e ree_RemoveFunction(struct ree_function_manager_t *manager, const char *name){
+// differentiates the RPN of source, then simplifies and compiles the result the same way ree_ParseFunction does
+static enum reh_error_code_e ree_BuildDerivative(const struct ree_function_t *source, struct ree_function_t *derivative, struct ree_function_manager_t *manager){
+  struct rma_arena_t *scratch = &manager->scratch;
+
+  uint16_t variable;
+  CHECK_ERROR_CTX(ree_InternSymbol(source->parameter, (int)strlen(source->parameter), &variable), "Failed to intern parameter of %s.", source->name);
+  CHECK_ERROR_CTX(ree_DifferentiateRpn(scratch, &derivative->arena, source->rpn, source->rpnCount, variable, &derivative->rpn, &derivative->rpnCount), "Failed to differentiate %s.", source->name);
+
+  // the chain and product rules leave plenty of * 1 and + 0 behind
+  int unoptimizedRpnCount = derivative->rpnCount;
+  CHECK_ERROR_CTX(ree_OptimizeRpn(scratch, derivative->rpn, &derivative->rpnCount), "Failed to optimize RPN.");
+  rl_LogMsg(RL_DEBUG, "Optimized RPN of %s: %d -> %d ops", derivative->name, unoptimizedRpnCount, derivative->rpnCount);
+
+  // the RPN is the only allocation of the function arena so far, shrink it in place
+  struct ree_output_token_t *shrunkRpn = rma_Realloc(&derivative->arena, derivative->rpn, (size_t)unoptimizedRpnCount * sizeof(struct ree_output_token_t), (size_t)derivative->rpnCount * sizeof(struct ree_output_token_t));
+  if (shrunkRpn != nullptr){
+    derivative->rpn = shrunkRpn;
+  }
+
+  const char *variableNames[] = {derivative->parameter};
+  CHECK_ERROR_CTX(ree_CompileRpn(scratch, &derivative->arena, derivative->rpn, derivative->rpnCount, variableNames, 1, &manager->parameters, &derivative->program), "Failed to compile RPN into bytecode.");
+
+  return ERR_SUCCESS;
+}
+
+// rebuilds a dependent function into a fresh arena after something it depends on was redefined
+// the previous arena is left alone, it's released (or restored) by the caller
+static enum reh_error_code_e ree_RebuildFunction(struct ree_function_manager_t *manager, struct ree_function_t *function){
+  const struct ree_function_t previous = *function;
+
+  rma_InitArena(&function->arena, &manager->pool);
+  memset(&function->program, 0, sizeof function->program);
+  function->cached = nullptr;
+  function->rpn = nullptr;
+  function->rpnCount = 0;
+  function->sourceRpn = nullptr;
+  function->sourceRpnCount = 0;
+  function->sampleCount = 0;
+  function->revision++;
+
+  if (function->source.generation != 0){
+    const struct ree_function_t *source = ree_ResolveFunction(manager, function->source);
+    if (source == nullptr){
+      SET_ERROR_RETURN(ERR_INVALID_INPUT, "Source of the derivative %s wasn't found.", function->name);
+    }
+    return ree_BuildDerivative(source, function, manager);
+  }
+
+  // a caller, the new bodies are inlined into its parsed RPN again
+  function->rpn = rma_Alloc(&function->arena, (size_t)previous.sourceRpnCount * sizeof(struct ree_output_token_t));
+  if (function->rpn == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate memory for RPN array.");
+  }
+  memcpy(function->rpn, previous.sourceRpn, (size_t)previous.sourceRpnCount * sizeof(struct ree_output_token_t));
+  function->rpnCount = previous.sourceRpnCount;
+
+  return ree_CompileFunction(manager, function);
+}
+
+enum reh_error_code_e ree_AddDerivative(struct ree_function_manager_t *manager, const char *name, struct rm_vec3_t *functionColor){
   if (manager == nullptr){
-    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Manager passed to ree_RemoveFunction is NULL.");
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Manager passed to ree_AddDerivative is NULL.");
   }
   else if (name == nullptr){
-    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Name passed to ree_RemoveFunction is NULL.");
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Name passed to ree_AddDerivative is NULL.");
+  }
+  else if (functionColor == nullptr){
+    rl_LogMsg(RL_WARNING, "No function color (NULL) provided to ree_AddDerivative, assigning next available color.");
+    functionColor = &functionColorArray[manager->functionCount % functionColorArrayLength];
+  }
+
+  // make room first, growing moves the source
+  CHECK_ERROR_CTX(ree_ReserveFunction(manager), "Failed to make room for another function.");
+
+  const struct ree_function_t *source = ree_GetFunction(manager, name);
+  if (source == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function with name %s passed to ree_AddDerivative wasn't found.", name);
   }
 
-  bool functionExists = false;
-  int functionPos;
+  // every derivative adds a ' to the name of its source
+  const size_t sourceLength = strlen(source->name);
+  size_t order = 0;
+  while (order < sourceLength && source->name[sourceLength - 1 - order] == '\''){
+    order++;
+  }
+  if (order + 1 > REE_MAX_DERIVATIVE_ORDER){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Derivative of %s would exceed the maximum derivative order (%d).", source->name, REE_MAX_DERIVATIVE_ORDER);
+  }
+
+  if (sourceLength + 1 > MAX_DERIVED_NAME_LEN){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Name of the derivative of %s would be longer than %d chars.", source->name, MAX_DERIVED_NAME_LEN);
+  }
 
-  // check that the name exists in the function manager
-  for (functionPos = 0; functionPos < manager->functionCount; ++functionPos){
-    // if the name of the function on the ith position is the same as the provided name
-    if (strcmp(manager->functions[functionPos].name, name) == 0){
-      functionExists = true;
-      break;
+  struct ree_function_t *derivative = &manager->functions[manager->functionCount];
+  memcpy(derivative->name, source->name, sourceLength);
+  derivative->name[sourceLength] = '\'';
+  derivative->name[sourceLength + 1] = '\0';
+  if (ree_IsFunctionInManager(manager, derivative->name) == true){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function with the same name (%s) already exists!", derivative->name);
+  }
+  strcpy(derivative->parameter, source->parameter);
+
+  rma_InitArena(&derivative->arena, &manager->pool);
+  derivative->cached = nullptr;
+  enum reh_error_code_e err = ree_BuildDerivative(source, derivative, manager);
+  rma_ResetArena(&manager->scratch);
+
+  if (err == ERR_SUCCESS){
+    derivative->precision = source->precision;
+    derivative->mathMode = source->mathMode;
+    derivative->sampleCount = 0;
+    derivative->isVisible = true;
+    derivative->color = *functionColor;
+    err = ree_RegisterFunction(manager, source->handle);
+  }
+
+  if (err != ERR_SUCCESS){
+    // leave the position as clean as ree_RemoveFunction does
+    rma_ResetArena(&derivative->arena);
+    memset(derivative, 0, sizeof *derivative);
+  }
+  CHECK_ERROR_CTX(err, "Failed to add the derivative of %s.", name);
+
+  return ERR_SUCCESS;
+}
+
+// releases the bookkeeping of ree_RedefineFunction, the allocations that failed are nullptr
+static void ree_FreeRedefinition(struct ree_function_manager_t *manager, int *dirty, bool *isDirty, struct ree_function_t *previous, bool *rebuilt){
+  ree_ManagerFree(manager, dirty);
+  ree_ManagerFree(manager, isDirty);
+  ree_ManagerFree(manager, previous);
+  ree_ManagerFree(manager, rebuilt);
+}
+
+enum reh_error_code_e ree_RedefineFunction(struct ree_function_manager_t *manager, char *definition){
+  if (manager == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Manager passed to ree_RedefineFunction is NULL.");
+  }
+  else if (definition == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Definition passed to ree_RedefineFunction is NULL.");
+  }
+
+  struct ree_function_t redefined;
+  memset(&redefined, 0, sizeof redefined);
+  CHECK_ERROR_CTX(ree_ParseFunction(definition, &redefined, manager, &functionColorArray[0]), "Failed to parse function definition.");
+
+  // y = ... definitions aren't unique, so they can't be redefined by name
+  const struct ree_function_t *found = ree_IsIndexedName(redefined.name) ? ree_GetFunction(manager, redefined.name) : nullptr;
+  if (found == nullptr || found->source.generation != 0){
+    ree_ReleaseFunction(&redefined);
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function with name %s passed to ree_RedefineFunction wasn't found.", redefined.name);
+  }
+  const int target = (int)(found - manager->functions);
+
+  int *dirty = ree_ManagerAlloc(manager, (size_t)manager->functionCount * sizeof *dirty);
+  bool *isDirty = ree_ManagerAlloc(manager, (size_t)manager->functionCount * sizeof *isDirty);
+  if (dirty == nullptr || isDirty == nullptr){
+    ree_FreeRedefinition(manager, dirty, isDirty, nullptr, nullptr);
+    ree_ReleaseFunction(&redefined);
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the dependency list of %s.", redefined.name);
+  }
+  memset(isDirty, 0, (size_t)manager->functionCount * sizeof *isDirty);
+
+  // everything depending on the function, directly or through other functions, is rebuilt
+  // functions nothing refers to have no dependents, so only the referenced ones cost a scan
+  int dirtyCount = 0;
+  dirty[dirtyCount++] = target;
+  isDirty[target] = true;
+  for (int d = 0; d < dirtyCount; ++d){
+    const struct ree_function_t *changed = &manager->functions[dirty[d]];
+    if (changed->referenceCount == 0) continue;
+
+    for (int i = 0; i < manager->functionCount; ++i){
+      if (isDirty[i] == false && ree_DependsOn(&manager->functions[i], changed) == true){
+        isDirty[i] = true;
+        dirty[dirtyCount++] = i;
+      }
+    }
+  }
+
+  // calling any of them would close a cycle (the function calling itself is caught by the parser)
+  for (int d = 0; d < dirtyCount; ++d){
+    const char *dependent = manager->functions[dirty[d]].name;
+    if (ree_FunctionCalls(&redefined, dependent) == true){
+      ree_FreeRedefinition(manager, dirty, isDirty, nullptr, nullptr);
+      ree_ReleaseFunction(&redefined);
+      SET_ERROR_RETURN(ERR_INVALID_INPUT, "Redefining %s would make it call itself through %s.", redefined.name, dependent);
     }
   }
 
-  if (functionExists == false){
+  // the old versions stay intact until every rebuild succeeded, so a failure can restore them
+  struct ree_function_t *previous = ree_ManagerAlloc(manager, (size_t)dirtyCount * sizeof *previous);
+  bool *rebuilt = ree_ManagerAlloc(manager, (size_t)dirtyCount * sizeof *rebuilt);
+  if (previous == nullptr || rebuilt == nullptr){
+    ree_FreeRedefinition(manager, dirty, isDirty, previous, rebuilt);
+    ree_ReleaseFunction(&redefined);
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the backups of the functions depending on %s.", redefined.name);
+  }
+  memset(rebuilt, 0, (size_t)dirtyCount * sizeof *rebuilt);
+
+  previous[0] = manager->functions[target];
+  redefined.handle = previous[0].handle;
+  redefined.source = previous[0].source;
+  redefined.referenceCount = previous[0].referenceCount;
+  redefined.precision = previous[0].precision;
+  redefined.mathMode = previous[0].mathMode;
+  redefined.isVisible = previous[0].isVisible;
+  redefined.color = previous[0].color;
+  redefined.revision = previous[0].revision + 1;
+  manager->functions[target] = redefined;
+  rebuilt[0] = true;
+
+  // a dependent is rebuilt once everything it depends on is, the graph has no cycles so every round makes progress
+  enum reh_error_code_e err = ERR_SUCCESS;
+  int rebuiltCount = 0;
+  for (bool progress = true; progress == true && err == ERR_SUCCESS;){
+    progress = false;
+    for (int d = 1; d < dirtyCount && err == ERR_SUCCESS; ++d){
+      if (rebuilt[d] == true) continue;
+
+      struct ree_function_t *function = &manager->functions[dirty[d]];
+      bool ready = true;
+      for (int k = 0; k < dirtyCount && ready == true; ++k){
+        ready = !(rebuilt[k] == false && k != d && ree_DependsOn(function, &manager->functions[dirty[k]]) == true);
+      }
+      if (ready == false) continue;
+
+      previous[d] = *function;
+      err = ree_RebuildFunction(manager, function);
+      rma_ResetArena(&manager->scratch);
+      rebuilt[d] = true;
+      rebuiltCount++;
+      progress = true;
+    }
+  }
+
+  // the calls of the redefined function changed, move its references over before the old RPN is released
+  if (err == ERR_SUCCESS){
+    ree_CountReferences(manager, &previous[0], -1);
+    ree_CountReferences(manager, &manager->functions[target], 1);
+  }
+
+  for (int d = 0; d < dirtyCount; ++d){
+    if (rebuilt[d] == false) continue;
+
+    struct ree_function_t *discarded = (err == ERR_SUCCESS) ? &previous[d] : &manager->functions[dirty[d]];
+    ree_ReleaseFunction(discarded);
+    if (err != ERR_SUCCESS){
+      manager->functions[dirty[d]] = previous[d];
+    }
+  }
+  ree_FreeRedefinition(manager, dirty, isDirty, previous, rebuilt);
+  CHECK_ERROR_CTX(err, "Failed to rebuild the functions depending on %s, the redefinition was undone.", redefined.name);
+
+  rl_LogMsg(RL_DEBUG, "Redefined %s, %d dependent functions were rebuilt.", redefined.name, rebuiltCount);
+
+  return ERR_SUCCESS;
+}
+
+// removes the function at pos alone, the caller made sure nothing refers to it anymore (or goes with it)
+static void ree_RemoveFunctionAt(struct ree_function_manager_t *manager, int functionPos){
+  const struct ree_function_handle_t handle = manager->functions[functionPos].handle;
+
+  struct ree_function_t *function = &manager->functions[functionPos];
+  ree_CountReferences(manager, function, -1);
+  if (ree_IsIndexedName(function->name) == true){
+    ree_EraseName(manager, function->name);
+  }
+
+  // free the function data (RPN and bytecode) in one go, native code lives outside of the arena
+  ree_ReleaseFunction(function);
+
+  // the slot moves on to the next generation (never 0) and joins the free list
+  struct ree_function_slot_t *slot = &manager->slots[handle.slot];
+  if (++slot->generation == 0) slot->generation = 1;
+  slot->index = manager->freeSlot;
+  manager->freeSlot = handle.slot;
+
+  // move the last function into the hole (to not have holes in the arr)
+  const int last = --manager->functionCount;
+  if (functionPos != last){
+    manager->functions[functionPos] = manager->functions[last];
+    manager->slots[manager->functions[functionPos].handle.slot].index = (uint32_t)functionPos;
+  }
+
+  // clear the old data left in the last position
+  memset(&manager->functions[last], 0, sizeof manager->functions[last]);
+}
+
+enum reh_error_code_e ree_RemoveFunction(struct ree_function_manager_t *manager, const char *name){
+  if (manager == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Manager passed to ree_RemoveFunction is NULL.");
+  }
+  else if (name == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Name passed to ree_RemoveFunction is NULL.");
+  }
+
+  const struct ree_function_t *function = ree_GetFunction(manager, name);
+  if (function == nullptr){
     SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function with name %s passed to ree_RemoveFunction wasn't found.", name);
   }
 
-  // free the function data
-  free(manager->functions[functionPos].tokens);
-  free(manager->functions[functionPos].rpn);
+  // nothing refers to the function, it goes alone
+  if (function->referenceCount <= 0){
+    ree_RemoveFunctionAt(manager, (int)(function - manager->functions));
+    return ERR_SUCCESS;
+  }
+
+  // one pass collects the derivatives (they'd be left without a source, so they go with it) and the callers outside of them
+  const struct ree_function_handle_t handle = function->handle;
+  struct ree_function_handle_t *removed = ree_ManagerAlloc(manager, (size_t)manager->functionCount * sizeof *removed);
+  if (removed == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the removal list of %s.", name);
+  }
 
-  // move the functions that were after this removed one back (to not have holes in the arr)
-  memmove(&manager->functions[functionPos], &manager->functions[functionPos + 1], (long unsigned int)(manager->functionCount - functionPos - 1) * sizeof *manager->functions);
+  int removedCount = 0;
+  int callerCount = 0;
+  char callers[4 * (MAX_DERIVED_NAME_LEN + 2)] = "";
+  for (int i = 0; i < manager->functionCount; ++i){
+    const struct ree_function_t *other = &manager->functions[i];
+    if (ree_IsDerivedFrom(manager, other, handle) == true){
+      removed[removedCount++] = other->handle;
+    }
+    else if (ree_CallsDerivedFrom(manager, other, handle) == true){
+      // the first few callers are named, the rest only counted
+      const size_t length = strlen(callers);
+      if (callerCount < 3){
+        snprintf(callers + length, sizeof callers - length, "%s%s", callerCount > 0 ? ", " : "", other->name);
+      }
+      callerCount++;
+    }
+  }
 
-  manager->functionCount--;
+  if (callerCount > 0){
+    ree_ManagerFree(manager, removed);
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "%s is called by %s%s, remove or redefine %s first.", name, callers, callerCount > 3 ? " and others" : "", callerCount > 1 ? "them" : "it");
+  }
 
-  // clear the old data left in the last slot after moving the array
-  memset(&manager->functions[manager->functionCount], 0, sizeof manager->functions[manager->functionCount]);
+  // positions move with every removal, so the functions are found again by handle
+  for (int i = 0; i < removedCount; ++i){
+    ree_RemoveFunctionAt(manager, (int)manager->slots[removed[i].slot].index);
+  }
+  ree_ManagerFree(manager, removed);
 
   return ERR_SUCCESS;
 }
@@ -0,0 +1,304 @@
+#include "expressionEngine/evaluator.h"
+#include "core/errorHandler.h"
+#include "expressionEngine/batchKernels.h"
+#include "expressionEngine/compiler.h"
+#include "math/utility.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  Same block interpreter as ree_EvaluateBatchMode, except that every stack entry and temporary slot carries the status bytes
+  of its own lanes next to its values: a failure in one fused program must not mark the samples of the others.
+  An operator keeps the first failure of its operands (left one first), so every output gets the status its program
+  would have had on its own.
+  Most entries never see a failure, so the status bytes of an entry are only written once one of its lanes failed
+  (its failed flag is set), until then every lane of it counts as REE_EVAL_OK.
+*/
+
+// marks a lane of one entry as undefined, the first failure of a lane is the one reported
+static inline void ree_FailFusedLane(uint8_t *entryStatus, bool *entryFailed, float *a, size_t lane, size_t lanes, enum ree_eval_status_e status){
+  if (*entryFailed == false){
+    memset(entryStatus, REE_EVAL_OK, lanes);
+    *entryFailed = true;
+  }
+  if (entryStatus[lane] == REE_EVAL_OK){
+    entryStatus[lane] = (uint8_t)status;
+  }
+  a[lane] = NAN;
+}
+
+// statuses of a binary operator's result (in a), the left operand was evaluated first so its failure wins
+static inline void ree_MergeFusedStatus(uint8_t *a, bool *aFailed, const uint8_t *b, bool bFailed, size_t lanes){
+  if (bFailed == false) return;
+
+  if (*aFailed == false){
+    memcpy(a, b, lanes);
+    *aFailed = true;
+    return;
+  }
+  for (size_t i = 0; i < lanes; ++i){
+    a[i] = (a[i] != REE_EVAL_OK) ? a[i] : b[i];
+  }
+}
+
+enum reh_error_code_e ree_EvaluateFusedBatch(const struct ree_fused_program_t *fused, enum ree_math_mode_e mode, const float *xs, size_t count, float *ys, uint8_t *status, size_t outputStride){
+  if (fused == nullptr || fused->program.code == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Fused program provided to ree_EvaluateFusedBatch is NULL.");
+  }
+  else if (xs == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "xs array provided to ree_EvaluateFusedBatch is NULL.");
+  }
+  else if (ys == nullptr || status == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Output arrays provided to ree_EvaluateFusedBatch are NULL.");
+  }
+  else if (outputStride < count){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Output stride passed to ree_EvaluateFusedBatch (%zu) is smaller than the sample count (%zu).", outputStride, count);
+  }
+
+  const struct ree_program_t *program = &fused->program;
+  if (program->maxStackDepth <= 0 || program->maxStackDepth > REE_MAX_STACK_DEPTH || program->maxStackDepth < fused->outputCount){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Fused program provided to ree_EvaluateFusedBatch has an invalid stack depth (%d).", program->maxStackDepth);
+  }
+  if (count == 0){
+    return ERR_SUCCESS;
+  }
+
+  const struct ree_batch_kernels_t *kernels = ree_GetBatchKernels();
+  const struct ree_math_kernels_t *math = ree_GetMathKernels(mode);
+
+  // one block of lanes per stack entry and per temporary slot, values first, then the status bytes and failed flags of the same entries
+  const size_t entryCount = (size_t)(program->maxStackDepth + program->tempCount);
+  float *stack = malloc(entryCount * (REE_BATCH_LANES * (sizeof(float) + sizeof(uint8_t)) + sizeof(bool)));
+  if (stack == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the block stack in ree_EvaluateFusedBatch.");
+  }
+  float *temps = stack + (size_t)program->maxStackDepth * REE_BATCH_LANES;
+  uint8_t *stackStatus = (uint8_t *)(stack + entryCount * REE_BATCH_LANES);
+  uint8_t *tempStatus = stackStatus + (size_t)program->maxStackDepth * REE_BATCH_LANES;
+  bool *stackFailed = (bool *)(stackStatus + entryCount * REE_BATCH_LANES);
+  bool *tempFailed = stackFailed + program->maxStackDepth;
+
+  const uint8_t *end = program->code + program->codeSize;
+
+  for (size_t base = 0; base < count; base += REE_BATCH_LANES){
+    const size_t lanes = (count - base < REE_BATCH_LANES) ? count - base : REE_BATCH_LANES;
+
+    size_t stackIndex = 0;
+    const uint8_t *code = program->code;
+
+    while (code < end){
+      // top of the stack (a) with its status bytes and failed flag, b is the top for binary operators
+      float *a = (stackIndex >= 1) ? &stack[(stackIndex - 1) * REE_BATCH_LANES] : nullptr;
+      uint8_t *aStatus = (stackIndex >= 1) ? &stackStatus[(stackIndex - 1) * REE_BATCH_LANES] : nullptr;
+      bool *aFailed = (stackIndex >= 1) ? &stackFailed[stackIndex - 1] : nullptr;
+
+      switch ((enum ree_opcode_e)*code++){
+        case OP_CONST: {
+          float value;
+          memcpy(&value, code, sizeof(float));
+          code += sizeof(float);
+          float *block = &stack[stackIndex * REE_BATCH_LANES];
+          for (size_t i = 0; i < lanes; ++i) block[i] = value;
+          stackFailed[stackIndex++] = false;
+          break;
+        }
+        case OP_VAR: {
+          // only the function parameter (slot 0) is bound in batch mode
+          if (*code++ != 0){
+            free(stack);
+            SET_ERROR_RETURN(ERR_INVALID_INPUT, "ree_EvaluateFusedBatch only binds variable slot 0, program references slot %u.", code[-1]);
+          }
+          memcpy(&stack[stackIndex * REE_BATCH_LANES], xs + base, lanes * sizeof(float));
+          stackFailed[stackIndex++] = false;
+          break;
+        }
+        case OP_STORE: {
+          const uint8_t slot = *code++;
+          memcpy(&temps[slot * REE_BATCH_LANES], a, lanes * sizeof(float));
+          tempFailed[slot] = *aFailed;
+          if (*aFailed) memcpy(&tempStatus[slot * REE_BATCH_LANES], aStatus, lanes);
+          break;
+        }
+        case OP_LOAD: {
+          const uint8_t slot = *code++;
+          memcpy(&stack[stackIndex * REE_BATCH_LANES], &temps[slot * REE_BATCH_LANES], lanes * sizeof(float));
+          stackFailed[stackIndex] = tempFailed[slot];
+          if (tempFailed[slot]) memcpy(&stackStatus[stackIndex * REE_BATCH_LANES], &tempStatus[slot * REE_BATCH_LANES], lanes);
+          stackIndex++;
+          break;
+        }
+        case OP_PARAM: {
+          // read once per block, the same value for every lane like a constant
+          const float value = program->parameters[*code++];
+          float *block = &stack[stackIndex * REE_BATCH_LANES];
+          for (size_t i = 0; i < lanes; ++i) block[i] = value;
+          stackFailed[stackIndex++] = false;
+          break;
+        }
+
+        /*
+          #############
+          # OPERATORS #
+          #############
+        */
+        case OP_ADD: {
+          stackIndex--;
+          a = &stack[(stackIndex - 1) * REE_BATCH_LANES];
+          aStatus = &stackStatus[(stackIndex - 1) * REE_BATCH_LANES];
+          aFailed = &stackFailed[stackIndex - 1];
+          kernels->add(a, &stack[stackIndex * REE_BATCH_LANES], lanes);
+          ree_MergeFusedStatus(aStatus, aFailed, &stackStatus[stackIndex * REE_BATCH_LANES], stackFailed[stackIndex], lanes);
+          break;
+        }
+        case OP_SUB: {
+          stackIndex--;
+          a = &stack[(stackIndex - 1) * REE_BATCH_LANES];
+          aStatus = &stackStatus[(stackIndex - 1) * REE_BATCH_LANES];
+          aFailed = &stackFailed[stackIndex - 1];
+          kernels->sub(a, &stack[stackIndex * REE_BATCH_LANES], lanes);
+          ree_MergeFusedStatus(aStatus, aFailed, &stackStatus[stackIndex * REE_BATCH_LANES], stackFailed[stackIndex], lanes);
+          break;
+        }
+        case OP_MUL: {
+          stackIndex--;
+          a = &stack[(stackIndex - 1) * REE_BATCH_LANES];
+          aStatus = &stackStatus[(stackIndex - 1) * REE_BATCH_LANES];
+          aFailed = &stackFailed[stackIndex - 1];
+          kernels->mul(a, &stack[stackIndex * REE_BATCH_LANES], lanes);
+          ree_MergeFusedStatus(aStatus, aFailed, &stackStatus[stackIndex * REE_BATCH_LANES], stackFailed[stackIndex], lanes);
+          break;
+        }
+        case OP_DIV: {
+          stackIndex--;
+          a = &stack[(stackIndex - 1) * REE_BATCH_LANES];
+          aStatus = &stackStatus[(stackIndex - 1) * REE_BATCH_LANES];
+          aFailed = &stackFailed[stackIndex - 1];
+          const float *b = &stack[stackIndex * REE_BATCH_LANES];
+          kernels->div(a, b, lanes);
+          ree_MergeFusedStatus(aStatus, aFailed, &stackStatus[stackIndex * REE_BATCH_LANES], stackFailed[stackIndex], lanes);
+          for (size_t i = 0; i < lanes; ++i){
+            if (fabsf(b[i]) < FLT_EPSILON){
+              ree_FailFusedLane(aStatus, aFailed, a, i, lanes, REE_EVAL_DIVISION_BY_ZERO);
+            }
+          }
+          break;
+        }
+        case OP_POW: {
+          stackIndex--;
+          a = &stack[(stackIndex - 1) * REE_BATCH_LANES];
+          aStatus = &stackStatus[(stackIndex - 1) * REE_BATCH_LANES];
+          aFailed = &stackFailed[stackIndex - 1];
+          math->pow(a, &stack[stackIndex * REE_BATCH_LANES], lanes);
+          ree_MergeFusedStatus(aStatus, aFailed, &stackStatus[stackIndex * REE_BATCH_LANES], stackFailed[stackIndex], lanes);
+          break;
+        }
+        case OP_FACT: {
+          for (size_t i = 0; i < lanes; ++i){
+            // same checks as the batch interpreter, all of them before the conversion to int
+            const float rounded = roundf(a[i]);
+            int localResult = 0;
+            if (!(fabsf(a[i] - rounded) < FLT_EPSILON) || !(rounded >= 0.0f && rounded <= REE_MAX_FACTORIAL_FLOAT) || rm_Factorial((int)rounded, &localResult) != ERR_SUCCESS){
+              ree_FailFusedLane(aStatus, aFailed, a, i, lanes, REE_EVAL_FACTORIAL_DOMAIN);
+              continue;
+            }
+            a[i] = (float)localResult;
+          }
+          break;
+        }
+        case OP_NEG: {
+          kernels->neg(a, lanes);
+          break;
+        }
+        case OP_POS: {
+          break;
+        }
+
+        /*
+          #############
+          # FUNCTIONS #
+          #############
+        */
+        case OP_SIN: {
+          math->sin(a, lanes);
+          break;
+        }
+        case OP_COS: {
+          math->cos(a, lanes);
+          break;
+        }
+        case OP_TAN: {
+          uint8_t poles[REE_BATCH_LANES];
+          math->tan(a, poles, lanes);
+          for (size_t i = 0; i < lanes; ++i){
+            if (poles[i]){
+              ree_FailFusedLane(aStatus, aFailed, a, i, lanes, REE_EVAL_TAN_DOMAIN);
+            }
+          }
+          break;
+        }
+        case OP_SQRT: {
+          for (size_t i = 0; i < lanes; ++i){
+            if (a[i] < 0){
+              ree_FailFusedLane(aStatus, aFailed, a, i, lanes, REE_EVAL_SQRT_DOMAIN);
+            }
+          }
+          kernels->sqrt(a, lanes);
+          break;
+        }
+        case OP_ABS: {
+          kernels->abs(a, lanes);
+          break;
+        }
+        case OP_LN: {
+          for (size_t i = 0; i < lanes; ++i){
+            if (a[i] <= 0){
+              ree_FailFusedLane(aStatus, aFailed, a, i, lanes, REE_EVAL_LN_DOMAIN);
+            }
+          }
+          math->ln(a, lanes);
+          break;
+        }
+        case OP_LOG: {
+          for (size_t i = 0; i < lanes; ++i){
+            if (a[i] <= 0){
+              ree_FailFusedLane(aStatus, aFailed, a, i, lanes, REE_EVAL_LOG_DOMAIN);
+            }
+          }
+          math->log10(a, lanes);
+          break;
+        }
+
+        /*
+          ##################
+          # UNKNOWN OPCODE #
+          ##################
+        */
+        default:
+          free(stack);
+          SET_ERROR_RETURN(ERR_INVALID_OPERATOR, "Provided opcode (%u) is unknown.", code[-1]);
+      }
+    }
+
+    // the result of every fused program is left on the stack in order
+    for (int output = 0; output < fused->outputCount; ++output){
+      float *outputYs = ys + (size_t)output * outputStride + base;
+      uint8_t *outputStatus = status + (size_t)output * outputStride + base;
+      memcpy(outputYs, &stack[(size_t)output * REE_BATCH_LANES], lanes * sizeof(float));
+      if (stackFailed[output] == false){
+        memset(outputStatus, REE_EVAL_OK, lanes);
+        continue;
+      }
+      // failed lanes are NaN, like in ree_EvaluateBatchMode
+      memcpy(outputStatus, &stackStatus[(size_t)output * REE_BATCH_LANES], lanes);
+      for (size_t i = 0; i < lanes; ++i){
+        if (outputStatus[i] != REE_EVAL_OK) outputYs[i] = NAN;
+      }
+    }
+  }
+
+  free(stack);
+  return ERR_SUCCESS;
+}
@@ -0,0 +1,146 @@
+#include "expressionEngine/inliner.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+#include "expressionEngine/parser/shuntingYard.h"
+#include "expressionEngine/tokens.h"
+#include <string.h>
+
+// what a callee contributes to the size of an inlined call
+struct ree_callee_shape_t {
+  int parameterUses;               /**< Tokens of the body that are replaced by the argument */
+  int otherTokens;                 /**< Tokens of the body that are copied as they are */
+};
+
+bool ree_IsCallToken(const struct ree_output_token_t *token){
+  return token->type == OUTPUT_FUNCTION && token->symbol >= SYMBOL_COUNT;
+}
+
+static int ree_FindCallee(const struct ree_inline_callee_t *callees, int calleeCount, uint16_t symbol){
+  for (int c = 0; c < calleeCount; ++c){
+    if (callees[c].symbol == symbol) return c;
+  }
+  return -1;
+}
+
+enum reh_error_code_e ree_InlineRpn(struct rma_arena_t *scratch, struct rma_arena_t *arena, const struct ree_output_token_t *rpn, int rpnCount, const struct ree_inline_callee_t *callees, int calleeCount, struct ree_output_token_t **inlined, int *inlinedCount){
+  if (scratch == nullptr || arena == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Arena passed to ree_InlineRpn is NULL.");
+  }
+  else if (rpn == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "RPN passed to ree_InlineRpn is NULL.");
+  }
+  else if (callees == nullptr && calleeCount > 0){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Callees passed to ree_InlineRpn are NULL.");
+  }
+  else if (inlined == nullptr || inlinedCount == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Output pointers passed to ree_InlineRpn are NULL.");
+  }
+  else if (rpnCount <= 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "rpnCount passed to ree_InlineRpn is less than or equal to 0.");
+  }
+
+  struct ree_callee_shape_t *shapes = rma_Alloc(scratch, (size_t)(calleeCount > 0 ? calleeCount : 1) * sizeof *shapes);
+  int *sizes = rma_Alloc(scratch, (size_t)rpnCount * sizeof *sizes);
+  int *calleeOf = rma_Alloc(scratch, (size_t)rpnCount * sizeof *calleeOf);
+  if (shapes == nullptr || sizes == nullptr || calleeOf == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the inliner state.");
+  }
+
+  for (int c = 0; c < calleeCount; ++c){
+    shapes[c] = (struct ree_callee_shape_t){0, 0};
+    for (int t = 0; t < callees[c].rpnCount; ++t){
+      const struct ree_output_token_t *token = &callees[c].rpn[t];
+      if (ree_IsCallToken(token)){
+        SET_ERROR_RETURN(ERR_INVALID_INPUT, "Body of %s still calls %s, callees must be inlined first.", ree_SymbolToStr(callees[c].symbol), ree_SymbolToStr(token->symbol));
+      }
+      if (token->type == OUTPUT_VARIABLE && token->symbol == callees[c].parameter) shapes[c].parameterUses++;
+      else shapes[c].otherTokens++;
+    }
+  }
+
+  // first pass sizes every subtree after inlining, so the output is allocated exactly once
+  // sizes saturate at REE_MAX_INLINED_RPN + 1, nested calls grow them multiplicatively
+  int depth = 0;
+  for (int i = 0; i < rpnCount; ++i){
+    const struct ree_output_token_t *token = &rpn[i];
+    int arity = ree_IsCallToken(token) ? 1 : token->arity;
+    if (depth < arity){
+      SET_ERROR_RETURN(ERR_INVALID_INPUT, "%s is missing operands.", ree_SymbolToStr(token->symbol));
+    }
+
+    long long size = 1;
+    if (ree_IsCallToken(token)){
+      calleeOf[i] = ree_FindCallee(callees, calleeCount, token->symbol);
+      if (calleeOf[i] < 0){
+        SET_ERROR_RETURN(ERR_INVALID_INPUT, "Call of undefined function %s.", ree_SymbolToStr(token->symbol));
+      }
+      const struct ree_callee_shape_t *shape = &shapes[calleeOf[i]];
+      size = shape->otherTokens + (long long)shape->parameterUses * sizes[--depth];
+    }
+    else {
+      for (int a = 0; a < arity; ++a){
+        size += sizes[--depth];
+      }
+    }
+
+    sizes[depth++] = (size > REE_MAX_INLINED_RPN) ? REE_MAX_INLINED_RPN + 1 : (int)size;
+  }
+
+  long long total = 0;
+  for (int d = 0; d < depth; ++d){
+    total += sizes[d];
+  }
+  if (total > REE_MAX_INLINED_RPN){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Inlined definition expands to more than %d RPN tokens.", REE_MAX_INLINED_RPN);
+  }
+
+  struct ree_output_token_t *out = rma_Alloc(arena, (size_t)total * sizeof *out);
+  if (out == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the inlined RPN.");
+  }
+
+  // second pass writes the tokens, the stack holds where every pending operand starts in the output
+  int *starts = sizes;
+  int outCount = 0;
+  depth = 0;
+  for (int i = 0; i < rpnCount; ++i){
+    const struct ree_output_token_t *token = &rpn[i];
+
+    if (ree_IsCallToken(token)){
+      const struct ree_inline_callee_t *callee = &callees[calleeOf[i]];
+
+      // the argument is already in the output, move it aside and write the body over it
+      const int argumentStart = starts[depth - 1];
+      const int argumentCount = outCount - argumentStart;
+      struct ree_output_token_t *argument = rma_Alloc(scratch, (size_t)argumentCount * sizeof *argument);
+      if (argument == nullptr){
+        SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the argument of %s.", ree_SymbolToStr(callee->symbol));
+      }
+      memcpy(argument, &out[argumentStart], (size_t)argumentCount * sizeof *argument);
+
+      outCount = argumentStart;
+      for (int t = 0; t < callee->rpnCount; ++t){
+        const struct ree_output_token_t *bodyToken = &callee->rpn[t];
+        if (bodyToken->type == OUTPUT_VARIABLE && bodyToken->symbol == callee->parameter){
+          memcpy(&out[outCount], argument, (size_t)argumentCount * sizeof *argument);
+          outCount += argumentCount;
+        }
+        else {
+          out[outCount++] = *bodyToken;
+        }
+      }
+      // the call still occupies the argument's place on the stack
+      continue;
+    }
+
+    depth -= token->arity;
+    int start = (token->arity > 0) ? starts[depth] : outCount;
+    out[outCount++] = *token;
+    starts[depth++] = start;
+  }
+
+  *inlined = out;
+  *inlinedCount = outCount;
+
+  return ERR_SUCCESS;
+}
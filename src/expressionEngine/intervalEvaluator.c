@@ -0,0 +1,182 @@
+#include "expressionEngine/evaluator.h"
+#include "core/errorHandler.h"
+#include "expressionEngine/compiler.h"
+#include "math/interval.h"
+#include "math/utility.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+// the compiler guarantees every instruction finds its operands, pops aren't checked
+#define POP_2_INTERVALS()               \
+    b = stack[--stackIndex];            \
+    a = stack[--stackIndex];
+
+#define POP_1_INTERVAL()                \
+    a = stack[--stackIndex];
+
+// checks whether an interval reaches into the (-FLT_EPSILON, FLT_EPSILON) band the evaluators treat as zero
+static bool ree_IntervalNearZero(struct rm_interval_t a){
+  return a.lo < (double)FLT_EPSILON && a.hi > -(double)FLT_EPSILON;
+}
+
+// checks whether every value of an interval stays finite in float, the lowest precision tier
+static bool ree_IntervalFitsFloat(struct rm_interval_t a){
+  return a.lo >= -(double)FLT_MAX && a.hi <= (double)FLT_MAX;
+}
+
+static bool ree_IntervalIsInteger(struct rm_interval_t a){
+  return rm_IsEqual(a.lo, a.hi) && rm_IsEqual(a.lo, nearbyint(a.lo));
+}
+
+/*
+  Factorial of the non-negative integers inside a, the exact value if a is a single integer the float tier handles.
+  Anything else hits a domain failure for some x, flagged by the caller.
+*/
+static struct rm_interval_t ree_IntervalFactorial(struct rm_interval_t a, bool *mayBeUndefined){
+  double first = ceil(fmax(a.lo, 0.0));
+  double last = floor(fmin(a.hi, REE_MAX_FACTORIAL_FLOAT));
+  if (!ree_IntervalIsInteger(a) || a.lo < 0 || a.hi > REE_MAX_FACTORIAL_FLOAT){
+    *mayBeUndefined = true;
+  }
+  if (first > last){
+    return rm_IntervalEntire();
+  }
+
+  // factorial is increasing on the non-negative integers
+  double low = 1.0;
+  for (int i = 2; i <= (int)first; ++i) low *= i;
+  double high = low;
+  for (int i = (int)first + 1; i <= (int)last; ++i) high *= i;
+
+  return (struct rm_interval_t){low, high};
+}
+
+enum reh_error_code_e ree_EvaluateInterval(const struct ree_program_t *program, struct rm_interval_t x, struct rm_interval_t *result, bool *mayBeUndefined){
+  if (program == nullptr || program->code == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Program provided to ree_EvaluateInterval is NULL.");
+  }
+  else if (result == nullptr || mayBeUndefined == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Output pointers provided to ree_EvaluateInterval are NULL.");
+  }
+  if (program->maxStackDepth <= 0 || program->maxStackDepth > REE_MAX_STACK_DEPTH){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Program provided to ree_EvaluateInterval has an invalid stack depth (%d).", program->maxStackDepth);
+  }
+
+  struct rm_interval_t stack[REE_MAX_STACK_DEPTH];
+  size_t stackIndex = 0;
+  struct rm_interval_t temps[REE_MAX_TEMP_SLOTS];
+  struct rm_interval_t a, b;
+  bool undefined = false;
+
+  const uint8_t *code = program->code;
+  const uint8_t *end = program->code + program->codeSize;
+
+  while (code < end){
+    switch ((enum ree_opcode_e)*code++){
+      case OP_CONST: {
+        float value;
+        memcpy(&value, code, sizeof(float));
+        code += sizeof(float);
+        stack[stackIndex++] = (struct rm_interval_t){(double)value, (double)value};
+        break;
+      }
+      case OP_VAR: {
+        // only the function parameter (slot 0) is bound, same as ree_EvaluateBatch
+        if (*code++ != 0){
+          SET_ERROR_RETURN(ERR_INVALID_INPUT, "ree_EvaluateInterval only binds variable slot 0, program references slot %u.", code[-1]);
+        }
+        stack[stackIndex++] = x;
+        break;
+      }
+      case OP_STORE: {
+        temps[*code++] = stack[stackIndex - 1];
+        break;
+      }
+      case OP_LOAD: {
+        stack[stackIndex++] = temps[*code++];
+        break;
+      }
+      case OP_PARAM: {
+        const double value = (double)program->parameters[*code++];
+        stack[stackIndex++] = (struct rm_interval_t){value, value};
+        break;
+      }
+
+      /*
+        #############
+        # OPERATORS #
+        #############
+      */
+      case OP_ADD: POP_2_INTERVALS(); stack[stackIndex++] = rm_IntervalAdd(a, b); break;
+      case OP_SUB: POP_2_INTERVALS(); stack[stackIndex++] = rm_IntervalSub(a, b); break;
+      case OP_MUL: POP_2_INTERVALS(); stack[stackIndex++] = rm_IntervalMul(a, b); break;
+      case OP_DIV: {
+        POP_2_INTERVALS();
+        if (ree_IntervalNearZero(b)) undefined = true;
+        stack[stackIndex++] = rm_IntervalDiv(a, b);
+        break;
+      }
+      case OP_POW: {
+        POP_2_INTERVALS();
+        // negative bases give NaN for non-integer exponents, 0 gives infinity for negative ones
+        if ((a.lo < 0 && !ree_IntervalIsInteger(b)) || (rm_IntervalContains(a, 0.0) && b.lo < 0)) undefined = true;
+        stack[stackIndex++] = rm_IntervalPow(a, b);
+        break;
+      }
+      case OP_FACT: POP_1_INTERVAL(); stack[stackIndex++] = ree_IntervalFactorial(a, &undefined); break;
+      case OP_NEG:  POP_1_INTERVAL(); stack[stackIndex++] = rm_IntervalNeg(a); break;
+      case OP_POS:  break;
+
+      /*
+        #############
+        # FUNCTIONS #
+        #############
+      */
+      case OP_SIN: POP_1_INTERVAL(); stack[stackIndex++] = rm_IntervalSin(a); break;
+      case OP_COS: POP_1_INTERVAL(); stack[stackIndex++] = rm_IntervalCos(a); break;
+      case OP_TAN: {
+        POP_1_INTERVAL();
+        if (ree_IntervalNearZero(rm_IntervalCos(a))) undefined = true;
+        stack[stackIndex++] = rm_IntervalTan(a);
+        break;
+      }
+      case OP_SQRT: {
+        POP_1_INTERVAL();
+        if (a.lo < 0) undefined = true;
+        stack[stackIndex++] = rm_IntervalSqrt(a);
+        break;
+      }
+      case OP_ABS: POP_1_INTERVAL(); stack[stackIndex++] = rm_IntervalAbs(a); break;
+      case OP_LN: {
+        POP_1_INTERVAL();
+        if (a.lo <= 0) undefined = true;
+        stack[stackIndex++] = rm_IntervalLn(a);
+        break;
+      }
+      case OP_LOG: {
+        POP_1_INTERVAL();
+        if (a.lo <= 0) undefined = true;
+        stack[stackIndex++] = rm_IntervalLog10(a);
+        break;
+      }
+
+      /*
+        ##################
+        # UNKNOWN OPCODE #
+        ##################
+      */
+      default:
+        SET_ERROR_RETURN(ERR_INVALID_OPERATOR, "Provided opcode (%u) is unknown.", code[-1]);
+    }
+
+    // an unbounded intermediate means a pole or an overflow somewhere in x, the sample there isn't finite
+    if (stackIndex > 0 && !ree_IntervalFitsFloat(stack[stackIndex - 1])) undefined = true;
+  }
+
+  *result = stack[0];
+  *mayBeUndefined = undefined;
+
+  return ERR_SUCCESS;
+}
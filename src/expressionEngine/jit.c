@@ -0,0 +1,510 @@
+// MAP_ANONYMOUS isn't part of strict ISO C, ask glibc for the default feature set before any include
+#define _DEFAULT_SOURCE
+
+#include "expressionEngine/jit.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+#include "expressionEngine/compiler.h"
+#include "expressionEngine/evaluator.h"
+#include "math/utility.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if REE_JIT_AVAILABLE
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+bool ree_JitIsSupported(void){
+  return REE_JIT_AVAILABLE;
+}
+
+void ree_JitFree(struct ree_program_t *program){
+  if (program == nullptr || program->jit == nullptr) return;
+
+#if REE_JIT_AVAILABLE
+  munmap(program->jit->code, program->jit->mappedSize);
+#endif
+  free(program->jit);
+  program->jit = nullptr;
+}
+
+enum reh_error_code_e ree_EvaluateJit(const struct ree_jit_program_t *jit, const float *xs, size_t count, float *ys, uint8_t *status){
+  if (jit == nullptr || jit->fn == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Native code provided to ree_EvaluateJit is NULL.");
+  }
+  else if (xs == nullptr || ys == nullptr || status == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Sample arrays provided to ree_EvaluateJit are NULL.");
+  }
+
+  size_t groupCount = count / REE_JIT_LANES;
+  jit->fn(xs, ys, status, groupCount);
+
+  // the emitted code only handles full groups, pad the tail into one more
+  size_t done = groupCount * REE_JIT_LANES;
+  if (done < count){
+    float tailXs[REE_JIT_LANES] = {0};
+    float tailYs[REE_JIT_LANES];
+    uint8_t tailStatus[REE_JIT_LANES];
+
+    memcpy(tailXs, xs + done, (count - done) * sizeof(float));
+    jit->fn(tailXs, tailYs, tailStatus, 1);
+    memcpy(ys + done, tailYs, (count - done) * sizeof(float));
+    memcpy(status + done, tailStatus, count - done);
+  }
+
+  // failed lanes are NaN like in ree_EvaluateBatchMode, even if a later instruction turned them back into a number
+  for (size_t i = 0; i < count; ++i){
+    if (status[i] != REE_EVAL_OK) ys[i] = NAN;
+  }
+
+  return ERR_SUCCESS;
+}
+
+#if REE_JIT_AVAILABLE
+
+/*
+  ###########
+  # HELPERS #
+  ###########
+
+  Operators that can fail or need transcendental kernels are called out of the emitted code, one group of lanes at a time.
+  They follow the batch evaluator lane for lane with the math kernels the program was compiled for,
+  so both paths give bit-identical results.
+*/
+typedef void (*ree_jit_helper_t)(float *a, const float *b, uint8_t *status, const struct ree_math_kernels_t *math);
+
+static inline void ree_JitFailLane(uint8_t *status, float *a, int lane, enum ree_eval_status_e failure){
+  if (status[lane] == REE_EVAL_OK){
+    status[lane] = (uint8_t)failure;
+  }
+  a[lane] = NAN;
+}
+
+static void ree_JitDiv(float *a, const float *b, uint8_t *status, const struct ree_math_kernels_t *math){
+  (void)math;
+  for (int i = 0; i < REE_JIT_LANES; ++i){
+    a[i] = a[i] / b[i];
+    if (fabsf(b[i]) < FLT_EPSILON) ree_JitFailLane(status, a, i, REE_EVAL_DIVISION_BY_ZERO);
+  }
+}
+
+static void ree_JitPow(float *a, const float *b, uint8_t *status, const struct ree_math_kernels_t *math){
+  (void)status;
+  math->pow(a, b, REE_JIT_LANES);
+}
+
+static void ree_JitFact(float *a, const float *b, uint8_t *status, const struct ree_math_kernels_t *math){
+  (void)b; (void)math;
+  for (int i = 0; i < REE_JIT_LANES; ++i){
+    // same checks as the batch interpreter, all of them before the conversion to int
+    const float rounded = roundf(a[i]);
+    int localResult = 0;
+    if (!(fabsf(a[i] - rounded) < FLT_EPSILON) || !(rounded >= 0.0f && rounded <= REE_MAX_FACTORIAL_FLOAT) || rm_Factorial((int)rounded, &localResult) != ERR_SUCCESS){
+      ree_JitFailLane(status, a, i, REE_EVAL_FACTORIAL_DOMAIN);
+      continue;
+    }
+    a[i] = (float)localResult;
+  }
+}
+
+static void ree_JitSin(float *a, const float *b, uint8_t *status, const struct ree_math_kernels_t *math){
+  (void)b; (void)status;
+  math->sin(a, REE_JIT_LANES);
+}
+
+static void ree_JitCos(float *a, const float *b, uint8_t *status, const struct ree_math_kernels_t *math){
+  (void)b; (void)status;
+  math->cos(a, REE_JIT_LANES);
+}
+
+static void ree_JitTan(float *a, const float *b, uint8_t *status, const struct ree_math_kernels_t *math){
+  (void)b;
+  uint8_t poles[REE_JIT_LANES];
+  math->tan(a, poles, REE_JIT_LANES);
+  for (int i = 0; i < REE_JIT_LANES; ++i){
+    if (poles[i]) ree_JitFailLane(status, a, i, REE_EVAL_TAN_DOMAIN);
+  }
+}
+
+static void ree_JitSqrt(float *a, const float *b, uint8_t *status, const struct ree_math_kernels_t *math){
+  (void)b; (void)math;
+  for (int i = 0; i < REE_JIT_LANES; ++i){
+    if (a[i] < 0){
+      ree_JitFailLane(status, a, i, REE_EVAL_SQRT_DOMAIN);
+    }
+  }
+  for (int i = 0; i < REE_JIT_LANES; ++i) a[i] = sqrtf(a[i]);
+}
+
+static void ree_JitLn(float *a, const float *b, uint8_t *status, const struct ree_math_kernels_t *math){
+  (void)b;
+  for (int i = 0; i < REE_JIT_LANES; ++i){
+    if (a[i] <= 0){
+      ree_JitFailLane(status, a, i, REE_EVAL_LN_DOMAIN);
+    }
+  }
+  math->ln(a, REE_JIT_LANES);
+}
+
+static void ree_JitLog(float *a, const float *b, uint8_t *status, const struct ree_math_kernels_t *math){
+  (void)b;
+  for (int i = 0; i < REE_JIT_LANES; ++i){
+    if (a[i] <= 0){
+      ree_JitFailLane(status, a, i, REE_EVAL_LOG_DOMAIN);
+    }
+  }
+  math->log10(a, REE_JIT_LANES);
+}
+
+/*
+  ###########
+  # EMITTER #
+  ###########
+
+  Register usage of the emitted function (System V):
+    rbx = xs, r12 = ys, r13 = status, r14 = groups left (all callee-saved, so they survive helper calls)
+    every evaluation stack entry and temporary slot holds REE_JIT_LANES floats (REE_JIT_VECTORS registers) on the machine stack
+    xmm0 / xmm1 are scratch registers, nothing is kept in registers across instructions
+*/
+struct ree_jit_emitter_t {
+  uint8_t *code;    /**< Staging buffer, copied into the executable mapping at the end */
+  size_t size;      /**< Bytes emitted so far */
+  size_t capacity;  /**< Size of the staging buffer */
+  bool overflow;    /**< Set if the staging buffer was too small */
+};
+
+// SSE opcodes (second byte after 0x0F)
+enum ree_sse_opcode_e {
+  SSE_MOVUPS_LOAD  = 0x10,
+  SSE_MOVUPS_STORE = 0x11,
+  SSE_MOVAPS_LOAD  = 0x28,
+  SSE_MOVAPS_STORE = 0x29,
+  SSE_ANDPS        = 0x54,
+  SSE_XORPS        = 0x57,
+  SSE_ADDPS        = 0x58,
+  SSE_MULPS        = 0x59,
+  SSE_SUBPS        = 0x5C,
+};
+
+static void ree_JitEmitBytes(struct ree_jit_emitter_t *emitter, const uint8_t *bytes, size_t count){
+  if (emitter->size + count > emitter->capacity){
+    emitter->overflow = true;
+    return;
+  }
+  memcpy(emitter->code + emitter->size, bytes, count);
+  emitter->size += count;
+}
+
+#define EMIT(...)                                                                       \
+  do {                                                                                  \
+    const uint8_t _bytes[] = {__VA_ARGS__};                                             \
+    ree_JitEmitBytes(emitter, _bytes, sizeof(_bytes));                                  \
+  } while(0)
+
+static void ree_JitEmitU32(struct ree_jit_emitter_t *emitter, uint32_t value){
+  uint8_t bytes[4];
+  memcpy(bytes, &value, sizeof(bytes));
+  ree_JitEmitBytes(emitter, bytes, sizeof(bytes));
+}
+
+static void ree_JitEmitU64(struct ree_jit_emitter_t *emitter, uint64_t value){
+  uint8_t bytes[8];
+  memcpy(bytes, &value, sizeof(bytes));
+  ree_JitEmitBytes(emitter, bytes, sizeof(bytes));
+}
+
+// <op>ps xmm, [rsp + disp32] (or the store form [rsp + disp32], xmm)
+static void ree_JitEmitSseSlot(struct ree_jit_emitter_t *emitter, enum ree_sse_opcode_e opcode, int xmm, int32_t disp){
+  EMIT(0x0F, (uint8_t)opcode, (uint8_t)(0x84 | (xmm << 3)), 0x24);
+  ree_JitEmitU32(emitter, (uint32_t)disp);
+}
+
+// xmm = {bits, bits, bits, bits}
+static void ree_JitEmitBroadcast(struct ree_jit_emitter_t *emitter, int xmm, uint32_t bits){
+  EMIT(0xB8);                                                     // mov eax, imm32
+  ree_JitEmitU32(emitter, bits);
+  EMIT(0x66, 0x0F, 0x6E, (uint8_t)(0xC0 | (xmm << 3)));           // movd xmm, eax
+  EMIT(0x0F, 0xC6, (uint8_t)(0xC0 | (xmm << 3) | xmm), 0x00);     // shufps xmm, xmm, 0
+}
+
+// helper(rsp + dispA, rsp + dispB, r13, math)
+static void ree_JitEmitHelperCall(struct ree_jit_emitter_t *emitter, ree_jit_helper_t helper, int32_t dispA, int32_t dispB, const struct ree_math_kernels_t *math){
+  EMIT(0x48, 0x8D, 0xBC, 0x24);                                   // lea rdi, [rsp + dispA]
+  ree_JitEmitU32(emitter, (uint32_t)dispA);
+  EMIT(0x48, 0x8D, 0xB4, 0x24);                                   // lea rsi, [rsp + dispB]
+  ree_JitEmitU32(emitter, (uint32_t)dispB);
+  EMIT(0x4C, 0x89, 0xEA);                                         // mov rdx, r13
+
+  // the kernel tables are static, their address is baked into the code
+  uint64_t kernels;
+  memcpy(&kernels, &math, sizeof(kernels));
+  EMIT(0x48, 0xB9);                                               // mov rcx, imm64
+  ree_JitEmitU64(emitter, kernels);
+
+  uint64_t address;
+  memcpy(&address, &helper, sizeof(address));
+  EMIT(0x48, 0xB8);                                               // mov rax, imm64
+  ree_JitEmitU64(emitter, address);
+  EMIT(0xFF, 0xD0);                                               // call rax
+}
+
+// a = a <op> b for two stack slots
+static void ree_JitEmitBinary(struct ree_jit_emitter_t *emitter, enum ree_sse_opcode_e opcode, int32_t dispA, int32_t dispB){
+  for (int32_t v = 0; v < REE_JIT_VECTORS; ++v){
+    ree_JitEmitSseSlot(emitter, SSE_MOVAPS_LOAD, 0, dispA + v * 16);
+    ree_JitEmitSseSlot(emitter, opcode, 0, dispB + v * 16);
+    ree_JitEmitSseSlot(emitter, SSE_MOVAPS_STORE, 0, dispA + v * 16);
+  }
+}
+
+// a = a <op> {mask, mask, mask, mask}, used for the sign bit tricks of NEG and ABS
+static void ree_JitEmitMask(struct ree_jit_emitter_t *emitter, enum ree_sse_opcode_e opcode, uint32_t mask, int32_t dispA){
+  ree_JitEmitBroadcast(emitter, 1, mask);
+  for (int32_t v = 0; v < REE_JIT_VECTORS; ++v){
+    ree_JitEmitSseSlot(emitter, SSE_MOVAPS_LOAD, 0, dispA + v * 16);
+    EMIT(0x0F, (uint8_t)opcode, 0xC1);                            // <op>ps xmm0, xmm1
+    ree_JitEmitSseSlot(emitter, SSE_MOVAPS_STORE, 0, dispA + v * 16);
+  }
+}
+
+// copies one stack slot into another
+static void ree_JitEmitCopy(struct ree_jit_emitter_t *emitter, int32_t dispTo, int32_t dispFrom){
+  for (int32_t v = 0; v < REE_JIT_VECTORS; ++v){
+    ree_JitEmitSseSlot(emitter, SSE_MOVAPS_LOAD, 0, dispFrom + v * 16);
+    ree_JitEmitSseSlot(emitter, SSE_MOVAPS_STORE, 0, dispTo + v * 16);
+  }
+}
+
+// byte offset of an evaluation stack slot (temporary slots follow the stack)
+static int32_t ree_JitSlot(int slot){
+  return (int32_t)(slot * REE_JIT_LANES * (int)sizeof(float));
+}
+
+// helper called for an opcode, nullptr if it's emitted inline
+static ree_jit_helper_t ree_JitHelperFor(enum ree_opcode_e opcode){
+  switch (opcode){
+    case OP_DIV:  return ree_JitDiv;
+    case OP_POW:  return ree_JitPow;
+    case OP_FACT: return ree_JitFact;
+    case OP_SIN:  return ree_JitSin;
+    case OP_COS:  return ree_JitCos;
+    case OP_TAN:  return ree_JitTan;
+    case OP_SQRT: return ree_JitSqrt;
+    case OP_LN:   return ree_JitLn;
+    case OP_LOG:  return ree_JitLog;
+    default:      return nullptr;
+  }
+}
+
+// emits the body of one iteration, returns false if the program uses something the JIT doesn't handle
+static bool ree_JitEmitBody(struct ree_jit_emitter_t *emitter, const struct ree_program_t *program, const struct ree_math_kernels_t *math){
+  const uint8_t *code = program->code;
+  const uint8_t *end = program->code + program->codeSize;
+  int stackIndex = 0;
+
+  while (code < end){
+    const enum ree_opcode_e opcode = (enum ree_opcode_e)*code++;
+    const int32_t top = ree_JitSlot(stackIndex - 1);
+    const int32_t below = ree_JitSlot(stackIndex - 2);
+
+    switch (opcode){
+      case OP_CONST: {
+        uint32_t bits;
+        memcpy(&bits, code, sizeof(bits));
+        code += sizeof(float);
+        ree_JitEmitBroadcast(emitter, 0, bits);
+        for (int32_t v = 0; v < REE_JIT_VECTORS; ++v){
+          ree_JitEmitSseSlot(emitter, SSE_MOVAPS_STORE, 0, ree_JitSlot(stackIndex) + v * 16);
+        }
+        stackIndex++;
+        break;
+      }
+      case OP_VAR: {
+        // only the function parameter (slot 0) is bound, same as the batch evaluator
+        if (*code++ != 0) return false;
+        for (int32_t v = 0; v < REE_JIT_VECTORS; ++v){
+          EMIT(0x0F, SSE_MOVUPS_LOAD, 0x43, (uint8_t)(v * 16));    // movups xmm0, [rbx + 16v]
+          ree_JitEmitSseSlot(emitter, SSE_MOVAPS_STORE, 0, ree_JitSlot(stackIndex) + v * 16);
+        }
+        stackIndex++;
+        break;
+      }
+      case OP_STORE: {
+        ree_JitEmitCopy(emitter, ree_JitSlot(program->maxStackDepth + *code++), top);
+        break;
+      }
+      case OP_LOAD: {
+        ree_JitEmitCopy(emitter, ree_JitSlot(stackIndex++), ree_JitSlot(program->maxStackDepth + *code++));
+        break;
+      }
+      case OP_PARAM: {
+        // the parameter table outlives the program, its address is baked in and the value read every iteration
+        const float *parameter = &program->parameters[*code++];
+        uint64_t address;
+        memcpy(&address, &parameter, sizeof(address));
+        EMIT(0x48, 0xB8);                                         // mov rax, imm64
+        ree_JitEmitU64(emitter, address);
+        EMIT(0xF3, 0x0F, SSE_MOVUPS_LOAD, 0x00);                  // movss xmm0, [rax]
+        EMIT(0x0F, 0xC6, 0xC0, 0x00);                             // shufps xmm0, xmm0, 0
+        for (int32_t v = 0; v < REE_JIT_VECTORS; ++v){
+          ree_JitEmitSseSlot(emitter, SSE_MOVAPS_STORE, 0, ree_JitSlot(stackIndex) + v * 16);
+        }
+        stackIndex++;
+        break;
+      }
+      case OP_ADD: ree_JitEmitBinary(emitter, SSE_ADDPS, below, top); stackIndex--; break;
+      case OP_SUB: ree_JitEmitBinary(emitter, SSE_SUBPS, below, top); stackIndex--; break;
+      case OP_MUL: ree_JitEmitBinary(emitter, SSE_MULPS, below, top); stackIndex--; break;
+      case OP_NEG: ree_JitEmitMask(emitter, SSE_XORPS, 0x80000000u, top); break;
+      case OP_ABS: ree_JitEmitMask(emitter, SSE_ANDPS, 0x7FFFFFFFu, top); break;
+      case OP_POS: break;
+      case OP_DIV:
+      case OP_POW: {
+        ree_JitEmitHelperCall(emitter, ree_JitHelperFor(opcode), below, top, math);
+        stackIndex--;
+        break;
+      }
+      case OP_FACT:
+      case OP_SIN:
+      case OP_COS:
+      case OP_TAN:
+      case OP_SQRT:
+      case OP_LN:
+      case OP_LOG: {
+        ree_JitEmitHelperCall(emitter, ree_JitHelperFor(opcode), top, top, math);
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+
+  return stackIndex == 1;
+}
+
+enum reh_error_code_e ree_JitCompile(struct ree_program_t *program, enum ree_math_mode_e mode){
+  if (program == nullptr || program->code == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Program provided to ree_JitCompile is NULL.");
+  }
+  if (program->maxStackDepth <= 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Program provided to ree_JitCompile has an invalid stack depth (%d).", program->maxStackDepth);
+  }
+  if (program->jit != nullptr){
+    return ERR_SUCCESS;
+  }
+
+  // no instruction expands to more than 128 bytes (NEG / ABS / ADD over four registers), prologue, loop and epilogue stay below 256
+  struct ree_jit_emitter_t staging = {0};
+  struct ree_jit_emitter_t *emitter = &staging;
+  staging.capacity = 256 + (size_t)program->opCount * 128;
+  staging.code = malloc(staging.capacity);
+  if (staging.code == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the staging buffer in ree_JitCompile.");
+  }
+
+  // keeps rsp 16-byte aligned for movaps and for the helper calls (5 pushes + return address)
+  const uint32_t frameSize = (uint32_t)ree_JitSlot(program->maxStackDepth + program->tempCount);
+
+  // prologue
+  EMIT(0x55);                                                     // push rbp
+  EMIT(0x48, 0x89, 0xE5);                                         // mov rbp, rsp
+  EMIT(0x53);                                                     // push rbx
+  EMIT(0x41, 0x54);                                               // push r12
+  EMIT(0x41, 0x55);                                               // push r13
+  EMIT(0x41, 0x56);                                               // push r14
+  EMIT(0x48, 0x81, 0xEC);                                         // sub rsp, frameSize
+  ree_JitEmitU32(emitter, frameSize);
+  EMIT(0x48, 0x89, 0xFB);                                         // mov rbx, rdi
+  EMIT(0x49, 0x89, 0xF4);                                         // mov r12, rsi
+  EMIT(0x49, 0x89, 0xD5);                                         // mov r13, rdx
+  EMIT(0x49, 0x89, 0xCE);                                         // mov r14, rcx
+
+  // loop header
+  const size_t loopStart = staging.size;
+  EMIT(0x4D, 0x85, 0xF6);                                         // test r14, r14
+  EMIT(0x0F, 0x84);                                               // jz done
+  const size_t exitJump = staging.size;
+  ree_JitEmitU32(emitter, 0);
+  EMIT(0x0F, SSE_XORPS, 0xC0);                                    // xorps xmm0, xmm0
+  EMIT(0x41, 0x0F, SSE_MOVUPS_STORE, 0x45, 0x00);                 // movups [r13], xmm0 (REE_EVAL_OK for every lane)
+
+  if (!ree_JitEmitBody(emitter, program, ree_GetMathKernels(mode))){
+    free(staging.code);
+    SET_ERROR_RETURN(ERR_UNSUPPORTED, "Program uses an instruction the JIT doesn't support.");
+  }
+
+  // write the result, advance and loop
+  for (int32_t v = 0; v < REE_JIT_VECTORS; ++v){
+    ree_JitEmitSseSlot(emitter, SSE_MOVAPS_LOAD, 0, ree_JitSlot(0) + v * 16);
+    EMIT(0x41, 0x0F, SSE_MOVUPS_STORE, 0x44, 0x24, (uint8_t)(v * 16)); // movups [r12 + 16v], xmm0
+  }
+  EMIT(0x48, 0x83, 0xC3, REE_JIT_LANES * sizeof(float));          // add rbx, lanes * 4
+  EMIT(0x49, 0x83, 0xC4, REE_JIT_LANES * sizeof(float));          // add r12, lanes * 4
+  EMIT(0x49, 0x83, 0xC5, REE_JIT_LANES);                          // add r13, lanes
+  EMIT(0x49, 0x83, 0xEE, 0x01);                                   // sub r14, 1
+  EMIT(0xE9);                                                     // jmp loopStart
+  ree_JitEmitU32(emitter, (uint32_t)((int64_t)loopStart - (int64_t)(staging.size + 4)));
+
+  // epilogue
+  const size_t loopEnd = staging.size;
+  EMIT(0x48, 0x81, 0xC4);                                         // add rsp, frameSize
+  ree_JitEmitU32(emitter, frameSize);
+  EMIT(0x41, 0x5E);                                               // pop r14
+  EMIT(0x41, 0x5D);                                               // pop r13
+  EMIT(0x41, 0x5C);                                               // pop r12
+  EMIT(0x5B);                                                     // pop rbx
+  EMIT(0x5D);                                                     // pop rbp
+  EMIT(0xC3);                                                     // ret
+
+  if (staging.overflow){
+    free(staging.code);
+    SET_ERROR_RETURN(ERR_OUT_OF_BOUNDS, "JIT staging buffer too small (%zu bytes) in ree_JitCompile.", staging.capacity);
+  }
+
+  // patch the loop exit now that the epilogue position is known
+  const uint32_t exitOffset = (uint32_t)((int64_t)loopEnd - (int64_t)(exitJump + 4));
+  memcpy(staging.code + exitJump, &exitOffset, sizeof(exitOffset));
+
+  // map writable, copy, then flip to executable (never writable and executable at once)
+  const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+  const size_t mappedSize = (staging.size + pageSize - 1) / pageSize * pageSize;
+  void *mapping = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED){
+    free(staging.code);
+    SET_ERROR_RETURN(ERR_ALLOCATION_FAILED, "Failed to map memory for native code in ree_JitCompile.");
+  }
+  memcpy(mapping, staging.code, staging.size);
+  free(staging.code);
+
+  if (mprotect(mapping, mappedSize, PROT_READ | PROT_EXEC) != 0){
+    munmap(mapping, mappedSize);
+    SET_ERROR_RETURN(ERR_ALLOCATION_FAILED, "Failed to make native code executable in ree_JitCompile.");
+  }
+
+  struct ree_jit_program_t *jit = malloc(sizeof(*jit));
+  if (jit == nullptr){
+    munmap(mapping, mappedSize);
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the JIT program in ree_JitCompile.");
+  }
+  jit->code = mapping;
+  jit->mappedSize = mappedSize;
+  jit->codeSize = staging.size;
+  jit->mode = mode;
+  memcpy(&jit->fn, &mapping, sizeof(jit->fn));
+
+  program->jit = jit;
+  return ERR_SUCCESS;
+}
+
+#else
+
+enum reh_error_code_e ree_JitCompile(struct ree_program_t *program, enum ree_math_mode_e mode){
+  (void)program; (void)mode;
+  SET_ERROR_RETURN(ERR_UNSUPPORTED, "No JIT backend for this platform, the program stays interpreted.");
+}
+
+#endif // REE_JIT_AVAILABLE
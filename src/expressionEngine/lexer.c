@@ -8,12 +8,21 @@
 #include <string.h>
 
 
-void ree_Print(struct ree_token_t *tokenVal){
-  printf("{%s, %s}\n", ree_TokenToStr(tokenVal->token_type), tokenVal->value);
+const char* ree_TokenText(const char *expression, const struct ree_token_t *token){
+  return expression + token->start;
+}
+
+bool ree_TokenEquals(const char *expression, const struct ree_token_t *token, const char *str){
+  return strncmp(expression + token->start, str, (size_t)token->length) == 0 && str[token->length] == '\0';
+}
+
+void ree_Print(const char *expression, struct ree_token_t *tokenVal){
+  printf("{%s, %.*s}\n", ree_TokenToStr(tokenVal->token_type), tokenVal->length, ree_TokenText(expression, tokenVal));
 }
 
 void ree_SkipWhitespace(struct ree_data_t *data){
-  while (data->currentChar == ' ' || data->currentChar == '\t' || data->currentChar == '\n' || data->currentChar == '\r'){
+  // past the end ree_Advance keeps yielding ' ', so bound the loop by the length
+  while (data->currentPosition < data->length && (data->currentChar == ' ' || data->currentChar == '\t' || data->currentChar == '\n' || data->currentChar == '\r')){
     ree_Advance(data);
   }
 }
@@ -36,7 +45,7 @@ void ree_Advance(struct ree_data_t *data){
   data->charsLexed++;
 }
 
-void ree_ReadNumber(struct ree_data_t *data, char* number){
+void ree_ReadNumber(struct ree_data_t *data, struct ree_token_t *number){
   if (number == nullptr){
     rl_LogMsg(RL_ERROR, "Number pointer passed to ree_ReadNumber is NULL.");
     return;
@@ -52,14 +61,11 @@ void ree_ReadNumber(struct ree_data_t *data, char* number){
     ree_Advance(data);
   }
 
-  // iterator i starts at start, e.g. the position of the number in the expression
-  // iterator i starts at 0 for us to fill the number arr
-  for (int i = start, j = 0; i < data->currentPosition; ++i, ++j){
-    number[j] = data->expression[i];
-  }
+  number->start = start;
+  number->length = data->currentPosition - start;
 }
 
-void ree_ReadIdentifier(struct ree_data_t *data, char* identifier){
+void ree_ReadIdentifier(struct ree_data_t *data, struct ree_token_t *identifier){
   if (identifier == nullptr){
     rl_LogMsg(RL_ERROR, "Identifier pointer passed to ree_ReadIdentifier is NULL.");
     return;
@@ -75,11 +81,8 @@ void ree_ReadIdentifier(struct ree_data_t *data, char* identifier){
     ree_Advance(data);
   }
 
-  // iterator i starts at start, e.g. the position of the number in the expression
-  // iterator i starts at 0 for us to fill the number arr
-  for (int i = start, j = 0; i < data->currentPosition; ++i, ++j){
-    identifier[j] = data->expression[i];
-  }
+  identifier->start = start;
+  identifier->length = data->currentPosition - start;
 }
 
 enum reh_error_code_e ree_NextToken(struct ree_data_t *data, struct ree_token_t *nextToken){
@@ -92,14 +95,22 @@ enum reh_error_code_e ree_NextToken(struct ree_data_t *data, struct ree_token_t
 
   ree_SkipWhitespace(data);
 
+  // end of the expression (also covers trailing whitespace)
+  if (data->currentPosition >= data->length){
+    nextToken->token_type = TOKEN_EOF;
+    nextToken->start = data->length;
+    nextToken->length = 0;
+    return ERR_SUCCESS;
+  }
+
   if (isdigit(data->currentChar)){
     nextToken->token_type = TOKEN_NUMBER;
-    ree_ReadNumber(data, nextToken->value);
+    ree_ReadNumber(data, nextToken);
     return ERR_SUCCESS; // return early to prevent additional position increment
   }
   else if (isalpha(data->currentChar)){
     nextToken->token_type = TOKEN_IDENTIFIER;
-    ree_ReadIdentifier(data, nextToken->value);
+    ree_ReadIdentifier(data, nextToken);
     return ERR_SUCCESS; // return early to prevent additional position increment
   }
   else if (data->currentChar == '+'){
@@ -131,54 +142,67 @@ enum reh_error_code_e ree_NextToken(struct ree_data_t *data, struct ree_token_t
   }
   else {
     nextToken->token_type = TOKEN_ILLEGAL;
-    nextToken->value[0] = (char)data->currentChar;
-    return ERR_INPUT_TOKEN_INVALID;
+    nextToken->start = data->currentPosition;
+    nextToken->length = 1;
+    SET_ERROR_RETURN(ERR_INPUT_TOKEN_INVALID, "Illegal character '%c' at position %d.", (char)data->currentChar, data->currentPosition);
   }
 
-  nextToken->value[0] = (char)data->currentChar;
+  nextToken->start = data->currentPosition;
+  nextToken->length = 1;
 
   ree_Advance(data);
 
   return ERR_SUCCESS;
 }
 
-enum reh_error_code_e ree_Lexer(char *expression, struct ree_token_t *tokens){
-  if (expression == nullptr){
-    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Expression passed to ree_Lexer is NULL.");
+enum reh_error_code_e ree_PushToken(struct rma_arena_t *arena, struct ree_token_t **tokens, int *tokenCount, int *tokenCapacity, struct ree_token_t token){
+  if (arena == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Arena passed to ree_PushToken is NULL.");
   }
-  if (tokens == nullptr){
-    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Tokens array passed to ree_Lexer is NULL.");
+  else if (tokens == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to tokens array in ree_PushToken is NULL.");
+  }
+  else if (tokenCount == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to tokenCount in ree_PushToken is NULL.");
+  }
+  else if (tokenCapacity == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to tokenCapacity in ree_PushToken is NULL.");
   }
 
-  struct ree_data_t data;
+  // amortized doubling keeps lexing linear in the length of the expression
+  // the buffer is usually the latest arena allocation, so it mostly grows in place
+  if (*tokenCount + 1 > *tokenCapacity){
+    int newCapacity = (*tokenCapacity == 0) ? 16 : (*tokenCapacity * 2);
 
-  // fill the data struct
-  data.currentPosition = 0;
-  data.nextPosition = 1;
-  data.currentChar = expression[0];
-  data.expression = expression;
-  data.length = (int)strlen(data.expression);
+    struct ree_token_t *tmp = rma_Realloc(arena, *tokens, (size_t)*tokenCapacity * sizeof **tokens, (size_t)newCapacity * sizeof **tokens);
+    if (tmp == nullptr){
+      SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to expand token buffer in ree_PushToken.");
+    }
 
-  int i = 0;
-  // loop through the entire expression
-  while (data.currentPosition != data.length){
-    // make sure to set all the chars of the string in the struct to empty char to prevent gibberish
-    struct ree_token_t token = {0, {' '}};
-
-    CHECK_ERROR_CTX(ree_NextToken(&data, &token), "Invalid character in lexed expression.");
-    tokens[i] = token;
-    i++;
+    *tokens = tmp;
+    *tokenCapacity = newCapacity;
   }
 
+  (*tokens)[(*tokenCount)++] = token;
+
   return ERR_SUCCESS;
 }
 
-enum reh_error_code_e ree_CountTokens(char* expression, int *tokenCount){
+enum reh_error_code_e ree_Lexer(struct rma_arena_t *arena, char *expression, struct ree_token_t **tokens, int *tokenCount, int *tokenCapacity){
+  if (arena == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Arena passed to ree_Lexer is NULL.");
+  }
   if (expression == nullptr){
-    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Expression passed to ree_CountTokens is NULL.");
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Expression passed to ree_Lexer is NULL.");
+  }
+  if (tokens == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to tokens array in ree_Lexer is NULL.");
   }
   if (tokenCount == nullptr){
-    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to tokenCount in ree_CountTokens is NULL.");
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to tokenCount in ree_Lexer is NULL.");
+  }
+  if (tokenCapacity == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to tokenCapacity in ree_Lexer is NULL.");
   }
 
   struct ree_data_t data;
@@ -191,17 +215,17 @@ enum reh_error_code_e ree_CountTokens(char* expression, int *tokenCount){
   data.expression = expression;
   data.length = (int)strlen(data.expression);
 
-  int i = 0;
-  // loop through the entire expression
-  while (data.currentPosition != data.length){
-    // make sure to set all the chars of the string in the struct to empty char to prevent gibberish
-    struct ree_token_t token = {0, {' '}};
+  // single pass, every token is appended to the growable buffer as soon as it's read
+  while (true){
+    struct ree_token_t token = {0, 0, 0};
 
-    CHECK_ERROR_CTX(ree_NextToken(&data, &token), "Invalid character in lexed expression: %c", data.currentChar);
-    i++;
-  }
+    CHECK_ERROR_CTX(ree_NextToken(&data, &token), "Invalid character in lexed expression.");
+    if (token.token_type == TOKEN_EOF){
+      break;
+    }
 
-  *tokenCount = i;
+    CHECK_ERROR_CTX(ree_PushToken(arena, tokens, tokenCount, tokenCapacity, token), "Failed to store lexed token.");
+  }
 
   return ERR_SUCCESS;
 }
@@ -0,0 +1,292 @@
+#include "expressionEngine/mathKernels.h"
+
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define REE_HAS_X86_KERNELS
+  #include <immintrin.h>
+#endif
+
+const char* ree_MathModeToStr(enum ree_math_mode_e mode){
+  switch (mode){
+    case REE_MATH_EXACT: return "exact";
+    case REE_MATH_FAST:  return "fast";
+    case REE_MATH_DRAW:  return "draw";
+    default:             return "Unknown math mode";
+  }
+}
+
+/*
+  #########
+  # EXACT #
+  #########
+*/
+static void ree_ExactSin(float *a, size_t count){
+  for (size_t i = 0; i < count; ++i) a[i] = sinf(a[i]);
+}
+static void ree_ExactCos(float *a, size_t count){
+  for (size_t i = 0; i < count; ++i) a[i] = cosf(a[i]);
+}
+static void ree_ExactExp(float *a, size_t count){
+  for (size_t i = 0; i < count; ++i) a[i] = expf(a[i]);
+}
+static void ree_ExactLn(float *a, size_t count){
+  for (size_t i = 0; i < count; ++i) a[i] = logf(a[i]);
+}
+static void ree_ExactLog10(float *a, size_t count){
+  for (size_t i = 0; i < count; ++i) a[i] = log10f(a[i]);
+}
+static void ree_ExactPow(float *a, const float *b, size_t count){
+  for (size_t i = 0; i < count; ++i) a[i] = powf(a[i], b[i]);
+}
+
+// the pole test is the one the scalar evaluators use, the vector kernels fall back to it as well
+static void ree_ExactTanLane(float *a, uint8_t *pole, float x){
+  float c = cosf(x);
+  *pole = fabsf(c) < FLT_EPSILON;
+  *a = tanf(x);
+}
+static void ree_ExactTan(float *a, uint8_t *poles, size_t count){
+  for (size_t i = 0; i < count; ++i) ree_ExactTanLane(a + i, poles + i, a[i]);
+}
+
+static const struct ree_math_kernels_t exactKernels = {
+  REE_MATH_EXACT, REE_ISA_SCALAR,
+  ree_ExactSin, ree_ExactCos, ree_ExactTan,
+  ree_ExactExp, ree_ExactLn, ree_ExactLog10, ree_ExactPow
+};
+
+/*
+  #############
+  # CONSTANTS #
+  #############
+*/
+#define REE_MK_ROUND_MAGIC 12582912.0f // 1.5 * 2^23
+#define REE_MK_2_PI        0.636619772367581343f
+#define REE_MK_SQRT_HALF   0.707106781186547524f
+#define REE_MK_LOG2_E      1.44269504088896341f
+
+// pi/2 in three parts, the first two have few enough bits that q * part is exact for |q| < 2^13
+#define REE_MK_PI_2_A      1.5703125f
+#define REE_MK_PI_2_B      4.837512969970703125e-4f
+#define REE_MK_PI_2_C      7.54978995489188216e-8f
+#define REE_MK_TRIG_MAX    8192.0f
+
+// remainders below |q| * 2^-20 lose more than 1/16 ulp to the reduction
+#define REE_MK_REDUCE_SLACK 9.5367431640625e-7f
+
+// ln(2) in two parts, same reasoning for the exponent
+#define REE_MK_LN_2_A      0.693359375f
+#define REE_MK_LN_2_B      -2.12194440e-4f
+
+#define REE_MK_LOG10_E_A   4.3359375E-1f
+#define REE_MK_LOG10_E_B   7.00731903251827651129E-4f
+#define REE_MK_LOG10_2_A   3.0078125E-1f
+#define REE_MK_LOG10_2_B   2.48745663981195213739E-4f
+
+// expf is finite and normal in between
+#define REE_MK_EXP_MIN     -87.0f
+#define REE_MK_EXP_MAX     88.0f
+
+// fast mode polynomials (Cephes), accurate to a few ulp
+#define REE_MK_SIN_1       -1.9515295891E-4f
+#define REE_MK_SIN_2       8.3321608736E-3f
+#define REE_MK_SIN_3       -1.6666654611E-1f
+
+#define REE_MK_COS_1       2.443315711809948E-5f
+#define REE_MK_COS_2       -1.388731625493765E-3f
+#define REE_MK_COS_3       4.166664568298827E-2f
+
+#define REE_MK_TAN_1       9.38540185543E-3f
+#define REE_MK_TAN_2       3.11992232697E-3f
+#define REE_MK_TAN_3       2.44301354525E-2f
+#define REE_MK_TAN_4       5.34112807005E-2f
+#define REE_MK_TAN_5       1.33387994085E-1f
+#define REE_MK_TAN_6       3.33331568548E-1f
+
+#define REE_MK_EXP_1       1.9875691500E-4f
+#define REE_MK_EXP_2       1.3981999507E-3f
+#define REE_MK_EXP_3       8.3334519073E-3f
+#define REE_MK_EXP_4       4.1665795894E-2f
+#define REE_MK_EXP_5       1.6666665459E-1f
+#define REE_MK_EXP_6       5.0000001201E-1f
+
+#define REE_MK_EXP2_1      0.6931469775991949f
+#define REE_MK_EXP2_2      0.2402224208537789f
+#define REE_MK_EXP2_3      0.05550733743189293f
+#define REE_MK_EXP2_4      0.009671512639580973f
+#define REE_MK_EXP2_5      0.0013264727217744262f
+
+#define REE_MK_LN_1        7.0376836292E-2f
+#define REE_MK_LN_2        -1.1514610310E-1f
+#define REE_MK_LN_3        1.1676998740E-1f
+#define REE_MK_LN_4        -1.2420140846E-1f
+#define REE_MK_LN_5        1.4249322787E-1f
+#define REE_MK_LN_6        -1.6668057665E-1f
+#define REE_MK_LN_7        2.0000714765E-1f
+#define REE_MK_LN_8        -2.4999993993E-1f
+#define REE_MK_LN_9        3.3333331174E-1f
+
+// integer exponents in [-4, 5] pow computes by repeated squaring, larger ones pile up more than the ulp bound
+#define REE_MK_FAST_POW_MAX 5
+
+// draw mode polynomials (minimax fits of lower degree), every one stays below REE_MATH_DRAW_MAX_ERROR
+#define REE_MK_DRAW_SIN_1  -0.16663390377297688f
+#define REE_MK_DRAW_SIN_2  0.008163281920991373f
+
+#define REE_MK_DRAW_COS_1  0.04166107130746965f
+#define REE_MK_DRAW_COS_2  -0.0013648714375674301f
+
+#define REE_MK_DRAW_TAN_1  0.3331543330190352f
+#define REE_MK_DRAW_TAN_2  0.1360650620954135f
+#define REE_MK_DRAW_TAN_3  0.04139854579094955f
+#define REE_MK_DRAW_TAN_4  0.04308880689942983f
+
+#define REE_MK_DRAW_EXP2_1 0.693124193417756f
+#define REE_MK_DRAW_EXP2_2 0.24024098609748462f
+#define REE_MK_DRAW_EXP2_3 0.055906424597293745f
+#define REE_MK_DRAW_EXP2_4 0.009582853101954782f
+
+#define REE_MK_DRAW_LN_1   0.33320860905700955f
+#define REE_MK_DRAW_LN_2   -0.24943832733878793f
+#define REE_MK_DRAW_LN_3   0.2044218721816563f
+#define REE_MK_DRAW_LN_4   -0.18407189995611067f
+#define REE_MK_DRAW_LN_5   0.11781900239304521f
+
+// draw pow takes integer exponents up to 2^5 by squaring, the rest of the positive bases as 2^(b * log2(a))
+#define REE_MK_DRAW_POW_MAX   32
+#define REE_MK_DRAW_POW_RANGE 64.0f
+
+/*
+  ############
+  # PORTABLE #
+  ############
+*/
+#ifdef REE_HAS_X86_KERNELS
+  #pragma GCC push_options
+  #pragma GCC target("sse2")
+#endif
+
+#define REE_MK_WIDTH 4
+#define REE_MK(name) name##Portable
+typedef float ree_mk_vf_portable_t __attribute__((vector_size(16)));
+typedef int32_t ree_mk_vi_portable_t __attribute__((vector_size(16)));
+#define REE_MK_VF ree_mk_vf_portable_t
+#define REE_MK_VI ree_mk_vi_portable_t
+#ifdef REE_HAS_X86_KERNELS
+  #define REE_MK_MOVEMASK(mask) _mm_movemask_ps((__m128)(mask))
+  // cvtps2dq rounds to nearest even, every rounded value fits an int32
+  #define REE_MK_ROUND(x) ((REE_MK_VF)_mm_cvtepi32_ps(_mm_cvtps_epi32((__m128)(x))))
+#endif
+
+#include "expressionEngine/mathKernelsSimd.h"
+
+#undef REE_MK_WIDTH
+#undef REE_MK
+#undef REE_MK_VF
+#undef REE_MK_VI
+#undef REE_MK_MOVEMASK
+#undef REE_MK_ROUND
+
+#ifdef REE_HAS_X86_KERNELS
+  #pragma GCC pop_options
+  #define REE_MK_PORTABLE_ISA REE_ISA_SSE2
+#else
+  #define REE_MK_PORTABLE_ISA REE_ISA_SCALAR
+#endif
+
+static const struct ree_math_kernels_t fastPortableKernels = {
+  REE_MATH_FAST, REE_MK_PORTABLE_ISA,
+  ree_MkFastSinPortable, ree_MkFastCosPortable, ree_MkFastTanPortable,
+  ree_MkFastExpPortable, ree_MkFastLnPortable, ree_MkFastLog10Portable, ree_MkFastPowPortable
+};
+
+static const struct ree_math_kernels_t drawPortableKernels = {
+  REE_MATH_DRAW, REE_MK_PORTABLE_ISA,
+  ree_MkDrawSinPortable, ree_MkDrawCosPortable, ree_MkDrawTanPortable,
+  ree_MkDrawExpPortable, ree_MkDrawLnPortable, ree_MkDrawLog10Portable, ree_MkDrawPowPortable
+};
+
+/*
+  ########
+  # AVX2 #
+  ########
+*/
+#ifdef REE_HAS_X86_KERNELS
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+#define REE_MK_WIDTH 8
+#define REE_MK(name) name##Avx2
+typedef float ree_mk_vf_avx2_t __attribute__((vector_size(32)));
+typedef int32_t ree_mk_vi_avx2_t __attribute__((vector_size(32)));
+#define REE_MK_VF ree_mk_vf_avx2_t
+#define REE_MK_VI ree_mk_vi_avx2_t
+#define REE_MK_MOVEMASK(mask) _mm256_movemask_ps((__m256)(mask))
+#define REE_MK_ROUND(x) ((REE_MK_VF)_mm256_round_ps((__m256)(x), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC))
+
+#include "expressionEngine/mathKernelsSimd.h"
+
+#undef REE_MK_WIDTH
+#undef REE_MK
+#undef REE_MK_VF
+#undef REE_MK_VI
+#undef REE_MK_MOVEMASK
+#undef REE_MK_ROUND
+
+#pragma GCC pop_options
+
+static const struct ree_math_kernels_t fastAvx2Kernels = {
+  REE_MATH_FAST, REE_ISA_AVX2,
+  ree_MkFastSinAvx2, ree_MkFastCosAvx2, ree_MkFastTanAvx2,
+  ree_MkFastExpAvx2, ree_MkFastLnAvx2, ree_MkFastLog10Avx2, ree_MkFastPowAvx2
+};
+
+static const struct ree_math_kernels_t drawAvx2Kernels = {
+  REE_MATH_DRAW, REE_ISA_AVX2,
+  ree_MkDrawSinAvx2, ree_MkDrawCosAvx2, ree_MkDrawTanAvx2,
+  ree_MkDrawExpAvx2, ree_MkDrawLnAvx2, ree_MkDrawLog10Avx2, ree_MkDrawPowAvx2
+};
+
+#endif // REE_HAS_X86_KERNELS
+
+const struct ree_math_kernels_t* ree_GetMathKernelsForIsa(enum ree_math_mode_e mode, enum ree_kernel_isa_e isa){
+  if (mode == REE_MATH_EXACT){
+    return &exactKernels;
+  }
+
+#ifdef REE_HAS_X86_KERNELS
+  __builtin_cpu_init();
+
+  if (isa == REE_ISA_AVX2 && __builtin_cpu_supports("avx2")){
+    return mode == REE_MATH_FAST ? &fastAvx2Kernels : &drawAvx2Kernels;
+  }
+#else
+  (void)isa;
+#endif
+
+  return mode == REE_MATH_FAST ? &fastPortableKernels : &drawPortableKernels;
+}
+
+// resolved once for every mode, the CPU doesn't change while we're running
+static const struct ree_math_kernels_t *ree_mathKernels[REE_MATH_DRAW + 1] = {nullptr};
+static pthread_once_t ree_mathKernelsOnce = PTHREAD_ONCE_INIT;
+
+static void ree_ResolveMathKernels(void){
+  for (int mode = 0; mode <= REE_MATH_DRAW; ++mode){
+    ree_mathKernels[mode] = ree_GetMathKernelsForIsa((enum ree_math_mode_e)mode, REE_ISA_AVX2);
+  }
+}
+
+const struct ree_math_kernels_t* ree_GetMathKernels(enum ree_math_mode_e mode){
+  if ((int)mode < 0 || mode > REE_MATH_DRAW){
+    mode = REE_MATH_EXACT;
+  }
+  // pool workers ask for the kernels concurrently, pthread_once publishes the tables to all of them
+  pthread_once(&ree_mathKernelsOnce, ree_ResolveMathKernels);
+  return ree_mathKernels[mode];
+}
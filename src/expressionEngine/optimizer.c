@@ -0,0 +1,269 @@
+#include "expressionEngine/optimizer.h"
+#include "core/errorHandler.h"
+#include "expressionEngine/evaluator.h"
+#include "expressionEngine/parser/shuntingYard.h"
+#include "math/utility.h"
+
+#include <math.h>
+
+// a node of the expression tree rebuilt from the RPN, children always have a lower index than their parent
+struct ree_rpn_node_t {
+  struct ree_output_token_t token; /**< Token of the node */
+  int children[2];                 /**< Indices of the operands, -1 if unused */
+  bool isConstant;                 /**< Whether the node is a plain number */
+  bool canFail;                    /**< Whether evaluating the subtree can raise a domain error */
+  bool isFinite;                   /**< Whether the subtree is always a finite number (no domain error, no overflow) */
+};
+
+struct ree_rpn_tree_t {
+  struct ree_rpn_node_t *nodes;    /**< Node storage, one slot per input token */
+  int nodeCount;                   /**< Number of nodes in use */
+};
+
+static bool ree_IsSymbol(const struct ree_rpn_node_t *node, enum ree_symbol_e symbol){
+  return (node->token.type == OUTPUT_OPERATOR || node->token.type == OUTPUT_FUNCTION) && node->token.symbol == symbol;
+}
+
+// neither below nor above is equal for number tokens, they are never NaN
+static bool ree_IsConstantValue(const struct ree_rpn_node_t *node, float value){
+  return node->isConstant && !(node->token.value < value) && !(node->token.value > value);
+}
+
+// operators and functions which can fail with a domain error in the evaluator
+static bool ree_SymbolCanFail(uint16_t symbol){
+  return symbol == SYMBOL_DIV || symbol == SYMBOL_FACT || symbol == SYMBOL_TAN ||
+         symbol == SYMBOL_SQRT || symbol == SYMBOL_LN || symbol == SYMBOL_LOG;
+}
+
+// operators and functions which map finite operands to a finite result, anything else can fail or overflow
+static bool ree_SymbolKeepsFinite(uint16_t symbol){
+  return symbol == SYMBOL_NEG || symbol == SYMBOL_POS || symbol == SYMBOL_ABS || symbol == SYMBOL_SIN || symbol == SYMBOL_COS;
+}
+
+// turns the node into a plain number
+static void ree_MakeConstant(struct ree_rpn_node_t *node, float value){
+  node->token.type = OUTPUT_NUMBER;
+  node->token.arity = 0;
+  node->token.symbol = SYMBOL_NONE;
+  node->token.value = value;
+  node->children[0] = -1;
+  node->children[1] = -1;
+  node->isConstant = true;
+  node->canFail = false;
+  node->isFinite = true;
+}
+
+// evaluates an operator over constant operands in double, returns false for operators it doesn't cover
+static bool ree_FoldDouble(const struct ree_rpn_node_t *node, const struct ree_output_token_t *operands, double *result){
+  double a = (double)operands[0].value;
+  double b = (node->token.arity == 2) ? (double)operands[1].value : 0.0;
+
+  switch (node->token.symbol){
+    case SYMBOL_ADD:  *result = a + b; return true;
+    case SYMBOL_SUB:  *result = a - b; return true;
+    case SYMBOL_MUL:  *result = a * b; return true;
+    case SYMBOL_DIV:  *result = a / b; return true;
+    case SYMBOL_POW:  *result = pow(a, b); return true;
+    case SYMBOL_NEG:  *result = -a; return true;
+    case SYMBOL_POS:  *result = a; return true;
+    case SYMBOL_ABS:  *result = fabs(a); return true;
+    case SYMBOL_SQRT: *result = sqrt(a); return true;
+    case SYMBOL_SIN:  *result = sin(a); return true;
+    case SYMBOL_COS:  *result = cos(a); return true;
+    case SYMBOL_TAN:  *result = tan(a); return true;
+    case SYMBOL_LN:   *result = log(a); return true;
+    case SYMBOL_LOG:  *result = log10(a); return true;
+    case SYMBOL_FACT: {
+      // the float fold already checked for an integer in [0, REE_MAX_FACTORIAL_FLOAT], the loop stays bounded regardless
+      if (!(a >= 0.0 && a <= REE_MAX_FACTORIAL_FLOAT)) return false;
+      double factorial = 1.0;
+      for (int i = 2; i <= (int)a; ++i) factorial *= i;
+      *result = factorial;
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+// evaluates an operator over constant operands, returns false if it would raise an error
+static bool ree_TryFold(struct ree_rpn_tree_t *tree, struct ree_rpn_node_t *node, float *result){
+  struct ree_output_token_t rpn[3];
+  int rpnCount = 0;
+
+  for (int c = 0; c < node->token.arity; ++c){
+    rpn[rpnCount++] = tree->nodes[node->children[c]].token;
+  }
+  rpn[rpnCount++] = node->token;
+
+  if (ree_EvaluateRpn(rpn, (size_t)rpnCount, nullptr, 0, result) != ERR_SUCCESS){
+    // domain error, leave it for the evaluator to report at runtime
+    reh_ClearError();
+    return false;
+  }
+
+  // non-finite values can't be represented as a number token
+  if (!isfinite(*result)){
+    return false;
+  }
+
+  // only fold what float holds exactly, otherwise the double tiers would inherit the float rounding of the constant
+  double exact;
+  return ree_FoldDouble(node, rpn, &exact) && rm_IsEqual(exact, (double)*result);
+}
+
+// simplifies the node at index, returns the index of the node that replaces it
+static int ree_SimplifyNode(struct ree_rpn_tree_t *tree, int index){
+  struct ree_rpn_node_t *node = &tree->nodes[index];
+
+  if (node->token.type == OUTPUT_NUMBER || node->token.type == OUTPUT_VARIABLE){
+    return index;
+  }
+
+  struct ree_rpn_node_t *left = &tree->nodes[node->children[0]];
+  struct ree_rpn_node_t *right = (node->token.arity == 2) ? &tree->nodes[node->children[1]] : nullptr;
+
+  // constant folding
+  bool allConstant = left->isConstant && (right == nullptr || right->isConstant);
+  if (allConstant){
+    float value;
+    if (ree_TryFold(tree, node, &value)){
+      ree_MakeConstant(node, value);
+    }
+    return index;
+  }
+
+  // +e -> e
+  if (ree_IsSymbol(node, SYMBOL_POS)){
+    return node->children[0];
+  }
+  // --e -> e
+  if (ree_IsSymbol(node, SYMBOL_NEG) && ree_IsSymbol(left, SYMBOL_NEG)){
+    return left->children[0];
+  }
+
+  if (right == nullptr){
+    return index;
+  }
+
+  // e + 0 -> e, 0 + e -> e
+  if (ree_IsSymbol(node, SYMBOL_ADD)){
+    if (ree_IsConstantValue(right, 0.0f)) return node->children[0];
+    if (ree_IsConstantValue(left, 0.0f)) return node->children[1];
+  }
+  else if (ree_IsSymbol(node, SYMBOL_SUB)){
+    // e - 0 -> e
+    if (ree_IsConstantValue(right, 0.0f)) return node->children[0];
+    // 0 - e -> NEG e
+    if (ree_IsConstantValue(left, 0.0f)){
+      node->token.type = OUTPUT_OPERATOR;
+      node->token.arity = 1;
+      node->token.symbol = SYMBOL_NEG;
+      node->children[0] = node->children[1];
+      node->children[1] = -1;
+      return ree_SimplifyNode(tree, index);
+    }
+  }
+  else if (ree_IsSymbol(node, SYMBOL_MUL)){
+    // e * 1 -> e, 1 * e -> e
+    if (ree_IsConstantValue(right, 1.0f)) return node->children[0];
+    if (ree_IsConstantValue(left, 1.0f)) return node->children[1];
+    // e * 0 -> 0, 0 * e -> 0, only if e is always finite (an undefined or overflowing e makes the product NaN)
+    if ((ree_IsConstantValue(right, 0.0f) && left->isFinite) || (ree_IsConstantValue(left, 0.0f) && right->isFinite)){
+      ree_MakeConstant(node, 0.0f);
+      return index;
+    }
+  }
+  else if (ree_IsSymbol(node, SYMBOL_DIV)){
+    // e / 1 -> e
+    if (ree_IsConstantValue(right, 1.0f)) return node->children[0];
+  }
+  else if (ree_IsSymbol(node, SYMBOL_POW)){
+    // e ^ 1 -> e
+    if (ree_IsConstantValue(right, 1.0f)) return node->children[0];
+    // e ^ 0 -> 1, 1 ^ e -> 1 (powf returns 1 for these even with NaN operands)
+    if ((ree_IsConstantValue(right, 0.0f) && !left->canFail) || (ree_IsConstantValue(left, 1.0f) && !right->canFail)){
+      ree_MakeConstant(node, 1.0f);
+      return index;
+    }
+  }
+
+  return index;
+}
+
+// writes the subtree rooted at index back into RPN (post-order)
+static void ree_EmitNode(const struct ree_rpn_tree_t *tree, int index, struct ree_output_token_t *out, int *outCount){
+  const struct ree_rpn_node_t *node = &tree->nodes[index];
+
+  for (int c = 0; c < node->token.arity; ++c){
+    ree_EmitNode(tree, node->children[c], out, outCount);
+  }
+  out[(*outCount)++] = node->token;
+}
+
+enum reh_error_code_e ree_OptimizeRpn(struct rma_arena_t *arena, struct ree_output_token_t *rpn, int *rpnCount){
+  if (arena == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Arena passed to ree_OptimizeRpn is NULL.");
+  }
+  else if (rpn == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "RPN passed to ree_OptimizeRpn is NULL.");
+  }
+  else if (rpnCount == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to rpnCount in ree_OptimizeRpn is NULL.");
+  }
+
+  if (*rpnCount <= 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "rpnCount passed to ree_OptimizeRpn is less than or equal to 0.");
+  }
+
+  struct ree_rpn_tree_t tree;
+  tree.nodes = rma_Alloc(arena, (size_t)*rpnCount * sizeof(struct ree_rpn_node_t));
+  tree.nodeCount = 0;
+  if (tree.nodes == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate memory for the expression tree in ree_OptimizeRpn.");
+  }
+
+  // the node stack lives in the arena too, a VLA would overflow the call stack on huge definitions
+  int *stack = rma_Alloc(arena, (size_t)*rpnCount * sizeof(int));
+  int stackIndex = 0;
+  if (stack == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the node stack in ree_OptimizeRpn.");
+  }
+
+  // rebuild the tree bottom-up, simplifying every node as soon as its operands are final
+  for (int i = 0; i < *rpnCount; ++i){
+    int arity = (rpn[i].type == OUTPUT_NUMBER || rpn[i].type == OUTPUT_VARIABLE) ? 0 : rpn[i].arity;
+
+    if (arity < 0 || arity > 2 || stackIndex < arity){
+      SET_ERROR_RETURN(ERR_INVALID_STACK_STATE, "Not enough operands for RPN token (%s) in ree_OptimizeRpn.", ree_SymbolToStr(rpn[i].symbol));
+    }
+
+    struct ree_rpn_node_t *node = &tree.nodes[tree.nodeCount];
+    node->token = rpn[i];
+    node->children[0] = -1;
+    node->children[1] = -1;
+    node->isConstant = (rpn[i].type == OUTPUT_NUMBER);
+    node->canFail = (rpn[i].type == OUTPUT_OPERATOR || rpn[i].type == OUTPUT_FUNCTION) && ree_SymbolCanFail(rpn[i].symbol);
+    // numbers, variables and parameters are finite (parameters can't be set to anything else)
+    node->isFinite = arity == 0 || ree_SymbolKeepsFinite(rpn[i].symbol);
+
+    for (int c = arity - 1; c >= 0; --c){
+      node->children[c] = stack[--stackIndex];
+      node->canFail = node->canFail || tree.nodes[node->children[c]].canFail;
+      node->isFinite = node->isFinite && tree.nodes[node->children[c]].isFinite;
+    }
+
+    stack[stackIndex++] = ree_SimplifyNode(&tree, tree.nodeCount++);
+  }
+
+  if (stackIndex != 1){
+    SET_ERROR_RETURN(ERR_INVALID_STACK_STATE, "RPN passed to ree_OptimizeRpn leaves %d values on the stack instead of 1.", stackIndex);
+  }
+
+  // the simplified tree is never larger than the input, so it can be written back in place
+  int outCount = 0;
+  ree_EmitNode(&tree, stack[0], rpn, &outCount);
+  *rpnCount = outCount;
+
+  return ERR_SUCCESS;
+}
@@ -0,0 +1,73 @@
+#include "expressionEngine/parameters.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+int ree_FindParameter(const struct ree_parameter_table_t *table, const char *name){
+  if (table == nullptr || name == nullptr) return -1;
+
+  for (int i = 0; i < table->count; ++i){
+    if (strcmp(table->names[i], name) == 0){
+      return i;
+    }
+  }
+  return -1;
+}
+
+enum reh_error_code_e ree_DeclareParameter(struct ree_parameter_table_t *table, const char *name, int *index){
+  if (table == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Parameter table passed to ree_DeclareParameter is NULL.");
+  }
+  else if (name == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Name passed to ree_DeclareParameter is NULL.");
+  }
+  else if (index == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to index in ree_DeclareParameter is NULL.");
+  }
+
+  *index = ree_FindParameter(table, name);
+  if (*index >= 0){
+    return ERR_SUCCESS;
+  }
+
+  if (strlen(name) == 0 || strlen(name) > REE_MAX_PARAMETER_NAME_LEN){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Parameter name %s is empty or longer than %d chars.", name, REE_MAX_PARAMETER_NAME_LEN);
+  }
+  if (table->count >= REE_MAX_PARAMETERS){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Parameter table has reached its maximum capacity (%d).", REE_MAX_PARAMETERS);
+  }
+
+  *index = table->count++;
+  strcpy(table->names[*index], name);
+  table->values[*index] = REE_PARAMETER_DEFAULT;
+  rl_LogMsg(RL_DEBUG, "Declared parameter %s = %g.", name, (double)REE_PARAMETER_DEFAULT);
+
+  return ERR_SUCCESS;
+}
+
+bool ree_ParseParameterAssignment(const char *text, char *name, size_t nameSize, float *value){
+  if (text == nullptr || name == nullptr || value == nullptr) return false;
+
+  const char *equals = strchr(text, '=');
+  if (equals == nullptr) return false;
+
+  const char *nameStart = text;
+  const char *nameEnd = equals;
+  while (nameStart < nameEnd && isspace((unsigned char)*nameStart)) ++nameStart;
+  while (nameEnd > nameStart && isspace((unsigned char)nameEnd[-1])) --nameEnd;
+
+  const size_t nameLength = (size_t)(nameEnd - nameStart);
+  if (nameLength == 0 || nameLength >= nameSize || memchr(nameStart, '(', nameLength) != nullptr) return false;
+  if (nameLength == 1 && *nameStart == 'y') return false;
+
+  char *valueEnd;
+  *value = strtof(equals + 1, &valueEnd);
+  while (isspace((unsigned char)*valueEnd)) ++valueEnd;
+  if (valueEnd == equals + 1 || *valueEnd != '\0') return false;
+
+  memcpy(name, nameStart, nameLength);
+  name[nameLength] = '\0';
+  return true;
+}
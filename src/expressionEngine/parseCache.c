@@ -0,0 +1,219 @@
+#include "expressionEngine/parseCache.h"
+#include "core/errorHandler.h"
+#include "expressionEngine/tokens.h"
+#include <ctype.h>
+#include <string.h>
+#include "core/logger.h"
+
+void ree_InitParseCache(struct ree_parse_cache_t *cache, struct rma_pool_t *pool){
+  if (cache == nullptr) return;
+
+  // the table is allocated on the first insertion
+  memset(cache, 0, sizeof *cache);
+  cache->pool = pool;
+}
+
+void ree_DestroyParseCache(struct ree_parse_cache_t *cache){
+  if (cache == nullptr || cache->entries == nullptr) return;
+
+  for (int i = 0; i < REE_PARSE_CACHE_CAPACITY; ++i){
+    if (cache->entries[i].hash == 0) continue;
+    if (cache->entries[i].referenceCount != 0){
+      rl_LogMsg(RL_WARNING, "Parse cache entry is still shared by %d functions while the cache is destroyed.", cache->entries[i].referenceCount);
+    }
+    rma_ResetArena(&cache->entries[i].arena);
+  }
+  cache->pool->allocator.free(cache->entries, cache->pool->allocator.userData);
+
+  cache->entries = nullptr;
+  cache->entryCount = 0;
+  cache->evictCursor = 0;
+}
+
+static bool ree_IsBlank(char c){
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// numbers are runs of digits and identifiers runs of letters, whitespace only separates tokens between two of the same kind (2 3, a b)
+static bool ree_SeparatesTokens(char left, char right){
+  return (isdigit((unsigned char)left) != 0 && isdigit((unsigned char)right) != 0) ||
+         (isalpha((unsigned char)left) != 0 && isalpha((unsigned char)right) != 0);
+}
+
+// calls are resolved by name and an unknown a(...) is a product, only built-ins, the parameter and y mean the same in every manager
+static enum reh_error_code_e ree_IsContextFree(const char *word, int length, const char *parameter, bool *contextFree){
+  *contextFree = true;
+  if ((length == 1 && word[0] == 'y') || ((size_t)length == strlen(parameter) && memcmp(word, parameter, (size_t)length) == 0)){
+    return ERR_SUCCESS;
+  }
+
+  uint16_t symbol;
+  CHECK_ERROR_CTX(ree_InternSymbol(word, length, &symbol), "Failed to intern identifier.");
+  *contextFree = ree_IsFunctionSymbol(symbol);
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e ree_ParseCacheKey(struct rma_arena_t *scratch, const char *parameter, const char *body, char **key, size_t *keyLength, uint64_t *hash, bool *cacheable){
+  if (scratch == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Arena passed to ree_ParseCacheKey is NULL.");
+  }
+  else if (parameter == nullptr || body == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Parameter or body passed to ree_ParseCacheKey is NULL.");
+  }
+  else if (key == nullptr || keyLength == nullptr || hash == nullptr || cacheable == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Output pointers passed to ree_ParseCacheKey are NULL.");
+  }
+
+  // the parameter is part of the key, x^2 in f(x) and in f(t) compile differently (the other one reads a global parameter)
+  const size_t parameterLength = strlen(parameter);
+  char *out = rma_Alloc(scratch, parameterLength + 1 + strlen(body) + 1);
+  if (out == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the parse cache key.");
+  }
+  memcpy(out, parameter, parameterLength + 1);
+
+  size_t length = parameterLength + 1;
+  const size_t bodyStart = length;
+  *cacheable = true;
+  for (const char *c = body; *c != '\0'; ++c){
+    if (ree_IsBlank(*c) == true){
+      while (ree_IsBlank(c[1]) == true) ++c;
+      if (length > bodyStart && ree_SeparatesTokens(out[length - 1], c[1]) == true){
+        out[length++] = ' ';
+      }
+      continue;
+    }
+
+    // the whitespace before '(' is already dropped, so the word before it ends right here
+    if (*c == '(' && length > bodyStart && isalpha((unsigned char)out[length - 1]) != 0 && *cacheable == true){
+      size_t wordStart = length;
+      while (wordStart > bodyStart && isalpha((unsigned char)out[wordStart - 1]) != 0) --wordStart;
+      CHECK_ERROR_CTX(ree_IsContextFree(&out[wordStart], (int)(length - wordStart), parameter, cacheable), "Failed to check the calls of the definition.");
+    }
+    out[length++] = *c;
+  }
+  out[length] = '\0';
+
+  // FNV-1a, 0 marks empty entries
+  uint64_t h = UINT64_C(14695981039346656037);
+  for (size_t i = 0; i < length; ++i){
+    h ^= (uint8_t)out[i];
+    h *= UINT64_C(1099511628211);
+  }
+
+  *key = out;
+  *keyLength = length;
+  *hash = (h == 0) ? 1 : h;
+
+  return ERR_SUCCESS;
+}
+
+struct ree_parse_cache_entry_t* ree_FindParseCacheEntry(struct ree_parse_cache_t *cache, const char *key, size_t keyLength, uint64_t hash){
+  if (cache == nullptr || key == nullptr) return nullptr;
+
+  for (int i = 0; cache->entries != nullptr && i < REE_PARSE_CACHE_CAPACITY; ++i){
+    struct ree_parse_cache_entry_t *entry = &cache->entries[i];
+    if (entry->hash == hash && entry->keyLength == keyLength && memcmp(entry->key, key, keyLength) == 0){
+      cache->stats.hits++;
+      return entry;
+    }
+  }
+
+  cache->stats.misses++;
+  return nullptr;
+}
+
+// finds an empty entry, or evicts one no function shares anymore (round robin), nullptr if all are in use
+static struct ree_parse_cache_entry_t* ree_ClaimParseCacheEntry(struct ree_parse_cache_t *cache){
+  for (int n = 0; n < REE_PARSE_CACHE_CAPACITY; ++n){
+    struct ree_parse_cache_entry_t *entry = &cache->entries[cache->evictCursor];
+    cache->evictCursor = (cache->evictCursor + 1) % REE_PARSE_CACHE_CAPACITY;
+
+    if (entry->hash == 0){
+      cache->entryCount++;
+      return entry;
+    }
+    if (entry->referenceCount == 0){
+      rma_ResetArena(&entry->arena);
+      cache->stats.evictions++;
+      return entry;
+    }
+  }
+  return nullptr;
+}
+
+enum reh_error_code_e ree_InsertParseCacheEntry(struct ree_parse_cache_t *cache, const char *key, size_t keyLength, uint64_t hash, struct rma_arena_t *arena, struct ree_output_token_t *rpn, int rpnCount, const struct ree_program_t *program, struct ree_parse_cache_entry_t **entry){
+  if (cache == nullptr || cache->pool == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Parse cache passed to ree_InsertParseCacheEntry is NULL or not initialized.");
+  }
+  else if (key == nullptr || arena == nullptr || rpn == nullptr || program == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Compiled body passed to ree_InsertParseCacheEntry is NULL.");
+  }
+  else if (entry == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to entry in ree_InsertParseCacheEntry is NULL.");
+  }
+
+  *entry = nullptr;
+
+  if (cache->entries == nullptr){
+    const size_t size = REE_PARSE_CACHE_CAPACITY * sizeof *cache->entries;
+    cache->entries = cache->pool->allocator.alloc(size, cache->pool->allocator.userData);
+    if (cache->entries == nullptr){
+      SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the parse cache.");
+    }
+    memset(cache->entries, 0, size);
+  }
+
+  struct ree_parse_cache_entry_t *claimed = ree_ClaimParseCacheEntry(cache);
+  if (claimed == nullptr){
+    return ERR_SUCCESS;
+  }
+
+  // the key goes into the arena it takes over, one reset releases everything the entry holds
+  char *ownedKey = rma_Alloc(arena, keyLength + 1);
+  if (ownedKey == nullptr){
+    memset(claimed, 0, sizeof *claimed);
+    cache->entryCount--;
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the parse cache key.");
+  }
+  memcpy(ownedKey, key, keyLength);
+  ownedKey[keyLength] = '\0';
+
+  claimed->hash = hash;
+  claimed->key = ownedKey;
+  claimed->keyLength = keyLength;
+  claimed->arena = *arena;
+  claimed->rpn = rpn;
+  claimed->rpnCount = rpnCount;
+  claimed->program = *program;
+  claimed->program.jit = nullptr;
+  claimed->referenceCount = 0;
+  rma_InitArena(arena, cache->pool);
+
+  *entry = claimed;
+  return ERR_SUCCESS;
+}
+
+void ree_ReleaseParseCacheEntry(struct ree_parse_cache_entry_t *entry){
+  if (entry == nullptr) return;
+
+  if (entry->referenceCount <= 0){
+    rl_LogMsg(RL_WARNING, "Parse cache entry released more often than it was shared.");
+    return;
+  }
+  entry->referenceCount--;
+}
+
+enum reh_error_code_e ree_GetParseCacheStats(const struct ree_parse_cache_t *cache, struct ree_parse_cache_stats_t *stats){
+  if (cache == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Parse cache passed to ree_GetParseCacheStats is NULL.");
+  }
+  else if (stats == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to stats in ree_GetParseCacheStats is NULL.");
+  }
+
+  *stats = cache->stats;
+  stats->entryCount = cache->entryCount;
+
+  return ERR_SUCCESS;
+}
@@ -1,17 +1,60 @@
 #include "expressionEngine/parser/functionParser.h"
 #include "core/errorHandler.h"
+#include "expressionEngine/compiler.h"
 #include "expressionEngine/functionManager.h"
+#include "expressionEngine/inliner.h"
 #include "expressionEngine/lexer.h"
+#include "expressionEngine/optimizer.h"
+#include "expressionEngine/parseCache.h"
 #include "expressionEngine/parser/shuntingYard.h"
 #include "expressionEngine/tokens.h"
 #include "math/Vec3.h"
-#include "utils/utilities.h"
+#include <ctype.h>
 #include <string.h>
 #include <stdlib.h>
 #include "core/logger.h"
 
-enum reh_error_code_e ree_ImplicitMultiplication(struct ree_token_t **tokens, int *tokenCount, int *tokenCapacity){
-  if (tokens == nullptr){
+// checks whether a multiplication sign has to be inserted between two adjacent tokens, e.g. 2x, 3(x + 1), (x)(x)
+static enum reh_error_code_e ree_NeedsImplicitMultiplication(const char *expression, const struct ree_token_t *left, const struct ree_token_t *right, bool *needsMultiplication){
+  *needsMultiplication = false;
+
+  // set bools based on if we get one of the required token types
+  bool leftFactor =  left->token_type == TOKEN_NUMBER         ||
+                     left->token_type == TOKEN_IDENTIFIER     ||
+                     left->token_type == TOKEN_PAREN_CLOSE;
+
+  bool rightFactor = right->token_type == TOKEN_NUMBER         ||
+                     right->token_type == TOKEN_IDENTIFIER     ||
+                     right->token_type == TOKEN_FUNCTION       ||
+                     right->token_type == TOKEN_PAREN_OPEN;
+
+  // dont do anything unless both factors are true
+  if (!leftFactor || !rightFactor){
+    return ERR_SUCCESS;
+  }
+
+  // bail out early if the left factor is a known function
+  // if we kept it, sin(x) would turn into sin * (x) and thus break the parser
+  if (left->token_type == TOKEN_IDENTIFIER){
+    uint16_t symbol;
+    CHECK_ERROR_CTX(ree_InternSymbol(ree_TokenText(expression, left), left->length, &symbol), "Failed to intern identifier.");
+    if (ree_IsFunctionSymbol(symbol) == true){
+      return ERR_SUCCESS;
+    }
+  }
+
+  *needsMultiplication = true;
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e ree_ImplicitMultiplication(struct rma_arena_t *arena, const char *expression, struct ree_token_t **tokens, int *tokenCount, int *tokenCapacity){
+  if (arena == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Arena passed to ree_ImplicitMultiplication is NULL.");
+  }
+  else if (expression == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Expression passed to ree_ImplicitMultiplication is NULL.");
+  }
+  else if (tokens == nullptr){
     SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to tokens array in ree_ImplicitMultiplication is NULL.");
   }
   else if (tokenCount == nullptr){
@@ -24,76 +67,190 @@ enum reh_error_code_e ree_ImplicitMultiplication(struct ree_token_t **tokens, in
     SET_ERROR_RETURN(ERR_INVALID_INPUT, "tokenCount passed to ree_ImplicitMultiplication is less than or equal to 0.");
   }
 
-  // walk the array of tokens
+  // count the insertions first, so the buffer grows at most once
+  int insertionCount = 0;
   for (int i = 0; i < *tokenCount - 1; i++){
-    // set bools based on if we get one of the required token types
-    bool leftFactor =  (*tokens)[i].token_type == TOKEN_NUMBER         ||
-                       (*tokens)[i].token_type == TOKEN_IDENTIFIER     ||
-                       (*tokens)[i].token_type == TOKEN_PAREN_CLOSE;
-
-    bool rightFactor = (*tokens)[i+1].token_type == TOKEN_NUMBER         ||
-                       (*tokens)[i+1].token_type == TOKEN_IDENTIFIER     ||
-                       (*tokens)[i+1].token_type == TOKEN_FUNCTION       ||
-                       (*tokens)[i+1].token_type == TOKEN_PAREN_OPEN;
-
-    bool leftIsFunction = ((*tokens)[i].token_type == TOKEN_IDENTIFIER) &&
-                      rgu_IsStrInArray(validFunctions, functionArrLength, (*tokens)[i].value);
-
-    // bail out early if the left factor is a known function
-    // if we kept it, sin(x) would turn into sin * (x) and thus break the parser
-    if (leftIsFunction){
-      continue;
+    bool needsMultiplication;
+    CHECK_ERROR_CTX(ree_NeedsImplicitMultiplication(expression, &(*tokens)[i], &(*tokens)[i+1], &needsMultiplication), "Failed to check for implicit multiplication.");
+    if (needsMultiplication == true) insertionCount++;
+  }
+
+  if (insertionCount == 0){
+    return ERR_SUCCESS;
+  }
+
+  const int newCount = *tokenCount + insertionCount;
+  if (newCount > *tokenCapacity){
+    struct ree_token_t *tmp = rma_Realloc(arena, *tokens, (size_t)*tokenCapacity * sizeof **tokens, (size_t)newCount * sizeof **tokens);
+    if (tmp == nullptr){
+      SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to expand token buffer in ree_ImplicitMultiplication.");
     }
 
-    // dont do anything unless both factors are true
-    if ((!leftFactor || !rightFactor)){
-      continue;
+    *tokens = tmp;
+    *tokenCapacity = newCount;
+  }
+
+  // fill the buffer from the back so every token is moved exactly once (instead of a memmove per insertion)
+  // the write index never falls below i, so tokens[i] is still intact when it's read, tokens[i+1] might not be
+  int write = newCount - 1;
+  struct ree_token_t right = (*tokens)[*tokenCount - 1];
+  (*tokens)[write--] = right;
+
+  for (int i = *tokenCount - 2; i >= 0; i--){
+    struct ree_token_t left = (*tokens)[i];
+
+    bool needsMultiplication;
+    CHECK_ERROR_CTX(ree_NeedsImplicitMultiplication(expression, &left, &right, &needsMultiplication), "Failed to check for implicit multiplication.");
+
+    if (needsMultiplication == true){
+      // synthesized token, it has no text in the expression
+      struct ree_token_t multiply = {TOKEN_MULTIPLY, right.start, 0};
+      (*tokens)[write--] = multiply;
     }
-    if (*tokenCount + 1 > *tokenCapacity){
-      int newCapacity = (*tokenCapacity == 0) ? 8 : (*tokenCapacity * 2);
-      while (*tokenCount + 1 > newCapacity){
-        newCapacity *= 2;
-      }
 
-      struct ree_token_t *tmp = realloc(*tokens, (long unsigned int)newCapacity * sizeof **tokens);
-      if (tmp == nullptr){
-        SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to expand token buffer in ree_ImplicitMultiplication.");
+    (*tokens)[write--] = left;
+    right = left;
+  }
+
+  *tokenCount = newCount;
+
+  return ERR_SUCCESS;
+}
+
+// checks whether an identifier names a built-in function (sin, cos, ...), names can be longer than one letter
+static bool ree_IsBuiltinFunctionName(const char *definition, const struct ree_token_t *token){
+  uint16_t symbol;
+  if (ree_InternSymbol(ree_TokenText(definition, token), token->length, &symbol) != ERR_SUCCESS){
+    reh_ClearError();
+    return false;
+  }
+  return ree_IsFunctionSymbol(symbol);
+}
+
+// turns identifiers naming a function of the manager and followed by '(' into call tokens
+// unknown multi-letter names followed by '(' are rejected, they would be read as a parameter times the parenthesis
+// the parameter shadows functions of the same name, y definitions can't be called (there can be several of them)
+static enum reh_error_code_e ree_MarkFunctionCalls(const char *definition, struct ree_token_t *tokens, int tokenCount, const struct ree_function_t *function, struct ree_function_manager_t *manager){
+  for (int i = 0; i < tokenCount - 1; ++i){
+    if (tokens[i].token_type != TOKEN_IDENTIFIER || tokens[i + 1].token_type != TOKEN_PAREN_OPEN) continue;
+    if (ree_TokenEquals(definition, &tokens[i], function->parameter) == true || ree_TokenEquals(definition, &tokens[i], "y") == true) continue;
+
+    if (ree_TokenEquals(definition, &tokens[i], function->name) == true){
+      SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function %s can't call itself.", function->name);
+    }
+
+    // names longer than a function name can have are never calls
+    if (tokens[i].length <= MAX_FN_NAME_LEN){
+      char name[MAX_FN_NAME_LEN + 1];
+      memcpy(name, ree_TokenText(definition, &tokens[i]), (size_t)tokens[i].length);
+      name[tokens[i].length] = '\0';
+      if (ree_IsFunctionInManager(manager, name) == true){
+        tokens[i].token_type = TOKEN_FUNCTION;
       }
+    }
 
-      *tokens = tmp;
-      *tokenCapacity = newCapacity;
+    // other identifiers are parameters and a(x + 1) is a product, a longer unknown name is most likely a misspelled function
+    uint16_t symbol;
+    CHECK_ERROR_CTX(ree_InternSymbol(ree_TokenText(definition, &tokens[i]), tokens[i].length, &symbol), "Failed to intern identifier.");
+    if (tokens[i].token_type == TOKEN_IDENTIFIER && tokens[i].length > 1 && ree_IsFunctionSymbol(symbol) == false){
+      SET_ERROR_RETURN(ERR_UNKNOWN_IDENTIFIER, "Unknown function %.*s.", tokens[i].length, ree_TokenText(definition, &tokens[i]));
     }
-    // shift the array to the right by one slot to have space to insert the multiplication token
-    memmove(&(*tokens)[i+2],
-            &(*tokens)[i+1],
-            (long unsigned int)(*tokenCount - (i + 1)) * sizeof **tokens);
+  }
+
+  return ERR_SUCCESS;
+}
 
-    (*tokens)[i+1].token_type = TOKEN_MULTIPLY;
-    strcpy((*tokens)[i+1].value, "*");
-    (*tokenCount)++;
-    i++;
+// collects the distinct functions called by an RPN array, looked up by name in the manager
+// a callee reading a global parameter named like the caller's parameter is rejected, inlining would bind it to the caller's variable
+static enum reh_error_code_e ree_ResolveCallees(struct ree_function_manager_t *manager, const struct ree_function_t *function, const struct ree_output_token_t *rpn, int rpnCount, struct ree_inline_callee_t **callees, int *calleeCount){
+  // every call could name a different function
+  *callees = rma_Alloc(&manager->scratch, (size_t)rpnCount * sizeof **callees);
+  if (*callees == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the callee table.");
+  }
+  *calleeCount = 0;
+
+  for (int i = 0; i < rpnCount; ++i){
+    if (ree_IsCallToken(&rpn[i]) == false) continue;
+
+    bool known = false;
+    for (int c = 0; c < *calleeCount && known == false; ++c){
+      known = ((*callees)[c].symbol == rpn[i].symbol);
+    }
+    if (known == true) continue;
+
+    const char *name = ree_SymbolToStr(rpn[i].symbol);
+    const struct ree_function_t *callee = ree_GetFunction(manager, name);
+    if (callee == nullptr){
+      SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function %s isn't defined.", name);
+    }
+
+    struct ree_inline_callee_t *entry = &(*callees)[(*calleeCount)++];
+    entry->symbol = rpn[i].symbol;
+    CHECK_ERROR_CTX(ree_InternSymbol(callee->parameter, (int)strlen(callee->parameter), &entry->parameter), "Failed to intern parameter of %s.", callee->name);
+
+    const int captured = ree_FindParameter(&manager->parameters, function->parameter);
+    if (captured >= 0 && strcmp(callee->parameter, function->parameter) != 0 && (callee->program.parameterMask & (UINT64_C(1) << captured)) != 0){
+      SET_ERROR_RETURN(ERR_INVALID_INPUT, "%s reads the parameter %s, it can't be called from %s(%s).", callee->name, function->parameter, function->name, function->parameter);
+    }
+    entry->rpn = callee->rpn;
+    entry->rpnCount = callee->rpnCount;
   }
 
   return ERR_SUCCESS;
 }
 
-enum reh_error_code_e ree_ParseFunction(char *definition, struct ree_function_t *function, struct ree_function_manager_t *manager, struct rm_vec3_t *functionColor){
-  if (definition == nullptr){
-    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Definition passed to ree_ParseFunction is NULL.");
+enum reh_error_code_e ree_CompileFunction(struct ree_function_manager_t *manager, struct ree_function_t *function){
+  if (manager == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Manager passed to ree_CompileFunction is NULL.");
   }
-  else if (function == nullptr){
-    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Function struct (ree_function_t) passed to ree_ParseFunction is NULL.");
+  else if (function == nullptr || function->rpn == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Function passed to ree_CompileFunction has no RPN.");
   }
-  else if (functionColor == nullptr){
-    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Function color (rm_vec3_t) passed to ree_ParseFunction is NULL.");
+
+  struct rma_arena_t *scratch = &manager->scratch;
+
+  bool hasCalls = false;
+  for (int i = 0; i < function->rpnCount && hasCalls == false; ++i){
+    hasCalls = ree_IsCallToken(&function->rpn[i]);
   }
 
-  int tokenCount = 0;
-  CHECK_ERROR_CTX(ree_CountTokens(definition, &tokenCount), "Failed to count tokens.");
+  function->sourceRpn = nullptr;
+  function->sourceRpnCount = 0;
+
+  // the parsed RPN is kept to inline the callees again when one of them is redefined
+  // the callees are inlined already, so one level of substitution flattens the whole call graph
+  if (hasCalls == true){
+    function->sourceRpn = function->rpn;
+    function->sourceRpnCount = function->rpnCount;
+
+    struct ree_inline_callee_t *callees;
+    int calleeCount;
+    CHECK_ERROR_CTX(ree_ResolveCallees(manager, function, function->sourceRpn, function->sourceRpnCount, &callees, &calleeCount), "Failed to resolve the functions called by %s.", function->name);
+    CHECK_ERROR_CTX(ree_InlineRpn(scratch, &function->arena, function->sourceRpn, function->sourceRpnCount, callees, calleeCount, &function->rpn, &function->rpnCount), "Failed to inline the functions called by %s.", function->name);
+  }
+
+  // fold constants and strip identities before compiling, inlined bodies are folded together with the caller
+  int unoptimizedRpnCount = function->rpnCount;
+  CHECK_ERROR_CTX(ree_OptimizeRpn(scratch, function->rpn, &function->rpnCount), "Failed to optimize RPN.");
+  rl_LogMsg(RL_DEBUG, "Optimized RPN of %s: %d -> %d ops", function->name, unoptimizedRpnCount, function->rpnCount);
 
-  struct ree_token_t tokens[tokenCount];
-  CHECK_ERROR_CTX(ree_Lexer(definition, tokens), "Failed to perform lexical analysis.");
+  // the optimized RPN is never larger, give the rest back (in place, it's the latest allocation of the function arena)
+  struct ree_output_token_t *shrunkRpn = rma_Realloc(&function->arena, function->rpn, (size_t)unoptimizedRpnCount * sizeof(struct ree_output_token_t), (size_t)function->rpnCount * sizeof(struct ree_output_token_t));
+  if (shrunkRpn != nullptr){
+    function->rpn = shrunkRpn;
+  }
+
+  // lower the RPN into bytecode, the parameter is the only variable slot (slot 0)
+  const char *variableNames[] = {function->parameter};
+  CHECK_ERROR_CTX(ree_CompileRpn(scratch, &function->arena, function->rpn, function->rpnCount, variableNames, 1, &manager->parameters, &function->program), "Failed to compile RPN into bytecode.");
+
+  return ERR_SUCCESS;
+}
 
+// validates the 'f(x) =' / 'y =' header and copies the name and the parameter into the function
+// headerTokenCount is the number of tokens up to and including the equals sign
+static enum reh_error_code_e ree_ParseHeader(const char *definition, const struct ree_token_t *tokens, int tokenCount, struct ree_function_t *function, int *headerTokenCount){
   // ---- f(x) = ... ----
   // tokens[0].token_type MUST be an identifier (for example: f) and CAN'T be y (due to the support for y = ...)
   // tokens[1].token_type MUST be an open parenthesis '('
@@ -106,86 +263,236 @@ enum reh_error_code_e ree_ParseFunction(char *definition, struct ree_function_t
   // tokens[1].token_type MUST be an equals sign '='
   bool isYFunctionDefinition = false;
 
+  if (tokenCount < 2){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function definition is incomplete: %s", definition);
+  }
+
   // check for function identifier and make sure its not longer than the allowed size (to prevent buffer overflow)
   if (tokens[0].token_type != TOKEN_IDENTIFIER){
-    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function identifier incorrect: %s instead of %s with value: %s", ree_TokenToStr(tokens[0].token_type), ree_TokenToStr(TOKEN_IDENTIFIER), tokens[0].value);
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function identifier incorrect: %s instead of %s with value: %.*s", ree_TokenToStr(tokens[0].token_type), ree_TokenToStr(TOKEN_IDENTIFIER), tokens[0].length, ree_TokenText(definition, &tokens[0]));
   }
-  else if (strlen(tokens[0].value) > (unsigned long)MAX_FN_NAME_LEN){
-    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function identifier too long: %zu chars. Max length: %d chars.", strlen(tokens[0].value), MAX_FN_NAME_LEN);
+  else if (tokens[0].length > MAX_FN_NAME_LEN){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function identifier too long: %d chars. Max length: %d chars.", tokens[0].length, MAX_FN_NAME_LEN);
   }
-  else if (strcmp(tokens[0].value, "y") == 0){
-    isYFunctionDefinition = true;
+  else if (ree_IsBuiltinFunctionName(definition, &tokens[0]) == true){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function identifier %.*s is a built-in function.", tokens[0].length, ree_TokenText(definition, &tokens[0]));
   }
-  else if (ree_IsFunctionInManager(manager, tokens[0].value) == true){
-    // function with the same name already exists
-    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function with the same name (%s) already exists!", tokens[0].value);
+  else if (ree_TokenEquals(definition, &tokens[0], "y") == true){
+    isYFunctionDefinition = true;
   }
 
+  // the name is validated, copy it out of the definition
+  memcpy(function->name, ree_TokenText(definition, &tokens[0]), (size_t)tokens[0].length);
+  function->name[tokens[0].length] = '\0';
+
   // check for left parentheses '(' or '='
   if (tokens[1].token_type != TOKEN_EQUALS && isYFunctionDefinition == true){
-    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function equals (for function definition such as y = ...) incorrect: %s instead of %s with value: %s", ree_TokenToStr(tokens[1].token_type), ree_TokenToStr(TOKEN_PAREN_OPEN), tokens[1].value);
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function equals (for function definition such as y = ...) incorrect: %s instead of %s with value: %.*s", ree_TokenToStr(tokens[1].token_type), ree_TokenToStr(TOKEN_PAREN_OPEN), tokens[1].length, ree_TokenText(definition, &tokens[1]));
   }
   else if (tokens[1].token_type != TOKEN_PAREN_OPEN && isYFunctionDefinition == false){
-    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function open parenthesis incorrect: %s instead of %s with value: %s", ree_TokenToStr(tokens[1].token_type), ree_TokenToStr(TOKEN_PAREN_OPEN), tokens[1].value);
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function open parenthesis incorrect: %s instead of %s with value: %.*s", ree_TokenToStr(tokens[1].token_type), ree_TokenToStr(TOKEN_PAREN_OPEN), tokens[1].length, ree_TokenText(definition, &tokens[1]));
+  }
+
+  if (isYFunctionDefinition == false && tokenCount < 5){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function definition is incomplete: %s", definition);
   }
 
   // check for parameter, make sure it doesn't match the function identifier and make sure its not longer than allowed (to prevent buffer overflow) only in the case the 'f(x)' style function definition was inputted
-  if (tokens[2].token_type != TOKEN_IDENTIFIER && isYFunctionDefinition == false){
-    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function parameter incorrect: %s instead of %s with value: %s", ree_TokenToStr(tokens[2].token_type), ree_TokenToStr(TOKEN_IDENTIFIER), tokens[2].value);
+  if (isYFunctionDefinition == false && tokens[2].token_type != TOKEN_IDENTIFIER){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function parameter incorrect: %s instead of %s with value: %.*s", ree_TokenToStr(tokens[2].token_type), ree_TokenToStr(TOKEN_IDENTIFIER), tokens[2].length, ree_TokenText(definition, &tokens[2]));
   }
-  else if (strcmp(tokens[0].value, tokens[2].value) == 0 && isYFunctionDefinition == false){
+  else if (isYFunctionDefinition == false && ree_TokenEquals(definition, &tokens[2], function->name) == true){
     SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function identifier cannot be the same as the parameter.");
   }
-  else if (strlen(tokens[2].value) > (unsigned long)MAX_PARAM_NAME_LEN && isYFunctionDefinition == false){
-    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function parameter too long: %zu chars. Max length: %d chars.", strlen(tokens[2].value), MAX_PARAM_NAME_LEN);
+  else if (isYFunctionDefinition == false && tokens[2].length > MAX_PARAM_NAME_LEN){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function parameter too long: %d chars. Max length: %d chars.", tokens[2].length, MAX_PARAM_NAME_LEN);
+  }
+  else if (isYFunctionDefinition == false && ree_IsBuiltinFunctionName(definition, &tokens[2]) == true){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function parameter %.*s is a built-in function.", tokens[2].length, ree_TokenText(definition, &tokens[2]));
   }else 
 
   // check for right parenthesis ')' only in the case the 'f(x)' style function definition was inputted
-  if (tokens[3].token_type != TOKEN_PAREN_CLOSE && isYFunctionDefinition == false){
-    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function close parenthesis incorrect: %s instead of %s with value: %s", ree_TokenToStr(tokens[3].token_type), ree_TokenToStr(TOKEN_PAREN_CLOSE), tokens[3].value);
+  if (isYFunctionDefinition == false && tokens[3].token_type != TOKEN_PAREN_CLOSE){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function close parenthesis incorrect: %s instead of %s with value: %.*s", ree_TokenToStr(tokens[3].token_type), ree_TokenToStr(TOKEN_PAREN_CLOSE), tokens[3].length, ree_TokenText(definition, &tokens[3]));
   }
 
   // check for equals sign '=' only in the case the 'f(x)' style function definition was inputted
-  if (tokens[4].token_type != TOKEN_EQUALS && isYFunctionDefinition == false){
-    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function equals sign incorrect: %s instead of %s with value: %s", ree_TokenToStr(tokens[4].token_type), ree_TokenToStr(TOKEN_EQUALS), tokens[4].value);
+  if (isYFunctionDefinition == false && tokens[4].token_type != TOKEN_EQUALS){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function equals sign incorrect: %s instead of %s with value: %.*s", ree_TokenToStr(tokens[4].token_type), ree_TokenToStr(TOKEN_EQUALS), tokens[4].length, ree_TokenText(definition, &tokens[4]));
   }
 
   // all valid, proceed to fill the function struct
-  strcpy(function->name, tokens[0].value);
-  (isYFunctionDefinition == true) ? strcpy(function->parameter, "x") : strcpy(function->parameter, tokens[2].value);
+  if (isYFunctionDefinition == true){
+    strcpy(function->parameter, "x");
+  }
+  else {
+    memcpy(function->parameter, ree_TokenText(definition, &tokens[2]), (size_t)tokens[2].length);
+    function->parameter[tokens[2].length] = '\0';
+  }
+
+  *headerTokenCount = (isYFunctionDefinition == true) ? 2 : 5;
+  return ERR_SUCCESS;
+}
 
-  // fill tokens array with all tokens besides the ones defining the function name and variable (as the parser doesn't handle 'f(x) =' or 'y =')
-  // allocate token array
-  function->tokens = malloc((long unsigned int)tokenCount * sizeof(struct ree_token_t));
-  if (function->tokens == NULL){
-    free(function->tokens);
-    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate memory for function tokens.");
+// builds the RPN and bytecode of a definition from its lexed tokens
+// scratch memory comes from the manager, everything the function keeps comes from its own arena
+static enum reh_error_code_e ree_BuildFunction(char *definition, struct ree_token_t **tokenBuffer, int *tokenCount, int *tokenCapacity, struct ree_function_t *function, struct ree_function_manager_t *manager){
+  struct rma_arena_t *scratch = &manager->scratch;
+  struct ree_token_t *tokens = *tokenBuffer;
+
+  int fnDefTokenCount;
+  enum reh_error_code_e err = ree_ParseHeader(definition, tokens, *tokenCount, function, &fnDefTokenCount);
+  if (err != ERR_SUCCESS){
+    return err;
   }
 
-  int j = 0;
-  int fnDefTokenCount = (isYFunctionDefinition == true) ? 2 : 5;
-  for (int i = fnDefTokenCount; i < tokenCount; i++, j++){
-    function->tokens[j] = tokens[i];
+  // drop the tokens defining the function name and variable (as the parser doesn't handle 'f(x) =' or 'y =')
+  // the tokens are only needed until the RPN is built, the function keeps the compact RPN and the bytecode
+  int bodyTokenCount = *tokenCount - fnDefTokenCount;
+  if (bodyTokenCount <= 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Function %s has no definition after the equals sign.", function->name);
   }
 
-  function->tokenCount = j;
-  function->tokenCapacity = j;
+  memmove(tokens, &tokens[fnDefTokenCount], (size_t)bodyTokenCount * sizeof(struct ree_token_t));
+  *tokenCount = bodyTokenCount;
+
+  // calls of other functions have to be known before implicit multiplication, g(2x) isn't g * (2x)
+  CHECK_ERROR_CTX(ree_MarkFunctionCalls(definition, tokens, *tokenCount, function, manager), "Failed to resolve function calls.");
 
   // support for implicit multiplication
-  ree_ImplicitMultiplication(&function->tokens, &function->tokenCount, &function->tokenCapacity);
+  CHECK_ERROR_CTX(ree_ImplicitMultiplication(scratch, definition, tokenBuffer, tokenCount, tokenCapacity), "Failed to insert implicit multiplication.");
+  tokens = *tokenBuffer;
 
   // allocate RPN array
-  function->rpn = malloc((long unsigned int)function->tokenCount * sizeof(struct ree_output_token_t));
-  if (function->rpn == NULL){
-    free(function->tokens);
+  function->rpn = rma_Alloc(&function->arena, (size_t)*tokenCount * sizeof(struct ree_output_token_t));
+  if (function->rpn == nullptr){
     SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate memory for RPN array.");
   }
 
   // mark unary operators, parse and assign the result
-  CHECK_ERROR_CTX(ree_MarkUnaryOperators(function->tokens, function->tokenCount), "Failed to mark unary operators.");
-  CHECK_ERROR_CTX(ree_ParseToPostfix(function->tokens, function->tokenCount, function->rpn, &function->rpnCount), "Failed to parse tokens into RPN.");
+  CHECK_ERROR_CTX(ree_MarkUnaryOperators(tokens, *tokenCount), "Failed to mark unary operators.");
+  CHECK_ERROR_CTX(ree_ParseToPostfix(scratch, definition, tokens, *tokenCount, function->rpn, &function->rpnCount), "Failed to parse tokens into RPN.");
+
+  return ree_CompileFunction(manager, function);
+}
+
+// lexes just the 'f(x) =' / 'y =' header and looks the normalized body up in the parse cache of the manager
+// nothing is reported if the header is invalid, the full parse runs and explains what's wrong with it
+static enum reh_error_code_e ree_FindCachedBody(const char *definition, struct ree_function_t *function, struct ree_function_manager_t *manager, char **key, size_t *keyLength, uint64_t *hash, bool *cacheable, struct ree_parse_cache_entry_t **entry){
+  const char *equals = strchr(definition, '=');
+  if (equals == nullptr){
+    return ERR_SUCCESS;
+  }
+
+  // a header with anything else is invalid, leave it to the full parse so the lexer error is only logged once
+  const size_t headerLength = (size_t)(equals - definition) + 1;
+  for (size_t i = 0; i + 1 < headerLength; ++i){
+    if (isalpha((unsigned char)definition[i]) == 0 && strchr(" \t\n\r()", definition[i]) == nullptr){
+      return ERR_SUCCESS;
+    }
+  }
+
+  char *header = rma_Alloc(&manager->scratch, headerLength + 1);
+  if (header == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the function header.");
+  }
+  memcpy(header, definition, headerLength);
+  header[headerLength] = '\0';
+
+  struct ree_token_t *tokens = nullptr;
+  int tokenCount = 0;
+  int tokenCapacity = 0;
+  int headerTokenCount = 0;
+  if (ree_Lexer(&manager->scratch, header, &tokens, &tokenCount, &tokenCapacity) != ERR_SUCCESS ||
+      ree_ParseHeader(header, tokens, tokenCount, function, &headerTokenCount) != ERR_SUCCESS ||
+      headerTokenCount != tokenCount){
+    reh_ClearError();
+    return ERR_SUCCESS;
+  }
+
+  CHECK_ERROR_CTX(ree_ParseCacheKey(&manager->scratch, function->parameter, equals + 1, key, keyLength, hash, cacheable), "Failed to build the parse cache key.");
+  if (*cacheable == true){
+    *entry = ree_FindParseCacheEntry(&manager->parseCache, *key, *keyLength, *hash);
+  }
+
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e ree_ParseFunction(char *definition, struct ree_function_t *function, struct ree_function_manager_t *manager, struct rm_vec3_t *functionColor){
+  if (definition == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Definition passed to ree_ParseFunction is NULL.");
+  }
+  else if (function == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Function struct (ree_function_t) passed to ree_ParseFunction is NULL.");
+  }
+  else if (manager == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Manager passed to ree_ParseFunction is NULL.");
+  }
+  else if (functionColor == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Function color (rm_vec3_t) passed to ree_ParseFunction is NULL.");
+  }
+
+  rma_InitArena(&function->arena, &manager->pool);
+  function->cached = nullptr;
+
+  // a body compiled before is shared, only the header is lexed to find it
+  struct ree_parse_cache_entry_t *entry = nullptr;
+  char *key = nullptr;
+  size_t keyLength = 0;
+  uint64_t hash = 0;
+  bool cacheable = false;
+  enum reh_error_code_e err = ree_FindCachedBody(definition, function, manager, &key, &keyLength, &hash, &cacheable, &entry);
+
+  if (err == ERR_SUCCESS && entry == nullptr){
+    // lex once into a growable buffer, it's shared by every stage up to the shunting yard
+    struct ree_token_t *tokens = nullptr;
+    int tokenCount = 0;
+    int tokenCapacity = 0;
+
+    err = ree_Lexer(&manager->scratch, definition, &tokens, &tokenCount, &tokenCapacity);
+    if (err == ERR_SUCCESS){
+      err = ree_BuildFunction(definition, &tokens, &tokenCount, &tokenCapacity, function, manager);
+    }
+
+    // the cache takes over the function arena, the function shares it like any later definition with the same body
+    // a body the cache can't take is still a valid definition, the function just keeps its own copy
+    if (err == ERR_SUCCESS && cacheable == true && function->sourceRpn == nullptr &&
+        ree_InsertParseCacheEntry(&manager->parseCache, key, keyLength, hash, &function->arena, function->rpn, function->rpnCount, &function->program, &entry) != ERR_SUCCESS){
+      rl_LogMsg(RL_WARNING, "Failed to cache the body of %s: %s", function->name, reh_GetLastError()->message);
+      reh_ClearError();
+      entry = nullptr;
+    }
+  }
+
+  if (err == ERR_SUCCESS && entry != nullptr){
+    entry->referenceCount++;
+    function->cached = entry;
+    function->rpn = entry->rpn;
+    function->rpnCount = entry->rpnCount;
+    function->sourceRpn = nullptr;
+    function->sourceRpnCount = 0;
+    function->program = entry->program;
+  }
+
+  // key, tokens, operator stack, expression tree and DAG are all released here, whichever stage failed
+  rma_ResetArena(&manager->scratch);
+
+  if (err != ERR_SUCCESS){
+    // drop whatever the function got so far, the slot is reused by the next definition
+    rma_ResetArena(&function->arena);
+    function->rpn = nullptr;
+    function->rpnCount = 0;
+    function->sourceRpn = nullptr;
+    function->sourceRpnCount = 0;
+    memset(&function->program, 0, sizeof function->program);
+  }
+
+  CHECK_ERROR_CTX(err, "Failed to parse function definition: %s", definition);
 
-  // rendering data
+  // sampling and rendering data
+  function->precision = REE_PRECISION_AUTO;
+  function->mathMode = REE_MATH_DRAW;
+  function->sampleCount = 0;
   function->isVisible = true;
   function->color = *functionColor;
 
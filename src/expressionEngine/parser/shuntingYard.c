@@ -1,20 +1,16 @@
 #include "expressionEngine/parser/shuntingYard.h"
 #include "core/errorHandler.h"
+#include "core/logger.h"
 #include "expressionEngine/lexer.h"
 #include "expressionEngine/tokens.h"
-#include "utils/utilities.h"
 #include <stdlib.h>
-#include <string.h>
-#include <ctype.h>
-
-const char* validFunctions[] = {"sin", "cos", "tan", "sqrt", "abs", "ln", "log"};
-const int functionArrLength = sizeof(validFunctions) / sizeof(validFunctions[0]);
 
 const char* ree_OutputTokenToStr(enum ree_output_type_e outputToken){
   switch (outputToken){
     case OUTPUT_NUMBER:   return "OUTPUT_NUMBER";
     case OUTPUT_OPERATOR: return "OUTPUT_OPERATOR";
     case OUTPUT_FUNCTION: return "OUTPUT_FUNCTION";
+    case OUTPUT_VARIABLE: return "OUTPUT_VARIABLE";
     default: return "Unknown Output Token";
   }
 }
@@ -59,6 +55,7 @@ int ree_DetermineArity(enum ree_token_type_e tokenType){
     case TOKEN_UNARY_MINUS:
     case TOKEN_FACTORIAL:
     case TOKEN_IDENTIFIER:
+    case TOKEN_FUNCTION:
       return 1;
 
     case TOKEN_PLUS:
@@ -80,9 +77,6 @@ enum reh_error_code_e ree_MarkUnaryOperators(struct ree_token_t *tokens, const i
   else if (tokenCount <= 0){
     SET_ERROR_RETURN(ERR_INVALID_INPUT, "tokenCount passed to ree_MarkUnaryOperators is less than or equal to 0.");
   }
-  else if (tokenCount > REE_MAX_TOKENS){
-    SET_ERROR_RETURN(ERR_INVALID_INPUT, "tokenCount passed to ree_MarkUnaryOperators exceeds maximum allowed tokens (%d > %d).", tokenCount, REE_MAX_TOKENS);
-  }
 
   struct ree_token_t currentToken, previousToken;
 
@@ -141,62 +135,87 @@ enum reh_error_code_e ree_MarkUnaryOperators(struct ree_token_t *tokens, const i
   return ERR_SUCCESS;
 }
 
-enum reh_error_code_e ree_ParseToPostfix(struct ree_token_t *tokens, const int tokenCount, struct ree_output_token_t *outputQueue, int *outputCount){
-  if (outputCount == nullptr){
-    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to outputCount in ree_ParseToPostfix is NULL.");
-  }
-  else if (tokens == nullptr){
-    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Tokens array passed to ree_ParseToPostfix is NULL.");
-  }
-  else if (outputQueue == nullptr){
-    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Output queue passed to ree_ParseToPostfix is NULL.");
+// resolves the symbol id of a token popped off the operator stack (operator or function identifier)
+static enum reh_error_code_e ree_StackTokenSymbol(const char *expression, const struct ree_token_t *token, uint16_t *symbol){
+  switch (token->token_type){
+    case TOKEN_PLUS:        *symbol = SYMBOL_ADD;  return ERR_SUCCESS;
+    case TOKEN_MINUS:       *symbol = SYMBOL_SUB;  return ERR_SUCCESS;
+    case TOKEN_MULTIPLY:    *symbol = SYMBOL_MUL;  return ERR_SUCCESS;
+    case TOKEN_DIVIDE:      *symbol = SYMBOL_DIV;  return ERR_SUCCESS;
+    case TOKEN_POWER:       *symbol = SYMBOL_POW;  return ERR_SUCCESS;
+    case TOKEN_FACTORIAL:   *symbol = SYMBOL_FACT; return ERR_SUCCESS;
+    // the raw '-' and '+' would cause a stack underflow when evaluated as binary operators
+    case TOKEN_UNARY_MINUS: *symbol = SYMBOL_NEG;  return ERR_SUCCESS;
+    case TOKEN_UNARY_PLUS:  *symbol = SYMBOL_POS;  return ERR_SUCCESS;
+    case TOKEN_IDENTIFIER:
+    case TOKEN_FUNCTION:    return ree_InternSymbol(ree_TokenText(expression, token), token->length, symbol);
+    default:
+      SET_ERROR_RETURN(ERR_INVALID_OPERATOR, "Token of type %s has no operator symbol.", ree_TokenToStr(token->token_type));
   }
+}
 
-  if (tokenCount <= 0){
-    SET_ERROR_RETURN(ERR_INVALID_INPUT, "tokenCount passed to ree_ParseToPostfix is less than or equal to 0.");
-  }
-  if (tokenCount > REE_MAX_TOKENS){
-    SET_ERROR_RETURN(ERR_INVALID_INPUT, "tokenCount passed to ree_ParseToPostfix exceeds maximum allowed tokens (%d > %d).", tokenCount, REE_MAX_TOKENS);
-  }
+// pops the operator stack top into the output queue
+static enum reh_error_code_e ree_EmitStackToken(const char *expression, const struct ree_token_t *token, struct ree_output_token_t *outputQueue, int *outputCount){
+  uint16_t symbol;
+  CHECK_ERROR_CTX(ree_StackTokenSymbol(expression, token, &symbol), "Failed to resolve operator symbol.");
+
+  struct ree_output_token_t outputToken = {
+    .type = (token->token_type == TOKEN_IDENTIFIER || token->token_type == TOKEN_FUNCTION) ? OUTPUT_FUNCTION : OUTPUT_OPERATOR,
+    .arity = (uint8_t)ree_DetermineArity(token->token_type),
+    .symbol = symbol,
+    .value = 0.0f // not used in the case of an operator
+  };
 
+  outputQueue[*outputCount] = outputToken;
+  (*outputCount)++;
+
+  return ERR_SUCCESS;
+}
+
+// the shunting yard itself, stack is scratch space for at least tokenCount operator tokens
+static enum reh_error_code_e ree_ShuntingYard(const char *expression, struct ree_token_t *tokens, const int tokenCount, struct ree_token_t *stack, struct ree_output_token_t *outputQueue, int *outputCount){
   *outputCount = 0;
   int operatorStackPointer = 0;
-  struct ree_token_t stack[tokenCount];
 
   for (int i = 0; i < tokenCount; i++){
     struct ree_token_t currentToken = tokens[i];
 
     if (currentToken.token_type == TOKEN_NUMBER){
+      // the lexer only reads digits, so the span is always a valid prefix for strtof
       struct ree_output_token_t outputToken = {
         .type = OUTPUT_NUMBER,
         .arity = 0,
-        .value = strtof(currentToken.value, NULL)
+        .symbol = SYMBOL_NONE,
+        .value = strtof(ree_TokenText(expression, &currentToken), NULL)
       };
-      strcpy(outputToken.symbol, currentToken.value);
 
       outputQueue[*outputCount] = outputToken;
       (*outputCount)++;
     }
     else if (currentToken.token_type == TOKEN_IDENTIFIER){ 
+      uint16_t symbol;
+      CHECK_ERROR_CTX(ree_InternSymbol(ree_TokenText(expression, &currentToken), currentToken.length, &symbol), "Failed to intern identifier.");
+
       // check if the identifier matches any of the supported functions 
-      if (rgu_IsStrInArray(validFunctions, functionArrLength, currentToken.value) == true){
+      if (ree_IsFunctionSymbol(symbol) == true){
         stack[operatorStackPointer++] = currentToken;
       }
-      // check if its a parameter
-      else if (isalpha(currentToken.value[0])){
+      // otherwise its a parameter
+      else {
         struct ree_output_token_t outputToken = {
-          .type = OUTPUT_NUMBER,
+          .type = OUTPUT_VARIABLE,
           .arity = 0,
+          .symbol = symbol,
           .value = 0.0f // the evaluator will substitute this
         };
-        strcpy(outputToken.symbol, currentToken.value);
 
         outputQueue[*outputCount] = outputToken;
         (*outputCount)++;
       }
-      else { // unknown identifier
-        SET_ERROR_RETURN(ERR_UNKNOWN_IDENTIFIER, "Unknown identifier: %s", currentToken.value);
-      }
+    }
+    // call of a user defined function, it's always followed by '(' and emitted as a function with the name as its symbol
+    else if (currentToken.token_type == TOKEN_FUNCTION){
+      stack[operatorStackPointer++] = currentToken;
     }
     else if (currentToken.token_type == TOKEN_PAREN_OPEN){
         stack[operatorStackPointer++] = currentToken;
@@ -217,15 +236,7 @@ enum reh_error_code_e ree_ParseToPostfix(struct ree_token_t *tokens, const int t
           break;
         }
         else {
-          struct ree_output_token_t outputToken = {
-            .type = OUTPUT_OPERATOR,
-            .arity = ree_DetermineArity(topOperator.token_type),
-            .value = 0.0f // not used in the case of an operator
-          };
-          strcpy(outputToken.symbol, topOperator.value);
-
-          outputQueue[*outputCount] = outputToken;
-          (*outputCount)++;
+          CHECK_ERROR_CTX(ree_EmitStackToken(expression, &topOperator, outputQueue, outputCount), "Failed to emit operator.");
         }
       }
 
@@ -235,27 +246,18 @@ enum reh_error_code_e ree_ParseToPostfix(struct ree_token_t *tokens, const int t
       }
 
       // check if theres a function on top of the stack (e.g. "sin(...")
-      if (operatorStackPointer != 0 && stack[operatorStackPointer - 1].token_type == TOKEN_IDENTIFIER){
+      if (operatorStackPointer != 0 && (stack[operatorStackPointer - 1].token_type == TOKEN_IDENTIFIER || stack[operatorStackPointer - 1].token_type == TOKEN_FUNCTION)){
         struct ree_token_t functionToken = stack[--operatorStackPointer];
-
-        struct ree_output_token_t outputToken = {
-          .type = OUTPUT_FUNCTION,
-          .arity = ree_DetermineArity(functionToken.token_type),
-          .value = 0.0f // not used in the case of an operator
-        };
-        strcpy(outputToken.symbol, functionToken.value);
-
-        outputQueue[*outputCount] = outputToken;
-        (*outputCount)++;
+        CHECK_ERROR_CTX(ree_EmitStackToken(expression, &functionToken, outputQueue, outputCount), "Failed to emit function.");
       }
     }
     else if (currentToken.token_type == TOKEN_FACTORIAL){
       struct ree_output_token_t outputToken = {
         .type = OUTPUT_FUNCTION,
-        .arity = ree_DetermineArity(currentToken.token_type),
+        .arity = (uint8_t)ree_DetermineArity(currentToken.token_type),
+        .symbol = SYMBOL_FACT,
         .value = 0.0f // not used in the case of an operator
       };
-      strcpy(outputToken.symbol, currentToken.value);
 
       outputQueue[*outputCount] = outputToken;
       (*outputCount)++;
@@ -302,27 +304,7 @@ enum reh_error_code_e ree_ParseToPostfix(struct ree_token_t *tokens, const int t
 
         if (shouldPop == true){
           struct ree_token_t poppedOperator = stack[--operatorStackPointer];
- 
-          const char* symbolName;
-          if (poppedOperator.token_type == TOKEN_UNARY_MINUS){
-            symbolName = "NEG";
-          }
-          else if (poppedOperator.token_type == TOKEN_UNARY_PLUS){
-            symbolName = "POS";
-          }
-          else {
-            symbolName = poppedOperator.value;
-          }
-
-          struct ree_output_token_t outputToken = {
-            .type = OUTPUT_OPERATOR,
-            .arity = ree_DetermineArity(poppedOperator.token_type),
-            .value = 0.0f // not used in the case of an operator
-          };
-          strcpy(outputToken.symbol, symbolName);
-
-          outputQueue[*outputCount] = outputToken;
-          (*outputCount)++;
+          CHECK_ERROR_CTX(ree_EmitStackToken(expression, &poppedOperator, outputQueue, outputCount), "Failed to emit operator.");
         }
         else {
           break;
@@ -345,30 +327,39 @@ enum reh_error_code_e ree_ParseToPostfix(struct ree_token_t *tokens, const int t
     if (remainingOperator.token_type == TOKEN_PAREN_OPEN){
       SET_ERROR_RETURN(ERR_INVALID_INPUT, "Mismatched parentheses: extra '('");
     }
-    // here because the parser would push the raw operator ('-', '+') even for the unary operator, thus causing stack underflow while attempting to sample the function using them
-    const char *symbolName;
-    if (remainingOperator.token_type == TOKEN_UNARY_MINUS){
-      symbolName = "NEG";
-    }
-    else if (remainingOperator.token_type == TOKEN_UNARY_PLUS){
-      symbolName = "POS";
-    }
-    else {
-      symbolName = remainingOperator.value;
-    }
 
-    enum ree_output_type_e outputTokenType = (remainingOperator.token_type == TOKEN_IDENTIFIER) ? OUTPUT_FUNCTION : OUTPUT_OPERATOR;
+    CHECK_ERROR_CTX(ree_EmitStackToken(expression, &remainingOperator, outputQueue, outputCount), "Failed to emit operator.");
+  }
 
-    struct ree_output_token_t outputToken = {
-      .type =  outputTokenType,
-      .arity = ree_DetermineArity(remainingOperator.token_type),
-      .value = 0.0f // not used in the case of an operator
-    };
-    strcpy(outputToken.symbol, symbolName);
+  return ERR_SUCCESS;
+}
 
-    outputQueue[*outputCount] = outputToken;
-    (*outputCount)++;
+enum reh_error_code_e ree_ParseToPostfix(struct rma_arena_t *arena, const char *expression, struct ree_token_t *tokens, const int tokenCount, struct ree_output_token_t *outputQueue, int *outputCount){
+  if (arena == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Arena passed to ree_ParseToPostfix is NULL.");
+  }
+  else if (outputCount == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to outputCount in ree_ParseToPostfix is NULL.");
+  }
+  else if (expression == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Expression passed to ree_ParseToPostfix is NULL.");
+  }
+  else if (tokens == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Tokens array passed to ree_ParseToPostfix is NULL.");
+  }
+  else if (outputQueue == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Output queue passed to ree_ParseToPostfix is NULL.");
   }
 
-  return ERR_SUCCESS;
+  if (tokenCount <= 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "tokenCount passed to ree_ParseToPostfix is less than or equal to 0.");
+  }
+
+  // the operator stack doesn't live on the call stack, machine-generated definitions can have thousands of tokens
+  struct ree_token_t *stack = rma_Alloc(arena, (size_t)tokenCount * sizeof(struct ree_token_t));
+  if (stack == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the operator stack in ree_ParseToPostfix.");
+  }
+
+  return ree_ShuntingYard(expression, tokens, tokenCount, stack, outputQueue, outputCount);
 }
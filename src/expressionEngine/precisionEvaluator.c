@@ -0,0 +1,386 @@
+#include "expressionEngine/evaluator.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+#include "expressionEngine/compiler.h"
+#include "math/doubleDouble.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+// the largest factorial a double can hold is 170!
+#define REE_MAX_FACTORIAL_DOUBLE 170
+
+// domain checks of the double-double tier, matches FLT_EPSILON / DBL_EPSILON of the other tiers
+#define REE_DD_EPSILON (DBL_EPSILON * DBL_EPSILON)
+
+// the compiler guarantees every instruction finds its operands, pops aren't checked
+#define POP_2_NUMS()                    \
+    num2 = stack[--stackIndex];         \
+    num1 = stack[--stackIndex];
+
+#define POP_1_NUM()                     \
+    num1 = stack[--stackIndex];
+
+#define DOMAIN_FAILURE(code, nan)       \
+    *status = (uint8_t)(code);          \
+    *result = (nan);                    \
+    return ERR_SUCCESS;
+
+const char* ree_PrecisionToStr(enum ree_precision_e precision){
+  switch (precision){
+    case REE_PRECISION_AUTO:          return "auto";
+    case REE_PRECISION_FLOAT:         return "float";
+    case REE_PRECISION_DOUBLE:        return "double";
+    case REE_PRECISION_DOUBLE_DOUBLE: return "double-double";
+    default:                          return "Unknown precision";
+  }
+}
+
+enum ree_precision_e ree_SelectPrecision(enum ree_precision_e requested, double rangeMin, double rangeMax, double step){
+  if (requested != REE_PRECISION_AUTO){
+    return requested;
+  }
+
+  // the spacing of representable x values around the range has to stay well below the step
+  double magnitude = fmax(fabs(rangeMin), fabs(rangeMax));
+  if (magnitude * (double)FLT_EPSILON * REE_PRECISION_HEADROOM <= step){
+    return REE_PRECISION_FLOAT;
+  }
+  else if (magnitude * DBL_EPSILON * REE_PRECISION_HEADROOM <= step){
+    return REE_PRECISION_DOUBLE;
+  }
+  return REE_PRECISION_DOUBLE_DOUBLE;
+}
+
+/*
+  ##########
+  # DOUBLE #
+  ##########
+*/
+static enum reh_error_code_e ree_RunProgramDouble(const struct ree_program_t *program, const double *variables, double *result, uint8_t *status){
+  double stack[REE_MAX_STACK_DEPTH];
+  size_t stackIndex = 0;
+  double temps[REE_MAX_TEMP_SLOTS];
+  double num1, num2;
+
+  const uint8_t *code = program->code;
+  const uint8_t *end = program->code + program->codeSize;
+
+  while (code < end){
+    switch ((enum ree_opcode_e)*code++){
+      case OP_CONST: {
+        float value;
+        memcpy(&value, code, sizeof(float));
+        code += sizeof(float);
+        stack[stackIndex++] = (double)value;
+        break;
+      }
+      case OP_VAR: {
+        if (variables == nullptr){
+          SET_ERROR_RETURN(ERR_INVALID_POINTER, "Program references a variable but no variables were provided to ree_EvaluateProgramDouble.");
+        }
+        stack[stackIndex++] = variables[*code++];
+        break;
+      }
+      case OP_STORE: {
+        temps[*code++] = stack[stackIndex - 1];
+        break;
+      }
+      case OP_LOAD: {
+        stack[stackIndex++] = temps[*code++];
+        break;
+      }
+      case OP_PARAM: {
+        stack[stackIndex++] = (double)program->parameters[*code++];
+        break;
+      }
+      case OP_ADD: POP_2_NUMS(); stack[stackIndex++] = num1 + num2; break;
+      case OP_SUB: POP_2_NUMS(); stack[stackIndex++] = num1 - num2; break;
+      case OP_MUL: POP_2_NUMS(); stack[stackIndex++] = num1 * num2; break;
+      case OP_DIV: {
+        POP_2_NUMS();
+        if (fabs(num2) < DBL_EPSILON){
+          DOMAIN_FAILURE(REE_EVAL_DIVISION_BY_ZERO, NAN);
+        }
+        stack[stackIndex++] = num1 / num2;
+        break;
+      }
+      case OP_POW: POP_2_NUMS(); stack[stackIndex++] = pow(num1, num2); break;
+      case OP_FACT: {
+        POP_1_NUM();
+        if (!(fabs(num1 - round(num1)) < DBL_EPSILON) || num1 < 0){
+          DOMAIN_FAILURE(REE_EVAL_FACTORIAL_DOMAIN, NAN);
+        }
+        int n = (num1 > REE_MAX_FACTORIAL_DOUBLE) ? REE_MAX_FACTORIAL_DOUBLE + 1 : (int)round(num1);
+        double factorial = 1.0;
+        for (int i = 2; i <= n; ++i) factorial *= i;
+        stack[stackIndex++] = factorial;
+        break;
+      }
+      case OP_NEG: POP_1_NUM(); stack[stackIndex++] = -num1; break;
+      case OP_POS: POP_1_NUM(); stack[stackIndex++] = num1; break;
+      case OP_SIN: POP_1_NUM(); stack[stackIndex++] = sin(num1); break;
+      case OP_COS: POP_1_NUM(); stack[stackIndex++] = cos(num1); break;
+      case OP_TAN: {
+        POP_1_NUM();
+        if (fabs(cos(num1)) < DBL_EPSILON){
+          DOMAIN_FAILURE(REE_EVAL_TAN_DOMAIN, NAN);
+        }
+        stack[stackIndex++] = tan(num1);
+        break;
+      }
+      case OP_SQRT: {
+        POP_1_NUM();
+        if (num1 < 0){
+          DOMAIN_FAILURE(REE_EVAL_SQRT_DOMAIN, NAN);
+        }
+        stack[stackIndex++] = sqrt(num1);
+        break;
+      }
+      case OP_ABS: POP_1_NUM(); stack[stackIndex++] = fabs(num1); break;
+      case OP_LN: {
+        POP_1_NUM();
+        if (num1 <= 0){
+          DOMAIN_FAILURE(REE_EVAL_LN_DOMAIN, NAN);
+        }
+        stack[stackIndex++] = log(num1);
+        break;
+      }
+      case OP_LOG: {
+        POP_1_NUM();
+        if (num1 <= 0){
+          DOMAIN_FAILURE(REE_EVAL_LOG_DOMAIN, NAN);
+        }
+        stack[stackIndex++] = log10(num1);
+        break;
+      }
+      default:
+        SET_ERROR_RETURN(ERR_INVALID_OPERATOR, "Provided opcode (%u) is unknown.", code[-1]);
+    }
+  }
+
+  *result = stack[0];
+  *status = REE_EVAL_OK;
+
+  return ERR_SUCCESS;
+}
+
+/*
+  #################
+  # DOUBLE-DOUBLE #
+  #################
+*/
+static enum reh_error_code_e ree_RunProgramDoubleDouble(const struct ree_program_t *program, const struct rm_dd_t *variables, struct rm_dd_t *result, uint8_t *status){
+  static const struct rm_dd_t DD_NAN = {NAN, 0.0};
+
+  struct rm_dd_t stack[REE_MAX_STACK_DEPTH];
+  size_t stackIndex = 0;
+  struct rm_dd_t temps[REE_MAX_TEMP_SLOTS];
+  struct rm_dd_t num1, num2;
+
+  const uint8_t *code = program->code;
+  const uint8_t *end = program->code + program->codeSize;
+
+  while (code < end){
+    switch ((enum ree_opcode_e)*code++){
+      case OP_CONST: {
+        float value;
+        memcpy(&value, code, sizeof(float));
+        code += sizeof(float);
+        stack[stackIndex++] = rm_DdFromDouble((double)value);
+        break;
+      }
+      case OP_VAR: {
+        if (variables == nullptr){
+          SET_ERROR_RETURN(ERR_INVALID_POINTER, "Program references a variable but no variables were provided to ree_EvaluateProgramDoubleDouble.");
+        }
+        stack[stackIndex++] = variables[*code++];
+        break;
+      }
+      case OP_STORE: {
+        temps[*code++] = stack[stackIndex - 1];
+        break;
+      }
+      case OP_LOAD: {
+        stack[stackIndex++] = temps[*code++];
+        break;
+      }
+      case OP_PARAM: {
+        stack[stackIndex++] = rm_DdFromDouble((double)program->parameters[*code++]);
+        break;
+      }
+      case OP_ADD: POP_2_NUMS(); stack[stackIndex++] = rm_DdAdd(num1, num2); break;
+      case OP_SUB: POP_2_NUMS(); stack[stackIndex++] = rm_DdSub(num1, num2); break;
+      case OP_MUL: POP_2_NUMS(); stack[stackIndex++] = rm_DdMul(num1, num2); break;
+      case OP_DIV: {
+        POP_2_NUMS();
+        if (fabs(num2.hi) < REE_DD_EPSILON){
+          DOMAIN_FAILURE(REE_EVAL_DIVISION_BY_ZERO, DD_NAN);
+        }
+        stack[stackIndex++] = rm_DdDiv(num1, num2);
+        break;
+      }
+      case OP_POW: POP_2_NUMS(); stack[stackIndex++] = rm_DdPow(num1, num2); break;
+      case OP_FACT: {
+        POP_1_NUM();
+        double rounded = round(num1.hi);
+        if (!(fabs((num1.hi - rounded) + num1.lo) < REE_DD_EPSILON) || rounded < 0){
+          DOMAIN_FAILURE(REE_EVAL_FACTORIAL_DOMAIN, DD_NAN);
+        }
+        int n = (rounded > REE_MAX_FACTORIAL_DOUBLE) ? REE_MAX_FACTORIAL_DOUBLE + 1 : (int)rounded;
+        struct rm_dd_t factorial = rm_DdFromDouble(1.0);
+        for (int i = 2; i <= n; ++i) factorial = rm_DdMul(factorial, rm_DdFromDouble((double)i));
+        stack[stackIndex++] = factorial;
+        break;
+      }
+      case OP_NEG: POP_1_NUM(); stack[stackIndex++] = rm_DdNeg(num1); break;
+      case OP_POS: POP_1_NUM(); stack[stackIndex++] = num1; break;
+      case OP_SIN: POP_1_NUM(); stack[stackIndex++] = rm_DdSin(num1); break;
+      case OP_COS: POP_1_NUM(); stack[stackIndex++] = rm_DdCos(num1); break;
+      case OP_TAN: {
+        POP_1_NUM();
+        if (fabs(rm_DdCos(num1).hi) < REE_DD_EPSILON){
+          DOMAIN_FAILURE(REE_EVAL_TAN_DOMAIN, DD_NAN);
+        }
+        stack[stackIndex++] = rm_DdTan(num1);
+        break;
+      }
+      case OP_SQRT: {
+        POP_1_NUM();
+        if (num1.hi < 0){
+          DOMAIN_FAILURE(REE_EVAL_SQRT_DOMAIN, DD_NAN);
+        }
+        stack[stackIndex++] = rm_DdSqrt(num1);
+        break;
+      }
+      case OP_ABS: POP_1_NUM(); stack[stackIndex++] = rm_DdAbs(num1); break;
+      case OP_LN: {
+        POP_1_NUM();
+        if (num1.hi <= 0){
+          DOMAIN_FAILURE(REE_EVAL_LN_DOMAIN, DD_NAN);
+        }
+        stack[stackIndex++] = rm_DdLn(num1);
+        break;
+      }
+      case OP_LOG: {
+        POP_1_NUM();
+        if (num1.hi <= 0){
+          DOMAIN_FAILURE(REE_EVAL_LOG_DOMAIN, DD_NAN);
+        }
+        stack[stackIndex++] = rm_DdLog10(num1);
+        break;
+      }
+      default:
+        SET_ERROR_RETURN(ERR_INVALID_OPERATOR, "Provided opcode (%u) is unknown.", code[-1]);
+    }
+  }
+
+  *result = stack[0];
+  *status = REE_EVAL_OK;
+
+  return ERR_SUCCESS;
+}
+
+// checks shared by every public entry point of this file
+static enum reh_error_code_e ree_ValidateProgram(const struct ree_program_t *program, const void *result, const uint8_t *status, const char *fnName){
+  if (program == nullptr || program->code == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Program provided to %s is NULL.", fnName);
+  }
+  else if (result == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Result provided to %s is NULL.", fnName);
+  }
+  else if (status == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Status provided to %s is NULL.", fnName);
+  }
+
+  if (program->maxStackDepth <= 0 || program->maxStackDepth > REE_MAX_STACK_DEPTH){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Program provided to %s has an invalid stack depth (%d).", fnName, program->maxStackDepth);
+  }
+
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e ree_EvaluateProgramDouble(const struct ree_program_t *program, const double *variables, double *result, uint8_t *status){
+  enum reh_error_code_e err = ree_ValidateProgram(program, result, status, __func__);
+  if (err != ERR_SUCCESS){
+    return err;
+  }
+
+  return ree_RunProgramDouble(program, variables, result, status);
+}
+
+enum reh_error_code_e ree_EvaluateProgramDoubleDouble(const struct ree_program_t *program, const struct rm_dd_t *variables, struct rm_dd_t *result, uint8_t *status){
+  enum reh_error_code_e err = ree_ValidateProgram(program, result, status, __func__);
+  if (err != ERR_SUCCESS){
+    return err;
+  }
+
+  return ree_RunProgramDoubleDouble(program, variables, result, status);
+}
+
+enum reh_error_code_e ree_SampleProgram(const struct ree_program_t *program, enum ree_precision_e precision, enum ree_math_mode_e mathMode, double xMin, double step, size_t count, double *xs, double *ys, uint8_t *status){
+  enum reh_error_code_e err = ree_ValidateProgram(program, ys, status, __func__);
+  if (err != ERR_SUCCESS){
+    return err;
+  }
+  else if (xs == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "xs array provided to ree_SampleProgram is NULL.");
+  }
+  if (count == 0){
+    return ERR_SUCCESS;
+  }
+
+  precision = ree_SelectPrecision(precision, xMin, xMin + step * (double)(count - 1), step);
+
+  switch (precision){
+    case REE_PRECISION_AUTO:
+    case REE_PRECISION_FLOAT: {
+      // float goes through the SIMD batch evaluator, a few blocks of lanes at a time
+      float xsFloat[REE_BATCH_LANES * 4];
+      float ysFloat[REE_BATCH_LANES * 4];
+      const size_t chunkSize = sizeof(xsFloat) / sizeof(xsFloat[0]);
+
+      for (size_t base = 0; base < count; base += chunkSize){
+        size_t chunkCount = (count - base < chunkSize) ? count - base : chunkSize;
+        for (size_t i = 0; i < chunkCount; ++i){
+          xsFloat[i] = (float)fma((double)(base + i), step, xMin);
+        }
+
+        CHECK_ERROR_CTX(ree_EvaluateBatchMode(program, mathMode, xsFloat, chunkCount, ysFloat, status + base), "Failed to sample the program in float precision.");
+
+        for (size_t i = 0; i < chunkCount; ++i){
+          xs[base + i] = (double)xsFloat[i];
+          ys[base + i] = (double)ysFloat[i];
+        }
+      }
+      break;
+    }
+    case REE_PRECISION_DOUBLE: {
+      for (size_t i = 0; i < count; ++i){
+        double x = fma((double)i, step, xMin);
+        CHECK_ERROR_CTX(ree_RunProgramDouble(program, &x, &ys[i], &status[i]), "Failed to sample the program in double precision.");
+        xs[i] = x;
+      }
+      break;
+    }
+    case REE_PRECISION_DOUBLE_DOUBLE: {
+      const struct rm_dd_t ddMin = rm_DdFromDouble(xMin);
+      const struct rm_dd_t ddStep = rm_DdFromDouble(step);
+
+      for (size_t i = 0; i < count; ++i){
+        // i * step is exact in double-double, so x doesn't drift however deep the zoom is
+        struct rm_dd_t x = rm_DdAdd(ddMin, rm_DdMul(rm_DdFromDouble((double)i), ddStep));
+        struct rm_dd_t y;
+        CHECK_ERROR_CTX(ree_RunProgramDoubleDouble(program, &x, &y, &status[i]), "Failed to sample the program in double-double precision.");
+        xs[i] = rm_DdToDouble(x);
+        ys[i] = rm_DdToDouble(y);
+      }
+      break;
+    }
+    default:
+      SET_ERROR_RETURN(ERR_INVALID_INPUT, "Unknown precision tier (%d) provided to ree_SampleProgram.", (int)precision);
+  }
+
+  return ERR_SUCCESS;
+}
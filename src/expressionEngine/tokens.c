@@ -1,4 +1,61 @@
 #include "expressionEngine/tokens.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// fixed names of the built-in symbols, indexed by enum ree_symbol_e
+static const char *builtinSymbolNames[SYMBOL_COUNT] = {
+  [SYMBOL_NONE] = "",
+  [SYMBOL_ADD]  = "+",   [SYMBOL_SUB]  = "-",    [SYMBOL_MUL] = "*",   [SYMBOL_DIV] = "/",  [SYMBOL_POW] = "^",
+  [SYMBOL_FACT] = "!",   [SYMBOL_NEG]  = "NEG",  [SYMBOL_POS] = "POS",
+  [SYMBOL_SIN]  = "sin", [SYMBOL_COS]  = "cos",  [SYMBOL_TAN] = "tan", [SYMBOL_SQRT] = "sqrt",
+  [SYMBOL_ABS]  = "abs", [SYMBOL_LN]   = "ln",   [SYMBOL_LOG] = "log",
+};
+
+// interned identifier names, internedNames[i] belongs to symbol id SYMBOL_COUNT + i
+// the table only ever grows, so ids (and the names they point to) stay valid for the lifetime of the program
+static char **internedNames = nullptr;
+static int internedCount = 0;
+static int internedCapacity = 0;
+
+// open addressing index over internedNames (-1 if empty), kept at most half full
+// every function name and parameter is interned, so a manager with thousands of functions needs more than a scan
+static int *internedBuckets = nullptr;
+static int internedBucketCount = 0;
+
+static uint32_t ree_HashName(const char *name, int length){
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < length; ++i){
+    hash ^= (uint8_t)name[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// rebuilds the index with twice the buckets, the names keep their ids
+static enum reh_error_code_e ree_GrowInternedIndex(void){
+  int bucketCount = (internedBucketCount == 0) ? 64 : internedBucketCount * 2;
+  int *buckets = malloc((size_t)bucketCount * sizeof *buckets);
+  if (buckets == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to expand the symbol index in ree_InternSymbol.");
+  }
+  memset(buckets, -1, (size_t)bucketCount * sizeof *buckets);
+
+  const uint32_t mask = (uint32_t)bucketCount - 1;
+  for (int i = 0; i < internedCount; ++i){
+    uint32_t bucket = ree_HashName(internedNames[i], (int)strlen(internedNames[i])) & mask;
+    while (buckets[bucket] != -1) bucket = (bucket + 1) & mask;
+    buckets[bucket] = i;
+  }
+
+  free(internedBuckets);
+  internedBuckets = buckets;
+  internedBucketCount = bucketCount;
+  return ERR_SUCCESS;
+}
 
 const char* ree_TokenToStr(enum ree_token_type_e tokenType){
   switch (tokenType){
@@ -25,3 +82,82 @@ const char* ree_TokenToStr(enum ree_token_type_e tokenType){
     default:                 return "Unknown Token";
   }
 }
+
+const char* ree_SymbolToStr(uint16_t symbol){
+  if (symbol < SYMBOL_COUNT){
+    return builtinSymbolNames[symbol];
+  }
+  else if (symbol - SYMBOL_COUNT < internedCount){
+    return internedNames[symbol - SYMBOL_COUNT];
+  }
+
+  return "Unknown Symbol";
+}
+
+bool ree_IsFunctionSymbol(uint16_t symbol){
+  return symbol >= SYMBOL_SIN && symbol <= SYMBOL_LOG;
+}
+
+enum reh_error_code_e ree_InternSymbol(const char *name, int length, uint16_t *symbol){
+  if (name == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Name passed to ree_InternSymbol is NULL.");
+  }
+  else if (symbol == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Pointer to symbol in ree_InternSymbol is NULL.");
+  }
+  else if (length <= 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Length passed to ree_InternSymbol is less than or equal to 0.");
+  }
+
+  // built-in functions first, so "sin" always resolves to SYMBOL_SIN
+  for (int i = SYMBOL_SIN; i <= SYMBOL_LOG; ++i){
+    if (strncmp(builtinSymbolNames[i], name, (size_t)length) == 0 && builtinSymbolNames[i][length] == '\0'){
+      *symbol = (uint16_t)i;
+      return ERR_SUCCESS;
+    }
+  }
+
+  if (2 * (internedCount + 1) > internedBucketCount){
+    CHECK_ERROR_CTX(ree_GrowInternedIndex(), "Failed to grow the symbol index.");
+  }
+
+  const uint32_t mask = (uint32_t)internedBucketCount - 1;
+  uint32_t bucket = ree_HashName(name, length) & mask;
+  for (; internedBuckets[bucket] != -1; bucket = (bucket + 1) & mask){
+    const char *interned = internedNames[internedBuckets[bucket]];
+    if (strncmp(interned, name, (size_t)length) == 0 && interned[length] == '\0'){
+      *symbol = (uint16_t)(SYMBOL_COUNT + internedBuckets[bucket]);
+      return ERR_SUCCESS;
+    }
+  }
+
+  if (SYMBOL_COUNT + internedCount >= REE_MAX_SYMBOLS){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Symbol table is full (%d symbols).", REE_MAX_SYMBOLS);
+  }
+
+  if (internedCount == internedCapacity){
+    int newCapacity = (internedCapacity == 0) ? 8 : (internedCapacity * 2);
+
+    char **tmp = realloc(internedNames, (size_t)newCapacity * sizeof *internedNames);
+    if (tmp == nullptr){
+      SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to expand the symbol table in ree_InternSymbol.");
+    }
+
+    internedNames = tmp;
+    internedCapacity = newCapacity;
+  }
+
+  char *copy = malloc((size_t)length + 1);
+  if (copy == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate memory for an interned symbol name.");
+  }
+  memcpy(copy, name, (size_t)length);
+  copy[length] = '\0';
+
+  internedNames[internedCount] = copy;
+  internedBuckets[bucket] = internedCount;
+  *symbol = (uint16_t)(SYMBOL_COUNT + internedCount);
+  internedCount++;
+
+  return ERR_SUCCESS;
+}
@@ -10,6 +10,7 @@
 #include "core/app.h"
 #include "core/window.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 int main(int argc, char** argv){
@@ -17,11 +18,6 @@ int main(int argc, char** argv){
     rl_enableANSI();
   #endif
 
-  if (argc > 16 + 1){
-    rl_LogMsg(RL_FAILURE, "Too many arguments passed (%d). Max arguments: %d", argc - 1, 16);
-    return -1;
-  }
-
   // Initialize application context
   struct ra_app_context_t appContext;
   memset(&appContext, 0, sizeof appContext);
@@ -40,7 +36,29 @@ int main(int argc, char** argv){
     int colorIterator = 0;
     for (int i = 1; i < argc; ++i){
       char* fnDef = argv[i];
-      err = ree_AddFunction(&functions, fnDef, &functionColorArray[colorIterator]);
+      size_t fnDefLength = strlen(fnDef);
+
+      // "a=2" sets a parameter, the definitions reading it can come before or after
+      char parameterName[REE_MAX_PARAMETER_NAME_LEN + 1];
+      float parameterValue;
+      if (ree_ParseParameterAssignment(fnDef, parameterName, sizeof parameterName, &parameterValue) == true){
+        err = ree_SetParameter(&functions, parameterName, parameterValue);
+        if (err != ERR_SUCCESS){
+          ra_AppShutdown(&appContext, "Failed to set a parameter.");
+          return -1;
+        }
+        continue;
+      }
+
+      // "f'" plots the derivative of a function passed before it
+      if (strchr(fnDef, '=') == nullptr && fnDefLength > 1 && fnDef[fnDefLength - 1] == '\''){
+        fnDef[fnDefLength - 1] = '\0';
+        err = ree_AddDerivative(&functions, fnDef, &functionColorArray[colorIterator]);
+        fnDef[fnDefLength - 1] = '\'';
+      }
+      else {
+        err = ree_AddFunction(&functions, fnDef, &functionColorArray[colorIterator]);
+      }
       if (err != ERR_SUCCESS){
         ra_AppShutdown(&appContext, "Failed to add function f to the function manager.");
         return -1;
@@ -90,6 +108,7 @@ int main(int argc, char** argv){
   }
 
   // Clean shutdown
+  ree_DestroyFunctionManager(&functions);
   ra_AppShutdown(&appContext, "Application shutting down normally.");
   return 0;
 }
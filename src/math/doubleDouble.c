@@ -0,0 +1,163 @@
+#include "math/doubleDouble.h"
+#include "math/utility.h"
+
+#include <math.h>
+
+/*
+  Error-free transformations the double-double arithmetic is built on,
+  see Dekker (1971) and the QD library by Hida, Li and Bailey.
+  The transcendental functions add their first-order term with rm_TwoSum,
+  near a zero of the function the correction can be larger than the double result.
+*/
+
+// s + err == a + b exactly, infinities don't produce a NaN low part
+static struct rm_dd_t rm_TwoSum(double a, double b){
+  double s = a + b;
+  if (!isfinite(s)){
+    return (struct rm_dd_t){s, 0.0};
+  }
+  double bb = s - a;
+  double err = (a - (s - bb)) + (b - bb);
+  return (struct rm_dd_t){s, err};
+}
+
+// same as rm_TwoSum but cheaper, requires |a| >= |b|
+static struct rm_dd_t rm_QuickTwoSum(double a, double b){
+  double s = a + b;
+  if (!isfinite(s)){
+    return (struct rm_dd_t){s, 0.0};
+  }
+  return (struct rm_dd_t){s, b - (s - a)};
+}
+
+// p + err == a * b exactly
+static struct rm_dd_t rm_TwoProd(double a, double b){
+  double p = a * b;
+  return (struct rm_dd_t){p, fma(a, b, -p)};
+}
+
+struct rm_dd_t rm_DdFromDouble(double value){
+  return (struct rm_dd_t){value, 0.0};
+}
+
+double rm_DdToDouble(struct rm_dd_t a){
+  return a.hi + a.lo;
+}
+
+struct rm_dd_t rm_DdAdd(struct rm_dd_t a, struct rm_dd_t b){
+  struct rm_dd_t s = rm_TwoSum(a.hi, b.hi);
+  struct rm_dd_t t = rm_TwoSum(a.lo, b.lo);
+  if (!isfinite(s.hi)){
+    return s;
+  }
+
+  s.lo += t.hi;
+  s = rm_QuickTwoSum(s.hi, s.lo);
+  s.lo += t.lo;
+  return rm_QuickTwoSum(s.hi, s.lo);
+}
+
+struct rm_dd_t rm_DdSub(struct rm_dd_t a, struct rm_dd_t b){
+  return rm_DdAdd(a, rm_DdNeg(b));
+}
+
+struct rm_dd_t rm_DdMul(struct rm_dd_t a, struct rm_dd_t b){
+  struct rm_dd_t p = rm_TwoProd(a.hi, b.hi);
+  if (!isfinite(p.hi)){
+    return (struct rm_dd_t){p.hi, 0.0};
+  }
+
+  p.lo += a.hi * b.lo + a.lo * b.hi;
+  return rm_QuickTwoSum(p.hi, p.lo);
+}
+
+struct rm_dd_t rm_DdDiv(struct rm_dd_t a, struct rm_dd_t b){
+  double q1 = a.hi / b.hi;
+  if (!isfinite(q1)){
+    return (struct rm_dd_t){q1, 0.0};
+  }
+
+  // long division, every quotient digit removes about 53 bits of the remainder
+  struct rm_dd_t r = rm_DdSub(a, rm_DdMul(rm_DdFromDouble(q1), b));
+  double q2 = r.hi / b.hi;
+  r = rm_DdSub(r, rm_DdMul(rm_DdFromDouble(q2), b));
+  double q3 = r.hi / b.hi;
+
+  struct rm_dd_t q = rm_QuickTwoSum(q1, q2);
+  return rm_DdAdd(q, rm_DdFromDouble(q3));
+}
+
+struct rm_dd_t rm_DdNeg(struct rm_dd_t a){
+  return (struct rm_dd_t){-a.hi, -a.lo};
+}
+
+struct rm_dd_t rm_DdAbs(struct rm_dd_t a){
+  return (a.hi < 0.0) ? rm_DdNeg(a) : a;
+}
+
+struct rm_dd_t rm_DdSqrt(struct rm_dd_t a){
+  if (fpclassify(a.hi) == FP_ZERO){
+    return (struct rm_dd_t){0.0, 0.0};
+  }
+  else if (a.hi < 0.0){
+    return (struct rm_dd_t){NAN, 0.0};
+  }
+
+  // one Newton step on top of the double square root (Karp's trick)
+  double x = 1.0 / sqrt(a.hi);
+  double ax = a.hi * x;
+  struct rm_dd_t residual = rm_DdSub(a, rm_TwoProd(ax, ax));
+  return rm_TwoSum(ax, residual.hi * (x * 0.5));
+}
+
+struct rm_dd_t rm_DdPow(struct rm_dd_t a, struct rm_dd_t b){
+  // small integer exponents (polynomials) are computed exactly by repeated squaring
+  if (fpclassify(b.lo) == FP_ZERO && rm_IsEqual(b.hi, nearbyint(b.hi)) && fabs(b.hi) <= 1024.0){
+    long n = (long)fabs(b.hi);
+    struct rm_dd_t result = rm_DdFromDouble(1.0);
+    struct rm_dd_t base = a;
+
+    while (n > 0){
+      if (n & 1){
+        result = rm_DdMul(result, base);
+      }
+      n >>= 1;
+      if (n > 0){
+        base = rm_DdMul(base, base);
+      }
+    }
+
+    return (b.hi < 0.0) ? rm_DdDiv(rm_DdFromDouble(1.0), result) : result;
+  }
+
+  double r = pow(a.hi, b.hi);
+  if (!isfinite(r) || a.hi <= 0.0){
+    return (struct rm_dd_t){r, 0.0};
+  }
+
+  // d(a^b) = a^b * (b / a * da + ln(a) * db)
+  double correction = r * (b.hi * a.lo / a.hi + log(a.hi) * b.lo);
+  return rm_TwoSum(r, correction);
+}
+
+struct rm_dd_t rm_DdSin(struct rm_dd_t a){
+  return rm_TwoSum(sin(a.hi), cos(a.hi) * a.lo);
+}
+
+struct rm_dd_t rm_DdCos(struct rm_dd_t a){
+  return rm_TwoSum(cos(a.hi), -sin(a.hi) * a.lo);
+}
+
+struct rm_dd_t rm_DdTan(struct rm_dd_t a){
+  double t = tan(a.hi);
+  return rm_TwoSum(t, (1.0 + t * t) * a.lo);
+}
+
+struct rm_dd_t rm_DdLn(struct rm_dd_t a){
+  return rm_TwoSum(log(a.hi), a.lo / a.hi);
+}
+
+struct rm_dd_t rm_DdLog10(struct rm_dd_t a){
+  static const double LN_10 = 2.302585092994045684;
+  return rm_TwoSum(log10(a.hi), a.lo / (a.hi * LN_10));
+}
@@ -0,0 +1,84 @@
+#include "math/dual.h"
+
+#include <math.h>
+
+#define RM_LN_10 2.302585093f
+
+// value with derivative da * slope, skipping the multiplication for constants
+static struct rm_dual_t rm_DualChain(float value, float da, float slope){
+  return (struct rm_dual_t){value, (fpclassify(da) == FP_ZERO) ? 0.0f : da * slope};
+}
+
+struct rm_dual_t rm_DualConst(float value){
+  return (struct rm_dual_t){value, 0.0f};
+}
+
+struct rm_dual_t rm_DualVariable(float value){
+  return (struct rm_dual_t){value, 1.0f};
+}
+
+struct rm_dual_t rm_DualAdd(struct rm_dual_t a, struct rm_dual_t b){
+  return (struct rm_dual_t){a.value + b.value, a.derivative + b.derivative};
+}
+
+struct rm_dual_t rm_DualSub(struct rm_dual_t a, struct rm_dual_t b){
+  return (struct rm_dual_t){a.value - b.value, a.derivative - b.derivative};
+}
+
+struct rm_dual_t rm_DualMul(struct rm_dual_t a, struct rm_dual_t b){
+  float derivative = 0.0f;
+  if (fpclassify(a.derivative) != FP_ZERO) derivative += a.derivative * b.value;
+  if (fpclassify(b.derivative) != FP_ZERO) derivative += a.value * b.derivative;
+  return (struct rm_dual_t){a.value * b.value, derivative};
+}
+
+struct rm_dual_t rm_DualDiv(struct rm_dual_t a, struct rm_dual_t b){
+  float value = a.value / b.value;
+  float derivative = 0.0f;
+  if (fpclassify(a.derivative) != FP_ZERO) derivative += a.derivative / b.value;
+  if (fpclassify(b.derivative) != FP_ZERO) derivative -= value * b.derivative / b.value;
+  return (struct rm_dual_t){value, derivative};
+}
+
+struct rm_dual_t rm_DualNeg(struct rm_dual_t a){
+  return (struct rm_dual_t){-a.value, -a.derivative};
+}
+
+struct rm_dual_t rm_DualAbs(struct rm_dual_t a){
+  float slope = (a.value > 0.0f) ? 1.0f : (a.value < 0.0f) ? -1.0f : 0.0f;
+  return rm_DualChain(fabsf(a.value), a.derivative, slope);
+}
+
+struct rm_dual_t rm_DualPow(struct rm_dual_t a, struct rm_dual_t b){
+  float value = powf(a.value, b.value);
+  float derivative = 0.0f;
+  if (fpclassify(a.derivative) != FP_ZERO) derivative += b.value * powf(a.value, b.value - 1.0f) * a.derivative;
+  if (fpclassify(b.derivative) != FP_ZERO) derivative += value * logf(a.value) * b.derivative;
+  return (struct rm_dual_t){value, derivative};
+}
+
+struct rm_dual_t rm_DualSqrt(struct rm_dual_t a){
+  float value = sqrtf(a.value);
+  return rm_DualChain(value, a.derivative, 0.5f / value);
+}
+
+struct rm_dual_t rm_DualSin(struct rm_dual_t a){
+  return rm_DualChain(sinf(a.value), a.derivative, cosf(a.value));
+}
+
+struct rm_dual_t rm_DualCos(struct rm_dual_t a){
+  return rm_DualChain(cosf(a.value), a.derivative, -sinf(a.value));
+}
+
+struct rm_dual_t rm_DualTan(struct rm_dual_t a){
+  float value = tanf(a.value);
+  return rm_DualChain(value, a.derivative, 1.0f + value * value);
+}
+
+struct rm_dual_t rm_DualLn(struct rm_dual_t a){
+  return rm_DualChain(logf(a.value), a.derivative, 1.0f / a.value);
+}
+
+struct rm_dual_t rm_DualLog10(struct rm_dual_t a){
+  return rm_DualChain(log10f(a.value), a.derivative, 1.0f / (a.value * RM_LN_10));
+}
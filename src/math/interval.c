@@ -0,0 +1,171 @@
+#include "math/interval.h"
+#include "math/utility.h"
+
+#include <float.h>
+#include <math.h>
+
+#define RM_PI   3.14159265358979323846
+#define RM_PI_2 1.57079632679489661923
+
+// beyond this magnitude one ulp of x spans several periods of sin / cos / tan
+#define RM_INTERVAL_MAX_TRIG_ARG 1e15
+
+// libm's double functions are accurate to within one ulp, so widening by one ulp on each side keeps the bounds sound
+struct rm_interval_t rm_IntervalMake(double lo, double hi){
+  if (isnan(lo) || isnan(hi)){
+    return rm_IntervalEntire();
+  }
+  return (struct rm_interval_t){nextafter(lo, -INFINITY), nextafter(hi, INFINITY)};
+}
+
+struct rm_interval_t rm_IntervalEntire(void){
+  return (struct rm_interval_t){-INFINITY, INFINITY};
+}
+
+bool rm_IntervalContains(struct rm_interval_t a, double value){
+  return a.lo <= value && value <= a.hi;
+}
+
+bool rm_IntervalIsBounded(struct rm_interval_t a){
+  return isfinite(a.lo) && isfinite(a.hi);
+}
+
+// smallest and largest of four candidate bounds, fmin / fmax skip the NaN of 0 * inf
+static struct rm_interval_t rm_IntervalHull4(double a, double b, double c, double d){
+  return rm_IntervalMake(fmin(fmin(a, b), fmin(c, d)), fmax(fmax(a, b), fmax(c, d)));
+}
+
+// checks whether [lo, hi] contains offset + k * period for some integer k, with some slack for the rounding of pi
+static bool rm_IntervalHitsPeriodic(struct rm_interval_t a, double offset, double period){
+  double slack = 4.0 * DBL_EPSILON * fmax(1.0, fmax(fabs(a.lo), fabs(a.hi)));
+  double k = ceil((a.lo - slack - offset) / period);
+  return offset + k * period <= a.hi + slack;
+}
+
+struct rm_interval_t rm_IntervalAdd(struct rm_interval_t a, struct rm_interval_t b){
+  return rm_IntervalMake(a.lo + b.lo, a.hi + b.hi);
+}
+
+struct rm_interval_t rm_IntervalSub(struct rm_interval_t a, struct rm_interval_t b){
+  return rm_IntervalMake(a.lo - b.hi, a.hi - b.lo);
+}
+
+struct rm_interval_t rm_IntervalMul(struct rm_interval_t a, struct rm_interval_t b){
+  return rm_IntervalHull4(a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi);
+}
+
+struct rm_interval_t rm_IntervalDiv(struct rm_interval_t a, struct rm_interval_t b){
+  if (rm_IntervalContains(b, 0.0)){
+    return rm_IntervalEntire();
+  }
+  return rm_IntervalHull4(a.lo / b.lo, a.lo / b.hi, a.hi / b.lo, a.hi / b.hi);
+}
+
+struct rm_interval_t rm_IntervalNeg(struct rm_interval_t a){
+  return (struct rm_interval_t){-a.hi, -a.lo};
+}
+
+struct rm_interval_t rm_IntervalAbs(struct rm_interval_t a){
+  if (a.lo >= 0.0){
+    return a;
+  }
+  else if (a.hi <= 0.0){
+    return rm_IntervalNeg(a);
+  }
+  return (struct rm_interval_t){0.0, fmax(-a.lo, a.hi)};
+}
+
+// a^n for a non-negative integer n
+static struct rm_interval_t rm_IntervalPowInt(struct rm_interval_t a, double n){
+  if (fpclassify(n) == FP_ZERO){
+    return (struct rm_interval_t){1.0, 1.0};
+  }
+
+  double powLo = pow(a.lo, n);
+  double powHi = pow(a.hi, n);
+
+  // odd powers are monotonic, even ones have their minimum at 0
+  if (fpclassify(fmod(n, 2.0)) != FP_ZERO || a.lo >= 0.0){
+    return rm_IntervalMake(powLo, powHi);
+  }
+  else if (a.hi <= 0.0){
+    return rm_IntervalMake(powHi, powLo);
+  }
+  return rm_IntervalMake(0.0, fmax(powLo, powHi));
+}
+
+struct rm_interval_t rm_IntervalPow(struct rm_interval_t a, struct rm_interval_t b){
+  if (rm_IsEqual(b.lo, b.hi) && rm_IsEqual(b.lo, nearbyint(b.lo)) && fabs(b.lo) <= 1024.0){
+    if (b.lo >= 0.0){
+      return rm_IntervalPowInt(a, b.lo);
+    }
+    return rm_IntervalDiv((struct rm_interval_t){1.0, 1.0}, rm_IntervalPowInt(a, -b.lo));
+  }
+
+  // non-integer exponents of negative bases are NaN
+  if (a.lo < 0.0){
+    return rm_IntervalEntire();
+  }
+
+  // for a >= 0, a^b is monotonic in a and in b on their own, so the extremes are in the corners
+  return rm_IntervalHull4(pow(a.lo, b.lo), pow(a.lo, b.hi), pow(a.hi, b.lo), pow(a.hi, b.hi));
+}
+
+struct rm_interval_t rm_IntervalSqrt(struct rm_interval_t a){
+  if (a.hi < 0.0){
+    return rm_IntervalEntire();
+  }
+  struct rm_interval_t result = rm_IntervalMake(sqrt(fmax(a.lo, 0.0)), sqrt(a.hi));
+  result.lo = fmax(result.lo, 0.0);
+  return result;
+}
+
+struct rm_interval_t rm_IntervalLn(struct rm_interval_t a){
+  if (a.hi <= 0.0){
+    return rm_IntervalEntire();
+  }
+  return rm_IntervalMake((a.lo <= 0.0) ? -HUGE_VAL : log(a.lo), log(a.hi));
+}
+
+struct rm_interval_t rm_IntervalLog10(struct rm_interval_t a){
+  if (a.hi <= 0.0){
+    return rm_IntervalEntire();
+  }
+  return rm_IntervalMake((a.lo <= 0.0) ? -HUGE_VAL : log10(a.lo), log10(a.hi));
+}
+
+struct rm_interval_t rm_IntervalSin(struct rm_interval_t a){
+  if (!rm_IntervalIsBounded(a) || a.hi - a.lo >= 2.0 * RM_PI || fmax(fabs(a.lo), fabs(a.hi)) > RM_INTERVAL_MAX_TRIG_ARG){
+    return (struct rm_interval_t){-1.0, 1.0};
+  }
+
+  struct rm_interval_t result = rm_IntervalMake(fmin(sin(a.lo), sin(a.hi)), fmax(sin(a.lo), sin(a.hi)));
+  // maxima at pi/2 + 2k*pi, minima at -pi/2 + 2k*pi
+  result.hi = rm_IntervalHitsPeriodic(a, RM_PI_2, 2.0 * RM_PI) ? 1.0 : fmin(result.hi, 1.0);
+  result.lo = rm_IntervalHitsPeriodic(a, -RM_PI_2, 2.0 * RM_PI) ? -1.0 : fmax(result.lo, -1.0);
+  return result;
+}
+
+struct rm_interval_t rm_IntervalCos(struct rm_interval_t a){
+  if (!rm_IntervalIsBounded(a) || a.hi - a.lo >= 2.0 * RM_PI || fmax(fabs(a.lo), fabs(a.hi)) > RM_INTERVAL_MAX_TRIG_ARG){
+    return (struct rm_interval_t){-1.0, 1.0};
+  }
+
+  struct rm_interval_t result = rm_IntervalMake(fmin(cos(a.lo), cos(a.hi)), fmax(cos(a.lo), cos(a.hi)));
+  // maxima at 2k*pi, minima at pi + 2k*pi
+  result.hi = rm_IntervalHitsPeriodic(a, 0.0, 2.0 * RM_PI) ? 1.0 : fmin(result.hi, 1.0);
+  result.lo = rm_IntervalHitsPeriodic(a, RM_PI, 2.0 * RM_PI) ? -1.0 : fmax(result.lo, -1.0);
+  return result;
+}
+
+struct rm_interval_t rm_IntervalTan(struct rm_interval_t a){
+  if (!rm_IntervalIsBounded(a) || a.hi - a.lo >= RM_PI || fmax(fabs(a.lo), fabs(a.hi)) > RM_INTERVAL_MAX_TRIG_ARG){
+    return rm_IntervalEntire();
+  }
+
+  // poles at pi/2 + k*pi, monotonic in between
+  if (rm_IntervalHitsPeriodic(a, RM_PI_2, RM_PI)){
+    return rm_IntervalEntire();
+  }
+  return rm_IntervalMake(tan(a.lo), tan(a.hi));
+}
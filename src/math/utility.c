@@ -44,3 +44,7 @@ enum reh_error_code_e rm_Factorial(int n, int *result){
 
   return ERR_SUCCESS;
 }
+
+bool rm_IsEqual(double a, double b){
+  return !isunordered(a, b) && !islessgreater(a, b);
+}
@@ -2,14 +2,17 @@
 #include "core/appContext.h"
 #include "core/logger.h"
 #include "core/errorHandler.h"
+#include "core/threadPool.h"
 #include "core/window.h"
 #include "expressionEngine/evaluator.h"
 #include "expressionEngine/functionManager.h"
+#include "math/utility.h"
 #include "utils/shaderUtils.h"
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
+#include <string.h>
 
 enum reh_error_code_e rfr_Init(struct ra_app_context_t *context){
   if (context == nullptr){
@@ -116,9 +119,8 @@ enum reh_error_code_e rfr_Init(struct ra_app_context_t *context){
     SET_ERROR_TECHNICAL_RETURN(ERR_BUFFER_SETUP_FAILED, "Failed to bind Vertex Buffer Object", technical);
   }
 
-  // set the initial capacity to 0, will be resized after sampling the function
+  // the buffer stays empty, the samples of every function live in its own buffer of the cache
   glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
-  context->fVertexCapacityBytes = 0;
 
   // vertex attribute pointer
   glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
@@ -152,85 +154,197 @@ enum reh_error_code_e rfr_Init(struct ra_app_context_t *context){
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
 
+  // functions are sampled on the workers of the pool, the render thread only uploads and draws
+  context->fPool = malloc(sizeof *context->fPool);
+  if (context->fPool == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the sampling thread pool.");
+  }
+  err = rtp_InitThreadPool(context->fPool, 0);
+  if (err != ERR_SUCCESS){
+    free(context->fPool);
+    context->fPool = nullptr;
+    ADD_ERROR_CONTEXT_RETURN(ERR_UNKNOWN, "Failed to start the sampling thread pool.");
+  }
+
   return ERR_SUCCESS;
 }
-enum reh_error_code_e rfr_SampleFunction(struct ree_function_t *function, float worldXRangeMin, float worldXRangeMax, float worldStep, struct rfr_function_point_data_t *pointsData){
-  if (function == nullptr){
-    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Function struct (ree_function_t) passed to rfr_SampleFunction is NULL.");
-  }
-  if (worldXRangeMin > worldXRangeMax){
-    SET_ERROR_RETURN(ERR_INVALID_INPUT, "worldXRangeMin is bigger than worldXRangeMax (%f > %f) in rfr_SampleFunction.", (double)worldXRangeMin, (double)worldXRangeMax);
+
+/*
+  #########
+  # CACHE #
+  #########
+
+  Every function keeps its samples and vertex buffer between frames, found by function handle.
+  An entry is resampled and uploaded again only when the viewport moved or the function's revision changed.
+*/
+
+// returns the cache entry of a function, adding an empty one (with its own vertex buffer) if it has none yet
+static enum reh_error_code_e rfr_GetCacheEntry(struct ra_app_context_t *context, struct ree_function_handle_t function, struct rfr_function_cache_t **entry){
+  for (int i = 0; i < context->fCacheCount; ++i){
+    if (context->fCache[i].function.slot == function.slot && context->fCache[i].function.generation == function.generation){
+      *entry = &context->fCache[i];
+      return ERR_SUCCESS;
+    }
   }
-  if (worldStep <= 0){
-    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Invalid step provided to rfr_SampleFunction (%f)", (double)worldStep);
+
+  if (context->fCacheCount == context->fCacheCapacity){
+    int capacity = (context->fCacheCapacity > 0) ? context->fCacheCapacity * 2 : 8;
+    struct rfr_function_cache_t *grown = realloc(context->fCache, (size_t)capacity * sizeof *grown);
+    if (grown == nullptr){
+      SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to grow the function cache to %d entries.", capacity);
+    }
+    context->fCache = grown;
+    context->fCacheCapacity = capacity;
   }
-  if (pointsData == nullptr ){
-    SET_ERROR_RETURN(ERR_INVALID_POINTER, "vertices array passed to rfr_SampleFunction is NULL.");
+
+  struct rfr_function_cache_t *created = &context->fCache[context->fCacheCount];
+  memset(created, 0, sizeof *created);
+  created->function = function;
+
+  glGenBuffers(1, &created->vbo);
+  if (created->vbo == 0){
+    SET_ERROR_RETURN(ERR_INVALID_VBO, "Generated VBO of function in slot %u is 0 (invalid)", function.slot);
   }
 
-  // calculate samplecount
-  float span = worldXRangeMax - worldXRangeMin;
-  size_t sampleCount = (size_t)floorf(span / worldStep) + 1;
-  size_t sample = 0;
+  context->fCacheCount++;
+  *entry = created;
+  return ERR_SUCCESS;
+}
 
-  // allocate memory for the vertices
-  pointsData->vertices = (float *)malloc(sizeof(float) * sampleCount * 2);
+static void rfr_ReleaseCacheEntry(struct rfr_function_cache_t *entry){
+  if (entry->vbo != 0){
+    glDeleteBuffers(1, &entry->vbo);
+  }
+  free(entry->points.vertices);
+  free(entry->points.undefinedPoints);
+  memset(entry, 0, sizeof *entry);
+}
 
-  if (pointsData->vertices == nullptr){
-    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate memory for vertices in rfr_SampleFunction");
+// drops the entries of functions that aren't in the manager anymore
+static void rfr_PruneCache(struct ra_app_context_t *context, struct ree_function_manager_t *functions){
+  for (int i = 0; i < context->fCacheCount;){
+    if (ree_ResolveFunction(functions, context->fCache[i].function) != nullptr){
+      ++i;
+      continue;
+    }
+    rfr_ReleaseCacheEntry(&context->fCache[i]);
+    context->fCache[i] = context->fCache[--context->fCacheCount];
   }
+}
 
-  // allocate memory for undefined points
-  pointsData->undefinedPoints = (float *)malloc(sizeof(float) * sampleCount);
-  pointsData->undefinedPointsCount = 0;
-  if (pointsData->undefinedPoints == nullptr){
-    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate memory for undefinedPoints in rfr_SampleFunction");
+// checks whether the entry already holds the samples of the function for this viewport
+static bool rfr_IsCacheEntryCurrent(const struct rfr_function_cache_t *entry, const struct ree_function_t *function, double step){
+  return entry->revision == function->revision && rm_IsEqual(entry->step, step) &&
+      rm_IsEqual(entry->xMin, worldXMin) && rm_IsEqual(entry->xMax, worldXMax) && rm_IsEqual(entry->yMin, worldYMin) && rm_IsEqual(entry->yMax, worldYMax);
+}
+
+// takes over freshly sampled points and uploads them into the vertex buffer of the entry
+static void rfr_CommitCacheEntry(struct rfr_function_cache_t *entry, const struct ree_function_t *function, double step, struct rfr_function_point_data_t pointData){
+  free(entry->points.vertices);
+  free(entry->points.undefinedPoints);
+  entry->points = pointData;
+  entry->revision = function->revision;
+  entry->xMin = worldXMin;
+  entry->xMax = worldXMax;
+  entry->yMin = worldYMin;
+  entry->yMax = worldYMax;
+  entry->step = step;
+
+  // grow if the byte count is larger than the previous capacity
+  glBindBuffer(GL_ARRAY_BUFFER, entry->vbo);
+  const GLsizeiptr byteCount = (GLsizeiptr)(pointData.vertexCount * 2u * sizeof(float));
+  if (byteCount > entry->vboCapacityBytes){
+    glBufferData(GL_ARRAY_BUFFER, byteCount, pointData.vertices, GL_DYNAMIC_DRAW);
+    entry->vboCapacityBytes = byteCount;
+  }
+  else {
+    glBufferSubData(GL_ARRAY_BUFFER, 0, byteCount, pointData.vertices);
   }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-  // fill vertices (sample the function)
-  for (size_t i = 0; i < sampleCount; ++i){
-    float x = (float)(worldXRangeMin + (float)i * worldStep);
-    // evaluate function at current x (get y)
-    float y;
-    struct ree_variable_t variables[] = {{function->parameter, x}};
+/*
+  #####################
+  # PARALLEL SAMPLING #
+  #####################
+
+  Every function that has to be resampled goes to the sampler in one call (see rfr_SampleFunctions):
+  float tier ones sharing enough work are evaluated together by a fused program, then the chunks of all of them run as one batch on the thread pool.
+  Workers only evaluate (every chunk writes its own part of the output), GL stays on the render thread.
+*/
+
+// resamples every visible function whose entry is out of date in parallel, then uploads the results
+static enum reh_error_code_e rfr_UpdateCache(struct ra_app_context_t *context, struct ree_function_manager_t *functions, double step){
+  // entries are created first, creating one may move the others
+  int staleCount = 0;
+  for (int i = 0; i < functions->functionCount; ++i){
+    struct ree_function_t *function = &functions->functions[i];
+    if (function->isVisible == false) continue;
 
-    // gutted CHECK_ERROR_CTX macro
-    enum reh_error_code_e _err = ree_EvaluateRpn(function->rpn, (size_t)function->rpnCount, variables, 1, &y);
+    struct rfr_function_cache_t *entry;
+    CHECK_ERROR_CTX(rfr_GetCacheEntry(context, function->handle, &entry), "Failed to get the cache entry of function %s.", function->name);
+    staleCount += !rfr_IsCacheEntryCurrent(entry, function, step);
+  }
+  if (staleCount == 0) return ERR_SUCCESS;
+
+  struct ree_function_t **stale = malloc((size_t)staleCount * sizeof *stale);
+  struct rfr_function_cache_t **entries = malloc((size_t)staleCount * sizeof *entries);
+  struct rfr_function_point_data_t *points = malloc((size_t)staleCount * sizeof *points);
+  if (stale == nullptr || entries == nullptr || points == nullptr){
+    free(stale);
+    free(entries);
+    free(points);
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the list of %d functions to sample.", staleCount);
+  }
 
-    if (!isfinite(y) || (fabsf(y) > ((worldYMax - worldYMin) * 10))){
-        pointsData->undefinedPoints[pointsData->undefinedPointsCount++] = x;
-        reh_ClearError();
-        continue;
-    }
+  int count = 0;
+  for (int i = 0; i < functions->functionCount; ++i){
+    struct ree_function_t *function = &functions->functions[i];
+    if (function->isVisible == false) continue;
 
-    if (_err != ERR_SUCCESS){
-      if (_err == ERR_DIVISION_BY_ZERO || _err == ERR_TAN_OUT_OF_DOMAIN ||
-          _err == ERR_LOG_OUT_OF_DOMAIN || _err == ERR_LN_OUT_OF_DOMAIN ||
-          _err == ERR_INVALID_SQRT){
-        pointsData->undefinedPoints[pointsData->undefinedPointsCount++] = x;
-        reh_ClearError();
-        continue;
-      }
-      const struct reh_error_context_t *_ctx = reh_GetLastError();
-      rl_LogError(_ctx, RL_ERROR);
-      char _new_msg[256];
-      snprintf(_new_msg, sizeof(_new_msg), "Failed to evaluate RPN.");
-      reh_SetError(_err, __FILE__, __LINE__, __func__, _new_msg, reh_GetLastError()->message);
-      free(pointsData->vertices);
-      pointsData->vertices = nullptr;
-      pointsData->vertexCount = 0;
-      return _err;
+    // the entry exists since the first pass, this only looks it up
+    struct rfr_function_cache_t *entry;
+    enum reh_error_code_e err = rfr_GetCacheEntry(context, function->handle, &entry);
+    if (err != ERR_SUCCESS){
+      free(stale);
+      free(entries);
+      free(points);
+      CHECK_ERROR_CTX(err, "Failed to get the cache entry of function %s.", function->name);
     }
-    // add the coordinates into the vertex array
-    (pointsData->vertices)[sample++] = x;
-    (pointsData->vertices)[sample++] = y;
+    if (rfr_IsCacheEntryCurrent(entry, function, step)) continue;
+
+    stale[count] = function;
+    entries[count] = entry;
+    count++;
+  }
+
+  // functions that were sampled are kept even if another one failed, the sampler reports the first failure
+  enum reh_error_code_e err = rfr_SampleFunctions(stale, (size_t)count, context->fPool, worldXMin, worldXMax, worldYMin, worldYMax, step, points);
+  for (int i = 0; i < count; ++i){
+    if (points[i].vertices == nullptr) continue;
+    rfr_CommitCacheEntry(entries[i], stale[i], step, points[i]);
   }
+  free(stale);
+  free(entries);
+  free(points);
 
-  pointsData->vertexCount = sample / 2;
+  CHECK_ERROR_CTX(err, "Failed to sample the functions that changed.");
 
   return ERR_SUCCESS;
 }
 
+void rfr_ReleaseCache(struct ra_app_context_t *context){
+  if (context == nullptr) return;
+
+  for (int i = 0; i < context->fCacheCount; ++i){
+    rfr_ReleaseCacheEntry(&context->fCache[i]);
+  }
+  free(context->fCache);
+  context->fCache = nullptr;
+  context->fCacheCount = 0;
+  context->fCacheCapacity = 0;
+}
+
 enum reh_error_code_e rfr_Render(struct ra_app_context_t *context, struct ree_function_manager_t *functions, float **projectionMatrixPtr){
   if (context == nullptr){
     SET_ERROR_RETURN(ERR_INVALID_POINTER, "context passed to rfr_Render is NULL.");
@@ -242,30 +356,25 @@ enum reh_error_code_e rfr_Render(struct ra_app_context_t *context, struct ree_fu
     SET_ERROR_RETURN(ERR_INVALID_POINTER, "Projection matrix pointer passed to rfr_Render is NULL.");
   }
 
+  rfr_PruneCache(context, functions);
+
+  // sample every function that changed since the previous frame, all of them at once
+  CHECK_ERROR_CTX(rfr_UpdateCache(context, functions, 0.01f), "Failed to update the samples of the functions.");
+
   for (size_t i = 0; i < (size_t)functions->functionCount; ++i){
     struct ree_function_t *function = &functions->functions[i];
 
     // skip rendering functions that are not visible
     if (function->isVisible == false) continue;
 
-    struct rfr_function_point_data_t pointData;
-
-    // sample the function
-    CHECK_ERROR_CTX(rfr_SampleFunction(function, worldXMin, worldXMax, 0.01f, &pointData), "Failed to sample function.");
+    struct rfr_function_cache_t *entry;
+    CHECK_ERROR_CTX(rfr_GetCacheEntry(context, function->handle, &entry), "Failed to get the cache entry of function %s.", function->name);
+    const struct rfr_function_point_data_t *pointData = &entry->points;
 
-    // bind VAO, VBO and grow if needed
+    // every function draws from its own buffer through the shared VAO
     glBindVertexArray(context->fVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, context->fVBO);
-
-    const GLsizeiptr byteCount = (GLsizeiptr)(pointData.vertexCount * 2u * sizeof(float));
-    // grow if the byte count is larger than the previous capacity
-    if (byteCount > context->fVertexCapacityBytes){
-      glBufferData(GL_ARRAY_BUFFER, byteCount, pointData.vertices, GL_DYNAMIC_DRAW);
-      context->fVertexCapacityBytes = byteCount;
-    }
-    else {
-      glBufferSubData(GL_ARRAY_BUFFER, 0, byteCount, pointData.vertices);
-    }
+    glBindBuffer(GL_ARRAY_BUFFER, entry->vbo);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
 
     glUseProgram(context->fProgram);
     rsu_GluSetMat4(context->fProgram, "functionProjection", *projectionMatrixPtr);
@@ -275,22 +384,22 @@ enum reh_error_code_e rfr_Render(struct ra_app_context_t *context, struct ree_fu
     size_t start = 0;
     size_t undefinedIndex = 0;
 
-    while (start < pointData.vertexCount){
+    while (start < pointData->vertexCount){
       // get the index of the undefined point
-      while (undefinedIndex < pointData.undefinedPointsCount &&
-          pointData.undefinedPoints[undefinedIndex] <= pointData.vertices[start * 2]
+      while (undefinedIndex < pointData->undefinedPointsCount &&
+          pointData->undefinedPoints[undefinedIndex] <= pointData->vertices[start * 2]
           ){
         ++undefinedIndex;
       }
 
       // first assume the end is the end of the array
-      size_t end = pointData.vertexCount;
+      size_t end = pointData->vertexCount;
 
-      if (undefinedIndex < pointData.undefinedPointsCount){
-        float cutX = pointData.undefinedPoints[undefinedIndex];
+      if (undefinedIndex < pointData->undefinedPointsCount){
+        float cutX = pointData->undefinedPoints[undefinedIndex];
         // try to find the end of this segment (between two undefined points, for example)
-        for (size_t j = start; j < pointData.vertexCount; ++j){
-          if (pointData.vertices[j * 2] > cutX){
+        for (size_t j = start; j < pointData->vertexCount; ++j){
+          if (pointData->vertices[j * 2] > cutX){
             end = j;
             break;
           }
@@ -306,8 +415,6 @@ enum reh_error_code_e rfr_Render(struct ra_app_context_t *context, struct ree_fu
 
     glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    free(pointData.vertices);
-    free(pointData.undefinedPoints);
   }
   return ERR_SUCCESS;
 }
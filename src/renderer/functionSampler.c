@@ -0,0 +1,677 @@
+#include "renderer/functionSampler.h"
+#include "core/errorHandler.h"
+#include "core/logger.h"
+#include "core/threadPool.h"
+#include "expressionEngine/evaluator.h"
+#include "expressionEngine/functionManager.h"
+#include "math/interval.h"
+#include "math/utility.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  ############
+  # SAMPLING #
+  ############
+
+  The x range is split recursively into spans of samples, each one bounded with the interval evaluator first:
+    spans that are provably above or below the viewport only get their two end points (the line between them stays offscreen)
+    spans that may contain a domain failure or a pole check every gap between two defined samples for a discontinuity
+  A span's interval also covers the gap to the sample before it, so no gap goes unchecked.
+*/
+
+// spans with at most this many samples are sampled directly instead of being split further
+#define RFR_MIN_SPAN_SAMPLES 32
+
+// bisection depth used to prove that the gap between two defined samples is continuous
+#define RFR_GAP_REFINE_DEPTH 8
+
+struct rfr_sampler_t {
+  const struct ree_program_t *program;            /**< Program being sampled */
+  enum ree_precision_e precision;                 /**< Resolved precision tier (never REE_PRECISION_AUTO) */
+  enum ree_math_mode_e mathMode;                  /**< Transcendental kernels of the float tier */
+  double xMin;                                    /**< x of the first sample */
+  double step;                                    /**< Distance between two samples */
+  double yMin;                                    /**< Bottom of the viewport, spans entirely below it are culled */
+  double yMax;                                    /**< Top of the viewport, spans entirely above it are culled */
+  struct rfr_function_point_data_t *pointsData;   /**< Output vertices and undefined points */
+  const float *sampledXs;                         /**< Samples taken ahead by a fused pass, nullptr to evaluate them here */
+  const float *sampledYs;
+  const uint8_t *sampledStatus;
+  size_t vertexFloats;                            /**< Floats written into pointsData->vertices so far */
+  bool previousDefined;                           /**< Whether the last emitted sample was defined */
+  double previousX;                               /**< x of the last emitted sample */
+};
+
+// x interval of the samples [first, last], widened by the rounding of x in the float tier
+static struct rm_interval_t rfr_XInterval(double x0, double x1){
+  return rm_IntervalMake(x0 - fabs(x0) * (double)FLT_EPSILON, x1 + fabs(x1) * (double)FLT_EPSILON);
+}
+
+// checks whether the curve may break (pole or undefined point) between two defined samples
+static enum reh_error_code_e rfr_GapMayBreak(const struct ree_program_t *program, double x0, double x1, int depth, bool *mayBreak){
+  struct rm_interval_t y;
+  bool mayBeUndefined;
+  CHECK_ERROR_CTX(ree_EvaluateInterval(program, rfr_XInterval(x0, x1), &y, &mayBeUndefined), "Failed to bound the function between two samples.");
+
+  if (!mayBeUndefined || depth == 0){
+    *mayBreak = mayBeUndefined;
+    return ERR_SUCCESS;
+  }
+
+  // the interval overestimates, halving the gap often proves it continuous after all
+  double middle = x0 + (x1 - x0) * 0.5;
+  CHECK_ERROR_CTX(rfr_GapMayBreak(program, x0, middle, depth - 1, mayBreak), "Failed to refine the left half of a gap.");
+  if (*mayBreak) return ERR_SUCCESS;
+  CHECK_ERROR_CTX(rfr_GapMayBreak(program, middle, x1, depth - 1, mayBreak), "Failed to refine the right half of a gap.");
+  return ERR_SUCCESS;
+}
+
+// gets the samples [first, first + count), from the fused pass if there was one
+static enum reh_error_code_e rfr_TakeSamples(const struct rfr_sampler_t *sampler, size_t first, size_t count, double *xs, double *ys, uint8_t *status){
+  if (sampler->sampledYs == nullptr){
+    return ree_SampleProgram(sampler->program, sampler->precision, sampler->mathMode, sampler->xMin + (double)first * sampler->step, sampler->step, count, xs, ys, status);
+  }
+
+  for (size_t i = 0; i < count; ++i){
+    xs[i] = (double)sampler->sampledXs[first + i];
+    ys[i] = (double)sampler->sampledYs[first + i];
+  }
+  memcpy(status, sampler->sampledStatus + first, count);
+  return ERR_SUCCESS;
+}
+
+// evaluates the samples [first, first + count) and appends them, checking the gaps in front of defined samples if asked to
+static enum reh_error_code_e rfr_SampleDirect(struct rfr_sampler_t *sampler, size_t first, size_t count, bool checkGaps){
+  struct rfr_function_point_data_t *pointsData = sampler->pointsData;
+  double xs[REE_BATCH_LANES * 4];
+  double ys[REE_BATCH_LANES * 4];
+  uint8_t status[REE_BATCH_LANES * 4];
+  const size_t batchSize = sizeof(xs) / sizeof(xs[0]);
+
+  for (size_t batchStart = first; batchStart < first + count; batchStart += batchSize){
+    size_t batchCount = (first + count - batchStart < batchSize) ? first + count - batchStart : batchSize;
+
+    // evaluate function at every x of the batch (get y), domain failures come back as per-sample status bytes without touching the error state
+    CHECK_ERROR_CTX(rfr_TakeSamples(sampler, batchStart, batchCount, xs, ys, status), "Failed to sample a span of the function.");
+
+    for (size_t i = 0; i < batchCount; ++i){
+      float x = (float)xs[i];
+      float y = (float)ys[i];
+
+      if (status[i] != REE_EVAL_OK || !isfinite(y)){
+        pointsData->undefinedPoints[pointsData->undefinedPointsCount++] = x;
+        sampler->previousDefined = false;
+        continue;
+      }
+
+      // a pole between two defined samples (1/x sampled at -0.005 and 0.005) cuts the line in the middle of the gap
+      if (checkGaps && sampler->previousDefined){
+        bool mayBreak = false;
+        CHECK_ERROR_CTX(rfr_GapMayBreak(sampler->program, sampler->previousX, xs[i], RFR_GAP_REFINE_DEPTH, &mayBreak), "Failed to check a gap for a discontinuity.");
+        if (mayBreak){
+          pointsData->undefinedPoints[pointsData->undefinedPointsCount++] = (float)(sampler->previousX + (xs[i] - sampler->previousX) * 0.5);
+        }
+      }
+
+      // add the coordinates into the vertex array
+      pointsData->vertices[sampler->vertexFloats++] = x;
+      pointsData->vertices[sampler->vertexFloats++] = y;
+      sampler->previousDefined = true;
+      sampler->previousX = xs[i];
+    }
+  }
+
+  return ERR_SUCCESS;
+}
+
+// samples [first, first + count), culling or splitting it depending on its interval bound
+static enum reh_error_code_e rfr_SampleSpan(struct rfr_sampler_t *sampler, size_t first, size_t count){
+  // cover the gap to the previous sample too, a pole in there has to be found by this span
+  double x0 = sampler->xMin + (double)((first > 0) ? first - 1 : 0) * sampler->step;
+  double x1 = sampler->xMin + (double)(first + count - 1) * sampler->step;
+
+  struct rm_interval_t y;
+  bool mayBeUndefined;
+  CHECK_ERROR_CTX(ree_EvaluateInterval(sampler->program, rfr_XInterval(x0, x1), &y, &mayBeUndefined), "Failed to bound a span of the function.");
+
+  if (!mayBeUndefined && (y.hi < sampler->yMin || y.lo > sampler->yMax)){
+    // provably offscreen and continuous, the end points keep the line leaving and entering the viewport correct
+    CHECK_ERROR_CTX(rfr_SampleDirect(sampler, first, 1, false), "Failed to sample the start of an offscreen span.");
+    if (count > 1){
+      CHECK_ERROR_CTX(rfr_SampleDirect(sampler, first + count - 1, 1, false), "Failed to sample the end of an offscreen span.");
+    }
+    return ERR_SUCCESS;
+  }
+
+  bool fullyVisible = !mayBeUndefined && y.lo >= sampler->yMin && y.hi <= sampler->yMax;
+  if (fullyVisible || count <= RFR_MIN_SPAN_SAMPLES){
+    return rfr_SampleDirect(sampler, first, count, mayBeUndefined);
+  }
+
+  size_t half = count / 2;
+  CHECK_ERROR_CTX(rfr_SampleSpan(sampler, first, half), "Failed to sample the left half of a span.");
+  CHECK_ERROR_CTX(rfr_SampleSpan(sampler, first + half, count - half), "Failed to sample the right half of a span.");
+  return ERR_SUCCESS;
+}
+
+/*
+  The recursion over spans is cut at RFR_CHUNK_SAMPLES: larger spans are culled or split on the calling thread while planning,
+  every span of at most that many samples becomes a chunk that continues the recursion on its own (on any thread).
+  A fully visible span is sampled in chunks of RFR_CHUNK_SAMPLES as well, so a single expensive function is spread over every thread.
+  The decisions are the ones a single pass makes, the result doesn't depend on the thread count.
+
+  A chunk starts from the sample just before it (evaluated again), so the gap check at its start is the one a single pass would make.
+  Chunk k writes to the output at vertex float 2 * first and undefined point first (a sample adds at most one of either),
+  the pieces are moved together in chunk order afterwards.
+*/
+
+// samples per chunk, a multiple of the batch size of rfr_SampleDirect so chunked batches line up with unchunked ones
+#define RFR_CHUNK_SAMPLES (REE_BATCH_LANES * 4 * 2)
+
+static enum reh_error_code_e rfr_AddChunk(struct rfr_sampling_plan_t *plan, enum rfr_chunk_kind_e kind, size_t first, size_t count){
+  if (plan->chunkCount == plan->chunkCapacity){
+    size_t capacity = (plan->chunkCapacity > 0) ? plan->chunkCapacity * 2 : 16;
+    struct rfr_sampling_chunk_t *grown = realloc(plan->chunks, capacity * sizeof *grown);
+    if (grown == nullptr){
+      SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to grow the sampling chunks to %zu.", capacity);
+    }
+    plan->chunks = grown;
+    plan->chunkCapacity = capacity;
+  }
+
+  plan->chunks[plan->chunkCount++] = (struct rfr_sampling_chunk_t){.kind = kind, .first = first, .count = count};
+  return ERR_SUCCESS;
+}
+
+// the part of rfr_SampleSpan above chunk size, deciding what happens to [first, first + count) without sampling anything
+static enum reh_error_code_e rfr_PlanSpan(struct rfr_sampling_plan_t *plan, size_t first, size_t count){
+  if (count <= RFR_CHUNK_SAMPLES){
+    return rfr_AddChunk(plan, RFR_CHUNK_SPAN, first, count);
+  }
+
+  double x0 = plan->xMin + (double)((first > 0) ? first - 1 : 0) * plan->step;
+  double x1 = plan->xMin + (double)(first + count - 1) * plan->step;
+
+  struct rm_interval_t y;
+  bool mayBeUndefined;
+  CHECK_ERROR_CTX(ree_EvaluateInterval(&plan->function->program, rfr_XInterval(x0, x1), &y, &mayBeUndefined), "Failed to bound a span of the function.");
+
+  if (!mayBeUndefined && (y.hi < plan->yMin || y.lo > plan->yMax)){
+    return rfr_AddChunk(plan, RFR_CHUNK_ENDS, first, count);
+  }
+
+  if (!mayBeUndefined && y.lo >= plan->yMin && y.hi <= plan->yMax){
+    for (size_t offset = 0; offset < count; offset += RFR_CHUNK_SAMPLES){
+      CHECK_ERROR_CTX(rfr_AddChunk(plan, RFR_CHUNK_DIRECT, first + offset, (count - offset < RFR_CHUNK_SAMPLES) ? count - offset : RFR_CHUNK_SAMPLES), "Failed to add a chunk of a visible span.");
+    }
+    return ERR_SUCCESS;
+  }
+
+  size_t half = count / 2;
+  CHECK_ERROR_CTX(rfr_PlanSpan(plan, first, half), "Failed to plan the left half of a span.");
+  CHECK_ERROR_CTX(rfr_PlanSpan(plan, first + half, count - half), "Failed to plan the right half of a span.");
+  return ERR_SUCCESS;
+}
+
+enum reh_error_code_e rfr_PlanSampling(struct ree_function_t *function, double worldXRangeMin, double worldXRangeMax, double worldYRangeMin, double worldYRangeMax, double worldStep, struct rfr_function_point_data_t *pointsData, struct rfr_sampling_plan_t *plan){
+  if (function == nullptr){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Function struct (ree_function_t) passed to rfr_PlanSampling is NULL.");
+  }
+  if (worldXRangeMin > worldXRangeMax){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "worldXRangeMin is bigger than worldXRangeMax (%f > %f) in rfr_PlanSampling.", (double)worldXRangeMin, (double)worldXRangeMax);
+  }
+  if (worldStep <= 0){
+    SET_ERROR_RETURN(ERR_INVALID_INPUT, "Invalid step provided to rfr_PlanSampling (%f)", (double)worldStep);
+  }
+  if (pointsData == nullptr ){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "vertices array passed to rfr_PlanSampling is NULL.");
+  }
+
+  // functions that keep getting resampled (every frame) are compiled to native code after a few passes
+  ree_MarkFunctionSampled(function);
+
+  // calculate samplecount
+  double span = worldXRangeMax - worldXRangeMin;
+  size_t sampleCount = (size_t)floor(span / worldStep) + 1;
+
+  // allocate memory for the vertices
+  pointsData->vertices = (float *)malloc(sizeof(float) * sampleCount * 2);
+  pointsData->vertexCount = 0;
+
+  if (pointsData->vertices == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate memory for vertices in rfr_PlanSampling");
+  }
+
+  // allocate memory for undefined points
+  pointsData->undefinedPoints = (float *)malloc(sizeof(float) * sampleCount);
+  pointsData->undefinedPointsCount = 0;
+  if (pointsData->undefinedPoints == nullptr){
+    free(pointsData->vertices);
+    pointsData->vertices = nullptr;
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate memory for undefinedPoints in rfr_PlanSampling");
+  }
+
+  // pick the precision tier once for the whole range, float as long as it can still resolve the step
+  *plan = (struct rfr_sampling_plan_t){
+    .function = function,
+    .precision = ree_SelectPrecision(function->precision, worldXRangeMin, worldXRangeMax, worldStep),
+    .xMin = worldXRangeMin,
+    .step = worldStep,
+    .yMin = worldYRangeMin,
+    .yMax = worldYRangeMax,
+    .sampleCount = sampleCount,
+    .pointsData = pointsData,
+  };
+
+  enum reh_error_code_e err = rfr_PlanSpan(plan, 0, sampleCount);
+  if (err != ERR_SUCCESS){
+    free(plan->chunks);
+    free(pointsData->vertices);
+    free(pointsData->undefinedPoints);
+    pointsData->vertices = nullptr;
+    pointsData->undefinedPoints = nullptr;
+    plan->chunks = nullptr;
+    CHECK_ERROR_CTX(err, "Failed to cut the range of %s into chunks.", function->name);
+  }
+
+  return ERR_SUCCESS;
+}
+
+void rfr_SampleChunk(const struct rfr_sampling_plan_t *plan, size_t chunkIndex){
+  struct rfr_sampling_chunk_t *chunk = &plan->chunks[chunkIndex];
+
+  struct rfr_function_point_data_t chunkPoints = {
+    .vertices = plan->pointsData->vertices + 2 * chunk->first,
+    .undefinedPoints = plan->pointsData->undefinedPoints + chunk->first,
+  };
+  struct rfr_sampler_t sampler = {
+    .program = &plan->function->program,
+    .precision = plan->precision,
+    .mathMode = plan->function->mathMode,
+    .xMin = plan->xMin,
+    .step = plan->step,
+    .yMin = plan->yMin,
+    .yMax = plan->yMax,
+    .pointsData = &chunkPoints,
+    .sampledXs = plan->sampledXs,
+    .sampledYs = plan->sampledYs,
+    .sampledStatus = plan->sampledStatus,
+  };
+
+  // the last sample before the chunk is always emitted (or undefined), it's what the first gap is checked against
+  // only spans check gaps, direct and end point chunks come from spans that can't break
+  chunk->err = ERR_SUCCESS;
+  if (chunk->first > 0 && chunk->kind == RFR_CHUNK_SPAN){
+    double x;
+    double y;
+    uint8_t status;
+    chunk->err = rfr_TakeSamples(&sampler, chunk->first - 1, 1, &x, &y, &status);
+    sampler.previousDefined = (status == REE_EVAL_OK && isfinite((float)y));
+    sampler.previousX = x;
+  }
+
+  if (chunk->err == ERR_SUCCESS){
+    switch (chunk->kind){
+      case RFR_CHUNK_SPAN:
+        chunk->err = rfr_SampleSpan(&sampler, chunk->first, chunk->count);
+        break;
+      case RFR_CHUNK_DIRECT:
+        chunk->err = rfr_SampleDirect(&sampler, chunk->first, chunk->count, false);
+        break;
+      case RFR_CHUNK_ENDS:
+        // provably offscreen and continuous, the end points keep the line leaving and entering the viewport correct
+        chunk->err = rfr_SampleDirect(&sampler, chunk->first, 1, false);
+        if (chunk->err == ERR_SUCCESS && chunk->count > 1){
+          chunk->err = rfr_SampleDirect(&sampler, chunk->first + chunk->count - 1, 1, false);
+        }
+        break;
+    }
+  }
+  if (chunk->err != ERR_SUCCESS){
+    chunk->error = *reh_GetLastError();
+    reh_ClearError();
+    return;
+  }
+
+  chunk->vertexCount = sampler.vertexFloats / 2;
+  chunk->undefinedPointsCount = chunkPoints.undefinedPointsCount;
+}
+
+// sets the error a chunk ran into as the error of the calling thread
+static enum reh_error_code_e rfr_RestoreChunkError(const struct rfr_sampling_chunk_t *chunk){
+  reh_SetError(chunk->err, chunk->error.file, chunk->error.line, chunk->error.fnName, chunk->error.message, chunk->error.technicalDetails);
+  return chunk->err;
+}
+
+enum reh_error_code_e rfr_FinishSampling(struct rfr_sampling_plan_t *plan){
+  struct rfr_function_point_data_t *pointsData = plan->pointsData;
+
+  enum reh_error_code_e _err = ERR_SUCCESS;
+  for (size_t c = 0; c < plan->chunkCount; ++c){
+    const struct rfr_sampling_chunk_t *chunk = &plan->chunks[c];
+    if (chunk->err != ERR_SUCCESS){
+      _err = rfr_RestoreChunkError(chunk);
+      break;
+    }
+
+    // every part starts at or after where it's moved to, so moving them in order never overwrites one that is still to come
+    memmove(pointsData->vertices + 2 * pointsData->vertexCount, pointsData->vertices + 2 * chunk->first, chunk->vertexCount * 2 * sizeof(float));
+    memmove(pointsData->undefinedPoints + pointsData->undefinedPointsCount, pointsData->undefinedPoints + chunk->first, chunk->undefinedPointsCount * sizeof(float));
+    pointsData->vertexCount += chunk->vertexCount;
+    pointsData->undefinedPointsCount += chunk->undefinedPointsCount;
+  }
+
+  free(plan->chunks);
+  plan->chunks = nullptr;
+
+  if (_err != ERR_SUCCESS){
+    // gutted CHECK_ERROR_CTX macro
+    const struct reh_error_context_t *_ctx = reh_GetLastError();
+    rl_LogError(_ctx, RL_ERROR);
+    char _new_msg[256];
+    snprintf(_new_msg, sizeof(_new_msg), "Failed to evaluate function.");
+    reh_SetError(_err, __FILE__, __LINE__, __func__, _new_msg, reh_GetLastError()->message);
+    free(pointsData->vertices);
+    free(pointsData->undefinedPoints);
+    pointsData->vertices = nullptr;
+    pointsData->undefinedPoints = nullptr;
+    pointsData->vertexCount = 0;
+    pointsData->undefinedPointsCount = 0;
+    return _err;
+  }
+
+  return ERR_SUCCESS;
+}
+
+static void rfr_SampleChunkTask(void *userData, size_t index){
+  rfr_SampleChunk(userData, index);
+}
+
+enum reh_error_code_e rfr_SampleFunction(struct ree_function_t *function, struct rtp_thread_pool_t *pool, double worldXRangeMin, double worldXRangeMax, double worldYRangeMin, double worldYRangeMax, double worldStep, struct rfr_function_point_data_t *pointsData){
+  struct rfr_sampling_plan_t plan;
+  enum reh_error_code_e err = rfr_PlanSampling(function, worldXRangeMin, worldXRangeMax, worldYRangeMin, worldYRangeMax, worldStep, pointsData, &plan);
+  if (err != ERR_SUCCESS) return err;
+
+  rtp_ParallelFor(pool, plan.chunkCount, rfr_SampleChunkTask, &plan);
+
+  return rfr_FinishSampling(&plan);
+}
+
+/*
+  ##############
+  # FUSED PASS #
+  ##############
+
+  Functions sampled over the same range in the float tier are evaluated together before their chunks run:
+  a block of x is generated once and the fused program computes every function for it while the block is still in cache,
+  subexpressions the functions share (f(x) = sin(x) * x and g(x) = sin(x) * x + 1) are computed once for all of them.
+  The chunks then only cull, check gaps and emit, taking y from the pass instead of evaluating it.
+  The pass evaluates every sample, so a function whose plan culls most of its range to end points is left out and sampled on its own,
+  and the functions are only fused if the work they share outweighs that (see RFR_FUSED_MAX_COST).
+*/
+
+// most plans fused into one program, the ones after it are sampled on their own
+#define RFR_MAX_FUSED_PLANS 64
+
+// samples per block of the fused pass, the same cut as the chunks
+#define RFR_FUSED_BLOCK_SAMPLES RFR_CHUNK_SAMPLES
+
+// the fused pass has to cost at most this fraction of sampling the functions one by one (instructions times samples evaluated),
+// the rest pays for the per-output statuses of the pass and for the samples it evaluates that culling would have skipped
+#define RFR_FUSED_MAX_COST 0.75
+
+// samples the plan evaluates on its own, everything but the inside of provably offscreen spans
+static size_t rfr_EvaluatedSamples(const struct rfr_sampling_plan_t *plan){
+  size_t culledSamples = 0;
+  for (size_t c = 0; c < plan->chunkCount; ++c){
+    if (plan->chunks[c].kind == RFR_CHUNK_ENDS) culledSamples += plan->chunks[c].count;
+  }
+  return plan->sampleCount - culledSamples;
+}
+
+// checks whether a plan can be evaluated together with the reference plan (the first fused one, nullptr while there is none)
+static bool rfr_CanFusePlan(const struct rfr_sampling_plan_t *reference, const struct rfr_sampling_plan_t *plan){
+  if (plan->precision != REE_PRECISION_FLOAT) return false;
+
+  // at least half of the samples have to be needed, the rest of a mostly offscreen function is cheaper culled
+  if (rfr_EvaluatedSamples(plan) * 2 < plan->sampleCount) return false;
+
+  if (reference == nullptr) return true;
+
+  return plan->function->mathMode == reference->function->mathMode && rm_IsEqual(plan->xMin, reference->xMin) &&
+      rm_IsEqual(plan->step, reference->step) && plan->sampleCount == reference->sampleCount;
+}
+
+enum reh_error_code_e rfr_PlanFusedSampling(struct rfr_sampling_plan_t *plans, size_t planCount, struct rfr_fused_sampling_t *fused){
+  if (fused == nullptr || (plans == nullptr && planCount > 0)){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Plans or fused sampling passed to rfr_PlanFusedSampling are NULL.");
+  }
+
+  *fused = (struct rfr_fused_sampling_t){0};
+  CHECK_ERROR_CTX(rma_InitPool(&fused->pool, RMA_DEFAULT_BLOCK_SIZE, 0, nullptr), "Failed to initialize the pool of the fused program.");
+  rma_InitArena(&fused->scratch, &fused->pool);
+  rma_InitArena(&fused->arena, &fused->pool);
+
+  // the first float plan decides the math mode and the samples, the ones matching it are fused
+  const struct rfr_sampling_plan_t *reference = nullptr;
+  size_t fusedCount = 0;
+  for (size_t p = 0; p < planCount && fusedCount < RFR_MAX_FUSED_PLANS; ++p){
+    if (rfr_CanFusePlan(reference, &plans[p]) == false) continue;
+    if (reference == nullptr) reference = &plans[p];
+    fusedCount++;
+  }
+  if (fusedCount < 2) return ERR_SUCCESS;
+
+  fused->plans = malloc(fusedCount * sizeof *fused->plans);
+  const struct ree_program_t **programs = rma_Alloc(&fused->scratch, fusedCount * sizeof *programs);
+  if (fused->plans == nullptr || programs == nullptr){
+    rfr_ReleaseFusedSampling(fused);
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the list of %zu fused plans.", fusedCount);
+  }
+  double separateCost = 0.0;
+  for (size_t p = 0; p < planCount && fused->planCount < fusedCount; ++p){
+    if (rfr_CanFusePlan(reference, &plans[p]) == false) continue;
+    programs[fused->planCount] = &plans[p].function->program;
+    fused->plans[fused->planCount++] = &plans[p];
+    separateCost += (double)plans[p].function->program.opCount * (double)rfr_EvaluatedSamples(&plans[p]);
+  }
+
+  enum reh_error_code_e err = ree_FusePrograms(&fused->scratch, &fused->arena, programs, (int)fused->planCount, &fused->program);
+  rma_ResetArena(&fused->scratch);
+  if (err != ERR_SUCCESS){
+    // more than a program can hold, not worth failing the frame over
+    rl_LogMsg(RL_DEBUG, "Sampling %zu functions one by one: %s", fused->planCount, reh_GetLastError()->message);
+    reh_ClearError();
+    rfr_ReleaseFusedSampling(fused);
+    return ERR_SUCCESS;
+  }
+
+  // without enough shared subexpressions the pass only adds work
+  const double fusedCost = (double)fused->program.program.opCount * (double)reference->sampleCount;
+  if (fusedCost > RFR_FUSED_MAX_COST * separateCost){
+    rfr_ReleaseFusedSampling(fused);
+    return ERR_SUCCESS;
+  }
+
+  fused->mathMode = reference->function->mathMode;
+  fused->xMin = reference->xMin;
+  fused->step = reference->step;
+  fused->sampleCount = reference->sampleCount;
+  fused->blockCount = (fused->sampleCount + RFR_FUSED_BLOCK_SAMPLES - 1) / RFR_FUSED_BLOCK_SAMPLES;
+
+  fused->xs = malloc(fused->sampleCount * sizeof(float));
+  fused->ys = malloc(fused->planCount * fused->sampleCount * sizeof(float));
+  fused->status = malloc(fused->planCount * fused->sampleCount);
+  fused->blockErrors = calloc(fused->blockCount, sizeof *fused->blockErrors);
+  if (fused->xs == nullptr || fused->ys == nullptr || fused->status == nullptr || fused->blockErrors == nullptr){
+    rfr_ReleaseFusedSampling(fused);
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate the samples of %zu fused functions.", fusedCount);
+  }
+
+  return ERR_SUCCESS;
+}
+
+void rfr_SampleFusedBlock(const struct rfr_fused_sampling_t *fused, size_t blockIndex){
+  const size_t first = blockIndex * RFR_FUSED_BLOCK_SAMPLES;
+  const size_t count = (fused->sampleCount - first < RFR_FUSED_BLOCK_SAMPLES) ? fused->sampleCount - first : RFR_FUSED_BLOCK_SAMPLES;
+
+  // x the way the float tier of ree_SampleProgram computes it
+  for (size_t i = 0; i < count; ++i){
+    fused->xs[first + i] = (float)fma((double)(first + i), fused->step, fused->xMin);
+  }
+
+  enum reh_error_code_e err = ree_EvaluateFusedBatch(&fused->program, fused->mathMode, fused->xs + first, count, fused->ys + first, fused->status + first, fused->sampleCount);
+  if (err != ERR_SUCCESS){
+    reh_ClearError();
+  }
+  fused->blockErrors[blockIndex] = err;
+}
+
+void rfr_AttachFusedSamples(struct rfr_fused_sampling_t *fused){
+  for (size_t b = 0; b < fused->blockCount; ++b){
+    if (fused->blockErrors[b] != ERR_SUCCESS){
+      rl_LogMsg(RL_WARNING, "Evaluating %zu functions together failed (error %d), sampling them one by one.", fused->planCount, (int)fused->blockErrors[b]);
+      return;
+    }
+  }
+
+  for (size_t p = 0; p < fused->planCount; ++p){
+    fused->plans[p]->sampledXs = fused->xs;
+    fused->plans[p]->sampledYs = fused->ys + p * fused->sampleCount;
+    fused->plans[p]->sampledStatus = fused->status + p * fused->sampleCount;
+  }
+}
+
+void rfr_ReleaseFusedSampling(struct rfr_fused_sampling_t *fused){
+  for (size_t p = 0; p < fused->planCount; ++p){
+    fused->plans[p]->sampledXs = nullptr;
+    fused->plans[p]->sampledYs = nullptr;
+    fused->plans[p]->sampledStatus = nullptr;
+  }
+
+  free(fused->plans);
+  free(fused->xs);
+  free(fused->ys);
+  free(fused->status);
+  free(fused->blockErrors);
+  rma_ResetArena(&fused->scratch);
+  rma_ResetArena(&fused->arena);
+  rma_DestroyPool(&fused->pool);
+  *fused = (struct rfr_fused_sampling_t){0};
+}
+
+/*
+  ##################
+  # MANY FUNCTIONS #
+  ##################
+
+  Every function is planned on the calling thread, then the fused pass and the chunks of all of them run as one batch each on the pool.
+  A single expensive function is spread over every thread as well as a dozen cheap ones are.
+*/
+
+// a chunk of one of the plans, the flat list lets a single batch cover every function
+struct rfr_chunk_task_t {
+  struct rfr_sampling_plan_t *plan;           /**< Plan of the function the chunk belongs to */
+  size_t chunk;                               /**< Index of the chunk in the plan */
+};
+
+static void rfr_ChunkTask(void *userData, size_t index){
+  const struct rfr_chunk_task_t *task = &((const struct rfr_chunk_task_t *)userData)[index];
+  rfr_SampleChunk(task->plan, task->chunk);
+}
+
+static void rfr_FusedBlockTask(void *userData, size_t index){
+  rfr_SampleFusedBlock(userData, index);
+}
+
+// releases the plans that were made and their output, the ones after them are untouched
+static void rfr_ReleasePlans(struct rfr_sampling_plan_t *plans, size_t plannedCount){
+  for (size_t p = 0; p < plannedCount; ++p){
+    free(plans[p].chunks);
+    free(plans[p].pointsData->vertices);
+    free(plans[p].pointsData->undefinedPoints);
+    plans[p].pointsData->vertices = nullptr;
+    plans[p].pointsData->undefinedPoints = nullptr;
+  }
+  free(plans);
+}
+
+enum reh_error_code_e rfr_SampleFunctions(struct ree_function_t *const *functions, size_t functionCount, struct rtp_thread_pool_t *pool, double worldXRangeMin, double worldXRangeMax, double worldYRangeMin, double worldYRangeMax, double worldStep, struct rfr_function_point_data_t *pointsData){
+  if ((functions == nullptr || pointsData == nullptr) && functionCount > 0){
+    SET_ERROR_RETURN(ERR_INVALID_POINTER, "Functions or points passed to rfr_SampleFunctions are NULL.");
+  }
+  if (functionCount == 0) return ERR_SUCCESS;
+
+  for (size_t f = 0; f < functionCount; ++f){
+    pointsData[f] = (struct rfr_function_point_data_t){0};
+  }
+
+  struct rfr_sampling_plan_t *plans = calloc(functionCount, sizeof *plans);
+  if (plans == nullptr){
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate %zu sampling plans.", functionCount);
+  }
+
+  size_t taskCount = 0;
+  for (size_t f = 0; f < functionCount; ++f){
+    enum reh_error_code_e err = rfr_PlanSampling(functions[f], worldXRangeMin, worldXRangeMax, worldYRangeMin, worldYRangeMax, worldStep, &pointsData[f], &plans[f]);
+    if (err != ERR_SUCCESS){
+      rfr_ReleasePlans(plans, f);
+      CHECK_ERROR_CTX(err, "Failed to plan the sampling of function %s.", (functions[f] != nullptr) ? functions[f]->name : "(null)");
+    }
+    taskCount += plans[f].chunkCount;
+  }
+
+  struct rfr_fused_sampling_t fused;
+  enum reh_error_code_e err = rfr_PlanFusedSampling(plans, functionCount, &fused);
+  if (err != ERR_SUCCESS){
+    rfr_ReleasePlans(plans, functionCount);
+    CHECK_ERROR_CTX(err, "Failed to plan the fused pass over %zu functions.", functionCount);
+  }
+
+  struct rfr_chunk_task_t *tasks = malloc(taskCount * sizeof *tasks);
+  if (tasks == nullptr){
+    rfr_ReleaseFusedSampling(&fused);
+    rfr_ReleasePlans(plans, functionCount);
+    SET_ERROR_RETURN(ERR_OUT_OF_MEMORY, "Failed to allocate %zu sampling tasks.", taskCount);
+  }
+
+  size_t task = 0;
+  for (size_t f = 0; f < functionCount; ++f){
+    for (size_t c = 0; c < plans[f].chunkCount; ++c){
+      tasks[task++] = (struct rfr_chunk_task_t){.plan = &plans[f], .chunk = c};
+    }
+  }
+
+  rtp_ParallelFor(pool, fused.blockCount, rfr_FusedBlockTask, &fused);
+  rfr_AttachFusedSamples(&fused);
+  rtp_ParallelFor(pool, taskCount, rfr_ChunkTask, tasks);
+  rfr_ReleaseFusedSampling(&fused);
+  free(tasks);
+
+  // functions that were sampled are kept even if another one failed, the first failure is reported
+  enum reh_error_code_e firstErr = ERR_SUCCESS;
+  struct reh_error_context_t firstError;
+  const char *failedName = nullptr;
+  for (size_t f = 0; f < functionCount; ++f){
+    err = rfr_FinishSampling(&plans[f]);
+    if (err != ERR_SUCCESS && firstErr == ERR_SUCCESS){
+      firstErr = err;
+      firstError = *reh_GetLastError();
+      failedName = functions[f]->name;
+    }
+  }
+  free(plans);
+
+  if (firstErr != ERR_SUCCESS){
+    reh_SetError(firstErr, firstError.file, firstError.line, firstError.fnName, firstError.message, firstError.technicalDetails);
+    CHECK_ERROR_CTX(firstErr, "Failed to sample function %s.", failedName);
+  }
+
+  return ERR_SUCCESS;
+}